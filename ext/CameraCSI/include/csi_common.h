@@ -27,24 +27,24 @@
 #ifndef _CSITEST_H_
 #define _CSITEST_H_
 
+#include "camera_renderer.h"
+
 typedef unsigned int __u32;
 typedef int __s32;
 typedef unsigned short __u16;
 typedef unsigned char __u8;
 
-enum render_type {
-        RENDER_TYPE_WL,
-        RENDER_TYPE_GL,
-        RENDER_TYPE_GL_DMA,
-};
-
-
 struct set_up {
         unsigned int ow, oh;
+        enum deinterlace_mode deinterlace;
+        enum render_type render_type;
+        void *capture;          /* CaptureSession the frames come from */
 };
 
-int CsiStartDisplay(struct set_up, void*, int);
+int CsiStartDisplay(struct set_up, int);
 void CsiStopDisplay(int);
+/* Destroys the renderer kept between CsiStartDisplay() calls. */
+void CsiReleaseDisplay(void);
 int ConfigureCSI(void);
 
 #endif
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSI_TOPOLOGY_H
+#define CSI_TOPOLOGY_H
+
+#include <stdint.h>
+#include <linux/media.h>
+
+#include "mediactl.h"
+
+#define CSI_TOPOLOGY_CACHE_DIR  "/var/lib/earlyapp"
+#define CSI_TOPOLOGY_CACHE      CSI_TOPOLOGY_CACHE_DIR "/csi_topology.bin"
+#define CSI_TOPOLOGY_MAGIC      0x50544943      /* "CITP" */
+#define CSI_TOPOLOGY_VERSION    2
+
+/* Media entities of the CVBS capture pipeline. */
+enum csi_topology_entity_type {
+	CSI_ENT_PIXEL_ARRAY,
+	CSI_ENT_BINNER,
+	CSI_ENT_CSI2,
+	CSI_ENT_BE_SOC,
+	CSI_ENT_CAPTURE,
+	CSI_ENT_COUNT
+};
+
+struct csi_topology_entity {
+	uint32_t id;
+	char name[32];
+	char devname[32];
+};
+
+/*
+ * Resolved pipeline topology. The kernel release, the media device
+ * information (driver, model, serial, bus) and a hash of every entity of the
+ * device (ID, type, name, device node) are the cache key, a cache written
+ * for another kernel, driver, sensor or graph is never applied.
+ */
+struct csi_topology {
+	uint32_t magic;
+	uint32_t version;
+	char kernel[65];
+	struct media_device_info info;
+	uint32_t entities_hash;
+	struct csi_topology_entity entities[CSI_ENT_COUNT];
+	uint32_t checksum;
+};
+
+/* Formats applied to the pipeline. */
+struct csi_pipeline_cfg {
+	unsigned int sensor_w, sensor_h;        /* ADV7481 pixel array and binner sink */
+	unsigned int out_w, out_h;              /* binner compose, CSI-2 and BE SOC */
+	unsigned int code;
+	int interlaced;
+};
+
+/*
+ * Brings up the CSI pipeline of media_node from the topology cache, or from a
+ * full media device enumeration when the cache is missing or stale, in which
+ * case the cache is rewritten. The capture video node is returned in
+ * video_devname when it is empty. Returns 0 on success.
+ */
+int csi_topology_setup(const char *media_node, const struct csi_pipeline_cfg *cfg,
+		char *video_devname, size_t video_devname_len);
+
+/*
+ * Resets the IPU part of the pipeline after a capture error: reapplies the
+ * routing and the formats of the CSI-2 receiver and the BE SOC and enables
+ * their dynamic links again. The capture has to be streamed off. Returns 0
+ * on success.
+ */
+int csi_topology_reset_ipu(const char *media_node, const struct csi_pipeline_cfg *cfg);
+
+#endif /*CSI_TOPOLOGY_H*/
@@ -0,0 +1,560 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include <sys/utsname.h>
+#include <linux/videodev2.h>
+#include <linux/v4l2-subdev.h>
+
+#include "mediactl-priv.h"
+#include "csi_topology.h"
+
+#define TOPOLOGY_MAX_STEPS 8
+
+struct topology_link {
+	enum csi_topology_entity_type source;
+	unsigned int source_pad;
+	enum csi_topology_entity_type sink;
+	unsigned int sink_pad;
+	uint32_t flags;
+};
+
+/* Entity names, matched as prefixes where the driver appends an instance. */
+static const struct {
+	const char *name;
+	int prefix;
+} entity_names[CSI_ENT_COUNT] = {
+	[CSI_ENT_PIXEL_ARRAY] = { "adv7481-cvbs pixel array a", 1 },
+	[CSI_ENT_BINNER] = { "adv7481-cvbs binner a", 1 },
+	[CSI_ENT_CSI2] = { "Intel IPU4 CSI-2 4", 0 },
+	[CSI_ENT_BE_SOC] = { "Intel IPU4 CSI2 BE SOC", 0 },
+	[CSI_ENT_CAPTURE] = { "Intel IPU4 BE SOC capture 0", 0 },
+};
+
+static const struct topology_link pipeline_links[] = {
+	{ CSI_ENT_PIXEL_ARRAY, 0, CSI_ENT_BINNER, 0, 0 },
+	{ CSI_ENT_BINNER, 1, CSI_ENT_CSI2, 0, 0 },
+	{ CSI_ENT_CSI2, 1, CSI_ENT_BE_SOC, 0, MEDIA_LNK_FL_DYNAMIC },
+	{ CSI_ENT_BE_SOC, 8, CSI_ENT_CAPTURE, 0, MEDIA_LNK_FL_DYNAMIC },
+};
+
+struct topology_steps {
+	unsigned int count;
+	const char *name[TOPOLOGY_MAX_STEPS];
+	double ms[TOPOLOGY_MAX_STEPS];
+	struct timespec last;
+};
+
+static void step_done(struct topology_steps *steps, const char *name)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (steps->count < TOPOLOGY_MAX_STEPS) {
+		steps->name[steps->count] = name;
+		steps->ms[steps->count] = (now.tv_sec - steps->last.tv_sec) * 1000.0
+			+ (now.tv_nsec - steps->last.tv_nsec) / 1000000.0;
+		steps->count++;
+	}
+	steps->last = now;
+}
+
+static void print_steps(const struct topology_steps *steps)
+{
+	unsigned int i;
+
+	printf("MEDIA CONTROLLER SETUP\n");
+	for (i = 0; i < steps->count; i++)
+		printf("%-25s | %6.02f ms\n", steps->name[i], steps->ms[i]);
+}
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t topology_checksum(const struct csi_topology *t)
+{
+	return fnv1a(2166136261u, t, offsetof(struct csi_topology, checksum));
+}
+
+/* Hashes the ID, type, name and device node of every entity of the device. */
+static int topology_entities_hash(int media_fd, uint32_t *hash)
+{
+	struct media_entity_desc desc;
+	uint32_t id = 0;
+
+	*hash = 2166136261u;
+	for (;;) {
+		memset(&desc, 0, sizeof(desc));
+		desc.id = id | MEDIA_ENT_ID_FLAG_NEXT;
+		if (ioctl(media_fd, MEDIA_IOC_ENUM_ENTITIES, &desc) < 0)
+			break;
+		id = desc.id;
+		*hash = fnv1a(*hash, &desc.id, sizeof(desc.id));
+		*hash = fnv1a(*hash, &desc.type, sizeof(desc.type));
+		*hash = fnv1a(*hash, desc.name, strnlen(desc.name, sizeof(desc.name)));
+		*hash = fnv1a(*hash, &desc.dev, sizeof(desc.dev));
+	}
+	/* EINVAL ends the enumeration. */
+	if (errno != EINVAL) {
+		printf("Cannot enumerate media entities: %s\n", strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+static int topology_key(struct csi_topology *t, int media_fd)
+{
+	struct utsname uts;
+
+	memset(t, 0, sizeof(*t));
+	t->magic = CSI_TOPOLOGY_MAGIC;
+	t->version = CSI_TOPOLOGY_VERSION;
+
+	if (uname(&uts) < 0)
+		return -1;
+	strncpy(t->kernel, uts.release, sizeof(t->kernel) - 1);
+
+	if (ioctl(media_fd, MEDIA_IOC_DEVICE_INFO, &t->info) < 0) {
+		printf("Cannot get media device info: %s\n", strerror(errno));
+		return -1;
+	}
+	return topology_entities_hash(media_fd, &t->entities_hash);
+}
+
+static int topology_load(struct csi_topology *t, const struct csi_topology *key)
+{
+	int fd;
+	ssize_t len;
+
+	fd = open(CSI_TOPOLOGY_CACHE, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	len = read(fd, t, sizeof(*t));
+	close(fd);
+
+	if (len != (ssize_t)sizeof(*t)
+			|| t->magic != key->magic
+			|| t->version != key->version
+			|| strncmp(t->kernel, key->kernel, sizeof(t->kernel)) != 0
+			|| memcmp(&t->info, &key->info, sizeof(t->info)) != 0
+			|| t->entities_hash != key->entities_hash
+			|| t->checksum != topology_checksum(t)) {
+		printf("Media topology cache is stale\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int topology_save(struct csi_topology *t)
+{
+	char tmp_path[] = CSI_TOPOLOGY_CACHE ".XXXXXX";
+	int fd;
+
+	t->checksum = topology_checksum(t);
+
+	if (mkdir(CSI_TOPOLOGY_CACHE_DIR, 0755) < 0 && errno != EEXIST)
+		return -1;
+
+	fd = mkstemp(tmp_path);
+	if (fd < 0)
+		return -1;
+
+	if (write(fd, t, sizeof(*t)) != (ssize_t)sizeof(*t) || fsync(fd) < 0) {
+		close(fd);
+		unlink(tmp_path);
+		return -1;
+	}
+	close(fd);
+
+	/* Readers see either the old or the complete new cache. */
+	if (rename(tmp_path, CSI_TOPOLOGY_CACHE) < 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+/* Resolves the pipeline entities from a full enumeration of the media device. */
+static int topology_resolve(const char *media_node, struct csi_topology *t)
+{
+	struct media_device *md;
+	struct media_entity *entity;
+	const struct media_entity_desc *desc;
+	unsigned int i, e, count;
+	int found;
+
+	md = media_device_new(media_node);
+	if (!md || media_device_enumerate(md) < 0) {
+		printf("Cannot enumerate media device %s\n", media_node);
+		if (md)
+			media_device_unref(md);
+		return -1;
+	}
+
+	count = media_get_entities_count(md);
+	for (e = 0; e < CSI_ENT_COUNT; e++) {
+		found = 0;
+		for (i = 0; i < count && !found; i++) {
+			entity = media_get_entity(md, i);
+			desc = media_entity_get_info(entity);
+			if (entity_names[e].prefix
+				? strncmp(desc->name, entity_names[e].name, strlen(entity_names[e].name)) == 0
+				: strcmp(desc->name, entity_names[e].name) == 0) {
+				t->entities[e].id = desc->id;
+				strncpy(t->entities[e].name, desc->name, sizeof(t->entities[e].name) - 1);
+				strncpy(t->entities[e].devname, media_entity_get_devname(entity),
+					sizeof(t->entities[e].devname) - 1);
+				found = 1;
+			}
+		}
+		if (!found) {
+			printf("Cannot find entity %s\n", entity_names[e].name);
+			media_device_unref(md);
+			return -1;
+		}
+	}
+
+	media_device_unref(md);
+	return 0;
+}
+
+/*
+ * Checks the cached entity IDs and device nodes against the running kernel
+ * with one ioctl and one stat per entity, and keeps the descriptors for the
+ * link queries.
+ */
+static int topology_validate(int media_fd, const struct csi_topology *t,
+		struct media_entity_desc *desc)
+{
+	struct stat st;
+	unsigned int e;
+
+	for (e = 0; e < CSI_ENT_COUNT; e++) {
+		memset(&desc[e], 0, sizeof(desc[e]));
+		desc[e].id = t->entities[e].id;
+		if (ioctl(media_fd, MEDIA_IOC_ENUM_ENTITIES, &desc[e]) < 0
+				|| strncmp(desc[e].name, t->entities[e].name, sizeof(t->entities[e].name)) != 0)
+			return -1;
+
+		if (stat(t->entities[e].devname, &st) < 0
+				|| major(st.st_rdev) != desc[e].dev.major
+				|| minor(st.st_rdev) != desc[e].dev.minor)
+			return -1;
+	}
+	return 0;
+}
+
+static int subdev_set_fmt(int fd, unsigned int pad, unsigned int width, unsigned int height,
+		unsigned int code, int interlaced)
+{
+	struct v4l2_subdev_format subdev_fmt;
+
+	memset(&subdev_fmt, 0, sizeof(subdev_fmt));
+	subdev_fmt.pad = pad;
+	subdev_fmt.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+	subdev_fmt.format.width = width;
+	subdev_fmt.format.height = height;
+	subdev_fmt.format.code = code;
+	subdev_fmt.format.field = interlaced ? V4L2_FIELD_ALTERNATE : V4L2_FIELD_NONE;
+
+	return ioctl(fd, VIDIOC_SUBDEV_S_FMT, &subdev_fmt);
+}
+
+static int subdev_set_compose(int fd, unsigned int pad, unsigned int width, unsigned int height)
+{
+	struct v4l2_subdev_selection sel;
+
+	memset(&sel, 0, sizeof(sel));
+	sel.pad = pad;
+	sel.target = V4L2_SEL_TGT_COMPOSE;
+	sel.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+	sel.r.width = width;
+	sel.r.height = height;
+
+	return ioctl(fd, VIDIOC_SUBDEV_S_SELECTION, &sel);
+}
+
+static int subdev_setup_routing(int fd)
+{
+	struct v4l2_subdev_routing routing;
+	struct v4l2_subdev_route route[2];
+
+	memset(route, 0, sizeof(route));
+	route[0].sink_pad = 0;
+	route[0].source_pad = 8;
+	route[0].flags = V4L2_SUBDEV_ROUTE_FL_ACTIVE;
+
+	route[1].sink_pad = 4;
+	route[1].source_pad = 12;
+	route[1].flags = V4L2_SUBDEV_ROUTE_FL_ACTIVE;
+
+	routing.routes = &route[0];
+	routing.num_routes = 2;
+
+	return ioctl(fd, VIDIOC_SUBDEV_S_ROUTING, &routing);
+}
+
+static int link_is_enabled(int media_fd, const struct media_entity_desc *source,
+		const struct topology_link *link, const struct csi_topology *t)
+{
+	struct media_links_enum links;
+	struct media_link_desc *descs;
+	struct media_pad_desc *pads;
+	unsigned int i;
+	int enabled = 0;
+
+	pads = calloc(source->pads, sizeof(*pads));
+	descs = calloc(source->links, sizeof(*descs));
+	if (!pads || !descs)
+		goto out;
+
+	memset(&links, 0, sizeof(links));
+	links.entity = source->id;
+	links.pads = pads;
+	links.links = descs;
+	if (ioctl(media_fd, MEDIA_IOC_ENUM_LINKS, &links) < 0)
+		goto out;
+
+	for (i = 0; i < source->links; i++) {
+		if (descs[i].source.index == link->source_pad
+				&& descs[i].sink.entity == t->entities[link->sink].id
+				&& descs[i].sink.index == link->sink_pad) {
+			enabled = descs[i].flags & MEDIA_LNK_FL_ENABLED;
+			break;
+		}
+	}
+out:
+	free(pads);
+	free(descs);
+	return enabled;
+}
+
+/* Enables the pipeline links from index first on that are not enabled yet. */
+static int topology_enable_links(int media_fd, const struct csi_topology *t,
+		const struct media_entity_desc *desc, unsigned int first)
+{
+	struct media_link_desc ulink;
+	const struct topology_link *link;
+	unsigned int i;
+
+	for (i = first; i < sizeof(pipeline_links) / sizeof(pipeline_links[0]); i++) {
+		link = &pipeline_links[i];
+		if (link_is_enabled(media_fd, &desc[link->source], link, t))
+			continue;
+
+		memset(&ulink, 0, sizeof(ulink));
+		ulink.source.entity = t->entities[link->source].id;
+		ulink.source.index = link->source_pad;
+		ulink.source.flags = MEDIA_PAD_FL_SOURCE;
+		ulink.sink.entity = t->entities[link->sink].id;
+		ulink.sink.index = link->sink_pad;
+		ulink.sink.flags = MEDIA_PAD_FL_SINK;
+		ulink.flags = MEDIA_LNK_FL_ENABLED | link->flags;
+		if (ioctl(media_fd, MEDIA_IOC_SETUP_LINK, &ulink) < 0) {
+			printf("Cannot setup link between %s[%u] -> %s[%u]\n",
+				t->entities[link->source].name, link->source_pad,
+				t->entities[link->sink].name, link->sink_pad);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int topology_apply(int media_fd, const struct csi_topology *t,
+		const struct media_entity_desc *desc, const struct csi_pipeline_cfg *cfg,
+		struct topology_steps *steps)
+{
+	int fd[CSI_ENT_COUNT];
+	unsigned int e;
+	int ret = -1;
+
+	for (e = 0; e < CSI_ENT_COUNT; e++)
+		fd[e] = -1;
+	for (e = CSI_ENT_PIXEL_ARRAY; e <= CSI_ENT_BE_SOC; e++) {
+		fd[e] = open(t->entities[e].devname, O_RDWR | O_CLOEXEC);
+		if (fd[e] < 0) {
+			printf("Cannot open subdev %s\n", t->entities[e].devname);
+			goto out;
+		}
+	}
+	step_done(steps, "Subdev open");
+
+	/* Kernels without stream routing reject it, that is not fatal. */
+	subdev_setup_routing(fd[CSI_ENT_BE_SOC]);
+	step_done(steps, "Routing");
+
+	if (subdev_set_fmt(fd[CSI_ENT_CSI2], 0, cfg->out_w, cfg->out_h, cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(fd[CSI_ENT_PIXEL_ARRAY], 0, cfg->sensor_w, cfg->sensor_h,
+				cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(fd[CSI_ENT_BINNER], 0, cfg->sensor_w, cfg->sensor_h,
+				cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(fd[CSI_ENT_BE_SOC], 0, cfg->out_w, cfg->out_h,
+				cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(fd[CSI_ENT_BE_SOC], 8, cfg->out_w, cfg->out_h,
+				cfg->code, cfg->interlaced) < 0) {
+		printf("Cannot set pipeline formats: %s\n", strerror(errno));
+		goto out;
+	}
+	if (subdev_set_compose(fd[CSI_ENT_BINNER], 0, cfg->out_w, cfg->out_h) < 0) {
+		printf("Cannot set compose for entity %s[0]\n", t->entities[CSI_ENT_BINNER].name);
+		goto out;
+	}
+	if (subdev_set_fmt(fd[CSI_ENT_BINNER], 1, cfg->out_w, cfg->out_h, cfg->code, cfg->interlaced) < 0) {
+		printf("Cannot set format for entity %s[1]\n", t->entities[CSI_ENT_BINNER].name);
+		goto out;
+	}
+	step_done(steps, "Formats");
+
+	if (topology_enable_links(media_fd, t, desc, 0) < 0)
+		goto out;
+	step_done(steps, "Links");
+	ret = 0;
+
+out:
+	for (e = 0; e < CSI_ENT_COUNT; e++)
+		if (fd[e] >= 0)
+			close(fd[e]);
+	return ret;
+}
+
+int csi_topology_setup(const char *media_node, const struct csi_pipeline_cfg *cfg,
+		char *video_devname, size_t video_devname_len)
+{
+	struct csi_topology key, t;
+	struct media_entity_desc desc[CSI_ENT_COUNT];
+	struct topology_steps steps;
+	int media_fd, cached, ret = -1;
+
+	memset(&steps, 0, sizeof(steps));
+	clock_gettime(CLOCK_MONOTONIC, &steps.last);
+
+	media_fd = open(media_node, O_RDWR | O_CLOEXEC);
+	if (media_fd < 0) {
+		printf("Cannot open media device %s\n", media_node);
+		return -1;
+	}
+	if (topology_key(&key, media_fd) < 0)
+		goto out;
+
+	cached = topology_load(&t, &key) == 0
+		&& topology_validate(media_fd, &t, desc) == 0;
+	step_done(&steps, "Topology cache load");
+
+	if (!cached) {
+		t = key;
+		if (topology_resolve(media_node, &t) < 0
+				|| topology_validate(media_fd, &t, desc) < 0)
+			goto out;
+		step_done(&steps, "Topology enumeration");
+	}
+
+	ret = topology_apply(media_fd, &t, desc, cfg, &steps);
+	if (ret == 0 && !cached) {
+		if (topology_save(&t) < 0)
+			printf("Cannot write %s: %s\n", CSI_TOPOLOGY_CACHE, strerror(errno));
+		step_done(&steps, "Topology cache save");
+	}
+
+	if (ret == 0 && video_devname[0] == '\0')
+		strncpy(video_devname, t.entities[CSI_ENT_CAPTURE].devname, video_devname_len - 1);
+
+	print_steps(&steps);
+out:
+	close(media_fd);
+	return ret;
+}
+
+/*
+ * Only the IPU side of the pipeline is touched: the ADV7481 entities keep
+ * their configuration, the sensor keeps running and the links to it stay up.
+ */
+int csi_topology_reset_ipu(const char *media_node, const struct csi_pipeline_cfg *cfg)
+{
+	struct csi_topology key, t;
+	struct media_entity_desc desc[CSI_ENT_COUNT];
+	int media_fd, csi2_fd = -1, be_fd = -1, ret = -1;
+
+	media_fd = open(media_node, O_RDWR | O_CLOEXEC);
+	if (media_fd < 0) {
+		printf("Cannot open media device %s\n", media_node);
+		return -1;
+	}
+	if (topology_key(&key, media_fd) < 0)
+		goto out;
+
+	if (topology_load(&t, &key) < 0 || topology_validate(media_fd, &t, desc) < 0) {
+		t = key;
+		if (topology_resolve(media_node, &t) < 0
+				|| topology_validate(media_fd, &t, desc) < 0)
+			goto out;
+	}
+
+	csi2_fd = open(t.entities[CSI_ENT_CSI2].devname, O_RDWR | O_CLOEXEC);
+	be_fd = open(t.entities[CSI_ENT_BE_SOC].devname, O_RDWR | O_CLOEXEC);
+	if (csi2_fd < 0 || be_fd < 0) {
+		printf("Cannot open IPU subdevs: %s\n", strerror(errno));
+		goto out;
+	}
+
+	subdev_setup_routing(be_fd);
+	if (subdev_set_fmt(csi2_fd, 0, cfg->out_w, cfg->out_h, cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(be_fd, 0, cfg->out_w, cfg->out_h, cfg->code, cfg->interlaced) < 0
+			|| subdev_set_fmt(be_fd, 8, cfg->out_w, cfg->out_h, cfg->code, cfg->interlaced) < 0) {
+		printf("Cannot reset IPU formats: %s\n", strerror(errno));
+		goto out;
+	}
+
+	/* The links behind the CSI-2 receiver are the dynamic ones. */
+	ret = topology_enable_links(media_fd, &t, desc, 2);
+
+out:
+	if (csi2_fd >= 0)
+		close(csi2_fd);
+	if (be_fd >= 0)
+		close(be_fd);
+	close(media_fd);
+	return ret;
+}
@@ -35,8 +35,10 @@ typedef unsigned char __u8;
 #include "ici.h"
 #include "icitest_common.h"
 
-int iciStartDisplay(struct setup, int, int, void*, int*);
+int iciStartDisplay(struct setup, int, int, int*);
 void iciStopDisplay(int);
+/* Destroys the renderer kept between iciStartDisplay() calls. */
+void iciReleaseDisplay(void);
 
 int initWlConnection(void);
 int disconnectWlConnection(void);
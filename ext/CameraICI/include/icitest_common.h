@@ -31,6 +31,8 @@
 #include <stdlib.h>
 #include <stdarg.h>
 
+#include "gl_deinterlace.h"
+
 #define BATCH_SIZE 0x80000
 
 enum input {
@@ -52,9 +54,11 @@ struct setup {
 	unsigned int port;
 	unsigned int fullscreen;
 	unsigned int interlaced;
+	enum deinterlace_mode deinterlace;
 	unsigned int frames_count;
 	enum input stream_input;
 	int mem_type;
+	void *capture;		/* CaptureSession the frames come from */
 };
 
 #if 1
@@ -63,7 +67,6 @@ extern int first_frame_rendered;
 
 extern int running;
 
-extern struct timeval *curr_time, *prev_time;
 #endif
 
 #define _ISP_MODE_PREVIEW       0x8000
@@ -28,29 +28,8 @@
 #define ICITEST_STREAM_H
 
 #define BUFFER_COUNT 4
+/* pending top field + mailbox pair + on screen pair + two in the driver */
+#define BUFFER_COUNT_INTERLACED 7
 #define DEFAULT_STREAM_ID 9 
 
-#include "ici.h"
-#include <EGL/egl.h>
-#include <EGL/eglext.h>
-
-#include "icitest_graph.h"
-
-extern struct ici_stream_format stream_fmt;
-extern unsigned long buffer_size;
-
-int open_device(const char* dev_name);
-void close_device(int dev_fd);
-int init_stream(int dev_fd);
-int allocate_buffers(struct buffer* buffers, unsigned long buffer_size,
-		int buffer_count, int mem_type, struct display* display);
-void free_buffers(struct buffer* buffers, int n_buffers, int mem_type);
-
-int queue_buffer(int dev_fd, struct buffer* buffers, int mem_type);
-int queue_buffers(int dev_fd, int buffer_count,
-		struct buffer* buffers, int mem_type);
-int dequeue_buffer(int dev_fd, int mem_type, int *is_top);
-int stream_on(int dev_fd);
-void cleanup(int fd);
-
 #endif /*ICITEST_STREAM_H*/
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <linux/input.h>
 #include <sys/mman.h>
@@ -41,103 +42,78 @@
 #include "ici.h"
 #include "icitest.h"
 #include "icitest_time.h"
-#include "icitest_graph.h"
 #include "icitest_stream.h"
+#include "CaptureSession.h"
+#include "camera_renderer.h"
+#include "capture_loop.h"
 
 int first_frame_received = 0;
 int first_frame_rendered = 0;
 
 int running = 1;
 
-struct timeval *curr_time, *prev_time;
-
 int pixelformat;
 
 int stream_id=-1;
 int m_ICIEnabled = 1;
 struct wl_display *g_display_connection = NULL;
-struct ici_stream_format stream_fmt;
+static struct ici_stream_format stream_fmt;
+static int capture_stop_fd = -1;
+
+/*
+ * The renderer outlives an RVC session. The Wayland surface, the EGL context,
+ * the capture buffers and their textures are set up on the first entry, a
+ * session end only streams off and unmaps the surface, so entering again
+ * costs one frame. iciReleaseDisplay() tears everything down.
+ */
+static struct setup g_setup;
+static struct camera_renderer g_renderer;
+static int g_renderer_ready = 0;
 
 static void polling_thread(void *data)
 {
-	struct display *display = (struct display *)data;
-	struct pollfd fd;
-	unsigned int received_frames;
-	unsigned int total_received_frames;
-	struct timeval prev_time_th, curr_time_th;
-	struct timeval time_diff;
-	struct timeval tmp;
-	float time_diff_secs;
-	int is_topbuf = 1;
-	int prev_top_idx = -1;
-	fd.fd = display->strm_fd;
-	fd.events = POLLIN;
-
-	gettimeofday(&prev_time_th, NULL);
-	received_frames = 0;
-	total_received_frames = 0;
+	struct camera_renderer *r = (struct camera_renderer *)data;
+	struct capture_events events;
+	struct capture_stats stats;
+	struct capture_frame captured;
+	int mask, buf_idx;
+
+	if (capture_events_init(&events, CaptureSession_fd(r->capture), capture_stop_fd) < 0) {
+		fprintf(stderr, "Cannot set up capture events\n");
+		return;
+	}
+
+	capture_stats_init(&stats, frame_mailbox_now_ns());
 	while(running) {
-		if(poll(&fd, 1, 5000) > 0) {
-			if(fd.revents & POLLIN) {
-				int buf_idx = dequeue_buffer(fd.fd, display->s->mem_type,
-						&is_topbuf);
-
-				if(buf_idx > display->s->buffer_count || buf_idx < 0)
-				{
-					fprintf(stderr,"Failed to Deque Buffer\n");
-					break;
-				}
-
-				display->buffers[buf_idx].is_top = is_topbuf;
-				if(display->s->interlaced){
-					if(is_topbuf)
-						prev_top_idx = buf_idx;
-					else {
-						if(prev_top_idx < 0)
-							printf("***Warning Top buffer not received ****\n");
-						else {
-							display->disp_bufs[0] = &display->buffers[prev_top_idx];
-							display->disp_bufs[1] = &display->buffers[buf_idx];
-							prev_top_idx=-1;
-						}
-					}
-				} else {
-						display->disp_bufs[0] = &display->buffers[buf_idx];
-				}
-				queue_buffer(fd.fd, &display->buffers[buf_idx],
-						display->s->mem_type);
-				if (first_frame_received == 0) {
-					first_frame_received = 1;
-					GET_TS(time_measurements.first_frame_time);
-				}
-
-				received_frames++;
-				total_received_frames++;
-				if (display->s->frames_count != 0 &&
-						total_received_frames >= display->s->frames_count) {
-					running = 0;
-				}
-				gettimeofday(&curr_time_th, NULL);
-				timersub(&curr_time_th, &prev_time_th, &time_diff);
-				time_diff_secs = (time_diff.tv_sec * 1000 +
-						time_diff.tv_usec / 1000) / 1000;
-
-				if (time_diff_secs >= TARGET_NUM_SECONDS) {
-					fprintf(stdout, "Received %d frames from IPU in %6.3f seconds = %6.3f FPS\n",
-							received_frames, time_diff_secs, received_frames / time_diff_secs);
-					fflush(stdout);
-
-					received_frames = 0;
-
-					tmp = prev_time_th;
-					prev_time_th = curr_time_th;
-					curr_time_th = tmp;
-				}
+		mask = capture_events_wait(&events, 5000);
+		if (mask < 0)
+			break;
+
+		if(mask & CAPTURE_EVENT_FRAME) {
+			buf_idx = CaptureSession_dequeue(r->capture, &captured);
+
+			/* Spurious wakeup or a frame dropped without a free buffer. */
+			if(buf_idx < 0)
+				continue;
+
+			capture_stats_frame(&stats, captured.timestamp_ns, captured.sequence);
+			camera_renderer_capture(r, buf_idx, &captured);
+			if (first_frame_received == 0) {
+				first_frame_received = 1;
+				GET_TS(time_measurements.first_frame_time);
+			}
+
+			if (g_setup.frames_count != 0 &&
+					stats.total_frames >= g_setup.frames_count) {
+				running = 0;
 			}
 		}
+		capture_stats_report(&stats, "IPU", frame_mailbox_now_ns());
 	}
-}
 
+	camera_renderer_drop_fields(r);
+	capture_events_close(&events);
+}
 
 void format_setup(struct setup *s)
 {
@@ -205,7 +181,7 @@ void format_setup(struct setup *s)
 	}
 	s->iw = stream_fmt.ffmt.width;
 	s->ih = stream_fmt.ffmt.height;
-	s->buffer_count = 4;
+	s->buffer_count = s->interlaced ? BUFFER_COUNT_INTERLACED : BUFFER_COUNT;
 	s->in_fourcc = stream_fmt.ffmt.pixelformat;
 }
 
@@ -230,128 +206,135 @@ int disconnectWlConnection(void)
 	return 0;
 }
 
-int iciStartDisplay(struct setup param, int io_stream_id, int start, void *gpioclass, int *ici_rdy)
+/* Renderer callback, the first frame is on screen. */
+static void ici_first_frame(void)
 {
-	GET_TS(time_measurements.app_start_time);
+	first_frame_rendered = 1;
+	GET_TS(time_measurements.first_frame_rendered_time);
+	print_time_measurements();
+}
+
+static enum camera_format ici_camera_format(unsigned int fourcc)
+{
+	switch (fourcc) {
+	case ICI_FORMAT_UYVY:
+		return CAMERA_FORMAT_UYVY;
+	case ICI_FORMAT_YUYV:
+		return CAMERA_FORMAT_YUYV;
+	case ICI_FORMAT_RGB565:
+		return CAMERA_FORMAT_RGB565;
+	case ICI_FORMAT_SGRBG8:
+		return CAMERA_FORMAT_SGRBG8;
+	default:
+		return CAMERA_FORMAT_RGB888;
+	}
+}
+
+/* Opens the stream and hands its buffers to the renderer, once. */
+static int capture_init(struct setup *s, int io_stream_id, int *ici_rdy)
+{
+	struct capture_config config;
+	struct camera_renderer_config renderer;
+	const struct capture_format *format;
 
-	struct setup s = param;
-	struct display display = { 0 };
-	struct window  window  = { 0 };
-	int ret = 0;
-	pthread_t poll_thread;
-	struct stat tmp;
-	char wayland_path[255];
-	unsigned long buf_size = 0;
-	int dev_fd;
 	/* if ici still not ready let us wait it till ready*/
 	/* with new earlyapp-fastboot, ipu4 modules will finish init
 	 * in 950ms after kernel start
 	 * */
-	if (!(*ici_rdy))
+	if (CaptureSession_hardware(s->capture) && !(*ici_rdy))
 		*ici_rdy = ConfigureICI(true);
 
 	stream_id = io_stream_id;
-	format_setup(&s);
-
-	/* open the device */
-	dev_fd = open_device(s.stream);
-	if(dev_fd == -1)
-	{
-		fprintf(stderr,"Failed to open device");
-		return 0;
-	}
-
-	/* Do any specific intilization */
-	ret = init_stream(dev_fd);
-	if(ret) {
-		close_device(dev_fd);
+	format_setup(s);
+
+	/* open the device, set the format, allocate and queue the buffers */
+	memset(&config, 0, sizeof(config));
+	strncpy(config.device, s->stream, sizeof(config.device) - 1);
+	config.width = stream_fmt.ffmt.width;
+	config.height = stream_fmt.ffmt.height;
+	config.fourcc = stream_fmt.ffmt.pixelformat;
+	config.bytes_per_pixel = (config.fourcc == ICI_FORMAT_UYVY ||
+			config.fourcc == ICI_FORMAT_YUYV) ? 2 : 4;
+	config.bytes_per_line = stream_fmt.pfmt.plane_fmt[0].bytesperline;
+	config.buffer_count = s->buffer_count;
+	config.interlaced = s->interlaced;
+	config.memory = (s->mem_type == ICI_MEM_DMABUF && CaptureSession_hardware(s->capture)) ?
+		CAPTURE_MEMORY_GEM : CAPTURE_MEMORY_USERPTR;
+	if (CaptureSession_start(s->capture, &config) < 0) {
 		fprintf(stderr,"Stream Init Failed\n");
-		return 0;
+		return -1;
 	}
 
-    s.stride_width = stream_fmt.pfmt.plane_fmt[0].bytesperline /
-		(stream_fmt.pfmt.plane_fmt[0].bpp >> 3);
-
-	/* Setup Buffers */
-	struct buffer buffers[s.buffer_count];
-	memset(buffers, 0, sizeof(struct buffer) * s.buffer_count);
-
-	if (s.mem_type == ICI_MEM_DMABUF)
-		init_gem(&display);
-
-	buf_size = stream_fmt.pfmt.plane_fmt[0].sizeimage;
-	printf("bufsize: %lu\n", buf_size);
-	allocate_buffers(buffers, buf_size, s.buffer_count, s.mem_type, &display);
+	format = CaptureSession_format(s->capture);
+	s->stride_width = format->bytes_per_line / format->bytes_per_pixel;
+	printf("bufsize: %u\n", format->size);
+
+	memset(&renderer, 0, sizeof(renderer));
+	renderer.title = "icitest";
+	renderer.name = "ici camera";
+	renderer.width = s->ow;
+	renderer.height = s->oh;
+	renderer.fullscreen = s->fullscreen;
+	renderer.render_type = RENDER_TYPE_GL;
+	renderer.format = ici_camera_format(s->in_fourcc);
+	renderer.iw = s->iw;
+	renderer.ih = s->ih;
+	renderer.stride_width = s->stride_width;
+	renderer.deinterlace = s->interlaced ? s->deinterlace : DEINTERLACE_NONE;
+	renderer.first_frame = ici_first_frame;
+	if (camera_renderer_init(&g_renderer, s->capture, &renderer) < 0) {
+		CaptureSession_stop(s->capture);
+		return -1;
+	}
+	return 0;
+}
 
-	window.display = &display;
-	display.window = &window;
-	window.window_size.width  = s.ow;
-	window.window_size.height = s.oh;
-	window.fullscreen = s.fullscreen;
-	window.output = 0;
-	window.print_fps = 1;
-	display.s = &s;
-	display.strm_fd = dev_fd;
-	display.buffers = buffers;
+int iciStartDisplay(struct setup param, int io_stream_id, int start, int *ici_rdy)
+{
+	GET_TS(time_measurements.app_start_time);
 
-	/* IPU4_ICI Prepare for streaming */
-	if(queue_buffers(dev_fd, s.buffer_count, buffers, s.mem_type) < 0)
-		goto cleanup0;
+	struct camera_renderer *r = &g_renderer;
+	int ret = 0;
+	pthread_t poll_thread;
 
-	if(stream_on(dev_fd) < 0)
-		goto cleanup0;
+	if (!g_renderer_ready) {
+		g_setup = param;
+		if (capture_init(&g_setup, io_stream_id, ici_rdy) < 0)
+			return 0;
+	} else if (CaptureSession_requeue(r->capture) < 0) {
+		fprintf(stderr, "Cannot restart streaming\n");
+		return 0;
+	}
 
 	running = start;
 	GET_TS(time_measurements.streamon_time);
 
+	if (capture_stop_fd < 0) {
+		capture_stop_fd = capture_wakeup_fd();
+		WARN_ON(capture_stop_fd < 0, "Cannot create capture wakeup: %s\n", ERRSTR);
+	}
+	r->wakeup_fd = capture_stop_fd;
+
 	/* IPU4_ICI Start Streaming*/
 	if(pthread_create(&poll_thread, NULL,
-				(void *) &polling_thread, (void *) &display)) {
+				(void *) &polling_thread, (void *) r)) {
 		printf("Couldn't create polling thread\n");
 	}
 
-	snprintf(wayland_path, 255, "%s/wayland-0", getenv("XDG_RUNTIME_DIR"));
-	while (stat(wayland_path, &tmp) != 0) {
-		usleep(100);
-	}
-
 	GET_TS(time_measurements.weston_init_time);
-
-	display.display = g_display_connection;
-	assert(display.display);
-	wl_list_init(&display.output_list);
-
-	display.registry = wl_display_get_registry(display.display);
-	wl_registry_add_listener(display.registry,
-			&registry_listener, &display);
-
-	wl_display_dispatch(display.display);
-	wl_display_roundtrip(display.display);
-
-	init_egl(&display, window.opaque);
-	create_surface(&window, gpioclass);
-	init_gl(&window);
-
-	GET_TS(time_measurements.rendering_init_time);
-
-	prev_time = calloc(1, sizeof(struct timeval));
-	if(!prev_time) {
-		fprintf(stderr, "Cannot allocate memory: %m\n");
-		return 0;
-	}
-
-	curr_time = calloc(1, sizeof(struct timeval));
-	if(!curr_time) {
-		fprintf(stderr, "Cannot allocate memory: %m\n");
-		return 0;
+	if (!g_renderer_ready) {
+		camera_renderer_connect(r, g_display_connection);
+		g_renderer_ready = 1;
+	} else {
+		camera_renderer_show(r);
 	}
 
-	gettimeofday(prev_time, NULL);
+	GET_TS(time_measurements.rendering_init_time);
 
 	/* Main display loop */
 
 	while (running && ret != -1) {
-		ret = wl_display_dispatch(display.display);
+		ret = wl_display_dispatch(r->display);
 	}
 
 	fprintf(stderr, "\nici-test exiting\n");
@@ -359,33 +342,22 @@ int iciStartDisplay(struct setup param, int io_stream_id, int start, void *gpioc
 
 	pthread_join(poll_thread, NULL);
 
-	free(curr_time);
-	free(prev_time);
-
-	cleanup(dev_fd);
-
-cleanup0:
-	free_buffers(buffers, s.buffer_count, s.mem_type);
+	camera_renderer_hide(r);
 
-	if (s.mem_type == ICI_MEM_DMABUF)
-		destroy_gem(&display);
-
-	destroy_surface(&window);
-
-	close_device(dev_fd);
-
-	wl_shell_destroy(display.wl_shell);
-	printf("WL_SHELL destroy\n");
-
-	printf("WL_COMPOSITOR destroy\n");
-	wl_compositor_destroy(display.compositor);
+	return 0;
+}
 
-	wl_display_flush(display.display);
+void iciReleaseDisplay(void)
+{
+	if (!g_renderer_ready)
+		return;
 
-	return 0;
+	camera_renderer_fini(&g_renderer);
+	g_renderer_ready = 0;
 }
 
 void iciStopDisplay(int stop)
 {
 	running = stop;
+	capture_wakeup(capture_stop_fd);
 }
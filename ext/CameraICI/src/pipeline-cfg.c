@@ -27,14 +27,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
 #include <fcntl.h>	/* low-level i/o */
 #include <unistd.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <sys/ioctl.h>
+#include <sys/utsname.h>
 #include <asm/types.h>
 #include <stdbool.h>
 
@@ -595,25 +601,368 @@ void parse_args(char argc, char *strtext)
 	}
 }
 
+/*
+ * Topology cache.
+ *
+ * The node IDs of the CVBS pipeline are stored in a small binary file. It
+ * is keyed by the kernel release, the driver and modalias of the pipeline
+ * device and a hash of the ID, pad count and name of every node, so a cache
+ * written for another driver, sensor or graph is never applied. The key is
+ * taken with one pass over the nodes, which also finds the pipeline nodes.
+ */
+#define ICI_TOPOLOGY_CACHE_DIR	"/var/lib/earlyapp"
+#define ICI_TOPOLOGY_CACHE	ICI_TOPOLOGY_CACHE_DIR "/ici_topology.bin"
+#define ICI_TOPOLOGY_MAGIC	0x50544949	/* "IITP" */
+#define ICI_TOPOLOGY_VERSION	2
+
+#define ICI_CVBS_WIDTH		720
+#define ICI_CVBS_HEIGHT		288
+
+enum ici_topology_node {
+	ICI_NODE_PIXEL_ARRAY,
+	ICI_NODE_BINNER,
+	ICI_NODE_CSI2,
+	ICI_NODE_BE_SOC,
+	ICI_NODE_STREAM,
+	ICI_NODE_COUNT
+};
+
+static const char *ici_node_names[ICI_NODE_COUNT] = {
+	[ICI_NODE_PIXEL_ARRAY] = "adv7481 cvbs pixel array",
+	[ICI_NODE_BINNER] = "adv7481 cvbs binner",
+	[ICI_NODE_CSI2] = "Intel IPU4 CSI-2 4 VC 0",
+	[ICI_NODE_BE_SOC] = "Intel IPU4 CSI2 BE SOC 0",
+	[ICI_NODE_STREAM] = "Intel IPU4 CSI2 BE SOC 0 Stream",
+};
+
+static const struct {
+	enum ici_topology_node node;
+	unsigned int pad;
+} ici_pipeline_formats[] = {
+	{ ICI_NODE_BE_SOC, 0 },
+	{ ICI_NODE_BE_SOC, 1 },
+	{ ICI_NODE_CSI2, 0 },
+	{ ICI_NODE_CSI2, 1 },
+	{ ICI_NODE_BINNER, 0 },
+	{ ICI_NODE_BINNER, 1 },
+	{ ICI_NODE_PIXEL_ARRAY, 0 },
+};
+
+static const struct {
+	enum ici_topology_node source;
+	unsigned int source_pad;
+	enum ici_topology_node sink;
+	unsigned int sink_pad;
+} ici_pipeline_links[] = {
+	{ ICI_NODE_PIXEL_ARRAY, 0, ICI_NODE_BINNER, 0 },
+	{ ICI_NODE_BINNER, 1, ICI_NODE_CSI2, 0 },
+	{ ICI_NODE_CSI2, 1, ICI_NODE_BE_SOC, 0 },
+	{ ICI_NODE_BE_SOC, 1, ICI_NODE_STREAM, 0 },
+};
+
+struct ici_topology {
+	uint32_t magic;
+	uint32_t version;
+	char kernel[65];
+	char driver[32];
+	char modalias[64];
+	uint32_t node_count;
+	uint32_t nodes_hash;
+	int32_t node_id[ICI_NODE_COUNT];
+	uint32_t checksum;
+};
+
+struct ici_topology_steps {
+	unsigned int count;
+	const char *name[6];
+	double ms[6];
+	struct timespec last;
+};
+
+static void ici_step_done(struct ici_topology_steps *steps, const char *name)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (steps->count < ARRAY_SIZE(steps->name)) {
+		steps->name[steps->count] = name;
+		steps->ms[steps->count] = (now.tv_sec - steps->last.tv_sec) * 1000.0
+			+ (now.tv_nsec - steps->last.tv_nsec) / 1000000.0;
+		steps->count++;
+	}
+	steps->last = now;
+}
+
+static uint32_t ici_fnv1a(uint32_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t ici_topology_checksum(const struct ici_topology *t)
+{
+	return ici_fnv1a(2166136261u, t, offsetof(struct ici_topology, checksum));
+}
+
+/* Reads the driver name and modalias of the pipeline device from sysfs. */
+static void ici_topology_device(struct ici_topology *t)
+{
+	char path[128], link[PATH_MAX];
+	struct stat st;
+	const char *base;
+	ssize_t len;
+	int sys_fd;
+
+	if (fstat(fd, &st) < 0)
+		return;
+
+	snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/device/driver",
+		major(st.st_rdev), minor(st.st_rdev));
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len > 0) {
+		link[len] = '\0';
+		base = strrchr(link, '/');
+		strncpy(t->driver, base ? base + 1 : link, sizeof(t->driver) - 1);
+	}
+
+	snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/device/modalias",
+		major(st.st_rdev), minor(st.st_rdev));
+	sys_fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (sys_fd >= 0) {
+		len = read(sys_fd, t->modalias, sizeof(t->modalias) - 1);
+		close(sys_fd);
+		if (len > 0 && t->modalias[len - 1] == '\n')
+			t->modalias[len - 1] = '\0';
+	}
+}
+
+/*
+ * Builds the cache key, enumerating every node once. The IDs of the
+ * pipeline nodes found on the way are returned in @node_id, -1 if missing.
+ */
+static int ici_topology_key(struct ici_topology *t, int32_t *node_id)
+{
+	struct ici_node_desc node = {0};
+	struct utsname uts;
+	unsigned int i;
+	int n;
+
+	memset(t, 0, sizeof(*t));
+	t->magic = ICI_TOPOLOGY_MAGIC;
+	t->version = ICI_TOPOLOGY_VERSION;
+	if (uname(&uts) < 0)
+		return -1;
+	strncpy(t->kernel, uts.release, sizeof(t->kernel) - 1);
+	ici_topology_device(t);
+
+	node.node_id = -1;
+	if (xioctl(fd, ICI_IOC_ENUM_NODES, &node) < 0)
+		return -1;
+	t->node_count = node.node_count;
+
+	for (n = 0; n < ICI_NODE_COUNT; n++)
+		node_id[n] = -1;
+	t->nodes_hash = 2166136261u;
+	for (i = 0; i < t->node_count; i++) {
+		memset(&node, 0, sizeof(node));
+		node.node_id = i;
+		if (xioctl(fd, ICI_IOC_ENUM_NODES, &node) < 0)
+			return -1;
+		node.name[sizeof(node.name) - 1] = '\0';
+		t->nodes_hash = ici_fnv1a(t->nodes_hash, &node.node_id, sizeof(node.node_id));
+		t->nodes_hash = ici_fnv1a(t->nodes_hash, &node.nr_pads, sizeof(node.nr_pads));
+		t->nodes_hash = ici_fnv1a(t->nodes_hash, node.name, strlen(node.name));
+
+		for (n = 0; n < ICI_NODE_COUNT; n++)
+			if (node_id[n] < 0 && strcmp(node.name, ici_node_names[n]) == 0)
+				node_id[n] = node.node_id;
+	}
+	return 0;
+}
+
+/* Loads the cache, valid if the key matches and the node IDs are the found ones. */
+static int ici_topology_load(struct ici_topology *t, const struct ici_topology *key,
+		const int32_t *node_id)
+{
+	ssize_t len;
+	int cache_fd;
+
+	cache_fd = open(ICI_TOPOLOGY_CACHE, O_RDONLY | O_CLOEXEC);
+	if (cache_fd < 0)
+		return -1;
+	len = read(cache_fd, t, sizeof(*t));
+	close(cache_fd);
+
+	if (len != (ssize_t)sizeof(*t)
+			|| t->checksum != ici_topology_checksum(t)
+			|| memcmp(t, key, offsetof(struct ici_topology, node_id)) != 0
+			|| memcmp(t->node_id, node_id, sizeof(t->node_id)) != 0)
+		return -1;
+	return 0;
+}
+
+static int ici_topology_resolve(struct ici_topology *t, const int32_t *node_id)
+{
+	int n;
+
+	for (n = 0; n < ICI_NODE_COUNT; n++) {
+		t->node_id[n] = node_id[n];
+		if (t->node_id[n] < 0) {
+			fprintf(stderr, "Cannot find node %s\n", ici_node_names[n]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int ici_topology_save(struct ici_topology *t)
+{
+	char tmp_path[] = ICI_TOPOLOGY_CACHE ".XXXXXX";
+	int cache_fd;
+
+	t->checksum = ici_topology_checksum(t);
+
+	if (mkdir(ICI_TOPOLOGY_CACHE_DIR, 0755) < 0 && errno != EEXIST)
+		return -1;
+
+	cache_fd = mkstemp(tmp_path);
+	if (cache_fd < 0)
+		return -1;
+	if (write(cache_fd, t, sizeof(*t)) != (ssize_t)sizeof(*t) || fsync(cache_fd) < 0) {
+		close(cache_fd);
+		unlink(tmp_path);
+		return -1;
+	}
+	close(cache_fd);
+
+	if (rename(tmp_path, ICI_TOPOLOGY_CACHE) < 0) {
+		unlink(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Enables a pipeline link unless it is already active. Other enabled links
+ * leaving the same source pad are reset, they would feed a second sink.
+ */
+static int ici_topology_link(const struct ici_topology *t, unsigned int l)
+{
+	static struct ici_links_query query;
+	struct ici_link_desc link = {0};
+	int i, active = 0;
+
+	memset(&query, 0, sizeof(query));
+	query.pad.node_id = t->node_id[ici_pipeline_links[l].source];
+	query.pad.pad_idx = ici_pipeline_links[l].source_pad;
+	if (xioctl(fd, ICI_IOC_ENUM_LINKS, &query) < 0)
+		return -1;
+
+	for (i = 0; i < query.links_cnt && i < ICI_MAX_LINKS; i++) {
+		if (!(query.links[i].flags & ICI_LINK_FLAG_ENABLED)
+				|| (query.links[i].flags & ICI_LINK_FLAG_BACKLINK))
+			continue;
+		if (query.links[i].sink.node_id == (__u32)t->node_id[ici_pipeline_links[l].sink]
+				&& query.links[i].sink.pad_idx == ici_pipeline_links[l].sink_pad) {
+			active = 1;
+		} else {
+			query.links[i].flags = 0;
+			if (xioctl(fd, ICI_IOC_SETUP_PIPE, &query.links[i]) < 0)
+				return -1;
+		}
+	}
+	if (active)
+		return 0;
+
+	link.source.node_id = t->node_id[ici_pipeline_links[l].source];
+	link.source.pad_idx = ici_pipeline_links[l].source_pad;
+	link.sink.node_id = t->node_id[ici_pipeline_links[l].sink];
+	link.sink.pad_idx = ici_pipeline_links[l].sink_pad;
+	link.flags = ICI_LINK_FLAG_ENABLED;
+	return xioctl(fd, ICI_IOC_SETUP_PIPE, &link);
+}
+
+static int ici_topology_apply(const struct ici_topology *t, struct ici_topology_steps *steps)
+{
+	struct ici_pad_framefmt pad_ffmt;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(ici_pipeline_formats); i++) {
+		memset(&pad_ffmt, 0, sizeof(pad_ffmt));
+		pad_ffmt.pad.node_id = t->node_id[ici_pipeline_formats[i].node];
+		pad_ffmt.pad.pad_idx = ici_pipeline_formats[i].pad;
+		pad_ffmt.ffmt.width = ICI_CVBS_WIDTH;
+		pad_ffmt.ffmt.height = ICI_CVBS_HEIGHT;
+		pad_ffmt.ffmt.pixelformat = ICI_FORMAT_UYVY;
+		pad_ffmt.ffmt.field = ICI_FIELD_NONE;
+		if (xioctl(fd, ICI_IOC_SET_FRAMEFMT, &pad_ffmt) < 0) {
+			fprintf(stderr, "Cannot set format on %s:%u\n",
+				ici_node_names[ici_pipeline_formats[i].node],
+				ici_pipeline_formats[i].pad);
+			return -1;
+		}
+	}
+	ici_step_done(steps, "Formats");
+
+	for (i = 0; i < ARRAY_SIZE(ici_pipeline_links); i++) {
+		if (ici_topology_link(t, i) < 0) {
+			fprintf(stderr, "Cannot set link %s:%u -> %s:%u\n",
+				ici_node_names[ici_pipeline_links[i].source],
+				ici_pipeline_links[i].source_pad,
+				ici_node_names[ici_pipeline_links[i].sink],
+				ici_pipeline_links[i].sink_pad);
+			return -1;
+		}
+	}
+	ici_step_done(steps, "Links");
+	return 0;
+}
+
 int ConfigureICI(bool w4pipline)
 {
 	// this configuration is for GP2.0 ici
-    if(open_pipe_device(w4pipline))
-    {
-        parse_args('r',"");
-        parse_args('f',"Intel IPU4 CSI2 BE SOC 0:0 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"Intel IPU4 CSI2 BE SOC 0:1 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"Intel IPU4 CSI-2 4 VC 0:0 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"Intel IPU4 CSI-2 4 VC 0:1 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"adv7481 cvbs binner:0 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"adv7481 cvbs binner:1 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('f',"adv7481 cvbs pixel array:0 [ffmt:720x288,ICI_FORMAT_UYVY,ICI_FIELD_NONE,0,0]");
-        parse_args('l',"adv7481 cvbs pixel array:0 adv7481 cvbs binner:0 [enabled]");
-        parse_args('l',"adv7481 cvbs binner:1 Intel IPU4 CSI-2 4 VC 0:0 [enabled]");
-        parse_args('l',"Intel IPU4 CSI-2 4 VC 0:1 Intel IPU4 CSI2 BE SOC 0:0 [enabled]");
-        parse_args('l',"Intel IPU4 CSI2 BE SOC 0:1 Intel IPU4 CSI2 BE SOC 0 Stream:0 [enabled]");
-        return 1;
-    }
+	struct ici_topology key, t;
+	struct ici_topology_steps steps;
+	int32_t node_id[ICI_NODE_COUNT];
+	unsigned int i;
+	int cached;
 
-	return 0;
+	memset(&steps, 0, sizeof(steps));
+	clock_gettime(CLOCK_MONOTONIC, &steps.last);
+
+	if(!open_pipe_device(w4pipline))
+		return 0;
+	ici_step_done(&steps, "Pipeline device open");
+
+	if (ici_topology_key(&key, node_id) < 0)
+		return 0;
+	ici_step_done(&steps, "Topology enumeration");
+
+	cached = ici_topology_load(&t, &key, node_id) == 0;
+	ici_step_done(&steps, "Topology cache load");
+	if (!cached) {
+		t = key;
+		if (ici_topology_resolve(&t, node_id) < 0)
+			return 0;
+	}
+
+	if (ici_topology_apply(&t, &steps) < 0)
+		return 0;
+
+	if (!cached) {
+		if (ici_topology_save(&t) < 0)
+			fprintf(stderr, "Cannot write %s: %s\n", ICI_TOPOLOGY_CACHE, strerror(errno));
+		ici_step_done(&steps, "Topology cache save");
+	}
+
+	printf("ICI PIPELINE SETUP\n");
+	for (i = 0; i < steps.count; i++)
+		printf("%-25s | %6.02f ms\n", steps.name[i], steps.ms[i]);
+	return 1;
 }
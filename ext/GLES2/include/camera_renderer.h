@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CAMERA_RENDERER_H
+#define CAMERA_RENDERER_H
+
+#include <stdint.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <wayland-client.h>
+
+#include "CaptureSession.h"
+#include "frame_mailbox.h"
+#include "gl_deinterlace.h"
+#include "gl_dmabuf_image.h"
+#include "render_stats.h"
+#include "shm_pool.h"
+#include "sw_convert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Renderer of the ICI and CSI camera engines. It shows the frames of a
+ * capture session in a Wayland surface: the engine's polling thread hands
+ * every dequeued buffer to camera_renderer_capture(), which pairs fields
+ * and publishes frames in the mailbox, and the thread dispatching the
+ * Wayland display draws the newest one on each frame callback, then gives
+ * the buffers of the frame it replaced back to the session.
+ *
+ * The renderer outlives a camera session. The surface, the EGL context and
+ * the textures of the capture buffers are created once by
+ * camera_renderer_connect(), camera_renderer_hide() only unmaps the surface
+ * and camera_renderer_show() maps it again with the next frame.
+ */
+enum render_type {
+	RENDER_TYPE_WL,		/* capture buffers attached as wl_drm buffers */
+	RENDER_TYPE_GL,		/* frames uploaded into textures */
+	RENDER_TYPE_GL_DMA,	/* capture buffers sampled in place */
+	RENDER_TYPE_SHM,	/* CPU conversion into wl_shm buffers */
+};
+
+/* Pixel layout of the capture buffers. */
+enum camera_format {
+	CAMERA_FORMAT_UYVY,
+	CAMERA_FORMAT_YUYV,
+	CAMERA_FORMAT_RGB888,	/* in 32 bit pixels */
+	CAMERA_FORMAT_RGB565,	/* in 32 bit pixels, 5 and 6 bit channels */
+	CAMERA_FORMAT_SGRBG8,	/* Bayer, GL only */
+};
+
+struct camera_renderer_config {
+	const char *title;		/* of the shell surface */
+	const char *name;		/* of the camera in the splash handoff */
+	unsigned int width, height;	/* of the window */
+	int fullscreen;
+	enum render_type render_type;	/* requested, see camera_renderer_connect() */
+	enum camera_format format;
+	unsigned int iw, ih;		/* shown pixels, one field high when interlaced */
+	unsigned int stride_width;	/* pixels per buffer line, iw or more */
+	enum deinterlace_mode deinterlace;
+	/* Called once the first captured frame is on screen, may be NULL. */
+	void (*first_frame)(void);
+};
+
+struct camera_buffer {
+	void *data;
+	unsigned int index;
+	int dbuf_fd;
+	uint32_t flink_name;
+	enum capture_field field;
+	uint64_t capture_ns;
+	uint32_t sequence;
+	struct wl_buffer *buf;		/* attached with RENDER_TYPE_WL */
+	struct gl_dmabuf_image gl;	/* sampled with RENDER_TYPE_GL_DMA */
+};
+
+struct camera_output {
+	struct wl_output *output;
+	struct wl_list link;
+};
+
+struct camera_renderer {
+	struct camera_renderer_config config;
+	void *capture;
+	int wakeup_fd;			/* of the polling thread, -1 for none */
+
+	struct camera_buffer *buffers;
+	unsigned int buffer_count;
+	struct frame_mailbox mailbox;
+	int pending_top;		/* polling thread only */
+	int last_field;			/* polling thread only */
+	int signal_lost;		/* the capture is recovering, the last frame stays up */
+	int capture_fault;		/* a buffer could not be queued, set by the renderer */
+	int first_frame_shown;
+
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct wl_compositor *compositor;
+	struct ias_shell *ias_shell;
+	struct wl_shell *wl_shell;
+	struct ivi_application *ivi_application;
+	struct wl_drm *wl_drm;
+	struct wl_shm *shm;
+	struct wl_list output_list;
+	struct {
+		EGLDisplay dpy;
+		EGLContext ctx;
+		EGLConfig conf;
+	} egl;
+
+	struct {
+		int width, height;
+	} geometry, window_size;
+	struct wl_surface *surface;
+	void *shell_surface;
+	struct ivi_surface *ivi_surface;
+	struct wl_egl_window *native;
+	EGLSurface egl_surface;
+	struct wl_callback *callback;
+	int configured;
+	int connected;
+
+	unsigned int frame_count;
+	uint64_t fps_start_ns;
+	struct render_stats render_stats;
+	struct shm_pool shm_pool;
+	struct sw_converter *converter;
+	enum sw_format sw_format;
+	struct {
+		GLuint program;
+		GLuint texture[2];	/* frames are uploaded into with RENDER_TYPE_GL */
+
+		GLint modelview_uniform;
+		GLint field_first;
+		GLint pos;
+		GLint attr_tex;
+
+		GLfloat hmi_vtx[12u];	/* coordinates of the vertices */
+		GLfloat hmi_tex[8u];	/* texture coordinates of the vertices */
+		GLubyte hmi_ind[6u];	/* vertices of the two triangles */
+		GLfloat model_view[16u];
+	} gl;
+};
+
+/*
+ * Takes the buffers of the started capture @session for a renderer drawn as
+ * @config says. Returns 0 or -1 when out of memory. Nothing is shown before
+ * camera_renderer_connect().
+ */
+int camera_renderer_init(struct camera_renderer *r, void *session,
+		const struct camera_renderer_config *config);
+
+/*
+ * Binds the globals of @display, waiting for the compositor, and creates
+ * the surface, the EGL context and the buffer textures, once. Without EGL
+ * GL rendering falls back to RENDER_TYPE_SHM, RENDER_TYPE_GL becomes
+ * RENDER_TYPE_GL_DMA when the buffers can be imported.
+ */
+void camera_renderer_connect(struct camera_renderer *r, struct wl_display *display);
+
+/* Picks the surface up again on the calling thread and draws into it. */
+void camera_renderer_show(struct camera_renderer *r);
+
+/*
+ * Streams off and unmaps the surface, keeping its buffers, the context and
+ * the textures. The frames on screen go back to the driver with the next
+ * requeue.
+ */
+void camera_renderer_hide(struct camera_renderer *r);
+
+/*
+ * Takes the buffer memory of the session again, after CaptureSession_restart(),
+ * and creates the wl_drm buffers or textures missing. Imports are kept for as
+ * long as the buffers are, showing a frame never imports or uploads anything.
+ */
+void camera_renderer_register_buffers(struct camera_renderer *r);
+/* Drops the wl_drm buffers and textures, before the buffers go away. */
+void camera_renderer_unregister_buffers(struct camera_renderer *r);
+
+/* Stops the capture and destroys everything but the Wayland connection. */
+void camera_renderer_fini(struct camera_renderer *r);
+
+/*
+ * Polling thread side. Takes the frame dequeued into buffer @index and
+ * publishes it, or keeps a top field until its bottom field arrives. At
+ * field rate with motion adaptive deinterlacing a field is shown by two
+ * consecutive frames.
+ */
+void camera_renderer_capture(struct camera_renderer *r, int index,
+		const struct capture_frame *frame);
+/* Gives back the fields held for the next frame, after a capture error or at the end. */
+void camera_renderer_drop_fields(struct camera_renderer *r);
+
+/*
+ * Drops a reference to buffer @index, the session gives it back to the
+ * driver with the last one. A buffer the driver refuses sets capture_fault
+ * and wakes the polling thread.
+ */
+void camera_renderer_put(struct camera_renderer *r, int index);
+/* Puts both fields of a mailbox frame. */
+void camera_renderer_release_frame(struct camera_renderer *r, uint32_t frame);
+
+static inline int camera_renderer_gl(const struct camera_renderer *r)
+{
+	return r->config.render_type == RENDER_TYPE_GL ||
+		r->config.render_type == RENDER_TYPE_GL_DMA;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAMERA_RENDERER_H */
@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CAPTURE_LOOP_H
+#define CAPTURE_LOOP_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+
+/*
+ * Event driven capture loop helpers.
+ *
+ * The capture thread sleeps in epoll on the video node and on an eventfd.
+ * Writing the eventfd wakes the thread at once, so stopping the stream does
+ * not wait for a poll timeout. Per frame statistics come from the driver
+ * timestamps and sequence numbers instead of the time the thread woke up.
+ */
+#define CAPTURE_EVENT_FRAME	0x1
+#define CAPTURE_EVENT_ERROR	0x2
+#define CAPTURE_EVENT_WAKEUP	0x4
+
+#define CAPTURE_REPORT_SECONDS	5
+#define CAPTURE_HIST_BINS	64	/* 1 ms bins, the last one collects the rest */
+
+struct capture_events {
+	int epoll_fd;
+	int video_fd;
+};
+
+/* Creates the eventfd used to wake capture threads, -1 on failure. */
+static inline int capture_wakeup_fd(void)
+{
+	return eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+/* Wakes the capture thread waiting on wakeup_fd, async-signal-safe. */
+static inline void capture_wakeup(int wakeup_fd)
+{
+	uint64_t one = 1;
+
+	if (wakeup_fd >= 0 && write(wakeup_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		fprintf(stderr, "capture wakeup failed: %s\n", strerror(errno));
+}
+
+static inline int capture_events_init(struct capture_events *ev, int video_fd, int wakeup_fd)
+{
+	struct epoll_event event;
+
+	ev->video_fd = video_fd;
+	ev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (ev->epoll_fd < 0)
+		return -1;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLERR;
+	event.data.fd = video_fd;
+	if (epoll_ctl(ev->epoll_fd, EPOLL_CTL_ADD, video_fd, &event) < 0)
+		goto fail;
+
+	event.events = EPOLLIN;
+	event.data.fd = wakeup_fd;
+	if (wakeup_fd >= 0 && epoll_ctl(ev->epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event) < 0)
+		goto fail;
+
+	return 0;
+fail:
+	close(ev->epoll_fd);
+	ev->epoll_fd = -1;
+	return -1;
+}
+
+/*
+ * Stops and restarts waiting on the video node. A streamed off node reports
+ * POLLERR, which epoll cannot mask, so it is taken out of the set while the
+ * capture is suspended for error recovery.
+ */
+static inline int capture_events_suspend(struct capture_events *ev)
+{
+	return epoll_ctl(ev->epoll_fd, EPOLL_CTL_DEL, ev->video_fd, NULL);
+}
+
+static inline int capture_events_resume(struct capture_events *ev)
+{
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLERR;
+	event.data.fd = ev->video_fd;
+	return epoll_ctl(ev->epoll_fd, EPOLL_CTL_ADD, ev->video_fd, &event);
+}
+
+static inline void capture_events_close(struct capture_events *ev)
+{
+	if (ev->epoll_fd >= 0)
+		close(ev->epoll_fd);
+	ev->epoll_fd = -1;
+}
+
+/*
+ * Waits for the next event. Returns a mask of CAPTURE_EVENT_* flags, 0 on
+ * timeout or -1 when epoll fails. A wakeup is consumed before returning.
+ */
+static inline int capture_events_wait(struct capture_events *ev, int timeout_ms)
+{
+	struct epoll_event events[2];
+	uint64_t count;
+	int n, i, mask = 0;
+
+	do {
+		n = epoll_wait(ev->epoll_fd, events, 2, timeout_ms);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		if (events[i].data.fd == ev->video_fd) {
+			if (events[i].events & EPOLLERR)
+				mask |= CAPTURE_EVENT_ERROR;
+			else if (events[i].events & EPOLLIN)
+				mask |= CAPTURE_EVENT_FRAME;
+		} else {
+			if (read(events[i].data.fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+				fprintf(stderr, "capture wakeup read failed: %s\n", strerror(errno));
+			mask |= CAPTURE_EVENT_WAKEUP;
+		}
+	}
+	return mask;
+}
+
+struct capture_stats {
+	uint64_t report_start_ns;
+	uint64_t last_ts_ns;
+	uint32_t last_sequence;
+	int have_last;
+
+	unsigned int frames;
+	unsigned int dropped;
+	unsigned int total_frames;
+	unsigned int total_dropped;
+	uint64_t max_interval_ns;
+	unsigned int histogram[CAPTURE_HIST_BINS];
+};
+
+static inline uint64_t capture_timeval_ns(const struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * 1000000000ull + (uint64_t)tv->tv_usec * 1000ull;
+}
+
+static inline void capture_stats_init(struct capture_stats *st, uint64_t now_ns)
+{
+	memset(st, 0, sizeof(*st));
+	st->report_start_ns = now_ns;
+}
+
+/* Accounts a frame with driver timestamp ts_ns and sequence number. */
+static inline void capture_stats_frame(struct capture_stats *st, uint64_t ts_ns, uint32_t sequence)
+{
+	uint64_t interval;
+	unsigned int bin;
+
+	if (st->have_last) {
+		/* Alternate fields of one frame share the sequence number. */
+		if (sequence > st->last_sequence + 1) {
+			st->dropped += sequence - st->last_sequence - 1;
+			st->total_dropped += sequence - st->last_sequence - 1;
+		}
+
+		if (ts_ns > st->last_ts_ns) {
+			interval = ts_ns - st->last_ts_ns;
+			bin = interval / 1000000ull;
+			st->histogram[bin < CAPTURE_HIST_BINS ? bin : CAPTURE_HIST_BINS - 1]++;
+			if (interval > st->max_interval_ns)
+				st->max_interval_ns = interval;
+		}
+	}
+
+	st->last_ts_ns = ts_ns;
+	st->last_sequence = sequence;
+	st->have_last = 1;
+	st->frames++;
+	st->total_frames++;
+}
+
+/* Interval in ms below which the given percentage of intervals fall. */
+static inline unsigned int capture_stats_percentile(const struct capture_stats *st, unsigned int percent)
+{
+	unsigned int total = 0, seen = 0, i;
+
+	for (i = 0; i < CAPTURE_HIST_BINS; i++)
+		total += st->histogram[i];
+	for (i = 0; i < CAPTURE_HIST_BINS; i++) {
+		seen += st->histogram[i];
+		if (seen * 100ull >= (uint64_t)total * percent)
+			return i + 1;
+	}
+	return CAPTURE_HIST_BINS;
+}
+
+/* Prints and restarts the statistics every CAPTURE_REPORT_SECONDS. */
+static inline void capture_stats_report(struct capture_stats *st, const char *name, uint64_t now_ns)
+{
+	double secs = (now_ns - st->report_start_ns) / 1e9;
+
+	if (secs < CAPTURE_REPORT_SECONDS)
+		return;
+
+	fprintf(stdout, "Received %u frames from %s in %6.3f seconds = %6.3f FPS, %u dropped\n",
+		st->frames, name, secs, st->frames / secs, st->dropped);
+	if (st->frames > 1)
+		fprintf(stdout, "Capture interval: p50 < %u ms, p99 < %u ms, max %6.3f ms\n",
+			capture_stats_percentile(st, 50), capture_stats_percentile(st, 99),
+			st->max_interval_ns / 1e6);
+	fflush(stdout);
+
+	st->report_start_ns = now_ns;
+	st->frames = 0;
+	st->dropped = 0;
+	st->max_interval_ns = 0;
+	memset(st->histogram, 0, sizeof(st->histogram));
+}
+
+#endif /*CAPTURE_LOOP_H*/
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CAPTURE_RECOVERY_H
+#define CAPTURE_RECOVERY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "CaptureSession.h"
+#include "capture_loop.h"
+
+/*
+ * Capture error recovery of a polling thread. On a capture error the thread
+ * streams off, resets the device and streams on again while the renderer
+ * keeps the surface and the last frame up with a "signal lost" border.
+ * Attempts back off exponentially, after CAPTURE_RECOVERY_MAX_ATTEMPTS the
+ * caller closes and opens the capture device again.
+ *
+ * Errors are a failed dequeue, an error event of the device, a stall of the
+ * stream and no frame after an attempt. Times are passed in, taken from
+ * frame_mailbox_now_ns(), so the transitions can be checked without waiting.
+ */
+enum capture_recovery_state {
+	CAPTURE_RECOVERY_STREAMING,
+	CAPTURE_RECOVERY_RESET,		/* streamed off, waiting for the next attempt */
+	CAPTURE_RECOVERY_WAIT_FRAME,	/* streamed on, waiting for the first frame */
+};
+
+#define CAPTURE_RECOVERY_MAX_ATTEMPTS		8
+#define CAPTURE_RECOVERY_FIRST_DELAY_MS		50
+#define CAPTURE_RECOVERY_MAX_DELAY_MS		2000
+#define CAPTURE_RECOVERY_FRAME_TIMEOUT_MS	1000
+/* Frame gap after which a streaming device is taken as stalled. */
+#define CAPTURE_RECOVERY_STALL_MS		1000
+
+struct capture_recovery {
+	enum capture_recovery_state state;
+	unsigned int attempts;
+	unsigned int delay_ms;
+	uint64_t deadline_ns;
+	uint64_t lost_ns;
+	uint64_t frame_ns;		/* of the last frame, 0 before the first */
+
+	void *session;
+	struct capture_events *events;
+	int *signal_lost;		/* shared with the renderer */
+	/* Resets the device before an attempt streams on, may be NULL. */
+	int (*reset)(void *data);
+	void *reset_data;
+};
+
+/*
+ * Starts watching the stream of @session. A renderer still showing the
+ * signal lost border means the device was reopened, the first frame is then
+ * waited for as after an attempt.
+ */
+static inline void capture_recovery_init(struct capture_recovery *rec, void *session,
+		struct capture_events *events, int *signal_lost, uint64_t now_ns)
+{
+	memset(rec, 0, sizeof(*rec));
+	rec->state = CAPTURE_RECOVERY_STREAMING;
+	rec->session = session;
+	rec->events = events;
+	rec->signal_lost = signal_lost;
+
+	if (__atomic_load_n(signal_lost, __ATOMIC_RELAXED)) {
+		rec->state = CAPTURE_RECOVERY_WAIT_FRAME;
+		rec->lost_ns = now_ns;
+		rec->deadline_ns = now_ns + CAPTURE_RECOVERY_FRAME_TIMEOUT_MS * 1000000ull;
+	}
+}
+
+/* Milliseconds until the next deadline, the poll timeout of the thread. */
+static inline int capture_recovery_timeout_ms(const struct capture_recovery *rec, uint64_t now_ns)
+{
+	if (rec->state == CAPTURE_RECOVERY_STREAMING)
+		return 500;
+	return (rec->deadline_ns > now_ns) ? (int)((rec->deadline_ns - now_ns + 999999) / 1000000) : 0;
+}
+
+/*
+ * Streams off after an error and schedules the next attempt. Returns 0, or
+ * -1 when the attempts are used up and the device has to be reopened.
+ */
+static inline int capture_recovery_suspend(struct capture_recovery *rec, uint64_t now_ns)
+{
+	CaptureSession_suspend(rec->session);
+	capture_events_suspend(rec->events);
+
+	if (rec->state == CAPTURE_RECOVERY_STREAMING) {
+		printf("Received IPU error - recovering\n");
+		__atomic_store_n(rec->signal_lost, 1, __ATOMIC_RELAXED);
+		rec->attempts = 0;
+		rec->delay_ms = CAPTURE_RECOVERY_FIRST_DELAY_MS;
+		rec->lost_ns = now_ns;
+	} else if (rec->delay_ms < CAPTURE_RECOVERY_MAX_DELAY_MS) {
+		rec->delay_ms = (rec->delay_ms * 2 < CAPTURE_RECOVERY_MAX_DELAY_MS) ?
+			rec->delay_ms * 2 : CAPTURE_RECOVERY_MAX_DELAY_MS;
+	}
+
+	if (rec->attempts >= CAPTURE_RECOVERY_MAX_ATTEMPTS)
+		return -1;
+
+	rec->state = CAPTURE_RECOVERY_RESET;
+	rec->deadline_ns = now_ns + rec->delay_ms * 1000000ull;
+	return 0;
+}
+
+/* Resets the device and streams on with the idle buffers. */
+static inline int capture_recovery_attempt(struct capture_recovery *rec, uint64_t now_ns)
+{
+	rec->attempts++;
+	printf("IPU recovery attempt %u\n", rec->attempts);
+
+	if (rec->reset && rec->reset(rec->reset_data) < 0)
+		return -1;
+	if (CaptureSession_resume(rec->session) < 0
+			|| capture_events_resume(rec->events) < 0)
+		return -1;
+
+	rec->state = CAPTURE_RECOVERY_WAIT_FRAME;
+	rec->deadline_ns = now_ns + CAPTURE_RECOVERY_FRAME_TIMEOUT_MS * 1000000ull;
+	return 0;
+}
+
+/*
+ * Checks a wakeup that brought no error, @frame when the device signalled a
+ * frame. Makes the attempt that is due and detects stalls. Returns -1 when
+ * the capture failed, 1 when the device is streamed off and 0 otherwise.
+ */
+static inline int capture_recovery_check(struct capture_recovery *rec, int frame, uint64_t now_ns)
+{
+	if (rec->state == CAPTURE_RECOVERY_RESET) {
+		if (now_ns >= rec->deadline_ns && capture_recovery_attempt(rec, now_ns) < 0)
+			return -1;
+		return 1;
+	}
+	if (frame)
+		return 0;
+
+	if (rec->state == CAPTURE_RECOVERY_WAIT_FRAME && now_ns >= rec->deadline_ns) {
+		printf("No frame from the IPU after recovery\n");
+		return -1;
+	}
+	if (rec->state == CAPTURE_RECOVERY_STREAMING && rec->frame_ns
+			&& now_ns - rec->frame_ns >= CAPTURE_RECOVERY_STALL_MS * 1000000ull) {
+		printf("No frame from the IPU for %u ms\n", CAPTURE_RECOVERY_STALL_MS);
+		return -1;
+	}
+	return 0;
+}
+
+/* Accounts a dequeued frame, the stream is up again when recovering. */
+static inline void capture_recovery_frame(struct capture_recovery *rec, uint64_t now_ns)
+{
+	rec->frame_ns = now_ns;
+	if (rec->state != CAPTURE_RECOVERY_WAIT_FRAME)
+		return;
+
+	printf("IPU recovered after %u attempts in %6.02f ms\n", rec->attempts,
+		(now_ns - rec->lost_ns) / 1e6);
+	__atomic_store_n(rec->signal_lost, 0, __ATOMIC_RELAXED);
+	rec->state = CAPTURE_RECOVERY_STREAMING;
+}
+
+#endif /* CAPTURE_RECOVERY_H */
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Latest frame mailbox between the capture polling thread and the renderer.
+ *
+ * A capture buffer is owned by the driver, by the mailbox or by the screen.
+ * The polling thread publishes each completed frame with an atomic exchange
+ * and requeues the frame it replaced, which was never displayed. The renderer
+ * takes the newest frame on each frame callback and gives the previous one
+ * back only once the swap showing its replacement has completed, so the IPU
+ * never writes into a buffer that is still on screen and the displayed frame
+ * is at most one frame old.
+ *
+ * A frame is packed in 32 bits: buffer index + 1 of the top (or progressive)
+ * field in the low half and of the bottom field in the high half, 0 for none.
+ */
+#define FRAME_MAILBOX_EMPTY 0u
+#define FRAME_MAILBOX_NONE  (-1)
+
+struct frame_mailbox {
+	uint32_t latest;		/* published frame, shared */
+	uint32_t front;			/* frame on screen, renderer only */
+	uint32_t retired;		/* frame waiting for its replacement to be presented */
+	unsigned int replaced;		/* frames overwritten before display */
+
+	/* Capture to present latency, renderer only. */
+	unsigned int presented;
+	uint64_t latency_sum_ns;
+	uint64_t latency_max_ns;
+};
+
+static inline void frame_mailbox_init(struct frame_mailbox *mb)
+{
+	memset(mb, 0, sizeof(*mb));
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t frame_mailbox_pack(int top, int bottom)
+{
+	return (uint32_t)(top + 1) | ((uint32_t)(bottom + 1) << 16);
+}
+
+static inline int frame_mailbox_top(uint32_t frame)
+{
+	return (int)(frame & 0xffff) - 1;
+}
+
+static inline int frame_mailbox_bottom(uint32_t frame)
+{
+	return (int)(frame >> 16) - 1;
+}
+
+/* Publishes a frame, returns the frame it replaced or FRAME_MAILBOX_EMPTY. */
+static inline uint32_t frame_mailbox_publish(struct frame_mailbox *mb, uint32_t frame)
+{
+	uint32_t old = __atomic_exchange_n(&mb->latest, frame, __ATOMIC_ACQ_REL);
+
+	if (old != FRAME_MAILBOX_EMPTY)
+		__atomic_fetch_add(&mb->replaced, 1, __ATOMIC_RELAXED);
+	return old;
+}
+
+/* Takes the newest frame, FRAME_MAILBOX_EMPTY if nothing new was captured. */
+static inline uint32_t frame_mailbox_acquire(struct frame_mailbox *mb)
+{
+	if (__atomic_load_n(&mb->latest, __ATOMIC_RELAXED) == FRAME_MAILBOX_EMPTY)
+		return FRAME_MAILBOX_EMPTY;
+	return __atomic_exchange_n(&mb->latest, FRAME_MAILBOX_EMPTY, __ATOMIC_ACQUIRE);
+}
+
+static inline uint64_t frame_mailbox_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Accounts one presented frame captured at capture_ns. */
+static inline void frame_mailbox_account(struct frame_mailbox *mb, uint64_t capture_ns)
+{
+	uint64_t latency = frame_mailbox_now_ns() - capture_ns;
+
+	mb->presented++;
+	mb->latency_sum_ns += latency;
+	if (latency > mb->latency_max_ns)
+		mb->latency_max_ns = latency;
+}
+
+/* Prints and restarts the latency statistics. */
+static inline void frame_mailbox_print_stats(struct frame_mailbox *mb)
+{
+	if (mb->presented == 0)
+		return;
+
+	fprintf(stdout, "Capture to present latency: avg %6.3f ms, max %6.3f ms, %u frames replaced before display\n",
+		mb->latency_sum_ns / 1e6 / mb->presented, mb->latency_max_ns / 1e6,
+		__atomic_exchange_n(&mb->replaced, 0, __ATOMIC_RELAXED));
+	mb->presented = 0;
+	mb->latency_sum_ns = 0;
+	mb->latency_max_ns = 0;
+}
+
+#endif /*FRAME_MAILBOX_H*/
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef GL_DEINTERLACE_H
+#define GL_DEINTERLACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deinterlacing of alternate field capture (CVBS) in the camera renderers.
+ *
+ * weave   shows a top/bottom pair as one frame, presented at frame rate.
+ * bob     shows every field on its own, the missing lines interpolated from
+ *         the lines above and below, presented at field rate.
+ * motion  shows every field at field rate and fills the missing lines from
+ *         the previous field where it matches the interpolation (static
+ *         content) and from the interpolation where it does not (motion).
+ */
+enum deinterlace_mode {
+	DEINTERLACE_NONE,	/* progressive capture */
+	DEINTERLACE_WEAVE,
+	DEINTERLACE_BOB,
+	DEINTERLACE_MOTION,
+	DEINTERLACE_MODE_COUNT
+};
+
+/* Returns 0 and sets @mode for "none", "weave", "bob" or "motion", -1 otherwise. */
+int deinterlace_mode_from_string(const char *name, enum deinterlace_mode *mode);
+
+/* Returns non-zero if every captured field is presented as a frame. */
+static inline int deinterlace_field_rate(enum deinterlace_mode mode)
+{
+	return mode == DEINTERLACE_BOB || mode == DEINTERLACE_MOTION;
+}
+
+/*
+ * Returns a fragment shader made of @head, the deinterlacer of @mode and
+ * @body, or NULL when out of memory. The string is never freed.
+ *
+ * The deinterlacer declares the samplers u_field (current field, or frame)
+ * and u_field_other (opposite field), the bool u_field_first (the current
+ * field holds the first line of each line pair) and defines
+ * "mediump vec4 deinterlace_fetch(highp vec2 tc)". @head must declare the
+ * "texsize" varying (texture size in texels, one field high).
+ */
+const char *deinterlace_shader(const char *head, enum deinterlace_mode mode,
+		const char *body);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GL_DEINTERLACE_H */
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef GL_DMABUF_IMAGE_H
+#define GL_DMABUF_IMAGE_H
+
+#include <stdint.h>
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Persistent dma-buf textures for capture buffers.
+ *
+ * Every capture buffer is imported once with EGL_EXT_image_dma_buf_import
+ * when streaming starts, and its EGLImage stays bound to a texture of its
+ * own until streaming stops. Drawing a frame is then a texture bind: the
+ * GPU samples the buffer the IPU wrote, with no per frame upload or image
+ * target call.
+ */
+
+/* Single plane layout of a dma-buf, as EGL_LINUX_DMA_BUF_EXT takes it. */
+struct gl_dmabuf_layout {
+	uint32_t fourcc;		/* DRM_FORMAT_* */
+	int width;			/* in pixels of fourcc */
+	int height;
+	int offset;			/* of the plane, in bytes */
+	int pitch;			/* in bytes */
+};
+
+struct gl_dmabuf_image {
+	EGLImageKHR image;
+	GLuint texture;			/* 0 when not imported */
+};
+
+/*
+ * Returns 1 if @dpy can import dma-bufs into textures, 0 otherwise. Needs a
+ * current GL context.
+ */
+int gl_dmabuf_image_supported(EGLDisplay dpy);
+
+/*
+ * Imports @fd with @layout into @img and binds it to a new GL_TEXTURE_2D
+ * with nearest filtering and edge clamping. Needs a current GL context, the
+ * texture binding of the active unit is reset to 0. Returns 0 on success and
+ * -1, with @img left empty, on failure.
+ */
+int gl_dmabuf_image_create(EGLDisplay dpy, int fd,
+		const struct gl_dmabuf_layout *layout, struct gl_dmabuf_image *img);
+
+/* Deletes the texture and the EGLImage of @img, if any. */
+void gl_dmabuf_image_destroy(EGLDisplay dpy, struct gl_dmabuf_image *img);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GL_DMABUF_IMAGE_H */
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef GL_PROGRAM_CACHE_H
+#define GL_PROGRAM_CACHE_H
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Persistent GL program binary cache shared by the camera and GLES2 renderers.
+ *
+ * A program is stored as one file per driver and source combination, named
+ * after a hash of the GL vendor, renderer and version strings and a hash of
+ * the shader sources and attribute bindings. A driver update or a shader
+ * change therefore never picks up a stale binary, and a file that does not
+ * validate or that the driver rejects is removed and rebuilt from source.
+ */
+#define GL_PROGRAM_CACHE_DIR            "/var/lib/earlyapp/shaders"
+#define GL_PROGRAM_CACHE_MAGIC          0x50474145      /* "EAGP" */
+#define GL_PROGRAM_CACHE_VERSION        1
+
+struct gl_program_source {
+	const char *vert;
+	const char *frag;
+	/* NULL terminated attribute names, bound to their index before linking. */
+	const char *const *attribs;
+};
+
+/*
+ * Returns a linked program for @src, loaded from the cache when possible and
+ * linked from source (and stored) otherwise. Needs a current GL context.
+ * Returns 0 if the shaders do not compile or link.
+ */
+GLuint gl_program_cache_get(const struct gl_program_source *src);
+
+/*
+ * Links every program of @srcs that is not cached yet on a low priority
+ * thread with its own context, so later sessions that select another variant
+ * load it from the cache too. Needs a current GL context on @dpy. Nothing is
+ * started when all variants are already cached. The shader strings must stay
+ * valid for the lifetime of the process.
+ */
+void gl_program_cache_precompile(EGLDisplay dpy, EGLConfig conf,
+		const struct gl_program_source *srcs, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GL_PROGRAM_CACHE_H */
@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * CPU time the render thread spends per frame, from taking the frame to
+ * handing it to the compositor, so the upload and dma-buf import paths can
+ * be compared on the target. Time blocked in the driver or the compositor
+ * does not count.
+ */
+struct render_stats {
+	const char *path;		/* name of the render path */
+	unsigned int frames;
+	uint64_t start_ns;
+	uint64_t cpu_sum_ns;
+	uint64_t cpu_max_ns;
+};
+
+static inline void render_stats_init(struct render_stats *st, const char *path)
+{
+	memset(st, 0, sizeof(*st));
+	st->path = path;
+}
+
+static inline uint64_t render_stats_thread_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void render_stats_begin(struct render_stats *st)
+{
+	st->start_ns = render_stats_thread_ns();
+}
+
+static inline void render_stats_end(struct render_stats *st)
+{
+	uint64_t cpu = render_stats_thread_ns() - st->start_ns;
+
+	st->frames++;
+	st->cpu_sum_ns += cpu;
+	if (cpu > st->cpu_max_ns)
+		st->cpu_max_ns = cpu;
+}
+
+/* Prints and restarts the statistics. */
+static inline void render_stats_print(struct render_stats *st)
+{
+	if (st->frames == 0)
+		return;
+
+	fprintf(stdout, "Render CPU time (%s): avg %6.3f ms, max %6.3f ms per frame\n",
+		st->path ? st->path : "unknown",
+		st->cpu_sum_ns / 1e6 / st->frames, st->cpu_max_ns / 1e6);
+	st->frames = 0;
+	st->cpu_sum_ns = 0;
+	st->cpu_max_ns = 0;
+}
+
+#endif /* RENDER_STATS_H */
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHM_POOL_H
+#define SHM_POOL_H
+
+#include <stddef.h>
+#include <wayland-client.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A fixed set of XRGB8888 wl_shm buffers carved out of one shared memory
+ * pool, for renderers that draw with the CPU. A buffer is busy from
+ * shm_pool_acquire() until the compositor releases it.
+ */
+#define SHM_POOL_MAX_BUFFERS	3
+
+struct shm_buffer {
+	struct wl_buffer *buffer;
+	void *data;
+	int busy;
+};
+
+struct shm_pool {
+	struct wl_shm_pool *pool;
+	struct shm_buffer buffers[SHM_POOL_MAX_BUFFERS];
+	unsigned int count;
+	unsigned int width, height, stride;
+	void *data;
+	size_t size;
+};
+
+/* Creates @count (at most SHM_POOL_MAX_BUFFERS) buffers. Returns 0 or -1. */
+int shm_pool_init(struct shm_pool *pool, struct wl_shm *shm,
+		unsigned int width, unsigned int height, unsigned int count);
+
+/* Returns a buffer the compositor does not use, or NULL if all are busy. */
+struct shm_buffer *shm_pool_acquire(struct shm_pool *pool);
+
+void shm_pool_fini(struct shm_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHM_POOL_H */
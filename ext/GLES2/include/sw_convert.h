@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SW_CONVERT_H
+#define SW_CONVERT_H
+
+#include <stdint.h>
+
+#include "gl_deinterlace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CPU conversion of camera frames to XRGB8888, used when there is no GL to
+ * render them with. Rows are converted with AVX2 or SSE4.1 kernels when the
+ * CPU has them (scalar otherwise), fields are woven or line doubled on the
+ * fly and the result is optionally scaled into the destination, so a frame
+ * is written straight into its wl_shm buffer in a single pass.
+ *
+ * YUV is BT.601 limited range, as delivered by the IPU.
+ */
+enum sw_format {
+	SW_FORMAT_UYVY,
+	SW_FORMAT_YUYV,
+	SW_FORMAT_NV12,
+	SW_FORMAT_XRGB8888,
+	SW_FORMAT_COUNT
+};
+
+enum sw_filter {
+	SW_FILTER_NEAREST,
+	SW_FILTER_BILINEAR
+};
+
+/*
+ * A captured frame, or a field and its opposite field. @other is only read
+ * for DEINTERLACE_WEAVE, bob and motion interpolate from @field alone.
+ * The @uv planes are only used for NV12.
+ */
+struct sw_frame {
+	enum sw_format format;
+	unsigned int width, height;	/* one field high when interlaced */
+	unsigned int stride, uv_stride;
+	const uint8_t *field, *field_uv;
+	const uint8_t *other, *other_uv;
+	enum deinterlace_mode mode;
+	int field_first;		/* @field holds the first line of each pair */
+};
+
+struct sw_converter;
+
+/*
+ * Returns a converter from @src_w x @src_h frames (twice the field height
+ * when interlaced) to @dst_w x @dst_h XRGB8888, or NULL when out of memory.
+ * Scratch rows are allocated here, never per frame.
+ */
+struct sw_converter *sw_converter_create(unsigned int src_w, unsigned int src_h,
+		unsigned int dst_w, unsigned int dst_h, enum sw_filter filter);
+void sw_converter_destroy(struct sw_converter *conv);
+
+/* Converts @frame into @dst, @dst_stride bytes apart. */
+void sw_convert_frame(struct sw_converter *conv, const struct sw_frame *frame,
+		void *dst, unsigned int dst_stride);
+
+/*
+ * Converts one row of @width pixels. @uv is the NV12 chroma row and is
+ * ignored for the other formats.
+ */
+void sw_convert_row(enum sw_format format, uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width);
+
+/* Returns the instruction set of the row kernels: "avx2", "sse4.1" or "c". */
+const char *sw_convert_isa(void);
+
+/*
+ * Prints the throughput of every kernel available on this CPU, and of
+ * weaving and scaling to 1920x1080, at 720x480 and 1920x1080. Returns 0,
+ * or -1 when out of memory.
+ */
+int sw_convert_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SW_CONVERT_H */
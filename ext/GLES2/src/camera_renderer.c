@@ -0,0 +1,1365 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <wayland-client.h>
+#include <wayland-egl.h>
+#include <drm/drm_fourcc.h>
+
+#include "ias-shell-client-protocol.h"
+#include "ivi-application-client-protocol.h"
+#include "wayland-drm-client-protocol.h"
+#include "camera_renderer.h"
+#include "capture_loop.h"
+#include "gl_program_cache.h"
+#include "KpiMarker.h"
+#include "SplashHandoff.h"
+
+#define ARRAY_SIZE(a)		(sizeof(a)/sizeof((a)[0]))
+
+#define BYE_ON(cond, ...) \
+	do { \
+		if (cond) { \
+			int errsv = errno; \
+			fprintf(stderr, "ERROR(%s:%d) : ", \
+					__FILE__, __LINE__); \
+			errno = errsv; \
+			fprintf(stderr,  __VA_ARGS__); \
+			abort(); \
+		} \
+	} while(0)
+
+/* Seconds between two frame rate reports. */
+#define FPS_REPORT_SECONDS	5
+
+/*
+ * Fragment shaders are split around the deinterlacer, which provides
+ * deinterlace_fetch() returning the raw texel of the output position.
+ */
+
+/* UYVY */
+static const char frag_shader_head_UYVY[] =
+  "uniform bool swap_rb;"\
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;";
+
+static const char frag_shader_body_UYVY[] =
+  "void main(void) {"\
+  "  mediump float y, u, v, tmp;"\
+  "  mediump vec4 resultcolor;"\
+  "  mediump vec4 raw = deinterlace_fetch(texcoord);"\
+  "  if (fract(texcoord.x * texsize.x) < 0.5)"\
+  "    raw.a = raw.g;"\
+  "  u = raw.b-0.5;"\
+  "  v = raw.r-0.5;"\
+  "  if (swap_rb) {"\
+  "    tmp = u;"\
+  "    u = v;"\
+  "    v = tmp;"\
+  "  }"\
+  "  y = 1.1643*(raw.a-0.0625);"\
+  "  resultcolor.r = (y+1.5958*(v));"\
+  "  resultcolor.g = (y-0.39173*(u)-0.81290*(v));"\
+  "  resultcolor.b = (y+2.017*(u));"\
+  "  resultcolor.a = 1.0;"\
+  "  gl_FragColor=resultcolor;"\
+  "}";
+
+/* YUYV */
+static const char frag_shader_head_YUYV[] =
+  "uniform bool swap_rb;"\
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;";
+
+static const char frag_shader_body_YUYV[] =
+  "void main(void) {"\
+  "  mediump float y, u, v, tmp;"\
+  "  mediump vec4 resultcolor;"\
+  "  mediump vec4 raw = deinterlace_fetch(texcoord);"\
+  "  if (fract(texcoord.x * texsize.x) < 0.5)"\
+  "    raw.b = raw.r;"\
+  "  u = raw.g-0.5;"\
+  "  v = raw.a-0.5;"\
+  "  y = 1.1643*(raw.b-0.0625);"\
+  "  resultcolor.r = (y+1.5958*(v));"\
+  "  resultcolor.g = (y-0.39173*(u)-0.81290*(v));"\
+  "  resultcolor.b = (y+2.017*(u));"\
+  "  resultcolor.a = 1.0;"\
+  "  gl_FragColor=resultcolor;"\
+  "}";
+
+/* RGB565 and RGB888 */
+static const char frag_shader_head_RGB[] =
+  "uniform bool rgb565;"\
+  "uniform bool swap_rb;"\
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;";
+
+static const char frag_shader_body_RGB[] =
+  "void main(void) {"\
+  "  highp vec4 resultcolor;"\
+  "  highp vec4 raw = deinterlace_fetch(texcoord);"\
+  "  if(rgb565) raw *= vec4(255.0/32.0, 255.0/64.0, 255.0/32.0, 1.0);"\
+  "  if (swap_rb) resultcolor.rgb = raw.bgr;"\
+  "  else resultcolor.rgb = raw.rgb;"\
+  "  resultcolor.a = 1.0;"\
+  "  gl_FragColor = resultcolor;"\
+  "}";
+
+/* SGRBG8, progressive only */
+static const char frag_shader_text_SGRBG8[] =
+  "uniform sampler2D u_field;"\
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;"\
+  "void main(void) {"\
+  "  mediump vec2 texcoord2;"\
+  "  mediump vec4 resultcolor;"\
+  "  texcoord2.x = texcoord.x;"\
+  "  texcoord2.y = texcoord.y + 0.5/texsize.y;"\
+  "  mediump vec4 raw1 = texture2D(u_field, texcoord);"\
+  "  mediump vec4 raw2 = texture2D(u_field, texcoord2);"\
+  "  if (fract(gl_FragCoord.y/2.0) < 0.5) {"\
+  "    resultcolor.g = raw1.r;"\
+  "  } else {"\
+  "    resultcolor.g = raw2.a;"\
+  "  }"\
+  "  resultcolor.r = raw1.a;"\
+  "  resultcolor.b = raw2.r;"\
+  "  resultcolor.a = 1.0;"\
+  "  gl_FragColor=resultcolor;"\
+  "}";
+
+/**
+ * @brief vertex shader for displaying the texture
+ */
+static const char vert_shader_text[] =
+  "varying  highp vec2 texcoord; "\
+  "varying  mediump vec2 texsize; "\
+  "attribute vec4 pos; "\
+  "attribute highp vec2 itexcoord; "\
+  "uniform mat4 modelviewProjection; "\
+  "uniform mediump vec2 u_texsize; "\
+  "void main(void) "\
+  "{ "\
+  " texcoord = itexcoord; "\
+  " texsize = u_texsize; "\
+  " gl_Position = modelviewProjection * pos; "\
+  "}";
+
+/* One program per input format and deinterlacing mode, format + mode. */
+enum camera_program {
+	CAMERA_PROGRAM_UYVY = 0,
+	CAMERA_PROGRAM_YUYV = CAMERA_PROGRAM_UYVY + DEINTERLACE_MODE_COUNT,
+	CAMERA_PROGRAM_RGB = CAMERA_PROGRAM_YUYV + DEINTERLACE_MODE_COUNT,
+	CAMERA_PROGRAM_SGRBG8 = CAMERA_PROGRAM_RGB + DEINTERLACE_MODE_COUNT,
+	CAMERA_PROGRAM_COUNT
+};
+
+/* Every program the renderer can select, precompiled after the first frame. */
+static struct gl_program_source camera_programs[CAMERA_PROGRAM_COUNT];
+
+static const struct wl_callback_listener frame_listener;
+
+static void redraw(void *data, struct wl_callback *callback, uint32_t time);
+
+/* Texels of a buffer line, YUV and Bayer hold two pixels per texel. */
+static unsigned int texture_width(const struct camera_renderer *r)
+{
+	if (r->config.format == CAMERA_FORMAT_RGB888 ||
+			r->config.format == CAMERA_FORMAT_RGB565)
+		return r->config.stride_width;
+	return r->config.stride_width / 2;
+}
+
+/* Bayer textures hold a line pair per texel line. */
+static unsigned int texture_height(const struct camera_renderer *r)
+{
+	if (r->config.format == CAMERA_FORMAT_SGRBG8)
+		return r->config.ih / 2;
+	return r->config.ih;
+}
+
+static GLenum texture_format(const struct camera_renderer *r)
+{
+	return (r->config.format == CAMERA_FORMAT_SGRBG8) ?
+		GL_LUMINANCE_ALPHA : GL_RGBA;
+}
+
+static const char *render_path_name(enum render_type type)
+{
+	switch (type) {
+	case RENDER_TYPE_WL:
+		return "wl_drm";
+	case RENDER_TYPE_GL:
+		return "GL upload";
+	case RENDER_TYPE_GL_DMA:
+		return "GL dma-buf";
+	case RENDER_TYPE_SHM:
+		return "shm";
+	}
+	return "unknown";
+}
+
+static struct camera_output *
+get_default_output(struct camera_renderer *r)
+{
+	struct camera_output *output;
+
+	/* The window always goes to the first output. */
+	if (wl_list_empty(&r->output_list))
+		return NULL;
+	return wl_container_of(r->output_list.next, output, link);
+}
+
+static void
+handle_ping(void *data, struct wl_shell_surface *shell_surface,
+		uint32_t serial)
+{
+	wl_shell_surface_pong(shell_surface, serial);
+}
+
+static void
+handle_resize(struct camera_renderer *r, int32_t width, int32_t height)
+{
+	r->geometry.width = width;
+	r->geometry.height = height;
+
+	if (!r->config.fullscreen) {
+		r->window_size.width = width;
+		r->window_size.height = height;
+	}
+}
+
+static void
+handle_configure(void *data, struct wl_shell_surface *shell_surface,
+		uint32_t edges, int32_t width, int32_t height)
+{
+	handle_resize(data, width, height);
+}
+
+static void
+handle_popup_done(void *data, struct wl_shell_surface *shell_surface)
+{
+}
+
+static const struct wl_shell_surface_listener wl_shell_surface_listener = {
+	handle_ping,
+	handle_configure,
+	handle_popup_done
+};
+
+static void
+ias_handle_ping(void *data, struct ias_surface *ias_surface,
+		uint32_t serial)
+{
+	ias_surface_pong(ias_surface, serial);
+}
+
+static void
+ias_handle_configure(void *data, struct ias_surface *ias_surface,
+		int32_t width, int32_t height)
+{
+	handle_resize(data, width, height);
+}
+
+static const struct ias_surface_listener ias_surface_listener = {
+	ias_handle_ping,
+	ias_handle_configure,
+};
+
+static void
+ivi_handle_configure(void *data, struct ivi_surface *ivi_surface,
+		int32_t width, int32_t height)
+{
+	struct camera_renderer *r = data;
+
+	if (r->native)
+		wl_egl_window_resize(r->native, width, height, 0, 0);
+	handle_resize(r, width, height);
+}
+
+static const struct ivi_surface_listener ivi_surface_listener = {
+	ivi_handle_configure,
+};
+
+static void
+configure_callback(void *data, struct wl_callback *callback, uint32_t time)
+{
+	struct camera_renderer *r = data;
+
+	wl_callback_destroy(callback);
+
+	r->configured = 1;
+
+	if (r->callback == NULL)
+		redraw(data, NULL, time);
+}
+
+static const struct wl_callback_listener configure_callback_listener = {
+	configure_callback,
+};
+
+static void
+toggle_fullscreen(struct camera_renderer *r, int fullscreen)
+{
+	struct wl_callback *callback;
+	struct camera_output *output;
+
+	r->config.fullscreen = fullscreen;
+	r->configured = 0;
+
+	if (fullscreen) {
+		output = get_default_output(r);
+		if (r->ias_shell && output) {
+			ias_surface_set_fullscreen(r->shell_surface, output->output);
+		}
+		if (r->wl_shell) {
+			wl_shell_surface_set_fullscreen(r->shell_surface,
+					WL_SHELL_SURFACE_FULLSCREEN_METHOD_DEFAULT,
+					0, NULL);
+		}
+	} else {
+		if (r->ias_shell) {
+			ias_surface_unset_fullscreen(r->shell_surface,
+					r->window_size.width, r->window_size.height);
+			ias_shell_set_zorder(r->ias_shell, r->shell_surface, 0);
+		}
+		if (r->wl_shell) {
+			wl_shell_surface_set_toplevel(r->shell_surface);
+		}
+		handle_resize(r, r->window_size.width, r->window_size.height);
+	}
+
+	callback = wl_display_sync(r->display);
+	wl_callback_add_listener(callback, &configure_callback_listener, r);
+}
+
+static void
+destroy_surface(struct camera_renderer *r)
+{
+	if (camera_renderer_gl(r)) {
+		/* Required, otherwise segfault in egl_dri2.c: dri2_make_current()
+		 * on eglReleaseThread(). */
+		eglMakeCurrent(r->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			       EGL_NO_CONTEXT);
+
+		eglDestroySurface(r->egl.dpy, r->egl_surface);
+		wl_egl_window_destroy(r->native);
+	}
+
+	if (r->ias_shell) {
+		ias_surface_destroy(r->shell_surface);
+	}
+	if (r->wl_shell) {
+		wl_shell_surface_destroy(r->shell_surface);
+	}
+	if (r->ivi_surface) {
+		ivi_surface_destroy(r->ivi_surface);
+	}
+
+	wl_surface_destroy(r->surface);
+
+	if (r->callback)
+		wl_callback_destroy(r->callback);
+}
+
+static void
+update_fps(struct camera_renderer *r)
+{
+	uint64_t now = frame_mailbox_now_ns();
+	double secs = (now - r->fps_start_ns) / 1e9;
+
+	r->frame_count++;
+	if (secs < FPS_REPORT_SECONDS)
+		return;
+
+	fprintf(stdout, "Rendered %u frames in %6.3f seconds = %6.3f FPS\n",
+		r->frame_count, secs, r->frame_count / secs);
+	fflush(stdout);
+
+	r->frame_count = 0;
+	r->fps_start_ns = now;
+	frame_mailbox_print_stats(&r->mailbox);
+	render_stats_print(&r->render_stats);
+}
+
+void camera_renderer_put(struct camera_renderer *r, int index)
+{
+	if (CaptureSession_put(r->capture, index) < 0) {
+		__atomic_store_n(&r->capture_fault, 1, __ATOMIC_RELEASE);
+		if (r->wakeup_fd >= 0)
+			capture_wakeup(r->wakeup_fd);
+	}
+}
+
+void camera_renderer_release_frame(struct camera_renderer *r, uint32_t frame)
+{
+	int top = frame_mailbox_top(frame);
+	int bottom = frame_mailbox_bottom(frame);
+
+	if (top >= 0)
+		camera_renderer_put(r, top);
+	if (bottom >= 0)
+		camera_renderer_put(r, bottom);
+}
+
+void camera_renderer_capture(struct camera_renderer *r, int index,
+		const struct capture_frame *frame)
+{
+	enum deinterlace_mode mode = r->config.deinterlace;
+	struct camera_buffer *buf = &r->buffers[index];
+	uint32_t next = FRAME_MAILBOX_EMPTY;
+
+	buf->field = frame->field;
+	buf->capture_ns = frame->timestamp_ns;
+	buf->sequence = frame->sequence;
+
+	if (deinterlace_field_rate(mode) && buf->field != CAPTURE_FIELD_NONE) {
+		/* Every field is a frame, shown with the field before it. The
+		 * renderer keeps a reference to the newest field and hands it
+		 * over to the next frame. */
+		if (mode == DEINTERLACE_MOTION) {
+			CaptureSession_get(r->capture, index);
+			next = frame_mailbox_pack(index, r->last_field);
+			r->last_field = index;
+		} else {
+			next = frame_mailbox_pack(index, FRAME_MAILBOX_NONE);
+		}
+	/* Fields are published in top/bottom pairs. */
+	} else if (buf->field == CAPTURE_FIELD_TOP) {
+		if (r->pending_top != FRAME_MAILBOX_NONE)
+			camera_renderer_put(r, r->pending_top);
+		r->pending_top = index;
+	} else if (buf->field == CAPTURE_FIELD_BOTTOM) {
+		if (r->pending_top == FRAME_MAILBOX_NONE) {
+			camera_renderer_put(r, index);
+		} else {
+			next = frame_mailbox_pack(r->pending_top, index);
+			r->pending_top = FRAME_MAILBOX_NONE;
+		}
+	} else {
+		next = frame_mailbox_pack(index, FRAME_MAILBOX_NONE);
+	}
+
+	/* The replaced frame was never displayed, requeue it. */
+	if (next != FRAME_MAILBOX_EMPTY)
+		camera_renderer_release_frame(r,
+			frame_mailbox_publish(&r->mailbox, next));
+}
+
+void camera_renderer_drop_fields(struct camera_renderer *r)
+{
+	if (r->pending_top != FRAME_MAILBOX_NONE)
+		camera_renderer_put(r, r->pending_top);
+	if (r->last_field != FRAME_MAILBOX_NONE)
+		camera_renderer_put(r, r->last_field);
+	r->pending_top = r->last_field = FRAME_MAILBOX_NONE;
+}
+
+/* Period of the blinking "signal lost" border. */
+#define SIGNAL_LOST_BLINK_MS	500
+#define SIGNAL_LOST_BORDER	16
+
+static inline int signal_lost_visible(struct camera_renderer *r)
+{
+	return __atomic_load_n(&r->signal_lost, __ATOMIC_RELAXED)
+		&& (frame_mailbox_now_ns() / (SIGNAL_LOST_BLINK_MS * 1000000ull)) % 2 == 0;
+}
+
+/* Draws a red border over the last frame while the capture recovers. */
+static void draw_signal_lost_gl(struct camera_renderer *r)
+{
+	int w = r->geometry.width, h = r->geometry.height;
+	int b = SIGNAL_LOST_BORDER;
+
+	glEnable(GL_SCISSOR_TEST);
+	glClearColor(1.0, 0.0, 0.0, 1.0);
+	glScissor(0, 0, w, b);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(0, h - b, w, b);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(0, 0, b, h);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glScissor(w - b, 0, b, h);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+}
+
+/* Same border in an XRGB8888 shm buffer. */
+static void draw_signal_lost_shm(struct camera_renderer *r, void *data)
+{
+	struct shm_pool *pool = &r->shm_pool;
+	unsigned int b = SIGNAL_LOST_BORDER, x, y;
+	uint32_t *row;
+
+	for (y = 0; y < pool->height; y++) {
+		row = (uint32_t *)((unsigned char *)data + y * pool->stride);
+		for (x = 0; x < pool->width; x++) {
+			/* Inner rows only get the left and right edges. */
+			if (y >= b && y + b < pool->height && x == b)
+				x = (pool->width > 2 * b) ? pool->width - b : x;
+			row[x] = 0xffff0000;
+		}
+	}
+}
+
+static void make_orth_matrix(GLfloat *data, GLfloat left, GLfloat right,
+		GLfloat bottom, GLfloat top,
+		GLfloat znear, GLfloat zfar)
+{
+	data[0] = 2.0/(right-left);
+	data[5] = 2.0/(top-bottom);
+	data[10] = -2.0/(zfar-znear);
+	data[15] = 1.0;
+	data[12] = (right+left)/(right-left);
+	data[13] = (top+bottom)/(top-bottom);
+	data[14] = (zfar+znear)/(zfar-znear);
+}
+
+static void make_matrix(GLfloat *data, GLfloat v)
+{
+	make_orth_matrix(data, -v, v, -v, v, -v, v);
+}
+
+/*
+ * Marks the first frame shown after capture started and hands the screen
+ * over from the splash. Returns 1 for that frame, 0 for the others.
+ */
+static int first_frame_presented(struct camera_renderer *r)
+{
+	if (r->first_frame_shown || r->mailbox.front == FRAME_MAILBOX_EMPTY)
+		return 0;
+
+	KPI_MARK("rvc_first_frame");
+	r->first_frame_shown = 1;
+	if (r->config.first_frame)
+		r->config.first_frame();
+	SplashHandoff_presented(r->config.name);
+	return 1;
+}
+
+static void redraw_wl_way(struct camera_renderer *r, struct wl_buffer *buf)
+{
+	wl_surface_attach(r->surface, buf, 0, 0);
+	wl_surface_damage(r->surface, 0, 0, r->config.stride_width, r->config.ih);
+	wl_surface_commit(r->surface);
+
+	first_frame_presented(r);
+}
+
+/*
+ * Converts @field (and @other, as for redraw_egl_way) with the CPU into a
+ * wl_shm buffer. The frame is copied, so its buffers can go back to the
+ * driver right away.
+ */
+static void redraw_shm_way(struct camera_renderer *r, struct camera_buffer *field,
+		struct camera_buffer *other)
+{
+	struct shm_buffer *buffer = shm_pool_acquire(&r->shm_pool);
+	struct sw_frame frame = { 0 };
+
+	/* The compositor holds every buffer, keep showing the last frame. */
+	if (!buffer) {
+		wl_surface_commit(r->surface);
+		return;
+	}
+
+	frame.format = r->sw_format;
+	frame.width = r->config.iw;
+	frame.height = r->config.ih;
+	frame.stride = r->config.stride_width *
+		((frame.format == SW_FORMAT_XRGB8888) ? 4 : 2);
+	frame.field = field->data;
+	frame.other = other->data;
+	frame.mode = r->config.deinterlace;
+	/* The IPU delivers the field labelled bottom on the first line of each pair. */
+	frame.field_first = (field->field == CAPTURE_FIELD_BOTTOM);
+	sw_convert_frame(r->converter, &frame, buffer->data, r->shm_pool.stride);
+	if (signal_lost_visible(r))
+		draw_signal_lost_shm(r, buffer->data);
+
+	wl_surface_attach(r->surface, buffer->buffer, 0, 0);
+	wl_surface_damage(r->surface, 0, 0, r->shm_pool.width, r->shm_pool.height);
+	wl_surface_commit(r->surface);
+
+	first_frame_presented(r);
+}
+
+/*
+ * Draws @field, a progressive frame or field, with @other, the opposite field
+ * of the pair at frame rate or the previous field at field rate.
+ */
+static void redraw_egl_way(struct camera_renderer *r, struct camera_buffer *field,
+		struct camera_buffer *other)
+{
+	enum deinterlace_mode mode = r->config.deinterlace;
+
+	glViewport(0, 0, r->geometry.width, r->geometry.height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearColor(0.0, 0.0, 0.0, 0.0); // full transparency
+
+	glActiveTexture(GL_TEXTURE0);
+
+	/* Imported buffers are sampled in place, others are copied first. */
+	if (field->gl.texture) {
+		glBindTexture(GL_TEXTURE_2D, field->gl.texture);
+	} else {
+		glBindTexture(GL_TEXTURE_2D, r->gl.texture[0]);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width(r),
+				texture_height(r), texture_format(r),
+				GL_UNSIGNED_BYTE, field->data);
+	}
+
+	/* bob only samples the current field */
+	if (mode == DEINTERLACE_WEAVE || mode == DEINTERLACE_MOTION) {
+		glActiveTexture(GL_TEXTURE1);
+
+		if (other->gl.texture) {
+			glBindTexture(GL_TEXTURE_2D, other->gl.texture);
+		} else {
+			glBindTexture(GL_TEXTURE_2D, r->gl.texture[1]);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width(r),
+					texture_height(r), texture_format(r),
+					GL_UNSIGNED_BYTE, other->data);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	glUseProgram(r->gl.program);
+
+	/* The IPU delivers the field labelled bottom on the first line of each pair. */
+	glUniform1i(r->gl.field_first, field->field == CAPTURE_FIELD_BOTTOM);
+
+	glUniformMatrix4fv(r->gl.modelview_uniform, 1, GL_FALSE, r->gl.model_view);
+
+	glVertexAttribPointer(r->gl.pos, 3, GL_FLOAT, GL_FALSE, 0, r->gl.hmi_vtx);
+	glVertexAttribPointer(r->gl.attr_tex, 2, GL_FLOAT, GL_FALSE, 0, r->gl.hmi_tex);
+	glEnableVertexAttribArray(r->gl.pos);
+	glEnableVertexAttribArray(r->gl.attr_tex);
+	glDrawElements(GL_TRIANGLES, 2*3, GL_UNSIGNED_BYTE, r->gl.hmi_ind);
+	glDisableVertexAttribArray(r->gl.pos);
+	glDisableVertexAttribArray(r->gl.attr_tex);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (signal_lost_visible(r))
+		draw_signal_lost_gl(r);
+
+	wl_surface_set_opaque_region(r->surface, NULL);
+	eglSwapBuffers(r->egl.dpy, r->egl_surface);
+
+	if (first_frame_presented(r))
+		gl_program_cache_precompile(r->egl.dpy, r->egl.conf,
+				camera_programs, CAMERA_PROGRAM_COUNT);
+}
+
+/*
+ * Nothing was captured since the surface was shown, draw black instead of a
+ * frame of an earlier session. wl_drm can only show capture buffers.
+ */
+static void redraw_blank(struct camera_renderer *r)
+{
+	struct shm_buffer *buffer;
+
+	if (camera_renderer_gl(r)) {
+		glClearColor(0.0, 0.0, 0.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		eglSwapBuffers(r->egl.dpy, r->egl_surface);
+	} else {
+		buffer = shm_pool_acquire(&r->shm_pool);
+		if (buffer) {
+			memset(buffer->data, 0, r->shm_pool.stride * r->shm_pool.height);
+			wl_surface_attach(r->surface, buffer->buffer, 0, 0);
+			wl_surface_damage(r->surface, 0, 0, r->shm_pool.width,
+					r->shm_pool.height);
+		}
+		wl_surface_commit(r->surface);
+	}
+}
+
+static void
+redraw(void *data, struct wl_callback *callback, uint32_t time)
+{
+	struct camera_renderer *r = data;
+	struct frame_mailbox *mb = &r->mailbox;
+	uint32_t next = frame_mailbox_acquire(mb);
+	uint32_t prev = FRAME_MAILBOX_EMPTY;
+	struct camera_buffer *buf_top;
+	struct camera_buffer *buf_bottom;
+	int top, bottom;
+
+	/* The commit replacing the retired frame has been presented by now. */
+	if (mb->retired != FRAME_MAILBOX_EMPTY) {
+		camera_renderer_release_frame(r, mb->retired);
+		mb->retired = FRAME_MAILBOX_EMPTY;
+	}
+
+	if (next != FRAME_MAILBOX_EMPTY) {
+		prev = mb->front;
+		mb->front = next;
+	}
+
+	/* At field rate "top" is the newest field and "bottom" the one before. */
+	top = frame_mailbox_top(mb->front);
+	bottom = frame_mailbox_bottom(mb->front);
+	buf_top = (top >= 0) ? &r->buffers[top] : &r->buffers[0];
+	buf_bottom = (bottom >= 0) ? &r->buffers[bottom] : buf_top;
+
+	if (callback)
+		wl_callback_destroy(callback);
+
+	r->callback = wl_surface_frame(r->surface);
+	wl_callback_add_listener(r->callback, &frame_listener, r);
+
+	if (mb->front == FRAME_MAILBOX_EMPTY && r->config.render_type != RENDER_TYPE_WL) {
+		redraw_blank(r);
+		return;
+	}
+
+	update_fps(r);
+
+	render_stats_begin(&r->render_stats);
+	if (r->config.render_type == RENDER_TYPE_WL) {
+		redraw_wl_way(r, buf_top->buf);
+	} else if (r->config.render_type == RENDER_TYPE_SHM) {
+		redraw_shm_way(r, buf_top, buf_bottom);
+	} else {
+		redraw_egl_way(r, buf_top, buf_bottom);
+	}
+	render_stats_end(&r->render_stats);
+
+	if (next != FRAME_MAILBOX_EMPTY) {
+		frame_mailbox_account(mb, (buf_bottom->capture_ns > buf_top->capture_ns)
+				? buf_bottom->capture_ns : buf_top->capture_ns);
+
+		/* The compositor scans out wl_buffers until the next commit is
+		 * presented, GL paths are done with the frame after the swap. */
+		if (r->config.render_type == RENDER_TYPE_WL)
+			mb->retired = prev;
+		else if (prev != FRAME_MAILBOX_EMPTY)
+			camera_renderer_release_frame(r, prev);
+	}
+}
+
+static const struct wl_callback_listener frame_listener = {
+	redraw
+};
+
+static void
+display_add_output(struct camera_renderer *r, uint32_t id)
+{
+	struct camera_output *output;
+
+	output = calloc(1, sizeof *output);
+	if (output == NULL)
+		return;
+
+	output->output =
+		wl_registry_bind(r->registry, id, &wl_output_interface, 1);
+	wl_list_insert(r->output_list.prev, &output->link);
+}
+
+static void
+registry_handle_global(void *data, struct wl_registry *registry,
+		uint32_t name, const char *interface, uint32_t version)
+{
+	struct camera_renderer *r = data;
+
+	if (strcmp(interface, "wl_compositor") == 0) {
+		r->compositor =
+			wl_registry_bind(registry, name,
+					&wl_compositor_interface, 1);
+	} else if (strcmp(interface, "wl_shell") == 0) {
+		if (!r->ias_shell && !r->ivi_application) {
+			r->wl_shell = wl_registry_bind(registry, name,
+					&wl_shell_interface, 1);
+		}
+	} else if (strcmp(interface, "ias_shell") == 0) {
+		if (!r->wl_shell && !r->ivi_application) {
+			r->ias_shell = wl_registry_bind(registry, name,
+					&ias_shell_interface, 1);
+		}
+	} else if (strcmp(interface, "ivi_application") == 0) {
+		if (!r->ias_shell && !r->wl_shell) {
+			r->ivi_application = wl_registry_bind(registry, name,
+					&ivi_application_interface, 1);
+		}
+	} else if (strcmp(interface, "wl_output") == 0) {
+		display_add_output(r, name);
+	} else if (!strcmp(interface, "wl_drm")) {
+		r->wl_drm =
+			wl_registry_bind(registry, name, &wl_drm_interface, 1);
+	} else if (!strcmp(interface, "wl_shm")) {
+		r->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+	}
+}
+
+static const struct wl_registry_listener registry_listener = {
+	registry_handle_global
+};
+
+/* Returns -1 when there is no usable EGL, the frames are then drawn with the CPU. */
+static int
+init_egl(struct camera_renderer *r)
+{
+	static const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+
+	static const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+		EGL_RED_SIZE, 1,
+		EGL_GREEN_SIZE, 1,
+		EGL_BLUE_SIZE, 1,
+		EGL_ALPHA_SIZE, 1,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NONE
+	};
+
+	EGLint major, minor, n;
+
+	r->egl.dpy = eglGetDisplay((EGLNativeDisplayType) r->display);
+	if (r->egl.dpy == EGL_NO_DISPLAY) {
+		fprintf(stderr, "eglGetDisplay failed\n");
+		return -1;
+	}
+
+	if (eglInitialize(r->egl.dpy, &major, &minor) != EGL_TRUE) {
+		fprintf(stderr, "eglInitialize failed: 0x%x\n", eglGetError());
+		return -1;
+	}
+	if (eglBindAPI(EGL_OPENGL_ES_API) != EGL_TRUE) {
+		fprintf(stderr, "eglBindAPI failed: 0x%x\n", eglGetError());
+		goto fail;
+	}
+
+	if (!eglChooseConfig(r->egl.dpy, config_attribs, &r->egl.conf, 1, &n) || n != 1) {
+		fprintf(stderr, "No GLES2 EGL config\n");
+		goto fail;
+	}
+
+	r->egl.ctx = eglCreateContext(r->egl.dpy, r->egl.conf,
+			EGL_NO_CONTEXT, context_attribs);
+	if (r->egl.ctx == EGL_NO_CONTEXT) {
+		fprintf(stderr, "eglCreateContext failed: 0x%x\n", eglGetError());
+		goto fail;
+	}
+
+	return 0;
+
+fail:
+	eglTerminate(r->egl.dpy);
+	return -1;
+}
+
+static void
+create_surface(struct camera_renderer *r)
+{
+	EGLBoolean ret;
+
+	r->surface = wl_compositor_create_surface(r->compositor);
+	if (r->ias_shell) {
+		r->shell_surface = ias_shell_get_ias_surface(r->ias_shell,
+				r->surface, r->config.title);
+		ias_surface_add_listener(r->shell_surface,
+				&ias_surface_listener, r);
+	}
+	if (r->wl_shell) {
+		r->shell_surface = wl_shell_get_shell_surface(r->wl_shell,
+				r->surface);
+		wl_shell_surface_add_listener(r->shell_surface,
+				&wl_shell_surface_listener, r);
+		wl_shell_surface_set_title(r->shell_surface, r->config.title);
+	}
+	if (r->ivi_application) {
+		r->ivi_surface = ivi_application_surface_create(r->ivi_application,
+				(uint32_t) getpid(), r->surface);
+		ivi_surface_add_listener(r->ivi_surface,
+				&ivi_surface_listener, r);
+	}
+
+	if (camera_renderer_gl(r)) {
+		r->native = wl_egl_window_create(r->surface,
+				r->window_size.width, r->window_size.height);
+		r->egl_surface = eglCreateWindowSurface(r->egl.dpy, r->egl.conf,
+				(EGLNativeWindowType) r->native, NULL);
+
+		ret = eglMakeCurrent(r->egl.dpy, r->egl_surface,
+				     r->egl_surface, r->egl.ctx);
+		assert(ret == EGL_TRUE);
+	}
+
+	toggle_fullscreen(r, r->config.fullscreen);
+}
+
+static void
+init_program_sources(void)
+{
+	static const struct {
+		enum camera_program program;
+		const char *head, *body;
+	} formats[] = {
+		{ CAMERA_PROGRAM_UYVY, frag_shader_head_UYVY, frag_shader_body_UYVY },
+		{ CAMERA_PROGRAM_YUYV, frag_shader_head_YUYV, frag_shader_body_YUYV },
+		{ CAMERA_PROGRAM_RGB, frag_shader_head_RGB, frag_shader_body_RGB },
+	};
+	struct gl_program_source *src;
+	unsigned int i, mode;
+
+	if (camera_programs[0].frag)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		for (mode = 0; mode < DEINTERLACE_MODE_COUNT; mode++) {
+			src = &camera_programs[formats[i].program + mode];
+			src->vert = vert_shader_text;
+			src->frag = deinterlace_shader(formats[i].head, mode,
+					formats[i].body);
+			BYE_ON(src->frag == NULL, "Out of memory\n");
+		}
+	}
+	camera_programs[CAMERA_PROGRAM_SGRBG8].vert = vert_shader_text;
+	camera_programs[CAMERA_PROGRAM_SGRBG8].frag = frag_shader_text_SGRBG8;
+}
+
+static GLuint
+init_gl_program(struct camera_renderer *r)
+{
+	enum deinterlace_mode mode = r->config.deinterlace;
+	unsigned int variant;
+
+	switch (r->config.format) {
+	case CAMERA_FORMAT_UYVY:
+		variant = CAMERA_PROGRAM_UYVY + mode;
+		break;
+	case CAMERA_FORMAT_YUYV:
+		/* Imported YUYV buffers are converted into RGB by the sampler. */
+		variant = (r->config.render_type == RENDER_TYPE_GL_DMA) ?
+			CAMERA_PROGRAM_RGB + mode : CAMERA_PROGRAM_YUYV + mode;
+		break;
+	case CAMERA_FORMAT_SGRBG8:
+		variant = CAMERA_PROGRAM_SGRBG8;
+		break;
+	default:
+		variant = CAMERA_PROGRAM_RGB + mode;
+		break;
+	}
+
+	init_program_sources();
+	return gl_program_cache_get(&camera_programs[variant]);
+}
+
+/* Textures the frames are copied into when the buffers can not be imported. */
+static void
+init_upload_textures(struct camera_renderer *r)
+{
+	int i;
+
+	glGenTextures(2, r->gl.texture);
+	for (i = 0; i < 2; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, r->gl.texture[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, texture_format(r), texture_width(r),
+				texture_height(r), 0, texture_format(r),
+				GL_UNSIGNED_BYTE, NULL);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+static void
+init_gl(struct camera_renderer *r)
+{
+	GLuint program;
+	const GLfloat HMI_W = 1.f;
+	const GLfloat HMI_H = 1.f;
+	const GLfloat HMI_Z = 0.f;
+
+	/*
+	 * Buffer lines longer than the image (the IPU pads CSI lines to a
+	 * multiple of 32 pixels) are cropped.
+	 */
+	GLfloat u_max = (GLfloat)r->config.iw / r->config.stride_width;
+
+	program = init_gl_program(r);
+	BYE_ON(!program, "Cannot build the camera shaders\n");
+	r->gl.program = program;
+
+	glUseProgram(program);
+
+	r->gl.pos = glGetAttribLocation(program, "pos");
+	r->gl.attr_tex = glGetAttribLocation(program, "itexcoord");
+	r->gl.modelview_uniform = glGetUniformLocation(program, "modelviewProjection");
+	r->gl.field_first = glGetUniformLocation(program, "u_field_first");
+
+	glUniform2f(glGetUniformLocation(program, "u_texsize"),
+			(float)(r->config.stride_width >> 1), (float)r->config.ih);
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glUniform1i(glGetUniformLocation(program, "u_field"), 0);
+	glUniform1i(glGetUniformLocation(program, "u_field_other"), 1);
+	glUniform1i(glGetUniformLocation(program, "rgb565"),
+			r->config.format == CAMERA_FORMAT_RGB565);
+	glUniform1i(r->gl.field_first, 0);
+
+	/*
+	 * Because GLES does not support BGRA format, red and blue components must
+	 * be swapped in shader, when GL_DMA rendering method is used, texture is
+	 * created using BGRA layout and swap is not required
+	 */
+	glUniform1i(glGetUniformLocation(program, "swap_rb"),
+			r->config.render_type == RENDER_TYPE_GL);
+
+	/* Imported buffers come with textures of their own. */
+	if (r->config.render_type == RENDER_TYPE_GL)
+		init_upload_textures(r);
+
+	glClearColor(.5, .5, .5, .20);
+
+	make_matrix(r->gl.model_view, 1.0);
+	r->gl.hmi_vtx[0] =  -HMI_W;
+	r->gl.hmi_vtx[1] =   HMI_H;
+	r->gl.hmi_vtx[2] =   HMI_Z;
+
+	r->gl.hmi_vtx[3] =  -HMI_W;
+	r->gl.hmi_vtx[4] =  -HMI_H;
+	r->gl.hmi_vtx[5] =   HMI_Z;
+
+	r->gl.hmi_vtx[6] =   HMI_W;
+	r->gl.hmi_vtx[7] =   HMI_H;
+	r->gl.hmi_vtx[8] =   HMI_Z;
+
+	r->gl.hmi_vtx[9]  =  HMI_W;
+	r->gl.hmi_vtx[10] = -HMI_H;
+	r->gl.hmi_vtx[11] =  HMI_Z;
+
+	r->gl.hmi_tex[0] = 0.0f;
+	r->gl.hmi_tex[1] = 0.0f;
+	r->gl.hmi_tex[2] = 0.0f;
+	r->gl.hmi_tex[3] = 1.0f;
+	r->gl.hmi_tex[4] = u_max;
+	r->gl.hmi_tex[5] = 0.0f;
+	r->gl.hmi_tex[6] = u_max;
+	r->gl.hmi_tex[7] = 1.0f;
+
+	r->gl.hmi_ind[0] = 0;
+	r->gl.hmi_ind[1] = 1;
+	r->gl.hmi_ind[2] = 3;
+	r->gl.hmi_ind[3] = 0;
+	r->gl.hmi_ind[4] = 3;
+	r->gl.hmi_ind[5] = 2;
+}
+
+static void
+init_shm(struct camera_renderer *r)
+{
+	unsigned int src_h = (r->config.deinterlace != DEINTERLACE_NONE) ?
+		r->config.ih * 2 : r->config.ih;
+	int ret;
+
+	BYE_ON(r->config.format == CAMERA_FORMAT_RGB565 ||
+			r->config.format == CAMERA_FORMAT_SGRBG8,
+			"Format is not supported with RENDER_TYPE_SHM\n");
+	BYE_ON(r->shm == NULL, "Compositor has no wl_shm\n");
+
+	if (r->config.format == CAMERA_FORMAT_UYVY)
+		r->sw_format = SW_FORMAT_UYVY;
+	else if (r->config.format == CAMERA_FORMAT_YUYV)
+		r->sw_format = SW_FORMAT_YUYV;
+	else
+		r->sw_format = SW_FORMAT_XRGB8888;
+
+	ret = shm_pool_init(&r->shm_pool, r->shm, r->window_size.width,
+			r->window_size.height, SHM_POOL_MAX_BUFFERS);
+	BYE_ON(ret < 0, "Cannot create wl_shm buffers\n");
+
+	r->converter = sw_converter_create(r->config.iw, src_h,
+			r->window_size.width, r->window_size.height,
+			SW_FILTER_BILINEAR);
+	BYE_ON(r->converter == NULL, "Out of memory\n");
+
+	fprintf(stderr, "Rendering camera frames with the CPU (%s)\n",
+			sw_convert_isa());
+}
+
+/* How a capture buffer is imported as a dma-buf for the shaders. */
+static void
+dmabuf_layout(const struct camera_renderer *r, const struct capture_format *format,
+		struct gl_dmabuf_layout *layout)
+{
+	layout->height = r->config.ih;
+	layout->offset = 0;
+	layout->pitch = format->bytes_per_line;
+
+	if (r->config.format == CAMERA_FORMAT_YUYV) {
+		/* The driver converts YUYV into RGB when sampling. */
+		layout->fourcc = DRM_FORMAT_YUYV;
+		layout->width = r->config.stride_width;
+	} else {
+		/* UYVY holds two pixels per texel, converted by the shader. */
+		layout->fourcc = DRM_FORMAT_ARGB8888;
+		layout->width = texture_width(r);
+	}
+}
+
+/* Takes the memory of the capture session buffers, after every (re)start. */
+static void
+take_buffers(struct camera_renderer *r)
+{
+	const struct capture_buffer *cb;
+	unsigned int i;
+
+	for (i = 0; i < r->buffer_count; i++) {
+		cb = CaptureSession_buffer(r->capture, i);
+		r->buffers[i].index = i;
+		r->buffers[i].data = cb->data;
+		r->buffers[i].dbuf_fd = cb->dmabuf_fd;
+		r->buffers[i].flink_name = cb->flink_name;
+	}
+}
+
+void camera_renderer_register_buffers(struct camera_renderer *r)
+{
+	const struct capture_format *format = CaptureSession_format(r->capture);
+	struct gl_dmabuf_layout layout;
+	struct camera_buffer *buf;
+	unsigned int i;
+	int ret;
+
+	take_buffers(r);
+	if (r->config.render_type == RENDER_TYPE_GL_DMA)
+		dmabuf_layout(r, format, &layout);
+
+	for (i = 0; i < r->buffer_count; i++) {
+		buf = &r->buffers[i];
+		if (r->config.render_type == RENDER_TYPE_WL && !buf->buf) {
+			//RGB565 can be displayed but as data is mapped to RGB888 it will have wrong color ie. image will have green tint
+			BYE_ON(r->config.format == CAMERA_FORMAT_RGB565,
+					"RGB565 format is not supported with RENDER_TYPE_WL\n");
+			buf->buf = wl_drm_create_buffer(r->wl_drm, buf->flink_name,
+					r->config.stride_width, r->config.ih,
+					format->bytes_per_line,
+					(r->config.format == CAMERA_FORMAT_YUYV) ?
+					WL_DRM_FORMAT_YUYV : WL_DRM_FORMAT_XRGB8888);
+		} else if (r->config.render_type == RENDER_TYPE_GL_DMA && !buf->gl.texture) {
+			ret = gl_dmabuf_image_create(r->egl.dpy, buf->dbuf_fd,
+					&layout, &buf->gl);
+			BYE_ON(ret < 0, "Cannot create texture from DMA buffer\n");
+		}
+	}
+}
+
+void camera_renderer_unregister_buffers(struct camera_renderer *r)
+{
+	struct camera_buffer *buf;
+	unsigned int i;
+
+	for (i = 0; i < r->buffer_count; i++) {
+		buf = &r->buffers[i];
+		if (buf->buf) {
+			wl_buffer_destroy(buf->buf);
+			buf->buf = NULL;
+		}
+		if (camera_renderer_gl(r))
+			gl_dmabuf_image_destroy(r->egl.dpy, &buf->gl);
+	}
+}
+
+int camera_renderer_init(struct camera_renderer *r, void *session,
+		const struct camera_renderer_config *config)
+{
+	memset(r, 0, sizeof(*r));
+	r->config = *config;
+	r->capture = session;
+	r->wakeup_fd = -1;
+	r->pending_top = r->last_field = FRAME_MAILBOX_NONE;
+	r->window_size.width = config->width;
+	r->window_size.height = config->height;
+	frame_mailbox_init(&r->mailbox);
+
+	r->buffer_count = CaptureSession_buffer_count(session);
+	r->buffers = calloc(r->buffer_count, sizeof(*r->buffers));
+	if (!r->buffers)
+		return -1;
+	take_buffers(r);
+
+	/* UYVY can not be flipped directly and fields can not be deinterlaced. */
+	if (r->config.render_type == RENDER_TYPE_WL &&
+			(r->config.format == CAMERA_FORMAT_UYVY ||
+			 r->config.deinterlace != DEINTERLACE_NONE))
+		r->config.render_type = RENDER_TYPE_SHM;
+	/* wl_drm needs GEM buffers. */
+	if (r->config.render_type == RENDER_TYPE_WL && r->buffers[0].dbuf_fd < 0)
+		r->config.render_type = RENDER_TYPE_GL;
+	return 0;
+}
+
+void camera_renderer_connect(struct camera_renderer *r, struct wl_display *display)
+{
+	struct stat tmp;
+	char wayland_path[255];
+
+	snprintf(wayland_path, 255, "%s/wayland-0", getenv("XDG_RUNTIME_DIR"));
+	while (stat(wayland_path, &tmp) != 0) {
+		usleep(100);
+	}
+
+	r->display = display;
+	assert(r->display);
+	wl_list_init(&r->output_list);
+
+	r->registry = wl_display_get_registry(r->display);
+	wl_registry_add_listener(r->registry, &registry_listener, r);
+
+	wl_display_dispatch(r->display);
+	wl_display_roundtrip(r->display);
+	if (camera_renderer_gl(r) && init_egl(r) < 0) {
+		fprintf(stderr, "EGL is not available, falling back to RENDER_TYPE_SHM\n");
+		r->config.render_type = RENDER_TYPE_SHM;
+	}
+
+	create_surface(r);
+
+	/* Sample the capture buffers in place instead of copying every frame,
+	 * Bayer frames still need the CPU layout of the upload. */
+	if (camera_renderer_gl(r))
+		r->config.render_type = (r->buffers[0].dbuf_fd >= 0 &&
+				r->config.format != CAMERA_FORMAT_SGRBG8 &&
+				gl_dmabuf_image_supported(r->egl.dpy)) ?
+			RENDER_TYPE_GL_DMA : RENDER_TYPE_GL;
+	render_stats_init(&r->render_stats, render_path_name(r->config.render_type));
+
+	if (camera_renderer_gl(r)) {
+		init_gl(r);
+	} else if (r->config.render_type == RENDER_TYPE_SHM) {
+		init_shm(r);
+	}
+	camera_renderer_register_buffers(r);
+
+	r->fps_start_ns = frame_mailbox_now_ns();
+	r->connected = 1;
+}
+
+void camera_renderer_show(struct camera_renderer *r)
+{
+	EGLBoolean ret;
+
+	if (camera_renderer_gl(r)) {
+		ret = eglMakeCurrent(r->egl.dpy, r->egl_surface,
+				r->egl_surface, r->egl.ctx);
+		assert(ret == EGL_TRUE);
+	}
+
+	r->frame_count = 0;
+	r->fps_start_ns = frame_mailbox_now_ns();
+
+	/* The first commit maps the surface and restarts the frame callbacks. */
+	if (r->configured && r->callback == NULL)
+		redraw(r, NULL, 0);
+}
+
+void camera_renderer_hide(struct camera_renderer *r)
+{
+	CaptureSession_suspend(r->capture);
+	frame_mailbox_init(&r->mailbox);
+
+	if (r->callback) {
+		wl_callback_destroy(r->callback);
+		r->callback = NULL;
+	}
+	wl_surface_attach(r->surface, NULL, 0, 0);
+	wl_surface_commit(r->surface);
+	wl_display_flush(r->display);
+
+	/* The next session renders from another thread. */
+	if (camera_renderer_gl(r))
+		eglMakeCurrent(r->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+				EGL_NO_CONTEXT);
+}
+
+void camera_renderer_fini(struct camera_renderer *r)
+{
+	struct camera_output *output, *tmp;
+
+	if (!r->connected) {
+		CaptureSession_stop(r->capture);
+		free(r->buffers);
+		memset(r, 0, sizeof(*r));
+		return;
+	}
+
+	/* The textures go with the context they were created in. */
+	if (camera_renderer_gl(r))
+		eglMakeCurrent(r->egl.dpy, r->egl_surface, r->egl_surface, r->egl.ctx);
+	camera_renderer_unregister_buffers(r);
+	CaptureSession_stop(r->capture);
+	if (r->config.render_type == RENDER_TYPE_SHM) {
+		shm_pool_fini(&r->shm_pool);
+		sw_converter_destroy(r->converter);
+	}
+	destroy_surface(r);
+	if (camera_renderer_gl(r)) {
+		eglDestroyContext(r->egl.dpy, r->egl.ctx);
+		eglTerminate(r->egl.dpy);
+	}
+
+	if (r->ias_shell)
+		ias_shell_destroy(r->ias_shell);
+	if (r->wl_shell)
+		wl_shell_destroy(r->wl_shell);
+	if (r->ivi_application)
+		ivi_application_destroy(r->ivi_application);
+	if (r->wl_drm)
+		wl_drm_destroy(r->wl_drm);
+	if (r->shm)
+		wl_shm_destroy(r->shm);
+	if (r->compositor)
+		wl_compositor_destroy(r->compositor);
+	wl_list_for_each_safe(output, tmp, &r->output_list, link) {
+		wl_output_destroy(output->output);
+		free(output);
+	}
+	wl_registry_destroy(r->registry);
+	wl_display_flush(r->display);
+
+	free(r->buffers);
+	memset(r, 0, sizeof(*r));
+}
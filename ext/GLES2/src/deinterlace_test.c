@@ -0,0 +1,442 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Deinterlacing checks. The weave, bob and motion shaders and the CPU
+ * converter are compared with a reference implementation on a fixed field
+ * pair, the GL output read back with glReadPixels from an offscreen EGL
+ * context.
+ *
+ * Usage: deinterlace_test       mode selection and the CPU converter
+ *        deinterlace_test gl    the shaders, exits with 77 without EGL/GLES2
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include "gl_deinterlace.h"
+#include "sw_convert.h"
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+
+/* Field size, the frame is twice as high. */
+#define FIELD_W		16
+#define FIELD_H		8
+
+#define EXIT_SKIP	77
+
+/* Largest channel difference to the reference, in 8 bit steps. */
+#define TOLERANCE	2
+
+static int failures;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+/* RGBA8 fields, which the CPU converter takes as XRGB8888. */
+static uint8_t field[FIELD_H][FIELD_W][4];
+static uint8_t other[FIELD_H][FIELD_W][4];
+
+/*
+ * The opposite field matches the interpolation of the current (top) field
+ * within 3 steps in the left columns (static), by 20 steps in the middle
+ * ones (between static and motion) and not at all on the right (motion).
+ */
+static void make_fields(void)
+{
+	int x, y, c, interp, offset;
+
+	for (y = 0; y < FIELD_H; y++)
+		for (x = 0; x < FIELD_W; x++)
+			for (c = 0; c < 4; c++)
+				field[y][x][c] = (y * 29 + x * 13 + c * 71) % 200 + 20;
+
+	for (y = 0; y < FIELD_H; y++) {
+		for (x = 0; x < FIELD_W; x++) {
+			for (c = 0; c < 4; c++) {
+				interp = (field[y][x][c] + field[y + 1 < FIELD_H ? y + 1 : y][x][c]) / 2;
+				offset = (x < 6) ? 3 : (x < 8) ? 20 : 0;
+				other[y][x][c] = (x < 8) ? interp + offset : 255 - interp;
+			}
+		}
+	}
+}
+
+static float smoothstep(float e0, float e1, float x)
+{
+	float t = (x - e0) / (e1 - e0);
+
+	t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+	return t * t * (3.0f - 2.0f * t);
+}
+
+/* Frame line @y of the field pair, in 0..1, as the shaders define it. */
+static void reference_line(enum deinterlace_mode mode, int field_first,
+		int y, float out[FIELD_W][4])
+{
+	int row = y / 2, near, x, c;
+	float spatial[4], temporal[4], motion, t;
+
+	for (x = 0; x < FIELD_W; x++) {
+		if (((y & 1) == 0) == !!field_first || mode == DEINTERLACE_NONE) {
+			for (c = 0; c < 4; c++)
+				out[x][c] = field[mode == DEINTERLACE_NONE ? y % FIELD_H : row][x][c] / 255.0f;
+			continue;
+		}
+		if (mode == DEINTERLACE_WEAVE) {
+			for (c = 0; c < 4; c++)
+				out[x][c] = other[row][x][c] / 255.0f;
+			continue;
+		}
+
+		/* Rows past the edge are clamped, as the textures are. */
+		near = field_first ? row + 1 : row - 1;
+		if (near < 0 || near >= FIELD_H)
+			near = row;
+		motion = 0.0f;
+		for (c = 0; c < 4; c++) {
+			spatial[c] = (field[row][x][c] + field[near][x][c]) / 2 / 255.0f;
+			temporal[c] = other[row][x][c] / 255.0f;
+			motion = fmaxf(motion, fabsf(temporal[c] - spatial[c]));
+		}
+		t = (mode == DEINTERLACE_MOTION) ? smoothstep(0.04f, 0.12f, motion) : 1.0f;
+		for (c = 0; c < 4; c++)
+			out[x][c] = temporal[c] + (spatial[c] - temporal[c]) * t;
+	}
+}
+
+/* Compares a frame of FIELD_W x 2 * FIELD_H RGBA8 pixels with the reference. */
+static int compare(const char *what, enum deinterlace_mode mode,
+		int field_first, const uint8_t *frame)
+{
+	float ref[FIELD_W][4];
+	int x, y, c, diff, worst = 0;
+
+	for (y = 0; y < 2 * FIELD_H; y++) {
+		reference_line(mode, field_first, y, ref);
+		for (x = 0; x < FIELD_W; x++) {
+			for (c = 0; c < 4; c++) {
+				diff = abs(frame[(y * FIELD_W + x) * 4 + c] - (int) lrintf(ref[x][c] * 255.0f));
+				if (diff > worst)
+					worst = diff;
+				if (diff > TOLERANCE) {
+					fprintf(stderr, "%s: line %d, x %d, channel %d: %d, expected %.2f\n",
+						what, y, x, c, frame[(y * FIELD_W + x) * 4 + c],
+						ref[x][c] * 255.0f);
+					return -1;
+				}
+			}
+		}
+	}
+	printf("%-28s max difference %d\n", what, worst);
+	return 0;
+}
+
+static void test_modes(void)
+{
+	static const char *const names[DEINTERLACE_MODE_COUNT] = {
+		"none", "weave", "bob", "motion",
+	};
+	enum deinterlace_mode mode;
+	const char *text;
+	int i;
+
+	for (i = 0; i < DEINTERLACE_MODE_COUNT; i++) {
+		mode = DEINTERLACE_MODE_COUNT;
+		CHECK(deinterlace_mode_from_string(names[i], &mode) == 0);
+		CHECK(mode == (enum deinterlace_mode) i);
+	}
+	mode = DEINTERLACE_BOB;
+	CHECK(deinterlace_mode_from_string("", &mode) == -1);
+	CHECK(deinterlace_mode_from_string("Bob", &mode) == -1);
+	CHECK(deinterlace_mode_from_string("motion-adaptive", &mode) == -1);
+	CHECK(mode == DEINTERLACE_BOB);
+
+	/* Weave presents a field pair as one frame, bob and motion every field. */
+	CHECK(!deinterlace_field_rate(DEINTERLACE_NONE));
+	CHECK(!deinterlace_field_rate(DEINTERLACE_WEAVE));
+	CHECK(deinterlace_field_rate(DEINTERLACE_BOB));
+	CHECK(deinterlace_field_rate(DEINTERLACE_MOTION));
+
+	/* Unknown modes get the progressive fetch. */
+	text = deinterlace_shader("", DEINTERLACE_MODE_COUNT, "");
+	CHECK(text && strstr(text, "deinterlace_fetch") && !strstr(text, "field_owns"));
+	text = deinterlace_shader("", DEINTERLACE_MOTION, "");
+	CHECK(text && strstr(text, "u_field_other") && strstr(text, "smoothstep"));
+}
+
+/* The CPU converter weaves and line doubles like the shaders, motion is bob. */
+static void test_sw_convert(void)
+{
+	static const enum deinterlace_mode modes[] = {
+		DEINTERLACE_WEAVE, DEINTERLACE_BOB, DEINTERLACE_MOTION,
+	};
+	static uint8_t out[2 * FIELD_H][FIELD_W][4];
+	struct sw_converter *conv;
+	struct sw_frame frame;
+	char what[64];
+	unsigned int i;
+	int first;
+
+	conv = sw_converter_create(FIELD_W, 2 * FIELD_H, FIELD_W, 2 * FIELD_H,
+			SW_FILTER_NEAREST);
+	CHECK(conv != NULL);
+	if (!conv)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++) {
+		for (first = 0; first < 2; first++) {
+			memset(&frame, 0, sizeof(frame));
+			frame.format = SW_FORMAT_XRGB8888;
+			frame.width = FIELD_W;
+			frame.height = FIELD_H;
+			frame.stride = FIELD_W * 4;
+			frame.field = &field[0][0][0];
+			frame.other = &other[0][0][0];
+			frame.mode = modes[i];
+			frame.field_first = first;
+			memset(out, 0, sizeof(out));
+			sw_convert_frame(conv, &frame, out, FIELD_W * 4);
+
+			snprintf(what, sizeof(what), "cpu %s, %s field", modes[i] == DEINTERLACE_WEAVE
+				? "weave" : modes[i] == DEINTERLACE_BOB ? "bob" : "motion as bob",
+				first ? "top" : "bottom");
+			CHECK(compare(what, modes[i] == DEINTERLACE_MOTION ? DEINTERLACE_BOB : modes[i],
+				first, &out[0][0][0]) == 0);
+		}
+	}
+	sw_converter_destroy(conv);
+}
+
+static const char vert_shader_text[] =
+  "attribute vec2 pos;"\
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;"\
+  "uniform mediump vec2 u_texsize;"\
+  "void main(void) {"\
+  "  texcoord = pos * 0.5 + 0.5;"\
+  "  texsize = u_texsize;"\
+  "  gl_Position = vec4(pos, 0.0, 1.0);"\
+  "}";
+
+static const char frag_shader_head[] =
+  "varying highp vec2 texcoord;"\
+  "varying mediump vec2 texsize;";
+
+static const char frag_shader_body[] =
+  "void main(void) {"\
+  "  gl_FragColor = deinterlace_fetch(texcoord);"\
+  "}";
+
+static int init_egl(void)
+{
+	static const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	static const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	static const EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+	EGLDisplay dpy = EGL_NO_DISPLAY;
+	EGLConfig config;
+	EGLSurface surface;
+	EGLContext context;
+	EGLint n;
+
+	/* Offscreen without a window system where Mesa has it. */
+	get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+		eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	if (get_platform_display)
+		dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+	if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)) {
+		dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL))
+			return -1;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_ES_API) ||
+	    !eglChooseConfig(dpy, config_attribs, &config, 1, &n) || n < 1)
+		return -1;
+	surface = eglCreatePbufferSurface(dpy, config, pbuffer_attribs);
+	context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT ||
+	    !eglMakeCurrent(dpy, surface, surface, context))
+		return -1;
+
+	printf("GL renderer: %s\n", glGetString(GL_RENDERER));
+	return 0;
+}
+
+static GLuint create_shader(const char *source, GLenum type)
+{
+	GLuint shader = glCreateShader(type);
+	GLint status;
+	char log[1000];
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "shader compile error: %s\n", log);
+		return 0;
+	}
+	return shader;
+}
+
+static GLuint create_texture(const void *pixels)
+{
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	/* As the camera renderers set them up. */
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FIELD_W, FIELD_H, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, pixels);
+	return tex;
+}
+
+/* Renders the field pair with the deinterlacer of @mode into @frame. */
+static int render(enum deinterlace_mode mode, int field_first, uint8_t *frame)
+{
+	static const GLfloat quad[] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+	GLuint vert, frag, program, tex[2], fbo, target;
+	GLint status;
+
+	vert = create_shader(vert_shader_text, GL_VERTEX_SHADER);
+	frag = create_shader(deinterlace_shader(frag_shader_head, mode, frag_shader_body),
+			GL_FRAGMENT_SHADER);
+	if (!vert || !frag)
+		return -1;
+	program = glCreateProgram();
+	glAttachShader(program, vert);
+	glAttachShader(program, frag);
+	glBindAttribLocation(program, 0, "pos");
+	glLinkProgram(program);
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status) {
+		fprintf(stderr, "program link error\n");
+		return -1;
+	}
+
+	tex[0] = create_texture(field);
+	tex[1] = create_texture(other);
+
+	/* Line 0 of the frame is row 0 of the framebuffer, as read back. */
+	glGenTextures(1, &target);
+	glBindTexture(GL_TEXTURE_2D, target);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FIELD_W, 2 * FIELD_H, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, NULL);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		fprintf(stderr, "framebuffer incomplete\n");
+		return -1;
+	}
+
+	glViewport(0, 0, FIELD_W, 2 * FIELD_H);
+	glUseProgram(program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tex[0]);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, tex[1]);
+	glUniform1i(glGetUniformLocation(program, "u_field"), 0);
+	glUniform1i(glGetUniformLocation(program, "u_field_other"), 1);
+	glUniform1i(glGetUniformLocation(program, "u_field_first"), field_first);
+	glUniform2f(glGetUniformLocation(program, "u_texsize"), FIELD_W, FIELD_H);
+
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+	glEnableVertexAttribArray(0);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glReadPixels(0, 0, FIELD_W, 2 * FIELD_H, GL_RGBA, GL_UNSIGNED_BYTE, frame);
+
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &target);
+	glDeleteTextures(2, tex);
+	glDeleteProgram(program);
+	glDeleteShader(frag);
+	glDeleteShader(vert);
+	return glGetError() == GL_NO_ERROR ? 0 : -1;
+}
+
+static void test_gl(void)
+{
+	static const char *const names[DEINTERLACE_MODE_COUNT] = {
+		"none", "weave", "bob", "motion",
+	};
+	static uint8_t frame[2 * FIELD_H][FIELD_W][4];
+	char what[64];
+	int mode, first;
+
+	for (mode = DEINTERLACE_WEAVE; mode < DEINTERLACE_MODE_COUNT; mode++) {
+		for (first = 0; first < 2; first++) {
+			memset(frame, 0, sizeof(frame));
+			CHECK(render(mode, first, &frame[0][0][0]) == 0);
+			snprintf(what, sizeof(what), "gl %s, %s field", names[mode],
+				first ? "top" : "bottom");
+			CHECK(compare(what, mode, first, &frame[0][0][0]) == 0);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	make_fields();
+
+	if (argc > 1 && strcmp(argv[1], "gl") == 0) {
+		if (init_egl() < 0) {
+			printf("no EGL/GLES2 context, skipped\n");
+			return EXIT_SKIP;
+		}
+		test_gl();
+	} else {
+		test_modes();
+		test_sw_convert();
+	}
+
+	if (failures == 0)
+		printf("deinterlace tests passed\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_deinterlace.h"
+
+static const char *const mode_names[DEINTERLACE_MODE_COUNT] = {
+	[DEINTERLACE_NONE] = "none",
+	[DEINTERLACE_WEAVE] = "weave",
+	[DEINTERLACE_BOB] = "bob",
+	[DEINTERLACE_MOTION] = "motion",
+};
+
+static const char fetch_uniforms[] =
+  "uniform sampler2D u_field;"\
+  "uniform sampler2D u_field_other;"\
+  "uniform bool u_field_first;";
+
+/* Line pairs: field row r covers output lines 2r and 2r + 1. */
+static const char fetch_rows[] =
+  "mediump vec4 field_row(sampler2D field, highp float x, highp float row) {"\
+  "  return texture2D(field, vec2(x, (row + 0.5) / texsize.y));"\
+  "}"\
+  "bool field_owns(highp vec2 tc) {"\
+  "  return (fract(tc.y * texsize.y) < 0.5) == u_field_first;"\
+  "}"\
+  "mediump vec4 field_interpolate(highp vec2 tc) {"\
+  "  highp float row = floor(tc.y * texsize.y);"\
+  "  highp float next = u_field_first ? row + 1.0 : row - 1.0;"\
+  "  return mix(field_row(u_field, tc.x, row), field_row(u_field, tc.x, next), 0.5);"\
+  "}";
+
+static const char fetch_none[] =
+  "mediump vec4 deinterlace_fetch(highp vec2 tc) {"\
+  "  return texture2D(u_field, tc);"\
+  "}";
+
+static const char fetch_weave[] =
+  "mediump vec4 deinterlace_fetch(highp vec2 tc) {"\
+  "  if (field_owns(tc))"\
+  "    return texture2D(u_field, tc);"\
+  "  return texture2D(u_field_other, tc);"\
+  "}";
+
+static const char fetch_bob[] =
+  "mediump vec4 deinterlace_fetch(highp vec2 tc) {"\
+  "  if (field_owns(tc))"\
+  "    return texture2D(u_field, tc);"\
+  "  return field_interpolate(tc);"\
+  "}";
+
+/*
+ * The previous field is trusted where it is close to the spatial
+ * interpolation. Two fields can not tell motion from vertical detail, so
+ * sharp horizontal edges are softened like moving content.
+ */
+static const char fetch_motion[] =
+  "mediump vec4 deinterlace_fetch(highp vec2 tc) {"\
+  "  mediump vec4 spatial, temporal, diff;"\
+  "  mediump float motion;"\
+  "  if (field_owns(tc))"\
+  "    return texture2D(u_field, tc);"\
+  "  spatial = field_interpolate(tc);"\
+  "  temporal = texture2D(u_field_other, tc);"\
+  "  diff = abs(temporal - spatial);"\
+  "  motion = max(max(diff.r, diff.g), max(diff.b, diff.a));"\
+  "  return mix(temporal, spatial, smoothstep(0.04, 0.12, motion));"\
+  "}";
+
+static const char *const fetch_text[DEINTERLACE_MODE_COUNT] = {
+	[DEINTERLACE_NONE] = fetch_none,
+	[DEINTERLACE_WEAVE] = fetch_weave,
+	[DEINTERLACE_BOB] = fetch_bob,
+	[DEINTERLACE_MOTION] = fetch_motion,
+};
+
+int deinterlace_mode_from_string(const char *name, enum deinterlace_mode *mode)
+{
+	int i;
+
+	for (i = 0; i < DEINTERLACE_MODE_COUNT; i++) {
+		if (strcmp(name, mode_names[i]) == 0) {
+			*mode = (enum deinterlace_mode)i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+const char *deinterlace_shader(const char *head, enum deinterlace_mode mode,
+		const char *body)
+{
+	const char *rows;
+	size_t len;
+	char *text;
+
+	if (mode >= DEINTERLACE_MODE_COUNT)
+		mode = DEINTERLACE_NONE;
+	rows = (mode == DEINTERLACE_NONE) ? "" : fetch_rows;
+
+	len = strlen(head) + sizeof(fetch_uniforms) + strlen(rows)
+		+ strlen(fetch_text[mode]) + strlen(body) + 1;
+	text = malloc(len);
+	if (!text)
+		return NULL;
+
+	snprintf(text, len, "%s%s%s%s%s", head, fetch_uniforms, rows,
+			fetch_text[mode], body);
+	return text;
+}
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "gl_dmabuf_image.h"
+
+static PFNEGLCREATEIMAGEKHRPROC create_image;
+static PFNEGLDESTROYIMAGEKHRPROC destroy_image;
+static PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture;
+static pthread_once_t resolve_once = PTHREAD_ONCE_INIT;
+
+static void resolve_entry_points(void)
+{
+	create_image = (PFNEGLCREATEIMAGEKHRPROC)
+		eglGetProcAddress("eglCreateImageKHR");
+	destroy_image = (PFNEGLDESTROYIMAGEKHRPROC)
+		eglGetProcAddress("eglDestroyImageKHR");
+	image_target_texture = (PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)
+		eglGetProcAddress("glEGLImageTargetTexture2DOES");
+}
+
+int gl_dmabuf_image_supported(EGLDisplay dpy)
+{
+	const char *egl_ext = eglQueryString(dpy, EGL_EXTENSIONS);
+	const char *gl_ext = (const char *)glGetString(GL_EXTENSIONS);
+
+	if (!egl_ext || !strstr(egl_ext, "EGL_KHR_image_base") ||
+	    !strstr(egl_ext, "EGL_EXT_image_dma_buf_import"))
+		return 0;
+	if (!gl_ext || !strstr(gl_ext, "GL_OES_EGL_image"))
+		return 0;
+
+	pthread_once(&resolve_once, resolve_entry_points);
+	return create_image && destroy_image && image_target_texture;
+}
+
+int gl_dmabuf_image_create(EGLDisplay dpy, int fd,
+		const struct gl_dmabuf_layout *layout, struct gl_dmabuf_image *img)
+{
+	EGLint attribs[] = {
+		EGL_WIDTH, layout->width,
+		EGL_HEIGHT, layout->height,
+		EGL_LINUX_DRM_FOURCC_EXT, (EGLint)layout->fourcc,
+		EGL_DMA_BUF_PLANE0_FD_EXT, fd,
+		EGL_DMA_BUF_PLANE0_OFFSET_EXT, layout->offset,
+		EGL_DMA_BUF_PLANE0_PITCH_EXT, layout->pitch,
+		EGL_NONE
+	};
+
+	img->image = EGL_NO_IMAGE_KHR;
+	img->texture = 0;
+
+	pthread_once(&resolve_once, resolve_entry_points);
+	if (fd < 0 || !create_image || !image_target_texture)
+		return -1;
+
+	img->image = create_image(dpy, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+			(EGLClientBuffer)NULL, attribs);
+	if (img->image == EGL_NO_IMAGE_KHR) {
+		fprintf(stderr, "Cannot import dma-buf %d (%.4s %dx%d pitch %d): 0x%x\n",
+			fd, (const char *)&layout->fourcc, layout->width,
+			layout->height, layout->pitch, eglGetError());
+		return -1;
+	}
+
+	/* Only report errors of the import itself. */
+	while (glGetError() != GL_NO_ERROR)
+		;
+
+	glGenTextures(1, &img->texture);
+	glBindTexture(GL_TEXTURE_2D, img->texture);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	image_target_texture(GL_TEXTURE_2D, (GLeglImageOES)img->image);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (glGetError() != GL_NO_ERROR) {
+		fprintf(stderr, "Cannot bind dma-buf %d to a texture\n", fd);
+		gl_dmabuf_image_destroy(dpy, img);
+		return -1;
+	}
+	return 0;
+}
+
+void gl_dmabuf_image_destroy(EGLDisplay dpy, struct gl_dmabuf_image *img)
+{
+	if (img->texture) {
+		glDeleteTextures(1, &img->texture);
+		img->texture = 0;
+	}
+	if (img->image != EGL_NO_IMAGE_KHR && destroy_image)
+		destroy_image(dpy, img->image);
+	img->image = EGL_NO_IMAGE_KHR;
+}
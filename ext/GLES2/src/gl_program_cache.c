@@ -0,0 +1,480 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "gl_program_cache.h"
+
+#define PRECOMPILE_NICE 19
+
+struct gl_program_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t driver_hash;
+	uint64_t source_hash;
+	uint32_t format;
+	uint32_t length;
+	uint64_t binary_hash;
+};
+
+struct precompile_job {
+	EGLDisplay dpy;
+	EGLConfig conf;
+	unsigned int count;
+	struct gl_program_source srcs[];
+};
+
+static PFNGLPROGRAMBINARYOESPROC program_binary;
+static PFNGLGETPROGRAMBINARYOESPROC get_program_binary;
+static pthread_once_t resolve_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t precompile_lock = PTHREAD_MUTEX_INITIALIZER;
+static int precompile_started;
+
+static uint64_t fnv64(uint64_t hash, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/* Hashes the string including its terminator so "ab","c" differs from "a","bc". */
+static uint64_t fnv64_str(uint64_t hash, const char *s)
+{
+	if (!s)
+		s = "";
+	return fnv64(hash, s, strlen(s) + 1);
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0
+		+ (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void resolve_entry_points(void)
+{
+	const char *ext = (const char *)glGetString(GL_EXTENSIONS);
+	GLint formats = 0;
+
+	if (!ext || !strstr(ext, "GL_OES_get_program_binary"))
+		return;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+	if (formats <= 0)
+		return;
+
+	program_binary = (PFNGLPROGRAMBINARYOESPROC)
+		eglGetProcAddress("glProgramBinaryOES");
+	get_program_binary = (PFNGLGETPROGRAMBINARYOESPROC)
+		eglGetProcAddress("glGetProgramBinaryOES");
+	if (!program_binary || !get_program_binary) {
+		program_binary = NULL;
+		get_program_binary = NULL;
+	}
+}
+
+static uint64_t driver_hash(void)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	hash = fnv64_str(hash, (const char *)glGetString(GL_VENDOR));
+	hash = fnv64_str(hash, (const char *)glGetString(GL_RENDERER));
+	hash = fnv64_str(hash, (const char *)glGetString(GL_VERSION));
+	return hash;
+}
+
+static uint64_t source_hash(const struct gl_program_source *src)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const char *const *attr;
+
+	hash = fnv64_str(hash, src->vert);
+	hash = fnv64_str(hash, src->frag);
+	for (attr = src->attribs; attr && *attr; attr++)
+		hash = fnv64_str(hash, *attr);
+	return hash;
+}
+
+static void cache_path(char *path, size_t len, uint64_t drv, uint64_t source)
+{
+	snprintf(path, len, GL_PROGRAM_CACHE_DIR "/%016llx-%016llx.bin",
+			(unsigned long long)drv, (unsigned long long)source);
+}
+
+static int mkdir_p(const char *dir)
+{
+	char tmp[sizeof(GL_PROGRAM_CACHE_DIR)];
+	char *p;
+
+	strcpy(tmp, dir);
+	for (p = tmp + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(tmp, 0755) < 0 && errno != EEXIST)
+			return -1;
+		*p = '/';
+	}
+	if (mkdir(tmp, 0755) < 0 && errno != EEXIST)
+		return -1;
+	return 0;
+}
+
+static GLuint compile_shader(const char *source, GLenum type)
+{
+	GLuint shader;
+	GLint status;
+
+	shader = glCreateShader(type);
+	if (!shader)
+		return 0;
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		char log[1000];
+		GLsizei len;
+		glGetShaderInfoLog(shader, sizeof(log), &len, log);
+		fprintf(stderr, "Error: compiling %s: %*s\n",
+			type == GL_VERTEX_SHADER ? "vertex" : "fragment",
+			len, log);
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static GLuint link_program(const struct gl_program_source *src)
+{
+	const char *const *attr;
+	GLuint program, vert, frag;
+	GLint status;
+	GLuint i;
+
+	vert = compile_shader(src->vert, GL_VERTEX_SHADER);
+	frag = compile_shader(src->frag, GL_FRAGMENT_SHADER);
+	if (!vert || !frag) {
+		glDeleteShader(vert);
+		glDeleteShader(frag);
+		return 0;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, frag);
+	glAttachShader(program, vert);
+	for (attr = src->attribs, i = 0; attr && *attr; attr++, i++)
+		glBindAttribLocation(program, i, *attr);
+	glLinkProgram(program);
+
+	/* The program keeps the executable, the shader objects are not needed. */
+	glDetachShader(program, frag);
+	glDetachShader(program, vert);
+	glDeleteShader(frag);
+	glDeleteShader(vert);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status) {
+		char log[1000];
+		GLsizei len;
+		glGetProgramInfoLog(program, sizeof(log), &len, log);
+		fprintf(stderr, "Error: linking:\n%*s\n", len, log);
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+static GLuint cache_load(const char *path, uint64_t drv, uint64_t source)
+{
+	struct gl_program_cache_header hdr;
+	struct stat st;
+	GLuint program = 0;
+	GLint status;
+	void *binary = NULL;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+
+	if (fstat(fd, &st) < 0
+			|| read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)
+			|| hdr.magic != GL_PROGRAM_CACHE_MAGIC
+			|| hdr.version != GL_PROGRAM_CACHE_VERSION
+			|| hdr.driver_hash != drv
+			|| hdr.source_hash != source
+			|| hdr.length == 0
+			|| (off_t)(sizeof(hdr) + hdr.length) != st.st_size)
+		goto stale;
+
+	binary = malloc(hdr.length);
+	if (!binary)
+		goto out;
+	if (read(fd, binary, hdr.length) != (ssize_t)hdr.length
+			|| fnv64(14695981039346656037ull, binary, hdr.length) != hdr.binary_hash)
+		goto stale;
+
+	program = glCreateProgram();
+	program_binary(program, hdr.format, binary, hdr.length);
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status)
+		goto out;
+
+	/* The driver rejected the binary, e.g. after a firmware update. */
+	glDeleteProgram(program);
+	program = 0;
+
+stale:
+	printf("GL program cache %s is stale\n", path);
+	unlink(path);
+out:
+	free(binary);
+	close(fd);
+	return program;
+}
+
+static int cache_save(GLuint program, const char *path, uint64_t drv, uint64_t source)
+{
+	char tmp_path[PATH_MAX];
+	struct gl_program_cache_header hdr;
+	GLint length = 0;
+	GLenum format;
+	void *binary;
+	int fd, ret = -1;
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+	if (length <= 0)
+		return -1;
+
+	binary = malloc(length);
+	if (!binary)
+		return -1;
+	get_program_binary(program, length, &length, &format, binary);
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = GL_PROGRAM_CACHE_MAGIC;
+	hdr.version = GL_PROGRAM_CACHE_VERSION;
+	hdr.driver_hash = drv;
+	hdr.source_hash = source;
+	hdr.format = format;
+	hdr.length = length;
+	hdr.binary_hash = fnv64(14695981039346656037ull, binary, length);
+
+	if (mkdir_p(GL_PROGRAM_CACHE_DIR) < 0)
+		goto out;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+	fd = mkstemp(tmp_path);
+	if (fd < 0)
+		goto out;
+
+	if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)
+			|| write(fd, binary, length) != (ssize_t)length
+			|| fsync(fd) < 0) {
+		close(fd);
+		unlink(tmp_path);
+		goto out;
+	}
+	close(fd);
+
+	/* Readers see either no cache or the complete binary. */
+	if (rename(tmp_path, path) < 0) {
+		unlink(tmp_path);
+		goto out;
+	}
+	ret = 0;
+out:
+	free(binary);
+	return ret;
+}
+
+static GLuint program_get(const struct gl_program_source *src, uint64_t drv,
+		int *from_cache)
+{
+	char path[PATH_MAX];
+	uint64_t source = source_hash(src);
+	GLuint program;
+
+	*from_cache = 0;
+	if (!program_binary)
+		return link_program(src);
+
+	cache_path(path, sizeof(path), drv, source);
+	program = cache_load(path, drv, source);
+	if (program) {
+		*from_cache = 1;
+		return program;
+	}
+
+	program = link_program(src);
+	if (program && cache_save(program, path, drv, source) < 0)
+		printf("Cannot store GL program cache %s: %s\n", path, strerror(errno));
+	return program;
+}
+
+GLuint gl_program_cache_get(const struct gl_program_source *src)
+{
+	struct timespec start;
+	GLuint program;
+	int from_cache;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_once(&resolve_once, resolve_entry_points);
+
+	program = program_get(src, driver_hash(), &from_cache);
+	if (program)
+		printf("GL program %016llx %-18s | %6.02f ms\n",
+				(unsigned long long)source_hash(src),
+				from_cache ? "loaded from cache" : "linked from source",
+				elapsed_ms(&start));
+	return program;
+}
+
+static void *precompile_thread(void *data)
+{
+	static const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+	struct precompile_job *job = data;
+	struct timespec start;
+	EGLContext ctx;
+	unsigned int i, linked = 0;
+	uint64_t drv;
+	GLuint program;
+	int from_cache;
+
+	/* Stay out of the way of the capture and render threads. */
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), PRECOMPILE_NICE);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	eglBindAPI(EGL_OPENGL_ES_API);
+	ctx = eglCreateContext(job->dpy, job->conf, EGL_NO_CONTEXT, context_attribs);
+	if (ctx == EGL_NO_CONTEXT)
+		goto out;
+	if (!eglMakeCurrent(job->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+		eglDestroyContext(job->dpy, ctx);
+		goto out;
+	}
+
+	drv = driver_hash();
+	for (i = 0; i < job->count; i++) {
+		program = program_get(&job->srcs[i], drv, &from_cache);
+		if (program) {
+			linked += !from_cache;
+			glDeleteProgram(program);
+		}
+	}
+	printf("GL program cache: %u variants linked in background in %.02f ms\n",
+			linked, elapsed_ms(&start));
+
+	eglMakeCurrent(job->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(job->dpy, ctx);
+out:
+	eglReleaseThread();
+	free(job);
+	return NULL;
+}
+
+void gl_program_cache_precompile(EGLDisplay dpy, EGLConfig conf,
+		const struct gl_program_source *srcs, unsigned int count)
+{
+	char path[PATH_MAX];
+	struct precompile_job *job;
+	const char *egl_extensions;
+	pthread_attr_t attr;
+	pthread_t thread;
+	unsigned int i, missing = 0;
+	uint64_t drv;
+
+	pthread_once(&resolve_once, resolve_entry_points);
+	if (!program_binary)
+		return;
+
+	pthread_mutex_lock(&precompile_lock);
+	if (precompile_started) {
+		pthread_mutex_unlock(&precompile_lock);
+		return;
+	}
+	precompile_started = 1;
+	pthread_mutex_unlock(&precompile_lock);
+
+	drv = driver_hash();
+	for (i = 0; i < count; i++) {
+		cache_path(path, sizeof(path), drv, source_hash(&srcs[i]));
+		if (access(path, R_OK) < 0)
+			missing++;
+	}
+	if (!missing)
+		return;
+
+	egl_extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+	if (!egl_extensions || !strstr(egl_extensions, "EGL_KHR_surfaceless_context")) {
+		printf("GL program cache: no surfaceless context, not precompiling\n");
+		return;
+	}
+
+	job = malloc(sizeof(*job) + count * sizeof(job->srcs[0]));
+	if (!job)
+		return;
+	job->dpy = dpy;
+	job->conf = conf;
+	job->count = count;
+	memcpy(job->srcs, srcs, count * sizeof(job->srcs[0]));
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&thread, &attr, precompile_thread, job) != 0)
+		free(job);
+	pthread_attr_destroy(&attr);
+}
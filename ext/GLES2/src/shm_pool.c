@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shm_pool.h"
+
+/* An unlinked file in XDG_RUNTIME_DIR, the compositor maps it through the fd. */
+static int create_anonymous_file(size_t size)
+{
+	static const char name[] = "/earlyapp-shm-XXXXXX";
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	char *path;
+	int fd;
+
+	if (!dir) {
+		errno = ENOENT;
+		return -1;
+	}
+
+	path = malloc(strlen(dir) + sizeof(name));
+	if (!path)
+		return -1;
+	strcpy(path, dir);
+	strcat(path, name);
+
+	fd = mkostemp(path, O_CLOEXEC);
+	if (fd >= 0)
+		unlink(path);
+	free(path);
+	if (fd < 0)
+		return -1;
+
+	if (ftruncate(fd, size) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void buffer_release(void *data, struct wl_buffer *wl_buffer)
+{
+	struct shm_buffer *buffer = data;
+
+	buffer->busy = 0;
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	buffer_release
+};
+
+int shm_pool_init(struct shm_pool *pool, struct wl_shm *shm,
+		unsigned int width, unsigned int height, unsigned int count)
+{
+	struct shm_buffer *buffer;
+	size_t frame_size;
+	unsigned int i;
+	int fd;
+
+	memset(pool, 0, sizeof(*pool));
+	if (!shm || !count || count > SHM_POOL_MAX_BUFFERS)
+		return -1;
+
+	pool->width = width;
+	pool->height = height;
+	pool->stride = width * 4;
+	frame_size = (size_t) pool->stride * height;
+	pool->size = frame_size * count;
+
+	fd = create_anonymous_file(pool->size);
+	if (fd < 0) {
+		fprintf(stderr, "Cannot create %zu byte shm file: %m\n", pool->size);
+		return -1;
+	}
+
+	pool->data = mmap(NULL, pool->size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	if (pool->data == MAP_FAILED) {
+		fprintf(stderr, "Cannot map shm file: %m\n");
+		pool->data = NULL;
+		close(fd);
+		return -1;
+	}
+
+	pool->pool = wl_shm_create_pool(shm, fd, pool->size);
+	close(fd);
+
+	for (i = 0; i < count; i++) {
+		buffer = &pool->buffers[i];
+		buffer->data = (char *) pool->data + frame_size * i;
+		buffer->buffer = wl_shm_pool_create_buffer(pool->pool,
+				frame_size * i, width, height, pool->stride,
+				WL_SHM_FORMAT_XRGB8888);
+		wl_buffer_add_listener(buffer->buffer, &buffer_listener, buffer);
+	}
+	pool->count = count;
+
+	return 0;
+}
+
+struct shm_buffer *shm_pool_acquire(struct shm_pool *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < pool->count; i++) {
+		if (!pool->buffers[i].busy) {
+			pool->buffers[i].busy = 1;
+			return &pool->buffers[i];
+		}
+	}
+	return NULL;
+}
+
+void shm_pool_fini(struct shm_pool *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < pool->count; i++)
+		wl_buffer_destroy(pool->buffers[i].buffer);
+	if (pool->pool)
+		wl_shm_pool_destroy(pool->pool);
+	if (pool->data)
+		munmap(pool->data, pool->size);
+	memset(pool, 0, sizeof(*pool));
+}
@@ -54,7 +54,8 @@
 #include "shared/weston-egl-ext.h"
 
 #include "simple-egl.h"
-void * g_GlesGpioClass = NULL;
+#include "gl_program_cache.h"
+#include "KpiMarker.h"
 
 struct window;
 struct seat;
@@ -258,65 +259,25 @@ fini_egl(struct display *display)
 	eglReleaseThread();
 }
 
-static GLuint
-create_shader(struct window *window, const char *source, GLenum shader_type)
-{
-	GLuint shader;
-	GLint status;
-
-	shader = glCreateShader(shader_type);
-	assert(shader != 0);
-
-	glShaderSource(shader, 1, (const char **) &source, NULL);
-	glCompileShader(shader);
-
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-	if (!status) {
-		char log[1000];
-		GLsizei len;
-		glGetShaderInfoLog(shader, 1000, &len, log);
-		fprintf(stderr, "Error: compiling %s: %*s\n",
-			shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment",
-			len, log);
-		exit(1);
-	}
-
-	return shader;
-}
-
 static void
 init_gl(struct window *window)
 {
-	GLuint frag, vert;
+	static const char *const attribs[] = { "pos", "color", NULL };
+	const struct gl_program_source src = {
+		vert_shader_text, frag_shader_text, attribs
+	};
 	GLuint program;
-	GLint status;
-
-	frag = create_shader(window, frag_shader_text, GL_FRAGMENT_SHADER);
-	vert = create_shader(window, vert_shader_text, GL_VERTEX_SHADER);
-
-	program = glCreateProgram();
-	glAttachShader(program, frag);
-	glAttachShader(program, vert);
-	glLinkProgram(program);
-
-	glGetProgramiv(program, GL_LINK_STATUS, &status);
-	if (!status) {
-		char log[1000];
-		GLsizei len;
-		glGetProgramInfoLog(program, 1000, &len, log);
-		fprintf(stderr, "Error: linking:\n%*s\n", len, log);
+
+	/* "pos" and "color" are bound to 0 and 1 before the (cached) link. */
+	program = gl_program_cache_get(&src);
+	if (!program)
 		exit(1);
-	}
 
 	glUseProgram(program);
 
 	window->gl.pos = 0;
 	window->gl.col = 1;
 
-	glBindAttribLocation(program, window->gl.pos, "pos");
-	glBindAttribLocation(program, window->gl.col, "color");
-	glLinkProgram(program);
-
 	window->gl.rotation_uniform =
 		glGetUniformLocation(program, "rotation");
 }
@@ -656,8 +617,8 @@ redraw(void *data, struct wl_callback *callback, uint32_t time)
 		eglSwapBuffers(display->egl.dpy, window->egl_surface);
 	}
 
-	if(g_GlesGpioClass)
-		GPIOControl_outputPattern(g_GlesGpioClass);
+	if (window->frames == 0)
+		KPI_MARK("egl_first_frame");
 
 	window->frames++;
 }
@@ -986,7 +947,7 @@ usage(int error_code)
 }
 
 int
-simple_egl_main(void *gles_GpioClass)
+simple_egl_main(void)
 //simple_egl_main(int argc, char **argv)
 {
 	struct sigaction sigint;
@@ -1005,7 +966,6 @@ simple_egl_main(void *gles_GpioClass)
 	window.frame_sync = 1;
 	window.delay = 0;
 
-	g_GlesGpioClass = gles_GpioClass;
 #if 0
 	for (i = 1; i < argc; i++) {
 		if (strcmp("-d", argv[i]) == 0 && i+1 < argc)
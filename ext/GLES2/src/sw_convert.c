@@ -0,0 +1,717 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SW_CONVERT_X86
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+#include "sw_convert.h"
+
+#define ARRAY_SIZE(a)	(sizeof(a)/sizeof((a)[0]))
+
+typedef void (*row_fn)(uint32_t *dst, const uint8_t *src, const uint8_t *uv,
+		unsigned int width);
+
+enum sw_isa {
+	SW_ISA_C,
+	SW_ISA_SSE41,
+	SW_ISA_AVX2,
+	SW_ISA_COUNT
+};
+
+static const char *const isa_names[SW_ISA_COUNT] = {
+	[SW_ISA_C] = "c",
+	[SW_ISA_SSE41] = "sse4.1",
+	[SW_ISA_AVX2] = "avx2",
+};
+
+/*
+ * BT.601 limited range coefficients in 6 bit fixed point. Every kernel uses
+ * the same 16 bit arithmetic, so they all produce the same pixels.
+ */
+#define CY	75	/* 1.164 */
+#define CRV	102	/* 1.596 */
+#define CGU	25	/* 0.391 */
+#define CGV	52	/* 0.813 */
+#define CBU	129	/* 2.018 */
+
+struct sw_converter {
+	unsigned int src_w, src_h;
+	unsigned int dst_w, dst_h;
+	enum sw_filter filter;
+	row_fn kernel;
+	uint32_t *line[2];	/* converted source rows, one pixel of padding */
+	uint32_t *scaled[2];	/* horizontally scaled rows */
+	unsigned int scaled_row[2];
+	uint32_t *xmap;		/* source x, in 24.8 fixed point for bilinear */
+};
+
+#define NO_ROW		(~0u)
+
+static inline uint32_t clamp255(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline uint32_t yuv_pixel(int y, int u, int v)
+{
+	int c = (y - 16) * CY + 32;
+	int d = u - 128;
+	int e = v - 128;
+
+	return 0xff000000 |
+		clamp255((c + CRV * e) >> 6) << 16 |
+		clamp255((c - CGU * d - CGV * e) >> 6) << 8 |
+		clamp255((c + CBU * d) >> 6);
+}
+
+/* Packed 4:2:2 with the first luma byte at @yo and the chroma at @uo, @vo. */
+static inline void row_422_c(uint32_t *dst, const uint8_t *src,
+		unsigned int width, int yo, int uo, int vo)
+{
+	unsigned int x;
+
+	for (x = 0; x + 1 < width; x += 2, src += 4) {
+		dst[x] = yuv_pixel(src[yo], src[uo], src[vo]);
+		dst[x + 1] = yuv_pixel(src[yo + 2], src[uo], src[vo]);
+	}
+	if (x < width)
+		dst[x] = yuv_pixel(src[yo], src[uo], src[vo]);
+}
+
+static void uyvy_c(uint32_t *dst, const uint8_t *src, const uint8_t *uv,
+		unsigned int width)
+{
+	row_422_c(dst, src, width, 1, 0, 2);
+}
+
+static void yuyv_c(uint32_t *dst, const uint8_t *src, const uint8_t *uv,
+		unsigned int width)
+{
+	row_422_c(dst, src, width, 0, 1, 3);
+}
+
+static void nv12_c(uint32_t *dst, const uint8_t *src, const uint8_t *uv,
+		unsigned int width)
+{
+	unsigned int x;
+
+	for (x = 0; x < width; x++)
+		dst[x] = yuv_pixel(src[x], uv[x & ~1u], uv[x | 1u]);
+}
+
+static void xrgb_copy(uint32_t *dst, const uint8_t *src, const uint8_t *uv,
+		unsigned int width)
+{
+	memcpy(dst, src, width * sizeof(*dst));
+}
+
+#ifdef SW_CONVERT_X86
+
+#define Z	-128
+
+/* pshufb masks picking Y, U and V of 8 pixels as 16 bit lanes. */
+static const int8_t shuffle_uyvy[3][16] = {
+	{ 1, Z, 3, Z, 5, Z, 7, Z, 9, Z, 11, Z, 13, Z, 15, Z },
+	{ 0, Z, 0, Z, 4, Z, 4, Z, 8, Z, 8, Z, 12, Z, 12, Z },
+	{ 2, Z, 2, Z, 6, Z, 6, Z, 10, Z, 10, Z, 14, Z, 14, Z },
+};
+
+static const int8_t shuffle_yuyv[3][16] = {
+	{ 0, Z, 2, Z, 4, Z, 6, Z, 8, Z, 10, Z, 12, Z, 14, Z },
+	{ 1, Z, 1, Z, 5, Z, 5, Z, 9, Z, 9, Z, 13, Z, 13, Z },
+	{ 3, Z, 3, Z, 7, Z, 7, Z, 11, Z, 11, Z, 15, Z, 15, Z },
+};
+
+/* Duplicates U and V of 16 bit interleaved NV12 chroma to every pixel. */
+static const int8_t shuffle_nv12[2][16] = {
+	{ 0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13 },
+	{ 2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15 },
+};
+
+#undef Z
+
+static inline SSE41 void store_xrgb_sse41(uint32_t *dst, __m128i y,
+		__m128i u, __m128i v)
+{
+	__m128i c, d, e, r, g, b, bg, ra;
+
+	c = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)),
+				_mm_set1_epi16(CY)), _mm_set1_epi16(32));
+	d = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	e = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	r = _mm_adds_epi16(c, _mm_mullo_epi16(e, _mm_set1_epi16(CRV)));
+	g = _mm_subs_epi16(_mm_subs_epi16(c,
+				_mm_mullo_epi16(d, _mm_set1_epi16(CGU))),
+			_mm_mullo_epi16(e, _mm_set1_epi16(CGV)));
+	b = _mm_adds_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(CBU)));
+	r = _mm_srai_epi16(r, 6);
+	g = _mm_srai_epi16(g, 6);
+	b = _mm_srai_epi16(b, 6);
+
+	bg = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), _mm_packus_epi16(g, g));
+	ra = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_set1_epi8(-1));
+	_mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i *) (dst + 4), _mm_unpackhi_epi16(bg, ra));
+}
+
+static inline SSE41 void row_422_sse41(uint32_t *dst, const uint8_t *src,
+		unsigned int width, const int8_t mask[3][16])
+{
+	__m128i ys = _mm_loadu_si128((const __m128i *) mask[0]);
+	__m128i us = _mm_loadu_si128((const __m128i *) mask[1]);
+	__m128i vs = _mm_loadu_si128((const __m128i *) mask[2]);
+	__m128i p;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		p = _mm_loadu_si128((const __m128i *) (src + 2 * x));
+		store_xrgb_sse41(dst + x, _mm_shuffle_epi8(p, ys),
+				_mm_shuffle_epi8(p, us), _mm_shuffle_epi8(p, vs));
+	}
+	if (x < width) {
+		if (mask == shuffle_uyvy)
+			uyvy_c(dst + x, src + 2 * x, NULL, width - x);
+		else
+			yuyv_c(dst + x, src + 2 * x, NULL, width - x);
+	}
+}
+
+static SSE41 void uyvy_sse41(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	row_422_sse41(dst, src, width, shuffle_uyvy);
+}
+
+static SSE41 void yuyv_sse41(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	row_422_sse41(dst, src, width, shuffle_yuyv);
+}
+
+static SSE41 void nv12_sse41(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	__m128i us = _mm_loadu_si128((const __m128i *) shuffle_nv12[0]);
+	__m128i vs = _mm_loadu_si128((const __m128i *) shuffle_nv12[1]);
+	__m128i y, c;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= width; x += 8) {
+		y = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *) (src + x)));
+		c = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *) (uv + x)));
+		store_xrgb_sse41(dst + x, y, _mm_shuffle_epi8(c, us),
+				_mm_shuffle_epi8(c, vs));
+	}
+	if (x < width)
+		nv12_c(dst + x, src + x, uv + x, width - x);
+}
+
+/* Same as store_xrgb_sse41 for 16 pixels, each 128 bit lane holding 8. */
+static inline AVX2 void store_xrgb_avx2(uint32_t *dst, __m256i y,
+		__m256i u, __m256i v)
+{
+	__m256i c, d, e, r, g, b, bg, ra, lo, hi;
+
+	c = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y,
+					_mm256_set1_epi16(16)), _mm256_set1_epi16(CY)),
+			_mm256_set1_epi16(32));
+	d = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	e = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+
+	r = _mm256_adds_epi16(c, _mm256_mullo_epi16(e, _mm256_set1_epi16(CRV)));
+	g = _mm256_subs_epi16(_mm256_subs_epi16(c,
+				_mm256_mullo_epi16(d, _mm256_set1_epi16(CGU))),
+			_mm256_mullo_epi16(e, _mm256_set1_epi16(CGV)));
+	b = _mm256_adds_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(CBU)));
+	r = _mm256_srai_epi16(r, 6);
+	g = _mm256_srai_epi16(g, 6);
+	b = _mm256_srai_epi16(b, 6);
+
+	bg = _mm256_unpacklo_epi8(_mm256_packus_epi16(b, b),
+			_mm256_packus_epi16(g, g));
+	ra = _mm256_unpacklo_epi8(_mm256_packus_epi16(r, r),
+			_mm256_set1_epi8(-1));
+	lo = _mm256_unpacklo_epi16(bg, ra);
+	hi = _mm256_unpackhi_epi16(bg, ra);
+	_mm256_storeu_si256((__m256i *) dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i *) (dst + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+static inline AVX2 void row_422_avx2(uint32_t *dst, const uint8_t *src,
+		unsigned int width, const int8_t mask[3][16])
+{
+	__m256i ys = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) mask[0]));
+	__m256i us = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) mask[1]));
+	__m256i vs = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) mask[2]));
+	__m256i p;
+	unsigned int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		p = _mm256_loadu_si256((const __m256i *) (src + 2 * x));
+		store_xrgb_avx2(dst + x, _mm256_shuffle_epi8(p, ys),
+				_mm256_shuffle_epi8(p, us), _mm256_shuffle_epi8(p, vs));
+	}
+	if (x < width) {
+		if (mask == shuffle_uyvy)
+			uyvy_c(dst + x, src + 2 * x, NULL, width - x);
+		else
+			yuyv_c(dst + x, src + 2 * x, NULL, width - x);
+	}
+}
+
+static AVX2 void uyvy_avx2(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	row_422_avx2(dst, src, width, shuffle_uyvy);
+}
+
+static AVX2 void yuyv_avx2(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	row_422_avx2(dst, src, width, shuffle_yuyv);
+}
+
+static AVX2 void nv12_avx2(uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	__m256i us = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) shuffle_nv12[0]));
+	__m256i vs = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) shuffle_nv12[1]));
+	__m256i y, c;
+	unsigned int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (src + x)));
+		c = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (uv + x)));
+		store_xrgb_avx2(dst + x, y, _mm256_shuffle_epi8(c, us),
+				_mm256_shuffle_epi8(c, vs));
+	}
+	if (x < width)
+		nv12_c(dst + x, src + x, uv + x, width - x);
+}
+
+#endif /* SW_CONVERT_X86 */
+
+static const row_fn kernels[SW_ISA_COUNT][SW_FORMAT_COUNT] = {
+	[SW_ISA_C] = { uyvy_c, yuyv_c, nv12_c, xrgb_copy },
+#ifdef SW_CONVERT_X86
+	[SW_ISA_SSE41] = { uyvy_sse41, yuyv_sse41, nv12_sse41, xrgb_copy },
+	[SW_ISA_AVX2] = { uyvy_avx2, yuyv_avx2, nv12_avx2, xrgb_copy },
+#endif
+};
+
+static pthread_once_t isa_once = PTHREAD_ONCE_INIT;
+static enum sw_isa isa = SW_ISA_C;
+
+static void detect_isa(void)
+{
+#ifdef SW_CONVERT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		isa = SW_ISA_AVX2;
+	else if (__builtin_cpu_supports("sse4.1"))
+		isa = SW_ISA_SSE41;
+#endif
+}
+
+static enum sw_isa best_isa(void)
+{
+	pthread_once(&isa_once, detect_isa);
+	return isa;
+}
+
+const char *sw_convert_isa(void)
+{
+	return isa_names[best_isa()];
+}
+
+void sw_convert_row(enum sw_format format, uint32_t *dst, const uint8_t *src,
+		const uint8_t *uv, unsigned int width)
+{
+	kernels[best_isa()][format](dst, src, uv, width);
+}
+
+/* Rounded up average of every channel, the four bytes of a pixel at once. */
+static void average_row(uint32_t *dst, const uint32_t *src, unsigned int width)
+{
+	unsigned int x;
+
+	for (x = 0; x < width; x++)
+		dst[x] = (dst[x] | src[x]) - (((dst[x] ^ src[x]) & 0xfefefefe) >> 1);
+}
+
+static inline uint32_t lerp_xrgb(uint32_t a, uint32_t b, uint32_t w)
+{
+	uint32_t rb = ((a & 0x00ff00ff) * (256 - w) + (b & 0x00ff00ff) * w) >> 8;
+	uint32_t ag = (((a >> 8) & 0x00ff00ff) * (256 - w) +
+			((b >> 8) & 0x00ff00ff) * w) >> 8;
+
+	return (rb & 0x00ff00ff) | (ag & 0x00ff00ff) << 8;
+}
+
+static void convert_field_row(struct sw_converter *conv,
+		const struct sw_frame *frame, const uint8_t *plane,
+		const uint8_t *uv, unsigned int row, uint32_t *dst)
+{
+	conv->kernel(dst, plane + (size_t) row * frame->stride,
+			uv ? uv + (size_t) (row / 2) * frame->uv_stride : NULL,
+			frame->width);
+}
+
+/*
+ * Produces output line @y of the frame, matching the GL deinterlacers: line
+ * pair r is made of field row r and, for the line the field does not own,
+ * the opposite field (weave) or the average of field rows r and r +/- 1.
+ * There is no motion detection on the CPU, so motion is rendered like bob.
+ */
+static void frame_row(struct sw_converter *conv, const struct sw_frame *frame,
+		unsigned int y, uint32_t *dst)
+{
+	unsigned int row, near;
+
+	if (frame->mode == DEINTERLACE_NONE) {
+		convert_field_row(conv, frame, frame->field, frame->field_uv, y, dst);
+		return;
+	}
+
+	row = y / 2;
+	if (((y & 1) == 0) == !!frame->field_first) {
+		convert_field_row(conv, frame, frame->field, frame->field_uv, row, dst);
+		return;
+	}
+
+	if (frame->mode == DEINTERLACE_WEAVE) {
+		convert_field_row(conv, frame, frame->other, frame->other_uv, row, dst);
+		return;
+	}
+
+	near = frame->field_first ? row + 1 : row - 1;
+	if (near >= frame->height)
+		near = row;
+	convert_field_row(conv, frame, frame->field, frame->field_uv, row, dst);
+	convert_field_row(conv, frame, frame->field, frame->field_uv, near, conv->line[1]);
+	average_row(dst, conv->line[1], frame->width);
+}
+
+static void scale_row(struct sw_converter *conv, const uint32_t *src,
+		uint32_t *dst)
+{
+	unsigned int x;
+	uint32_t pos;
+
+	if (conv->filter == SW_FILTER_NEAREST) {
+		for (x = 0; x < conv->dst_w; x++)
+			dst[x] = src[conv->xmap[x]];
+		return;
+	}
+
+	for (x = 0; x < conv->dst_w; x++) {
+		pos = conv->xmap[x];
+		dst[x] = lerp_xrgb(src[pos >> 8], src[(pos >> 8) + 1], pos & 0xff);
+	}
+}
+
+/* Returns source line @y scaled to the output width, converting it if needed. */
+static const uint32_t *scaled_row(struct sw_converter *conv,
+		const struct sw_frame *frame, unsigned int y)
+{
+	int slot;
+
+	if (conv->scaled_row[0] == y)
+		return conv->scaled[0];
+	if (conv->scaled_row[1] == y)
+		return conv->scaled[1];
+
+	/* Lines are requested in increasing order, the lower one is done. */
+	if (conv->scaled_row[0] == NO_ROW)
+		slot = 0;
+	else if (conv->scaled_row[1] == NO_ROW)
+		slot = 1;
+	else
+		slot = conv->scaled_row[0] > conv->scaled_row[1];
+
+	if (conv->src_w == conv->dst_w) {
+		frame_row(conv, frame, y, conv->scaled[slot]);
+	} else {
+		frame_row(conv, frame, y, conv->line[0]);
+		scale_row(conv, conv->line[0], conv->scaled[slot]);
+	}
+	conv->scaled_row[slot] = y;
+	return conv->scaled[slot];
+}
+
+/* Position of the centre of destination pixel @i in source pixels, 24.8 fixed point. */
+static uint32_t source_position(unsigned int i, unsigned int src, unsigned int dst)
+{
+	int64_t pos = (((int64_t) (2 * i + 1) * src) << 8) / (2 * dst) - 128;
+
+	if (pos < 0)
+		return 0;
+	if (pos > ((int64_t) (src - 1) << 8))
+		return (src - 1) << 8;
+	return pos;
+}
+
+struct sw_converter *sw_converter_create(unsigned int src_w, unsigned int src_h,
+		unsigned int dst_w, unsigned int dst_h, enum sw_filter filter)
+{
+	struct sw_converter *conv;
+	unsigned int i, width;
+
+	if (!src_w || !src_h || !dst_w || !dst_h)
+		return NULL;
+
+	conv = calloc(1, sizeof(*conv));
+	if (!conv)
+		return NULL;
+
+	conv->src_w = src_w;
+	conv->src_h = src_h;
+	conv->dst_w = dst_w;
+	conv->dst_h = dst_h;
+	conv->filter = filter;
+	conv->kernel = kernels[best_isa()][SW_FORMAT_UYVY];
+
+	width = (src_w > dst_w ? src_w : dst_w) + 1;
+	for (i = 0; i < ARRAY_SIZE(conv->line); i++) {
+		conv->line[i] = calloc(width, sizeof(uint32_t));
+		conv->scaled[i] = calloc(width, sizeof(uint32_t));
+		if (!conv->line[i] || !conv->scaled[i])
+			goto fail;
+	}
+
+	conv->xmap = calloc(dst_w, sizeof(uint32_t));
+	if (!conv->xmap)
+		goto fail;
+	for (i = 0; i < dst_w; i++) {
+		if (filter == SW_FILTER_NEAREST)
+			conv->xmap[i] = (uint32_t) (((uint64_t) (2 * i + 1) * src_w) / (2 * dst_w));
+		else
+			conv->xmap[i] = source_position(i, src_w, dst_w);
+	}
+
+	return conv;
+
+fail:
+	sw_converter_destroy(conv);
+	return NULL;
+}
+
+void sw_converter_destroy(struct sw_converter *conv)
+{
+	unsigned int i;
+
+	if (!conv)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(conv->line); i++) {
+		free(conv->line[i]);
+		free(conv->scaled[i]);
+	}
+	free(conv->xmap);
+	free(conv);
+}
+
+void sw_convert_frame(struct sw_converter *conv, const struct sw_frame *frame,
+		void *dst, unsigned int dst_stride)
+{
+	uint8_t *out = dst;
+	const uint32_t *a, *b;
+	unsigned int x, y;
+	uint32_t pos;
+
+	conv->kernel = kernels[best_isa()][frame->format];
+
+	if (conv->src_w == conv->dst_w && conv->src_h == conv->dst_h) {
+		for (y = 0; y < conv->dst_h; y++)
+			frame_row(conv, frame, y, (uint32_t *) (out + (size_t) y * dst_stride));
+		return;
+	}
+
+	conv->scaled_row[0] = conv->scaled_row[1] = NO_ROW;
+	for (y = 0; y < conv->dst_h; y++, out += dst_stride) {
+		if (conv->filter == SW_FILTER_NEAREST) {
+			a = scaled_row(conv, frame, (uint32_t) (((uint64_t) (2 * y + 1)
+						* conv->src_h) / (2 * conv->dst_h)));
+			memcpy(out, a, conv->dst_w * sizeof(uint32_t));
+			continue;
+		}
+
+		pos = source_position(y, conv->src_h, conv->dst_h);
+		a = scaled_row(conv, frame, pos >> 8);
+		if ((pos & 0xff) == 0) {
+			memcpy(out, a, conv->dst_w * sizeof(uint32_t));
+			continue;
+		}
+		b = scaled_row(conv, frame, (pos >> 8) + 1);
+		for (x = 0; x < conv->dst_w; x++)
+			((uint32_t *) out)[x] = lerp_xrgb(a[x], b[x], pos & 0xff);
+	}
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0 +
+		(now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+#define BENCHMARK_MS	250.0
+
+static void print_result(const char *name, unsigned int w, unsigned int h,
+		double ms, unsigned int frames)
+{
+	char size[16];
+
+	snprintf(size, sizeof(size), "%ux%u", w, h);
+	printf("%-25s | %-9s | %6.02f ms | %6.0f fps\n", name, size,
+			ms / frames, frames * 1000.0 / ms);
+}
+
+static void benchmark_kernel(enum sw_isa level, enum sw_format format,
+		const uint8_t *src, uint32_t *dst, unsigned int w, unsigned int h)
+{
+	static const char *const format_names[SW_FORMAT_COUNT] = {
+		"uyvy", "yuyv", "nv12", "xrgb8888",
+	};
+	unsigned int stride = (format == SW_FORMAT_NV12) ? w : w * 2;
+	const uint8_t *uv = src + (size_t) stride * h;
+	row_fn kernel = kernels[level][format];
+	struct timespec start;
+	unsigned int frames = 0, y;
+	char name[32];
+	double ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		for (y = 0; y < h; y++)
+			kernel(dst + (size_t) y * w, src + (size_t) y * stride,
+					uv + (size_t) (y / 2) * w, w);
+		frames++;
+	} while ((ms = elapsed_ms(&start)) < BENCHMARK_MS);
+
+	snprintf(name, sizeof(name), "%s %s", format_names[format], isa_names[level]);
+	print_result(name, w, h, ms, frames);
+}
+
+static int benchmark_frame(const char *name, struct sw_frame *frame,
+		unsigned int w, unsigned int h, enum sw_filter filter, uint32_t *dst)
+{
+	unsigned int src_h = frame->mode == DEINTERLACE_NONE ? frame->height
+		: frame->height * 2;
+	struct sw_converter *conv;
+	struct timespec start;
+	unsigned int frames = 0;
+	double ms;
+
+	conv = sw_converter_create(frame->width, src_h, w, h, filter);
+	if (!conv)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		sw_convert_frame(conv, frame, dst, w * sizeof(uint32_t));
+		frames++;
+	} while ((ms = elapsed_ms(&start)) < BENCHMARK_MS);
+
+	print_result(name, frame->width, src_h, ms, frames);
+	sw_converter_destroy(conv);
+	return 0;
+}
+
+int sw_convert_benchmark(void)
+{
+	static const struct {
+		unsigned int w, h;
+	} sizes[] = {
+		{ 720, 480 },
+		{ 1920, 1080 },
+	};
+	const size_t src_size = 1920 * 1080 * 2;
+	struct sw_frame frame;
+	unsigned int i, level, format;
+	uint8_t *src;
+	uint32_t *dst;
+	int ret = 0;
+
+	src = malloc(src_size);
+	dst = malloc(1920 * 1080 * sizeof(uint32_t));
+	if (!src || !dst) {
+		free(src);
+		free(dst);
+		return -1;
+	}
+	for (i = 0; i < src_size; i++)
+		src[i] = (uint8_t) (i * 2654435761u >> 13);
+
+	printf("SW CONVERT BENCHMARK (%s)\n", sw_convert_isa());
+	printf("%-25s | %-9s | %-9s | %s\n", "Kernel", "Size", "Frame", "Rate");
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		for (level = SW_ISA_C; level <= best_isa(); level++) {
+			for (format = SW_FORMAT_UYVY; format <= SW_FORMAT_NV12; format++)
+				benchmark_kernel(level, format, src, dst,
+						sizes[i].w, sizes[i].h);
+		}
+
+		memset(&frame, 0, sizeof(frame));
+		frame.format = SW_FORMAT_UYVY;
+		frame.width = sizes[i].w;
+		frame.height = sizes[i].h / 2;
+		frame.stride = sizes[i].w * 2;
+		frame.field = src;
+		frame.other = src + (size_t) frame.stride * frame.height;
+		frame.mode = DEINTERLACE_WEAVE;
+		ret |= benchmark_frame("uyvy weave", &frame, sizes[i].w,
+				sizes[i].h, SW_FILTER_NEAREST, dst);
+		frame.mode = DEINTERLACE_BOB;
+		ret |= benchmark_frame("uyvy bob", &frame, sizes[i].w,
+				sizes[i].h, SW_FILTER_NEAREST, dst);
+
+		frame.height = sizes[i].h;
+		frame.mode = DEINTERLACE_NONE;
+		ret |= benchmark_frame("uyvy nearest to 1080p", &frame, 1920, 1080,
+				SW_FILTER_NEAREST, dst);
+		ret |= benchmark_frame("uyvy bilinear to 1080p", &frame, 1920, 1080,
+				SW_FILTER_BILINEAR, dst);
+	}
+
+	free(src);
+	free(dst);
+	return ret;
+}
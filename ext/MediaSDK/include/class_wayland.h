@@ -25,9 +25,45 @@ extern "C"
 {
     #include <intel_bufmgr.h>
 }
-#include <poll.h>
+#include <pthread.h>
+#include <time.h>
 #include <wayland-client.h>
+#include "mfxdefs.h"
 #include "wayland-drm-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+
+/* Upper bound of buffers owned by the presentation scheduler at once.
+ * Covers the queued frames plus the ones still held by the compositor. */
+#define WL_PRESENT_MAX_FRAMES 8
+#define WL_PRESENT_DEFAULT_QUEUE_DEPTH 2
+#define WL_HIDE_TIMEOUT_MS 100
+
+class Wayland;
+
+/* Frame handed to the presentation scheduler. Lives from RenderBuffer()
+ * until the compositor releases its wl_buffer. */
+struct PresentFrame {
+    Wayland *wayland;
+    struct wl_buffer *buffer;
+    struct wp_presentation_feedback *feedback;
+    volatile mfxU16 *render_lock; /* dropped on wl_buffer release */
+    int32_t width;
+    int32_t height;
+    uint64_t queued_ns;   /* presentation clock when queued */
+    bool in_use;
+    bool committed;
+};
+
+/* Presentation statistics since the surface was created */
+struct PresentStats {
+    mfxU32 queued;        /* frames handed to RenderBuffer() */
+    mfxU32 presented;     /* frames reported on screen */
+    mfxU32 dropped;       /* mailbox replacements and discarded feedbacks */
+    uint64_t first_present_ns;
+    uint64_t last_present_ns;
+    uint64_t latency_sum_ns; /* queued -> presented */
+    uint64_t latency_max_ns;
+};
 
 /* ShmPool Struct */
 struct ShmPool {
@@ -45,9 +81,13 @@ class Wayland {
         virtual bool CreateSurface();
         virtual void FreeSurface();
         virtual void SetRenderWinPos(int x, int y);
+        /* Queues buffer for presentation. Blocks only when the queue is
+         * full in FIFO mode; render_lock, if given, is decremented once the
+         * compositor releases the buffer. */
         virtual void RenderBuffer(struct wl_buffer *buffer
             , int32_t width
-            , int32_t height);
+            , int32_t height
+            , volatile mfxU16 *render_lock = NULL);
         virtual void RenderBufferWinPosSize(struct wl_buffer *buffer
             , int x
             , int y
@@ -84,6 +124,7 @@ class Wayland {
         struct wl_surface * GetSurface() { return m_surface; }
         struct wl_shell_surface * GetShellSurface() { return m_shell_surface; }
         struct wl_callback * GetCallback() { return m_callback; }
+        struct wp_presentation * GetPresentation() { return m_presentation; }
         void SetCompositor(struct wl_compositor *compositor)
         {
             m_compositor = compositor;
@@ -114,11 +155,36 @@ class Wayland {
         void DestroyCallback();
         virtual void Sync();
         virtual void SetPerfMode(bool perf_mode);
+        /* Presentation scheduler */
+        virtual void SetPresentMode(bool mailbox, mfxU32 queue_depth);
+        virtual void FlushPresentQueue();
+        virtual void HideSurface();
+        void GetPresentStats(struct PresentStats *stats);
+        void PrintPresentStats();
+        void FrameDone(uint32_t time);
+        void FramePresented(struct PresentFrame *frame, uint64_t present_ns);
+        void FrameDiscarded(struct PresentFrame *frame);
+        void FrameReleased(struct PresentFrame *frame);
+        void PresentationClockId(uint32_t clk_id) { m_present_clock = (clockid_t)clk_id; }
     private:
         //no copies allowed
         Wayland(const Wayland &);
         void operator = (const Wayland&);
 
+        /* Present events are dispatched by their own thread so that
+         * FrameDone() commits the next queued frame right at vblank.
+         * Listeners run with m_present_mutex held. */
+        bool StartDispatch();
+        void StopDispatch();
+        void DispatchLoop();
+        static void * DispatchThread(void *arg);
+        bool WaitPresent(int timeout_ms);
+        void CommitFrame(struct PresentFrame *frame);
+        void CommitQueuedFrame();
+        void DropQueuedFrame();
+        void RecordPresent(uint64_t queued_ns, uint64_t present_ns);
+        uint64_t PresentClockNow();
+
         struct wl_display *m_display;
         struct wl_registry *m_registry;
         struct wl_compositor *m_compositor;
@@ -134,11 +200,29 @@ class Wayland {
         struct ShmPool *m_shm_pool;
         int m_display_fd;
         int m_fd;
-        struct pollfd m_poll;
+        pthread_t m_dispatch_thread;
+        bool m_dispatch_running;
+        int m_dispatch_wake; /* eventfd that stops the dispatch thread */
+        pthread_mutex_t m_present_mutex;
+        pthread_cond_t m_present_cond; /* signalled after each dispatch */
+        bool m_display_lost;
         drm_intel_bufmgr *m_bufmgr;
         char *m_device_name;
         int m_x, m_y;
         bool m_perf_mode;
+
+        struct wp_presentation *m_presentation;
+        clockid_t m_present_clock;
+        bool m_present_mailbox;
+        mfxU32 m_present_queue_depth;
+        struct PresentFrame m_present_frames[WL_PRESENT_MAX_FRAMES];
+        /* FIFO of frames waiting for the next frame callback */
+        struct PresentFrame *m_present_queue[WL_PRESENT_MAX_FRAMES];
+        mfxU32 m_present_queue_head;
+        mfxU32 m_present_queue_count;
+        /* queue time of the last commit, used without wp_presentation */
+        uint64_t m_present_last_queued_ns;
+        struct PresentStats m_present_stats;
 };
 
 extern "C" Wayland* WaylandCreate();
@@ -0,0 +1,83 @@
+/******************************************************************************\
+Copyright (c) 2005-2018, Intel Corporation
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**********************************************************************************/
+
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <time.h>
+#include "mfxdefs.h"
+
+enum ePacingPolicy {
+  PACING_CATCH_UP,  // late frames are shown at once until the timeline is met again
+  PACING_DROP_LATE  // frames late by more than one period are skipped
+};
+
+struct sPacingStats
+{
+    mfxU32 paced;        // frames which went through the pacer
+    mfxU32 late;         // frames which missed their deadline
+    mfxU32 dropped;      // late frames skipped by PACING_DROP_LATE
+    mfxU32 resyncs;      // timeline restarts after a stall
+    mfxU64 jitter_sum;   // |wake up - deadline| in ns
+    mfxU64 jitter_max;
+    mfxU64 wait_wall;    // time spent waiting for deadlines, ns
+    mfxU64 wait_cpu;     // CPU time burnt while waiting, ns
+};
+
+/** \brief Paces rendering on an absolute timeline.
+ *
+ * Deadlines are computed from the first paced frame: frame N is due at
+ * max(its timestamp offset, N * period), so a stream is never shown faster
+ * than the configured rate and the timeline does not drift with render time.
+ * Waiting is done with clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC.
+ */
+class CFramePacer
+{
+public:
+    CFramePacer();
+
+    /** Sets the rate limit; rate 0 disables pacing. */
+    void Init(mfxU32 frameRateN, mfxU32 frameRateD, ePacingPolicy policy);
+    /** Restarts the timeline on the next frame, e.g. after a rewind. */
+    void Reset();
+    bool IsEnabled() const { return m_period != 0; }
+
+    /** Sleeps until the deadline of the next frame.
+     *
+     * @param timeStamp frame timestamp in 90kHz units, (mfxU64)-1 if unknown
+     * @return false if the frame should be skipped
+     */
+    bool WaitForDeadline(mfxU64 timeStamp);
+
+    const sPacingStats& GetStats() const { return m_stats; }
+    void PrintStats();
+
+private:
+    static mfxU64 GetTime(clockid_t clock);
+
+    mfxU64          m_period;         // ns per frame, 0 - pacing is off
+    mfxU64          m_resyncLimit;    // lateness which restarts the timeline, ns
+    ePacingPolicy   m_policy;
+    bool            m_bStarted;
+    mfxU64          m_anchor;         // CLOCK_MONOTONIC of the first frame
+    mfxU64          m_firstTimeStamp;
+    mfxU64          m_frameIndex;
+    sPacingStats    m_stats;
+
+    CFramePacer(const CFramePacer&);
+    void operator=(const CFramePacer&);
+};
+
+#endif // __FRAME_PACER_H__
@@ -39,6 +39,10 @@ public:
     virtual mfxStatus Init(mfxAllocatorParams *pParams);
     virtual mfxStatus Close();
 
+    // number of Alloc() calls and frames handed out, video and system memory
+    mfxU32 GetAllocRequests() const { return m_nAllocRequests; }
+    mfxU32 GetAllocFrames(bool isD3DFrames) const { return isD3DFrames ? m_nD3DFrames : m_nSYSFrames; }
+
 protected:
     virtual mfxStatus LockFrame(mfxMemId mid, mfxFrameData *ptr);
     virtual mfxStatus UnlockFrame(mfxMemId mid, mfxFrameData *ptr);
@@ -53,6 +57,10 @@ protected:
     std::map<mfxHDL, bool>                  m_Mids;
     std::unique_ptr<BaseFrameAllocator>       m_D3DAllocator;
     std::unique_ptr<SysMemFrameAllocator>     m_SYSAllocator;
+
+    mfxU32                                  m_nAllocRequests;
+    mfxU32                                  m_nD3DFrames;
+    mfxU32                                  m_nSYSFrames;
 private:
     DISALLOW_COPY_AND_ASSIGN(GeneralAllocator);
 
@@ -63,4 +63,24 @@ void shell_surface_configure(void *data
 void handle_done(void *data, struct wl_callback *callback, uint32_t time);
 
 void buffer_release(void *data, struct wl_buffer *buffer);
+void present_buffer_release(void *data, struct wl_buffer *buffer);
+
+/* presentation listeners */
+void presentation_clock_id(void *data
+    , struct wp_presentation *presentation
+    , uint32_t clk_id);
+void feedback_sync_output(void *data
+    , struct wp_presentation_feedback *feedback
+    , struct wl_output *output);
+void feedback_presented(void *data
+    , struct wp_presentation_feedback *feedback
+    , uint32_t tv_sec_hi
+    , uint32_t tv_sec_lo
+    , uint32_t tv_nsec
+    , uint32_t refresh
+    , uint32_t seq_hi
+    , uint32_t seq_lo
+    , uint32_t flags);
+void feedback_discarded(void *data
+    , struct wp_presentation_feedback *feedback);
 #endif /* LISTENER_WAYLAND_H */
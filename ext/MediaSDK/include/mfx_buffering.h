@@ -21,6 +21,7 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 #define __MFX_BUFFERING_H__
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "mfxstructures.h"
 
@@ -34,15 +35,12 @@ struct msdkFrameSurface
     mfxFrameSurface1 frame; // NOTE: this _should_ be the first item (see CBuffering::FindUsedSurface())
     msdk_tick submit;       // tick when frame was submitted for processing
     mfxU16 render_lock;     // signifies that frame is locked for rendering
-    msdkFrameSurface* prev;
-    msdkFrameSurface* next;
 };
 
 struct msdkOutputSurface
 {
     msdkFrameSurface* surface;
     mfxSyncPoint syncp;
-    msdkOutputSurface* next;
 };
 
 /** \brief Debug purpose macro to terminate execution if buggy situation happenned.
@@ -53,16 +51,87 @@ struct msdkOutputSurface
  */
     #define MSDK_SELF_CHECK(C)
 
+#define MSDK_BITMAP_WORD_BITS 64
+
 class CBuffering;
 
-// LIFO list of frame surfaces
+/** \brief Set of indices kept as an array of 64-bit words.
+ *
+ * Bits are set and cleared with atomic OR/AND, so any thread may touch the
+ * bitmap without a lock. The first set bit of a word is found with a single
+ * count-trailing-zeros instruction (tzcnt/bsf).
+ */
+class msdkSurfaceBitmap
+{
+public:
+    msdkSurfaceBitmap():
+        m_pWords(NULL),
+        m_WordsNumber(0) {}
+
+    ~msdkSurfaceBitmap() {
+        Free();
+    }
+
+    mfxStatus Alloc(mfxU32 BitsNumber) {
+        Free();
+        m_WordsNumber = (BitsNumber + MSDK_BITMAP_WORD_BITS - 1) / MSDK_BITMAP_WORD_BITS;
+        m_pWords = (mfxU64*)calloc(m_WordsNumber ? m_WordsNumber : 1, sizeof(mfxU64));
+        return m_pWords ? MFX_ERR_NONE : MFX_ERR_MEMORY_ALLOC;
+    }
+    void Free() {
+        free((void*)m_pWords);
+        m_pWords = NULL;
+        m_WordsNumber = 0;
+    }
+
+    inline void Set(mfxU32 index) {
+        msdk_atomic_or64(&m_pWords[index / MSDK_BITMAP_WORD_BITS], Bit(index));
+    }
+    inline void Clear(mfxU32 index) {
+        msdk_atomic_and64(&m_pWords[index / MSDK_BITMAP_WORD_BITS], ~Bit(index));
+    }
+    /** \brief Clears the lowest set bit and returns its index, -1 if the set is empty.
+     */
+    inline mfxI32 TakeFirst() {
+        for (mfxU32 i = 0; i < m_WordsNumber; ++i) {
+            mfxU64 word = msdk_atomic_load64(&m_pWords[i]);
+            while (word) {
+                mfxU64 bit = word & (~word + 1);
+                // another thread may have taken the same bit: retry on what is left
+                word = msdk_atomic_and64(&m_pWords[i], ~bit);
+                if (word & bit) {
+                    return (mfxI32)(i * MSDK_BITMAP_WORD_BITS + __builtin_ctzll(bit));
+                }
+            }
+        }
+        return -1;
+    }
+    inline mfxU32 GetWordsNumber() {
+        return m_WordsNumber;
+    }
+    inline mfxU64 GetWord(mfxU32 i) {
+        return msdk_atomic_load64(&m_pWords[i]);
+    }
+
+private:
+    static inline mfxU64 Bit(mfxU32 index) {
+        return (mfxU64)1 << (index % MSDK_BITMAP_WORD_BITS);
+    }
+
+    volatile mfxU64* m_pWords;
+    mfxU32 m_WordsNumber;
+
+    msdkSurfaceBitmap(const msdkSurfaceBitmap&);
+    void operator=(const msdkSurfaceBitmap&);
+};
+
+// set of free frame surfaces
 class msdkFreeSurfacesPool
 {
     friend class CBuffering;
 public:
-    msdkFreeSurfacesPool(MSDKMutex* mutex):
-        m_pSurfaces(NULL),
-        m_pMutex(mutex) {}
+    msdkFreeSurfacesPool():
+        m_pSurfaces(NULL) {}
 
     ~msdkFreeSurfacesPool() {
         m_pSurfaces = NULL;
@@ -70,213 +139,141 @@ public:
     /** \brief The function adds free surface to the free surfaces array.
      *
      * @note That's caller responsibility to pass valid surface.
-     * @note We always add and get free surface from the array head. In case not all surfaces
+     * @note Surfaces are always taken starting from the lowest index. In case not all surfaces
      * will be actually used we have good chance to avoid actual allocation of the surface memory.
      */
     inline void AddSurface(msdkFrameSurface* surface) {
-        AutomaticMutex lock(*m_pMutex);
-        AddSurfaceUnsafe(surface);
+        MSDK_SELF_CHECK(surface);
+        m_Free.Set((mfxU32)(surface - m_pSurfaces));
     }
     /** \brief The function gets the next free surface from the free surfaces array.
      *
      * @note Surface is detached from the free surfaces array.
      */
     inline msdkFrameSurface* GetSurface() {
-        AutomaticMutex lock(*m_pMutex);
-        return GetSurfaceUnsafe();
-    }
-
-private:
-    inline void AddSurfaceUnsafe(msdkFrameSurface* surface) {
-        msdkFrameSurface* head;
-
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->prev);
-        MSDK_SELF_CHECK(!surface->next);
-
-        head = m_pSurfaces;
-        m_pSurfaces = surface;
-        m_pSurfaces->next = head;
-    }
-    inline msdkFrameSurface* GetSurfaceUnsafe() {
-
-        msdkFrameSurface* surface = NULL;
-
-        if (m_pSurfaces) {
-            surface = m_pSurfaces;
-            m_pSurfaces = m_pSurfaces->next;
-            surface->prev = surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->prev);
-            MSDK_SELF_CHECK(!surface->next);
-        }
-        return surface;
+        mfxI32 index = m_Free.TakeFirst();
+        return (index < 0) ? NULL : &m_pSurfaces[index];
     }
 
 protected:
-    msdkFrameSurface* m_pSurfaces;
-    MSDKMutex* m_pMutex;
+    msdkFrameSurface* m_pSurfaces;  // surfaces array the bitmap indexes
+    msdkSurfaceBitmap m_Free;
 
 private:
     msdkFreeSurfacesPool(const msdkFreeSurfacesPool&);
     void operator=(const msdkFreeSurfacesPool&);
 };
 
-// random access, predicted as FIFO
+// set of surfaces owned by Media SDK or the renderer
 class msdkUsedSurfacesPool
 {
     friend class CBuffering;
 public:
-    msdkUsedSurfacesPool(MSDKMutex* mutex):
-        m_pSurfacesHead(NULL),
-        m_pSurfacesTail(NULL),
-        m_pMutex(mutex) {}
+    msdkUsedSurfacesPool():
+        m_pSurfaces(NULL) {}
 
     ~msdkUsedSurfacesPool() {
-        m_pSurfacesHead = NULL;
-        m_pSurfacesTail = NULL;
+        m_pSurfaces = NULL;
     }
 
-    /** \brief The function adds surface to the used surfaces array (m_pUsedSurfaces).
+    /** \brief The function adds surface to the used surfaces array.
      *
      * @note That's caller responsibility to pass valid surface.
-     * @note We can't actually know which surface will be returned by the decoder or unlocked. However,
-     * we can make prediction that it will be the oldest surface. Thus, here the function adds new
-     * surface (youngest) to the tail of the least. Check operations for the list will run starting from
-     * head.
      */
     inline void AddSurface(msdkFrameSurface* surface) {
-        AutomaticMutex lock(*m_pMutex);
-        AddSurfaceUnsafe(surface);
+        MSDK_SELF_CHECK(surface);
+        m_Used.Set((mfxU32)(surface - m_pSurfaces));
     }
 
     /** \brief The function detaches surface from the used surfaces array.
      *
      * @note That's caller responsibility to pass valid surface.
      */
-
     inline void DetachSurface(msdkFrameSurface* surface) {
-        AutomaticMutex lock(*m_pMutex);
-        DetachSurfaceUnsafe(surface);
-    }
-
-private:
-    inline void DetachSurfaceUnsafe(msdkFrameSurface* surface)
-    {
         MSDK_SELF_CHECK(surface);
-
-        msdkFrameSurface *prev = surface->prev;
-        msdkFrameSurface *next = surface->next;
-
-        if (prev) {
-            prev->next = next;
-        }
-        else {
-            MSDK_SELF_CHECK(surface == m_pSurfacesHead);
-            m_pSurfacesHead = next;
-        }
-        if (next) {
-            next->prev = prev;
-        } else {
-            MSDK_SELF_CHECK(surface == m_pSurfacesTail);
-            m_pSurfacesTail = prev;
-        }
-
-        surface->prev = surface->next = NULL;
-        MSDK_SELF_CHECK(!surface->prev);
-        MSDK_SELF_CHECK(!surface->next);
-    }
-    inline void AddSurfaceUnsafe(msdkFrameSurface* surface)
-    {
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->prev);
-        MSDK_SELF_CHECK(!surface->next);
-
-        surface->prev = m_pSurfacesTail;
-        surface->next = NULL;
-        if (m_pSurfacesTail) {
-            m_pSurfacesTail->next = surface;
-            m_pSurfacesTail = m_pSurfacesTail->next;
-        } else {
-            m_pSurfacesHead = m_pSurfacesTail = surface;
-        }
+        m_Used.Clear((mfxU32)(surface - m_pSurfaces));
     }
 
 protected:
-    msdkFrameSurface* m_pSurfacesHead; // oldest surface
-    msdkFrameSurface* m_pSurfacesTail; // youngest surface
-    MSDKMutex* m_pMutex;
+    msdkFrameSurface* m_pSurfaces;  // surfaces array the bitmap indexes
+    msdkSurfaceBitmap m_Used;
 
 private:
     msdkUsedSurfacesPool(const msdkUsedSurfacesPool&);
     void operator=(const msdkUsedSurfacesPool&);
 };
 
-// FIFO list of surfaces
+/** \brief FIFO of output surfaces.
+ *
+ * Single producer / single consumer ring: one thread adds, one thread gets,
+ * and the two only share the head and tail indices.
+ */
 class msdkOutputSurfacesPool
 {
     friend class CBuffering;
 public:
-    msdkOutputSurfacesPool(MSDKMutex* mutex):
-        m_pSurfacesHead(NULL),
-        m_pSurfacesTail(NULL),
-        m_SurfacesCount(0),
-        m_pMutex(mutex) {}
+    msdkOutputSurfacesPool():
+        m_ppSurfaces(NULL),
+        m_Mask(0),
+        m_Head(0),
+        m_Tail(0) {}
 
     ~msdkOutputSurfacesPool() {
-        m_pSurfacesHead = NULL;
-        m_pSurfacesTail = NULL;
+        Free();
     }
 
-    inline void AddSurface(msdkOutputSurface* surface) {
-        AutomaticMutex lock(*m_pMutex);
-        AddSurfaceUnsafe(surface);
+    /** \brief Adds surface to the tail, false if the ring is full.
+     */
+    inline bool AddSurface(msdkOutputSurface* surface) {
+        mfxU32 tail = m_Tail;
+
+        MSDK_SELF_CHECK(surface);
+        if (tail - msdk_atomic_load32(&m_Head) > m_Mask) {
+            return false;
+        }
+        m_ppSurfaces[tail & m_Mask] = surface;
+        msdk_atomic_store32(&m_Tail, tail + 1);
+        return true;
     }
     inline msdkOutputSurface* GetSurface() {
-        AutomaticMutex lock(*m_pMutex);
-        return GetSurfaceUnsafe();
+        mfxU32 head = m_Head;
+
+        if (head == msdk_atomic_load32(&m_Tail)) {
+            return NULL;
+        }
+        msdkOutputSurface* surface = m_ppSurfaces[head & m_Mask];
+        msdk_atomic_store32(&m_Head, head + 1);
+        return surface;
     }
 
     inline mfxU32 GetSurfaceCount() {
-        return m_SurfacesCount;
+        return msdk_atomic_load32(&m_Tail) - msdk_atomic_load32(&m_Head);
     }
-private:
-    inline void AddSurfaceUnsafe(msdkOutputSurface* surface)
-    {
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->next);
-        surface->next = NULL;
-
-        if (m_pSurfacesTail) {
-            m_pSurfacesTail->next = surface;
-            m_pSurfacesTail = m_pSurfacesTail->next;
-        } else {
-            m_pSurfacesHead = m_pSurfacesTail = surface;
+
+protected:
+    mfxStatus Alloc(mfxU32 SurfaceNumber) {
+        mfxU32 size = 1;
+
+        Free();
+        while (size < SurfaceNumber) {
+            size <<= 1;
         }
-        ++m_SurfacesCount;
+        m_ppSurfaces = (msdkOutputSurface**)calloc(size, sizeof(msdkOutputSurface*));
+        if (!m_ppSurfaces) return MFX_ERR_MEMORY_ALLOC;
+        m_Mask = size - 1;
+        return MFX_ERR_NONE;
     }
-    inline msdkOutputSurface* GetSurfaceUnsafe()
-    {
-        msdkOutputSurface* surface = NULL;
-
-        if (m_pSurfacesHead) {
-            surface = m_pSurfacesHead;
-            m_pSurfacesHead = m_pSurfacesHead->next;
-            if (!m_pSurfacesHead) {
-                // there was only one surface in the array...
-                m_pSurfacesTail = NULL;
-            }
-            --m_SurfacesCount;
-            surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->next);
-        }
-        return surface;
+    void Free() {
+        free(m_ppSurfaces);
+        m_ppSurfaces = NULL;
+        m_Mask = 0;
+        m_Head = m_Tail = 0;
     }
 
-protected:
-    msdkOutputSurface*      m_pSurfacesHead; // oldest surface
-    msdkOutputSurface*      m_pSurfacesTail; // youngest surface
-    mfxU32                  m_SurfacesCount;
-    MSDKMutex*              m_pMutex;
+    msdkOutputSurface**     m_ppSurfaces;
+    mfxU32                  m_Mask;  // ring size - 1, size is a power of two
+    volatile mfxU32         m_Head;  // next slot to get, owned by the consumer
+    volatile mfxU32         m_Tail;  // next slot to fill, owned by the producer
 
 private:
     msdkOutputSurfacesPool(const msdkOutputSurfacesPool&);
@@ -284,6 +281,10 @@ private:
 };
 
 /** \brief Helper class defining optimal buffering operations for the Media SDK decoder.
+ *
+ * Surfaces move between pools without locks: frame surfaces are tracked in
+ * atomic bitmaps and decoded output travels to the delivering thread through
+ * a single producer / single consumer ring.
  */
 class CBuffering
 {
@@ -294,7 +295,6 @@ public:
 protected: // functions
     mfxStatus AllocBuffers(mfxU32 SurfaceNumber);
     mfxStatus AllocVppBuffers(mfxU32 VppSurfaceNumber);
-    void AllocOutputBuffer();
     void FreeBuffers();
     void ResetBuffers();
     void ResetVppBuffers();
@@ -306,6 +306,7 @@ protected: // functions
      */
     void SyncFrameSurfaces();
     void SyncVppFrameSurfaces();
+    static void SyncSurfaces(msdkUsedSurfacesPool& used, msdkFreeSurfacesPool& freePool);
 
     /** \brief Returns surface which corresponds to the given one in Media SDK format (mfxFrameSurface1).
      *
@@ -316,40 +317,13 @@ protected: // functions
         return (msdkFrameSurface*)(frame);
     }
 
-    inline void AddFreeOutputSurfaceUnsafe(msdkOutputSurface* surface)
-    {
-        msdkOutputSurface* head = m_pFreeOutputSurfaces;
-
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->next);
-        m_pFreeOutputSurfaces = surface;
-        m_pFreeOutputSurfaces->next = head;
-    }
     inline void AddFreeOutputSurface(msdkOutputSurface* surface) {
-        AutomaticMutex lock(m_Mutex);
-        AddFreeOutputSurfaceUnsafe(surface);
-    }
-
-    inline msdkOutputSurface* GetFreeOutputSurfaceUnsafe()
-    {
-        msdkOutputSurface* surface = NULL;
-
-        if (!m_pFreeOutputSurfaces) {
-            m_Mutex.Unlock();
-            AllocOutputBuffer();
-            m_Mutex.Lock();
-        }
-        if (m_pFreeOutputSurfaces) {
-            surface = m_pFreeOutputSurfaces;
-            m_pFreeOutputSurfaces = m_pFreeOutputSurfaces->next;
-            surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->next);
-        }
-        return surface;
+        MSDK_SELF_CHECK(surface);
+        m_FreeOutputSurfaces.Set((mfxU32)(surface - m_pOutputSurfaces));
     }
     inline msdkOutputSurface* GetFreeOutputSurface() {
-        AutomaticMutex lock(m_Mutex);
-        return GetFreeOutputSurfaceUnsafe();
+        mfxI32 index = m_FreeOutputSurfaces.TakeFirst();
+        return (index < 0) ? NULL : &m_pOutputSurfaces[index];
     }
 
     /** \brief Function returns surface data to the corresponding buffers.
@@ -373,20 +347,20 @@ protected: // variables
     mfxU32                  m_OutputSurfacesNumber;
     msdkFrameSurface*       m_pSurfaces;
     msdkFrameSurface*       m_pVppSurfaces;
-    MSDKMutex               m_Mutex;
 
-    // LIFO list of frame surfaces
+    // frame surfaces, the lowest free index is taken first
     msdkFreeSurfacesPool    m_FreeSurfacesPool;
     msdkFreeSurfacesPool    m_FreeVppSurfacesPool;
 
-    // random access, predicted as FIFO
+    // frame surfaces owned by Media SDK or the renderer
     msdkUsedSurfacesPool    m_UsedSurfacesPool;
     msdkUsedSurfacesPool    m_UsedVppSurfacesPool;
 
-    // LIFO list of output surfaces
-    msdkOutputSurface*      m_pFreeOutputSurfaces;
+    // output surfaces, one per output frame surface plus the one being filled
+    msdkOutputSurface*      m_pOutputSurfaces;
+    msdkSurfaceBitmap       m_FreeOutputSurfaces;
 
-    // FIFO list of surfaces
+    // FIFO rings of surfaces: submitted to Media SDK and synced for delivery
     msdkOutputSurfacesPool  m_OutputSurfacesPool;
     msdkOutputSurfacesPool  m_DeliveredSurfacesPool;
 
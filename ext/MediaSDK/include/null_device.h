@@ -0,0 +1,68 @@
+/******************************************************************************\
+Copyright (c) 2005-2018, Intel Corporation
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**********************************************************************************/
+
+#ifndef __NULL_DEVICE_H__
+#define __NULL_DEVICE_H__
+
+#include <memory>
+#include "hw_device.h"
+#include "vaapi_utils_drm.h"
+
+CHWDevice* CreateNullDevice(void);
+
+#define HANDLE_NULL_DEVICE   (MFX_HANDLE_VA_DISPLAY << 5)
+
+/** \brief Headless device: frames are counted and timestamped, nothing is shown.
+ *
+ * Lets the decoding pipeline run in rendering mode without Wayland. The VA
+ * display is only opened when Media SDK asks for it, so a software library
+ * with system memory needs no DRM node either.
+ */
+class CNullDevice : public CHWDevice
+{
+public:
+    CNullDevice(void);
+    virtual ~CNullDevice(void);
+
+    virtual mfxStatus Init(mfxHDL hWindow, mfxU16 nViews, mfxU32 nAdapterNum);
+    virtual mfxStatus Reset(void);
+    virtual void Close(void);
+
+    virtual mfxStatus SetHandle(mfxHandleType type, mfxHDL hdl) { return MFX_ERR_UNSUPPORTED; }
+    virtual mfxStatus GetHandle(mfxHandleType type, mfxHDL *pHdl);
+    virtual mfxStatus RenderFrame(mfxFrameSurface1 * pSurface, mfxFrameAllocator * pmfxAlloc);
+    virtual void UpdateTitle(double fps) { }
+    virtual void SetMondelloInput(bool isMondelloInputEnabled) { }
+
+    mfxU32 GetFrameCount() { return m_nFrames; }
+    void PrintStats();
+
+protected:
+    std::unique_ptr<DRMLibVA> m_DRMLibVA;
+
+private:
+    mfxU32 m_nFrames;
+    msdk_tick m_firstTick;   // tick of the first rendered frame
+    msdk_tick m_lastTick;
+    msdk_tick m_minInterval; // between two consecutive frames
+    msdk_tick m_maxInterval;
+    mfxU64 m_lastTimeStamp;  // of the last frame, 90kHz
+
+    // no copies allowed
+    CNullDevice(const CNullDevice &);
+    void operator=(const CNullDevice &);
+};
+
+#endif //__NULL_DEVICE_H__
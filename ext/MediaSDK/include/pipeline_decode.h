@@ -42,7 +42,7 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 #include "general_allocator.h"
 #include "vaapi_device.h"
 
-#include "GPIOControl.hpp"
+#include "frame_pacer.h"
 
 #ifndef MFX_VERSION
 #error MFX_VERSION not defined
@@ -60,6 +60,11 @@ enum eWorkMode {
   MODE_FILE_DUMP
 };
 
+enum ePresentMode {
+  PRESENT_MODE_FIFO,    // every frame is shown, delivery blocks when the queue is full
+  PRESENT_MODE_MAILBOX  // newest frame replaces the oldest queued one
+};
+
 #if MFX_VERSION >= 1022
 enum eDecoderPostProc {
   MODE_DECODER_POSTPROC_AUTO  = 0x1,
@@ -79,6 +84,7 @@ struct sInputParams
     bool    bCalLat; // latency calculation
     bool    bUseFullColorRange; //whether to use full color range
     mfxU16  nMaxFPS; //rendering limited by certain fps
+    ePacingPolicy pacingPolicy; // what to do with frames which are late for nMaxFPS
     mfxU32  nWallCell;
     mfxU32  nWallW; //number of windows located in each row
     mfxU32  nWallH; //number of windows located in each column
@@ -107,6 +113,9 @@ struct sInputParams
     bool    outI420;
 
     bool    bPerfMode;
+    bool    bNullRender; // rendering mode draws into CNullDevice instead of Wayland
+    ePresentMode presentMode;
+    mfxU16  nPresentQueueDepth; // frames queued ahead of the compositor, 0 - default
     bool    bRenderWin;
     mfxU32  nRenderWinX;
     mfxU32  nRenderWinY;
@@ -165,7 +174,7 @@ class CDecodingPipeline:
     public CPipelineStatistics
 {
 public:
-    CDecodingPipeline(earlyapp::GPIOControl* pGPIO=nullptr);
+    CDecodingPipeline();
     virtual ~CDecodingPipeline();
 
     virtual mfxStatus Init(sInputParams *pParams);
@@ -173,6 +182,10 @@ public:
     virtual void Close();
     virtual mfxStatus ResetDecoder(sInputParams *pParams);
     virtual mfxStatus ResetDevice();
+    // Hides the output; session, allocator and surfaces stay for Restart()
+    virtual void Stop();
+    // Rewinds the input and resets the decoder for another RunDecoding()
+    virtual mfxStatus Restart();
 
     void SetMultiView();
     void SetExtBuffersFlag()       { m_bIsExtBuffers = true; }
@@ -219,7 +232,7 @@ protected: // functions
     virtual bool IsVppRequired(sInputParams *pParams);
 
     virtual mfxStatus CreateAllocator();
-    virtual mfxStatus CreateHWDevice(earlyapp::GPIOControl* pGPIOCtrl=nullptr);
+    virtual mfxStatus CreateHWDevice();
     virtual mfxStatus AllocFrames();
     virtual void DeleteFrames();
     virtual void DeleteAllocator();
@@ -236,6 +249,7 @@ protected: // functions
     virtual void PrintPerFrameStat(bool force = false);
 
     virtual mfxStatus DeliverLoop(void);
+    virtual void FinishPresentation(void);
 
     static unsigned int MFX_STDCALL DeliverThreadFunc(void* ctx);
 
@@ -302,8 +316,7 @@ protected: // variables
     bool                    m_bVppFullColorRange;
     std::vector<msdk_tick>  m_vLatency;
 
-    msdk_tick               m_startTick;
-    msdk_tick               m_delayTicks;
+    CFramePacer             m_FramePacer; // keeps rendering at m_nMaxFps
 
     mfxExtVPPDoNotUse       m_VppDoNotUse;      // for disabling VPP algorithms
     mfxExtVPPDeinterlacing  m_VppDeinterlacing;
@@ -323,6 +336,9 @@ protected: // variables
     mfxU32                  m_export_mode;
     mfxI32                  m_monitorType;
     bool                    m_bPerfMode;
+    bool                    m_bNullRender;
+    ePresentMode            m_ePresentMode;
+    mfxU16                  m_nPresentQueueDepth;
 
     bool                    m_bResetFileWriter;
     bool                    m_bResetFileReader;
@@ -330,9 +346,6 @@ private:
     CDecodingPipeline(const CDecodingPipeline&);
 
     void operator=(const CDecodingPipeline&);
-
-    // GPIO control.
-    earlyapp::GPIOControl* m_pGPIOCtrl = nullptr;
 };
 
 #endif // __PIPELINE_DECODE_H__
@@ -22,11 +22,10 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 
 #include "hw_device.h"
 #include "vaapi_utils_drm.h"
-#include "GPIOControl.hpp"
 
 
 
-CHWDevice* CreateVAAPIDevice(earlyapp::GPIOControl* pGPIO=nullptr);
+CHWDevice* CreateVAAPIDevice(void);
 class Wayland;
 
 #define HANDLE_WAYLAND_DRIVER   (MFX_HANDLE_VA_DISPLAY << 4)
@@ -34,14 +33,13 @@ class Wayland;
 class CVAAPIDeviceWayland : public CHWDevice
 {
 public:
-    CVAAPIDeviceWayland(earlyapp::GPIOControl* pGPIO=nullptr){
+    CVAAPIDeviceWayland(void){
         m_nRenderWinX = 0;
         m_nRenderWinY = 0;
         m_nRenderWinW = 0;
         m_nRenderWinH = 0;
         m_isMondelloInputEnabled = false;
         m_Wayland = NULL;
-        m_pGPIOCtrl = pGPIO;
         m_bGotFirstFrame = false;
     }
     virtual ~CVAAPIDeviceWayland(void);
@@ -83,7 +81,6 @@ private:
 
     // Measure KPI number for the first frame.
     bool m_bGotFirstFrame = false;
-    earlyapp::GPIOControl* m_pGPIOCtrl = nullptr;
 
     // no copies allowed
     CVAAPIDeviceWayland(const CVAAPIDeviceWayland &);
@@ -34,4 +34,19 @@ mfxU32 msdk_atomic_inc32(volatile mfxU32 *pVariable);
 /* Thread-safe 32-bit variable decrementing */
 mfxU32 msdk_atomic_dec32(volatile mfxU32 *pVariable);
 
+/* 32-bit read with acquire semantics */
+mfxU32 msdk_atomic_load32(volatile mfxU32 *pVariable);
+
+/* 32-bit write with release semantics */
+void msdk_atomic_store32(volatile mfxU32 *pVariable, mfxU32 value);
+
+/* 64-bit read with acquire semantics */
+mfxU64 msdk_atomic_load64(volatile mfxU64 *pVariable);
+
+/* Thread-safe 64-bit OR, returns the previous value */
+mfxU64 msdk_atomic_or64(volatile mfxU64 *pVariable, mfxU64 mask);
+
+/* Thread-safe 64-bit AND, returns the previous value */
+mfxU64 msdk_atomic_and64(volatile mfxU64 *pVariable, mfxU64 mask);
+
 #endif // #ifndef __ATOMIC_DEFS_H__
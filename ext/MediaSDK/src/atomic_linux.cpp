@@ -60,3 +60,27 @@ mfxU32 msdk_atomic_dec32(volatile mfxU32 *pVariable)
     return msdk_atomic_add32(pVariable, (mfxU32)-1) + 1;
 }
 
+mfxU32 msdk_atomic_load32(volatile mfxU32 *pVariable)
+{
+    return __atomic_load_n(pVariable, __ATOMIC_ACQUIRE);
+}
+
+void msdk_atomic_store32(volatile mfxU32 *pVariable, mfxU32 value)
+{
+    __atomic_store_n(pVariable, value, __ATOMIC_RELEASE);
+}
+
+mfxU64 msdk_atomic_load64(volatile mfxU64 *pVariable)
+{
+    return __atomic_load_n(pVariable, __ATOMIC_ACQUIRE);
+}
+
+mfxU64 msdk_atomic_or64(volatile mfxU64 *pVariable, mfxU64 mask)
+{
+    return __atomic_fetch_or(pVariable, mask, __ATOMIC_ACQ_REL);
+}
+
+mfxU64 msdk_atomic_and64(volatile mfxU64 *pVariable, mfxU64 mask)
+{
+    return __atomic_fetch_and(pVariable, mask, __ATOMIC_ACQ_REL);
+}
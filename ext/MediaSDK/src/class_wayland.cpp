@@ -19,10 +19,13 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 
 #include <iostream>
 #include <exception>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <fcntl.h>
 #include <unistd.h>
 #include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 extern "C" {
 #include <drm.h>
@@ -32,6 +35,9 @@ extern "C" {
 #include "class_wayland.h"
 #include "listener_wayland.h"
 #include "wayland-drm-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+#include "vm/atomic_defs.h"
+#include "SplashHandoff.h"
 
 #define BATCH_SIZE 0x80000
 
@@ -43,6 +49,16 @@ static const struct wl_buffer_listener buffer_listener = {
     buffer_release
 };
 
+static const struct wl_buffer_listener present_buffer_listener = {
+    present_buffer_release
+};
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    feedback_sync_output,
+    feedback_presented,
+    feedback_discarded
+};
+
 Wayland::Wayland()
     : m_display(NULL)
     , m_registry(NULL)
@@ -59,12 +75,32 @@ Wayland::Wayland()
     , m_shm_pool(NULL)
     , m_display_fd(-1)
     , m_fd(-1)
+    , m_dispatch_running(false)
+    , m_dispatch_wake(-1)
+    , m_display_lost(false)
     , m_bufmgr(NULL)
     , m_device_name(NULL)
     , m_x(0), m_y(0)
     , m_perf_mode(false)
+    , m_presentation(NULL)
+    , m_present_clock(CLOCK_MONOTONIC)
+    , m_present_mailbox(false)
+    , m_present_queue_depth(WL_PRESENT_DEFAULT_QUEUE_DEPTH)
+    , m_present_queue_head(0)
+    , m_present_queue_count(0)
+    , m_present_last_queued_ns(0)
 {
-    std::memset(&m_poll, 0, sizeof(m_poll));
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&m_present_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&m_present_mutex, NULL);
+
+    std::memset(m_present_frames, 0, sizeof(m_present_frames));
+    std::memset(m_present_queue, 0, sizeof(m_present_queue));
+    std::memset(&m_present_stats, 0, sizeof(m_present_stats));
 }
 
 bool Wayland::InitDisplay()
@@ -91,9 +127,7 @@ bool Wayland::InitDisplay()
     if(NULL == m_event_queue)
         return false;
 
-    m_poll.fd = m_display_fd;
-    m_poll.events = POLLIN;
-    return true;
+    return StartDispatch();
 }
 
 int Wayland::DisplayRoundtrip()
@@ -133,29 +167,160 @@ bool Wayland::CreateSurface()
 
 void Wayland::FreeSurface()
 {
+    pthread_mutex_lock(&m_present_mutex);
+    while(m_present_queue_count)
+        DropQueuedFrame();
+    DestroyCallback();
+
+    /* Nothing is dispatched from here on, give back whatever the
+       compositor still holds */
+    for(int i = 0; i < WL_PRESENT_MAX_FRAMES; i++)
+    {
+        struct PresentFrame *frame = &m_present_frames[i];
+        if(!frame->in_use)
+            continue;
+        if(NULL != frame->feedback)
+            wp_presentation_feedback_destroy(frame->feedback);
+        if(NULL != frame->buffer)
+            wl_buffer_destroy(frame->buffer);
+        if(NULL != frame->render_lock)
+            msdk_atomic_dec16(frame->render_lock);
+        std::memset(frame, 0, sizeof(*frame));
+    }
+
     if(NULL != m_shell_surface)
         wl_shell_surface_destroy(m_shell_surface);
     if(NULL != m_surface)
         wl_surface_destroy(m_surface);
+    m_shell_surface = NULL;
+    m_surface = NULL;
+    pthread_mutex_unlock(&m_present_mutex);
 }
 
-void Wayland::Sync()
+bool Wayland::StartDispatch()
 {
-    int ret;
-    while(NULL != m_callback)
+    m_dispatch_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(m_dispatch_wake < 0)
+        return false;
+
+    if(0 != pthread_create(&m_dispatch_thread, NULL, DispatchThread, this))
     {
+        close(m_dispatch_wake);
+        m_dispatch_wake = -1;
+        return false;
+    }
+    m_dispatch_running = true;
+    return true;
+}
+
+void Wayland::StopDispatch()
+{
+    uint64_t one = 1;
+
+    if(!m_dispatch_running)
+        return;
+
+    if(write(m_dispatch_wake, &one, sizeof(one)) < 0)
+        std::cout << "Error: Cannot stop wayland dispatch thread\n";
+    pthread_join(m_dispatch_thread, NULL);
+    close(m_dispatch_wake);
+    m_dispatch_wake = -1;
+    m_dispatch_running = false;
+}
+
+void * Wayland::DispatchThread(void *arg)
+{
+    static_cast<Wayland*>(arg)->DispatchLoop();
+    return NULL;
+}
+
+void Wayland::DispatchLoop()
+{
+    struct pollfd fds[2];
+
+    fds[0].fd = m_display_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_dispatch_wake;
+    fds[1].events = POLLIN;
+
+    for(;;)
+    {
+        pthread_mutex_lock(&m_present_mutex);
         while(wl_display_prepare_read_queue(m_display, m_event_queue) < 0)
             wl_display_dispatch_queue_pending(m_display, m_event_queue);
-
+        /* Flushed under the lock so no request leaves before its
+           proxy is moved to m_event_queue */
         wl_display_flush(m_display);
+        pthread_mutex_unlock(&m_present_mutex);
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if((poll(fds, 2, -1) < 0) && (EINTR != errno))
+        {
+            wl_display_cancel_read(m_display);
+            break;
+        }
+        if(fds[1].revents)
+        {
+            wl_display_cancel_read(m_display);
+            return;
+        }
 
-        ret = poll(&m_poll,1,-1);
-        if(ret < 0 )
+        if(!(fds[0].revents & POLLIN))
             wl_display_cancel_read(m_display);
-        else
-        wl_display_read_events(m_display);
-        wl_display_dispatch_queue_pending(m_display, m_event_queue);
+        else if(wl_display_read_events(m_display) < 0)
+            break;
+
+        pthread_mutex_lock(&m_present_mutex);
+        if(wl_display_dispatch_queue_pending(m_display, m_event_queue) < 0)
+        {
+            pthread_mutex_unlock(&m_present_mutex);
+            break;
+        }
+        pthread_cond_broadcast(&m_present_cond);
+        pthread_mutex_unlock(&m_present_mutex);
     }
+
+    std::cout << "Error: Lost wayland display\n";
+    pthread_mutex_lock(&m_present_mutex);
+    m_display_lost = true;
+    pthread_cond_broadcast(&m_present_cond);
+    pthread_mutex_unlock(&m_present_mutex);
+}
+
+/* Waits, with m_present_mutex held, until the dispatch thread has handled
+   new events. Returns false on timeout or once the display is gone. */
+bool Wayland::WaitPresent(int timeout_ms)
+{
+    struct timespec ts;
+
+    if(m_display_lost)
+        return false;
+    if(timeout_ms < 0)
+        return (0 == pthread_cond_wait(&m_present_cond, &m_present_mutex))
+            && !m_display_lost;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if(ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return (0 == pthread_cond_timedwait(&m_present_cond, &m_present_mutex, &ts))
+        && !m_display_lost;
+}
+
+void Wayland::Sync()
+{
+    pthread_mutex_lock(&m_present_mutex);
+    while(NULL != m_callback)
+    {
+        if(!WaitPresent(-1))
+            break;
+    }
+    pthread_mutex_unlock(&m_present_mutex);
 }
 
 void Wayland::SetPerfMode(bool perf_mode)
@@ -168,30 +333,292 @@ void Wayland::SetRenderWinPos(int x, int y)
     m_x = x; m_y = y;
 }
 
+void Wayland::SetPresentMode(bool mailbox, mfxU32 queue_depth)
+{
+    m_present_mailbox = mailbox;
+
+    /* Keep room for the buffers the compositor holds while
+       the queue is full */
+    if(0 == queue_depth)
+        queue_depth = WL_PRESENT_DEFAULT_QUEUE_DEPTH;
+    if(queue_depth > WL_PRESENT_MAX_FRAMES - 2)
+        queue_depth = WL_PRESENT_MAX_FRAMES - 2;
+    m_present_queue_depth = queue_depth;
+}
+
+uint64_t Wayland::PresentClockNow()
+{
+    struct timespec ts;
+
+    clock_gettime(m_present_clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 void Wayland::RenderBuffer(struct wl_buffer *buffer
      , int32_t width
-     , int32_t height)
+     , int32_t height
+     , volatile mfxU16 *render_lock)
 {
-    wl_surface_attach(m_surface, buffer, 0, 0);
-    wl_surface_damage(m_surface, m_x, m_y, width, height);
+    struct PresentFrame *frame = NULL;
+
+    /* Frame callbacks and releases are handled by the dispatch thread,
+       only a full queue or a lack of free slots makes us wait for it */
+    pthread_mutex_lock(&m_present_mutex);
+    if(m_present_queue_count >= m_present_queue_depth)
+    {
+        if(m_present_mailbox)
+            DropQueuedFrame();
+        while(m_present_queue_count >= m_present_queue_depth)
+        {
+            if(!WaitPresent(-1))
+                break;
+        }
+    }
+
+    while(NULL == frame)
+    {
+        for(int i = 0; i < WL_PRESENT_MAX_FRAMES; i++)
+        {
+            if(!m_present_frames[i].in_use)
+            {
+                frame = &m_present_frames[i];
+                break;
+            }
+        }
+        if((NULL == frame) && !WaitPresent(-1))
+        {
+            std::cout << "Error: Lost wayland display\n";
+            wl_buffer_destroy(buffer);
+            pthread_mutex_unlock(&m_present_mutex);
+            return;
+        }
+    }
+
+    frame->wayland = this;
+    frame->buffer = buffer;
+    frame->feedback = NULL;
+    frame->render_lock = render_lock;
+    frame->width = width;
+    frame->height = height;
+    frame->queued_ns = PresentClockNow();
+    frame->in_use = true;
+    frame->committed = false;
+
+    if(NULL != render_lock)
+        msdk_atomic_inc16(render_lock);
 
     wl_proxy_set_queue((struct wl_proxy *) buffer, m_event_queue);
+    wl_buffer_add_listener(buffer, &present_buffer_listener, frame);
+
+    m_present_queue[(m_present_queue_head + m_present_queue_count)
+        % WL_PRESENT_MAX_FRAMES] = frame;
+    m_present_queue_count++;
+    m_present_stats.queued++;
+
+    /* Nothing waits for vblank: show it right away. Otherwise the
+       frame callback of the previous commit picks it up. */
+    if(NULL == m_callback)
+        CommitQueuedFrame();
+    pthread_mutex_unlock(&m_present_mutex);
+}
+
+void Wayland::CommitQueuedFrame()
+{
+    struct PresentFrame *frame;
+
+    if(0 == m_present_queue_count)
+        return;
+
+    frame = m_present_queue[m_present_queue_head];
+    m_present_queue_head = (m_present_queue_head + 1) % WL_PRESENT_MAX_FRAMES;
+    m_present_queue_count--;
+
+    CommitFrame(frame);
+}
+
+void Wayland::CommitFrame(struct PresentFrame *frame)
+{
+    wl_surface_attach(m_surface, frame->buffer, 0, 0);
+    wl_surface_damage(m_surface, m_x, m_y, frame->width, frame->height);
 
-    wl_buffer_add_listener(buffer, &buffer_listener, NULL);
     m_pending_frame=1;
     if (m_perf_mode)
         m_callback = wl_display_sync(m_display);
     else
-    m_callback = wl_surface_frame(m_surface);
+        m_callback = wl_surface_frame(m_surface);
     wl_callback_add_listener(m_callback, &frame_listener, this);
     wl_proxy_set_queue((struct wl_proxy *) m_callback, m_event_queue);
+
+    if(NULL != m_presentation)
+    {
+        frame->feedback = wp_presentation_feedback(m_presentation, m_surface);
+        wl_proxy_set_queue((struct wl_proxy *) frame->feedback, m_event_queue);
+        wp_presentation_feedback_add_listener(frame->feedback
+            , &feedback_listener
+            , frame);
+    }
+    else
+    {
+        m_present_last_queued_ns = frame->queued_ns;
+    }
+
+    frame->committed = true;
+    wl_surface_commit(m_surface);
+    wl_display_flush(m_display);
+}
+
+void Wayland::DropQueuedFrame()
+{
+    struct PresentFrame *frame;
+
+    if(0 == m_present_queue_count)
+        return;
+
+    frame = m_present_queue[m_present_queue_head];
+    m_present_queue_head = (m_present_queue_head + 1) % WL_PRESENT_MAX_FRAMES;
+    m_present_queue_count--;
+
+    /* Never attached, so no release event will come for it */
+    wl_buffer_destroy(frame->buffer);
+    if(NULL != frame->render_lock)
+        msdk_atomic_dec16(frame->render_lock);
+    std::memset(frame, 0, sizeof(*frame));
+    m_present_stats.dropped++;
+}
+
+void Wayland::FlushPresentQueue()
+{
+    pthread_mutex_lock(&m_present_mutex);
+    while(m_present_queue_count || (NULL != m_callback))
+    {
+        if(!WaitPresent(-1))
+            break;
+    }
+    pthread_mutex_unlock(&m_present_mutex);
+}
+
+void Wayland::HideSurface()
+{
+    FlushPresentQueue();
+
+    pthread_mutex_lock(&m_present_mutex);
+    /* A NULL attach unmaps the surface but keeps it and its shell role,
+       the next RenderBuffer() maps it again */
+    wl_surface_attach(m_surface, NULL, 0, 0);
     wl_surface_commit(m_surface);
-    wl_display_dispatch_queue(m_display, m_event_queue);
-    /* Force a Sync before and after render to ensure client handles
-      wayland events in a timely fashion. This also fixes the one time
-      flicker issue on wl_shell_surface pointer enter */
-    Sync();
+    wl_display_flush(m_display);
+
+    /* Wait for the compositor to give back the last shown buffer so the
+       decoder may reuse its surface */
+    for(int i = 0; i < WL_PRESENT_MAX_FRAMES; i++)
+    {
+        while(m_present_frames[i].in_use)
+        {
+            if(!WaitPresent(WL_HIDE_TIMEOUT_MS))
+            {
+                pthread_mutex_unlock(&m_present_mutex);
+                return;
+            }
+        }
+    }
+    pthread_mutex_unlock(&m_present_mutex);
+}
+
+void Wayland::FrameDone(uint32_t time)
+{
+    DestroyCallback();
+
+    /* Without presentation feedback the frame callback is the closest
+       hint that the last commit made it to the screen */
+    if((NULL == m_presentation) && m_present_last_queued_ns)
+    {
+        RecordPresent(m_present_last_queued_ns, PresentClockNow());
+        m_present_last_queued_ns = 0;
+    }
+
+    CommitQueuedFrame();
+}
+
+void Wayland::RecordPresent(uint64_t queued_ns, uint64_t present_ns)
+{
+    uint64_t latency = (present_ns > queued_ns) ? present_ns - queued_ns : 0;
+
+    if(0 == m_present_stats.presented)
+    {
+        m_present_stats.first_present_ns = present_ns;
+        SplashHandoff_presented("video");
+    }
+    m_present_stats.last_present_ns = present_ns;
+    m_present_stats.presented++;
+    m_present_stats.latency_sum_ns += latency;
+    if(latency > m_present_stats.latency_max_ns)
+        m_present_stats.latency_max_ns = latency;
+}
+
+void Wayland::FramePresented(struct PresentFrame *frame, uint64_t present_ns)
+{
+    RecordPresent(frame->queued_ns, present_ns);
+
+    wp_presentation_feedback_destroy(frame->feedback);
+    frame->feedback = NULL;
+    if(NULL == frame->buffer)
+        std::memset(frame, 0, sizeof(*frame));
+}
+
+void Wayland::FrameDiscarded(struct PresentFrame *frame)
+{
+    m_present_stats.dropped++;
 
+    wp_presentation_feedback_destroy(frame->feedback);
+    frame->feedback = NULL;
+    if(NULL == frame->buffer)
+        std::memset(frame, 0, sizeof(*frame));
+}
+
+void Wayland::FrameReleased(struct PresentFrame *frame)
+{
+    wl_buffer_destroy(frame->buffer);
+    frame->buffer = NULL;
+    if(NULL != frame->render_lock)
+    {
+        msdk_atomic_dec16(frame->render_lock);
+        frame->render_lock = NULL;
+    }
+    /* Feedback may still be on its way, keep the slot until then */
+    if(NULL == frame->feedback)
+        std::memset(frame, 0, sizeof(*frame));
+}
+
+void Wayland::GetPresentStats(struct PresentStats *stats)
+{
+    pthread_mutex_lock(&m_present_mutex);
+    *stats = m_present_stats;
+    pthread_mutex_unlock(&m_present_mutex);
+}
+
+void Wayland::PrintPresentStats()
+{
+    struct PresentStats st;
+    double fps = 0.0;
+    double latency_avg = 0.0;
+
+    GetPresentStats(&st);
+    if((st.presented > 1) && (st.last_present_ns > st.first_present_ns))
+        fps = (st.presented - 1) * 1e9 / (st.last_present_ns - st.first_present_ns);
+    if(st.presented)
+        latency_avg = st.latency_sum_ns / 1e6 / st.presented;
+
+    printf("Presentation (%s, %s, depth %u): queued %u, presented %u, dropped %u\n"
+        , m_present_mailbox ? "mailbox" : "fifo"
+        , (NULL != m_presentation) ? "wp_presentation" : "frame callback"
+        , m_present_queue_depth
+        , st.queued
+        , st.presented
+        , st.dropped);
+    printf("Presentation fps: %0.3f, present latency avg: %0.3f ms, max: %0.3f ms\n"
+        , fps
+        , latency_avg
+        , st.latency_max_ns / 1e6);
 }
 
 void Wayland::RenderBufferWinPosSize(struct wl_buffer *buffer
@@ -200,6 +627,7 @@ void Wayland::RenderBufferWinPosSize(struct wl_buffer *buffer
     , int32_t width
     , int32_t height)
 {
+    pthread_mutex_lock(&m_present_mutex);
     wl_surface_attach(m_surface, buffer, 0, 0);
     wl_surface_damage(m_surface, x, y, width, height);
 
@@ -214,7 +642,13 @@ void Wayland::RenderBufferWinPosSize(struct wl_buffer *buffer
     wl_callback_add_listener(m_callback, &frame_listener, this);
     wl_proxy_set_queue((struct wl_proxy *) m_callback, m_event_queue);
     wl_surface_commit(m_surface);
-    wl_display_dispatch_queue(m_display, m_event_queue);
+    wl_display_flush(m_display);
+    while(NULL != m_callback)
+    {
+        if(!WaitPresent(-1))
+            break;
+    }
+    pthread_mutex_unlock(&m_present_mutex);
 }
 
 
@@ -354,6 +788,9 @@ struct wl_buffer * Wayland::CreatePrimeBuffer(uint32_t name
 
 Wayland::~Wayland()
 {
+    StopDispatch();
+    if(NULL != m_presentation)
+        wp_presentation_destroy(m_presentation);
     if(NULL != m_shell)
         wl_shell_destroy(m_shell);
     if(NULL != m_shm)
@@ -371,6 +808,8 @@ Wayland::~Wayland()
         wl_display_disconnect(m_display);
     if(NULL != m_device_name)
         delete m_device_name;
+    pthread_cond_destroy(&m_present_cond);
+    pthread_mutex_destroy(&m_present_mutex);
 }
 
 // Registry
@@ -404,6 +843,19 @@ void Wayland::RegistryGlobal(struct wl_registry *registry
             , 2));
             wl_drm_add_listener(m_drm, &drm_listener, this);
     }
+    else if(0 == strcmp(interface, "wp_presentation")) {
+        static const struct wp_presentation_listener presentation_listener = {
+            presentation_clock_id
+        };
+        m_presentation = static_cast<wp_presentation*>
+            (wl_registry_bind(registry
+            , name
+            , &wp_presentation_interface
+            , 1));
+        wp_presentation_add_listener(m_presentation
+            , &presentation_listener
+            , this);
+    }
 }
 
 void Wayland::DrmHandleDevice(const char *name)
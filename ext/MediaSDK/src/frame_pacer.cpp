@@ -0,0 +1,150 @@
+/******************************************************************************\
+Copyright (c) 2005-2018, Intel Corporation
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**********************************************************************************/
+
+#include <string.h>
+#include <errno.h>
+#include "vm/strings_defs.h"
+#include "frame_pacer.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+
+static const mfxU32 MFX_TIME_STAMP_FREQUENCY = 90000;
+static const mfxU64 MFX_TIME_STAMP_INVALID = (mfxU64)-1;
+
+// A stall longer than this restarts the timeline instead of bursting frames
+#define PACING_RESYNC_PERIODS 10
+
+CFramePacer::CFramePacer():
+    m_period(0),
+    m_resyncLimit(0),
+    m_policy(PACING_CATCH_UP),
+    m_bStarted(false),
+    m_anchor(0),
+    m_firstTimeStamp(0),
+    m_frameIndex(0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void CFramePacer::Init(mfxU32 frameRateN, mfxU32 frameRateD, ePacingPolicy policy)
+{
+    m_period = (frameRateN && frameRateD) ? NSEC_PER_SEC * frameRateD / frameRateN : 0;
+    m_resyncLimit = m_period * PACING_RESYNC_PERIODS;
+    m_policy = policy;
+    memset(&m_stats, 0, sizeof(m_stats));
+    Reset();
+}
+
+void CFramePacer::Reset()
+{
+    m_bStarted = false;
+    m_frameIndex = 0;
+}
+
+mfxU64 CFramePacer::GetTime(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (mfxU64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+bool CFramePacer::WaitForDeadline(mfxU64 timeStamp)
+{
+    if (!m_period)
+        return true;
+
+    mfxU64 now = GetTime(CLOCK_MONOTONIC);
+    bool bValidTimeStamp = (MFX_TIME_STAMP_INVALID != timeStamp);
+
+    if (!m_bStarted)
+    {
+        m_bStarted = true;
+        m_anchor = now;
+        m_firstTimeStamp = bValidTimeStamp ? timeStamp : 0;
+        m_frameIndex = 0;
+    }
+
+    mfxU64 offset = m_frameIndex * m_period;
+    if (bValidTimeStamp && (timeStamp > m_firstTimeStamp))
+    {
+        mfxU64 tsOffset = (timeStamp - m_firstTimeStamp) * NSEC_PER_SEC / MFX_TIME_STAMP_FREQUENCY;
+        if (tsOffset > offset)
+            offset = tsOffset;
+    }
+    mfxU64 deadline = m_anchor + offset;
+
+    ++m_stats.paced;
+    ++m_frameIndex;
+
+    if (now > deadline)
+    {
+        mfxU64 lateness = now - deadline;
+
+        ++m_stats.late;
+        m_stats.jitter_sum += lateness;
+        if (lateness > m_stats.jitter_max)
+            m_stats.jitter_max = lateness;
+
+        if (lateness > m_resyncLimit)
+        {
+            // decoder or compositor stalled: start over from this frame
+            ++m_stats.resyncs;
+            m_anchor = now;
+            m_firstTimeStamp = bValidTimeStamp ? timeStamp : 0;
+            m_frameIndex = 1;
+            return true;
+        }
+        if ((PACING_DROP_LATE == m_policy) && (lateness > m_period))
+        {
+            ++m_stats.dropped;
+            return false;
+        }
+        return true;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = deadline / NSEC_PER_SEC;
+    ts.tv_nsec = deadline % NSEC_PER_SEC;
+
+    mfxU64 cpuStart = GetTime(CLOCK_THREAD_CPUTIME_ID);
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+        ;
+    mfxU64 wakeUp = GetTime(CLOCK_MONOTONIC);
+
+    m_stats.wait_cpu += GetTime(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+    m_stats.wait_wall += wakeUp - now;
+    m_stats.jitter_sum += wakeUp - deadline;
+    if (wakeUp - deadline > m_stats.jitter_max)
+        m_stats.jitter_max = wakeUp - deadline;
+
+    return true;
+}
+
+void CFramePacer::PrintStats()
+{
+    if (!m_period)
+        return;
+
+    msdk_printf(MSDK_STRING("Pacing (%s, %.2f fps): frames %u, late %u, dropped %u, resyncs %u\n"),
+        (PACING_DROP_LATE == m_policy) ? MSDK_STRING("drop") : MSDK_STRING("catch-up"),
+        (double)NSEC_PER_SEC / m_period,
+        m_stats.paced, m_stats.late, m_stats.dropped, m_stats.resyncs);
+    msdk_printf(MSDK_STRING("Pacing jitter avg: %.3f ms, max: %.3f ms, waited %.3f ms using %.3f ms CPU\n"),
+        m_stats.paced ? (double)m_stats.jitter_sum / m_stats.paced / 1e6 : 0.0,
+        (double)m_stats.jitter_max / 1e6,
+        (double)m_stats.wait_wall / 1e6,
+        (double)m_stats.wait_cpu / 1e6);
+}
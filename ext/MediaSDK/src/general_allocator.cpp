@@ -29,7 +29,10 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 
 // Wrapper on standard allocator for concurrent allocation of
 // D3D and system surfaces
-GeneralAllocator::GeneralAllocator()
+GeneralAllocator::GeneralAllocator():
+    m_nAllocRequests(0),
+    m_nD3DFrames(0),
+    m_nSYSFrames(0)
 {
 };
 GeneralAllocator::~GeneralAllocator()
@@ -121,6 +124,12 @@ mfxStatus GeneralAllocator::AllocImpl(mfxFrameAllocRequest *request, mfxFrameAll
 }
 void    GeneralAllocator::StoreFrameMids(bool isD3DFrames, mfxFrameAllocResponse *response)
 {
+    m_nAllocRequests++;
+    if (isD3DFrames)
+        m_nD3DFrames += response->NumFrameActual;
+    else
+        m_nSYSFrames += response->NumFrameActual;
+
     for (mfxU32 i = 0; i < response->NumFrameActual; i++)
         m_Mids.insert(std::pair<mfxHDL, bool>(response->mids[i], isD3DFrames));
 }
@@ -93,7 +93,7 @@ void shell_surface_configure(void *data
 void handle_done(void *data, struct wl_callback *callback, uint32_t time)
 {
     Wayland *wayland = static_cast<Wayland*>(data);
-    wayland->DestroyCallback();
+    wayland->FrameDone(time);
 }
 
 void buffer_release(void *data, struct wl_buffer *buffer)
@@ -101,3 +101,49 @@ void buffer_release(void *data, struct wl_buffer *buffer)
     wl_buffer_destroy(buffer);
     buffer = NULL;
 }
+
+void present_buffer_release(void *data, struct wl_buffer *buffer)
+{
+    struct PresentFrame *frame = static_cast<struct PresentFrame*>(data);
+    frame->wayland->FrameReleased(frame);
+}
+
+/* presentation listener */
+void presentation_clock_id(void *data
+    , struct wp_presentation *presentation
+    , uint32_t clk_id)
+{
+    Wayland *wayland = static_cast<Wayland*>(data);
+    wayland->PresentationClockId(clk_id);
+}
+
+/* presentation feedback listener */
+void feedback_sync_output(void *data
+    , struct wp_presentation_feedback *feedback
+    , struct wl_output *output)
+{
+    /* NOT IMPLEMENTED */
+}
+
+void feedback_presented(void *data
+    , struct wp_presentation_feedback *feedback
+    , uint32_t tv_sec_hi
+    , uint32_t tv_sec_lo
+    , uint32_t tv_nsec
+    , uint32_t refresh
+    , uint32_t seq_hi
+    , uint32_t seq_lo
+    , uint32_t flags)
+{
+    struct PresentFrame *frame = static_cast<struct PresentFrame*>(data);
+    uint64_t sec = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+
+    frame->wayland->FramePresented(frame, sec * 1000000000ULL + tv_nsec);
+}
+
+void feedback_discarded(void *data
+    , struct wp_presentation_feedback *feedback)
+{
+    struct PresentFrame *frame = static_cast<struct PresentFrame*>(data);
+    frame->wayland->FrameDiscarded(frame);
+}
@@ -26,13 +26,7 @@ CBuffering::CBuffering():
     m_OutputSurfacesNumber(0),
     m_pSurfaces(NULL),
     m_pVppSurfaces(NULL),
-    m_FreeSurfacesPool(&m_Mutex),
-    m_FreeVppSurfacesPool(&m_Mutex),
-    m_UsedSurfacesPool(&m_Mutex),
-    m_UsedVppSurfacesPool(&m_Mutex),
-    m_pFreeOutputSurfaces(NULL),
-    m_OutputSurfacesPool(&m_Mutex),
-    m_DeliveredSurfacesPool(&m_Mutex)
+    m_pOutputSurfaces(NULL)
 {
 }
 
@@ -43,6 +37,8 @@ CBuffering::~CBuffering()
 mfxStatus
 CBuffering::AllocBuffers(mfxU32 SurfaceNumber)
 {
+    mfxStatus sts;
+
     if (!SurfaceNumber) return MFX_ERR_MEMORY_ALLOC;
 
     if (!m_OutputSurfacesNumber) { // true - if Vpp isn't enabled
@@ -53,21 +49,29 @@ CBuffering::AllocBuffers(mfxU32 SurfaceNumber)
     m_pSurfaces = (msdkFrameSurface*)calloc(m_SurfacesNumber, sizeof(msdkFrameSurface));
     if (!m_pSurfaces) return MFX_ERR_MEMORY_ALLOC;
 
-    msdkOutputSurface* p = NULL;
-    msdkOutputSurface* tail = NULL;
+    sts = m_FreeSurfacesPool.m_Free.Alloc(m_SurfacesNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+    sts = m_UsedSurfacesPool.m_Used.Alloc(m_SurfacesNumber);
+    if (MFX_ERR_NONE != sts) return sts;
 
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-    if (!m_pFreeOutputSurfaces) return MFX_ERR_MEMORY_ALLOC;
+    // every output frame surface can be in flight at once, one more output
+    // surface is held by the decoding loop while it waits for a frame
+    mfxU32 OutputNumber = m_OutputSurfacesNumber + 1;
 
-    tail = m_pFreeOutputSurfaces;
+    m_pOutputSurfaces = (msdkOutputSurface*)calloc(OutputNumber, sizeof(msdkOutputSurface));
+    if (!m_pOutputSurfaces) return MFX_ERR_MEMORY_ALLOC;
 
-    for (mfxU32 i = 1; i < m_OutputSurfacesNumber; ++i) {
-        p = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-        if (!p) return MFX_ERR_MEMORY_ALLOC;
-        tail->next = p;
-        tail = p;
+    sts = m_FreeOutputSurfaces.Alloc(OutputNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+    for (mfxU32 i = 0; i < OutputNumber; ++i) {
+        m_FreeOutputSurfaces.Set(i);
     }
 
+    sts = m_OutputSurfacesPool.Alloc(OutputNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+    sts = m_DeliveredSurfacesPool.Alloc(OutputNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+
     ResetBuffers();
     return MFX_ERR_NONE;
 }
@@ -75,32 +79,21 @@ CBuffering::AllocBuffers(mfxU32 SurfaceNumber)
 mfxStatus
 CBuffering::AllocVppBuffers(mfxU32 VppSurfaceNumber)
 {
+    mfxStatus sts;
+
     m_OutputSurfacesNumber = VppSurfaceNumber;
     m_pVppSurfaces = (msdkFrameSurface*)calloc(m_OutputSurfacesNumber, sizeof(msdkFrameSurface));
     if (!m_pVppSurfaces) return MFX_ERR_MEMORY_ALLOC;
 
+    sts = m_FreeVppSurfacesPool.m_Free.Alloc(m_OutputSurfacesNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+    sts = m_UsedVppSurfacesPool.m_Used.Alloc(m_OutputSurfacesNumber);
+    if (MFX_ERR_NONE != sts) return sts;
+
     ResetVppBuffers();
     return MFX_ERR_NONE;
 }
 
-void
-CBuffering::AllocOutputBuffer()
-{
-    AutomaticMutex lock(m_Mutex);
-
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-}
-
-static void
-FreeList(msdkOutputSurface*& head) {
-    msdkOutputSurface* next;
-    while (head) {
-        next = head->next;
-        free(head);
-        head = next;
-    }
-}
-
 void
 CBuffering::FreeBuffers()
 {
@@ -114,30 +107,40 @@ CBuffering::FreeBuffers()
         m_pVppSurfaces = NULL;
     }
 
-    FreeList(m_pFreeOutputSurfaces);
-    FreeList(m_OutputSurfacesPool.m_pSurfacesHead);
-    FreeList(m_DeliveredSurfacesPool.m_pSurfacesHead);
+    if (m_pOutputSurfaces) {
+        free(m_pOutputSurfaces);
+        m_pOutputSurfaces = NULL;
+    }
+
+    m_FreeOutputSurfaces.Free();
+    m_OutputSurfacesPool.Free();
+    m_DeliveredSurfacesPool.Free();
 
-    m_UsedSurfacesPool.m_pSurfacesHead = NULL;
-    m_UsedSurfacesPool.m_pSurfacesTail = NULL;
-    m_UsedVppSurfacesPool.m_pSurfacesHead = NULL;
-    m_UsedVppSurfacesPool.m_pSurfacesTail = NULL;
+    m_UsedSurfacesPool.m_Used.Free();
+    m_UsedSurfacesPool.m_pSurfaces = NULL;
+    m_UsedVppSurfacesPool.m_Used.Free();
+    m_UsedVppSurfacesPool.m_pSurfaces = NULL;
 
+    m_FreeSurfacesPool.m_Free.Free();
     m_FreeSurfacesPool.m_pSurfaces = NULL;
+    m_FreeVppSurfacesPool.m_Free.Free();
     m_FreeVppSurfacesPool.m_pSurfaces = NULL;
+
+    // AllocVppBuffers/AllocBuffers count surfaces anew on the next allocation
+    m_SurfacesNumber = 0;
+    m_OutputSurfacesNumber = 0;
 }
 
 void
 CBuffering::ResetBuffers()
 {
     mfxU32 i;
-    msdkFrameSurface* pFreeSurf = m_FreeSurfacesPool.m_pSurfaces = m_pSurfaces;
+
+    m_FreeSurfacesPool.m_pSurfaces = m_pSurfaces;
+    m_UsedSurfacesPool.m_pSurfaces = m_pSurfaces;
 
     for (i = 0; i < m_SurfacesNumber; ++i) {
-        if (i < (m_SurfacesNumber-1)) {
-            pFreeSurf[i].next = &(pFreeSurf[i+1]);
-            pFreeSurf[i+1].prev = &(pFreeSurf[i]);
-        }
+        m_FreeSurfacesPool.m_Free.Set(i);
     }
 }
 
@@ -145,58 +148,45 @@ void
 CBuffering::ResetVppBuffers()
 {
     mfxU32 i;
-    msdkFrameSurface* pFreeVppSurf = m_FreeVppSurfacesPool.m_pSurfaces = m_pVppSurfaces;
+
+    m_FreeVppSurfacesPool.m_pSurfaces = m_pVppSurfaces;
+    m_UsedVppSurfacesPool.m_pSurfaces = m_pVppSurfaces;
 
     for (i = 0; i < m_OutputSurfacesNumber; ++i) {
-        if (i < (m_OutputSurfacesNumber-1)) {
-            pFreeVppSurf[i].next = &(pFreeVppSurf[i+1]);
-            pFreeVppSurf[i+1].prev = &(pFreeVppSurf[i]);
-        }
+        m_FreeVppSurfacesPool.m_Free.Set(i);
     }
 }
 
 void
-CBuffering::SyncFrameSurfaces()
+CBuffering::SyncSurfaces(msdkUsedSurfacesPool& used, msdkFreeSurfacesPool& freePool)
 {
-    AutomaticMutex lock(m_Mutex);
-    msdkFrameSurface *prev;
-    msdkFrameSurface *next;
-    prev = next = NULL;
-    msdkFrameSurface *cur = m_UsedSurfacesPool.m_pSurfacesHead;
-
-    while (cur) {
-        if (cur->frame.Data.Locked || cur->render_lock) {
-            // frame is still locked: just moving to the next one
-            cur = cur->next;
-        } else {
-            // frame was unlocked: moving it to the free surfaces array
-            m_UsedSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeSurfacesPool.AddSurfaceUnsafe(cur);
-
-            cur = next;
+    msdkSurfaceBitmap& bitmap = used.m_Used;
+
+    for (mfxU32 i = 0; i < bitmap.GetWordsNumber(); ++i) {
+        mfxU64 word = bitmap.GetWord(i);
+
+        while (word) {
+            mfxU32 index = i * MSDK_BITMAP_WORD_BITS + __builtin_ctzll(word);
+            msdkFrameSurface* cur = &used.m_pSurfaces[index];
+
+            word &= word - 1;
+            if (!cur->frame.Data.Locked && !cur->render_lock) {
+                // frame was unlocked: moving it to the free surfaces array
+                bitmap.Clear(index);
+                freePool.AddSurface(cur);
+            }
         }
     }
 }
 
+void
+CBuffering::SyncFrameSurfaces()
+{
+    SyncSurfaces(m_UsedSurfacesPool, m_FreeSurfacesPool);
+}
+
 void
 CBuffering::SyncVppFrameSurfaces()
 {
-    AutomaticMutex lock(m_Mutex);
-    msdkFrameSurface *prev;
-    msdkFrameSurface *next;
-    prev = next = NULL;
-    msdkFrameSurface *cur = m_UsedVppSurfacesPool.m_pSurfacesHead;
-
-    while (cur) {
-        if (cur->frame.Data.Locked || cur->render_lock) {
-            // frame is still locked: just moving to the next one
-            cur = cur->next;
-        } else {
-            // frame was unlocked: moving it to the free surfaces array
-            m_UsedVppSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeVppSurfacesPool.AddSurfaceUnsafe(cur);
-
-            cur = next;
-        }
-    }
+    SyncSurfaces(m_UsedVppSurfacesPool, m_FreeVppSurfacesPool);
 }
@@ -0,0 +1,117 @@
+/******************************************************************************\
+Copyright (c) 2005-2018, Intel Corporation
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+\**********************************************************************************/
+
+#include "null_device.h"
+#include "sample_utils.h"
+#include "KpiMarker.h"
+
+CNullDevice::CNullDevice(void):
+    m_nFrames(0),
+    m_firstTick(0),
+    m_lastTick(0),
+    m_minInterval(0),
+    m_maxInterval(0),
+    m_lastTimeStamp(0)
+{
+}
+
+CNullDevice::~CNullDevice(void)
+{
+    Close();
+}
+
+mfxStatus CNullDevice::Init(mfxHDL /*hWindow*/, mfxU16 /*nViews*/, mfxU32 /*nAdapterNum*/)
+{
+    return Reset();
+}
+
+mfxStatus CNullDevice::Reset(void)
+{
+    m_nFrames = 0;
+    m_firstTick = m_lastTick = 0;
+    m_minInterval = m_maxInterval = 0;
+    m_lastTimeStamp = 0;
+    return MFX_ERR_NONE;
+}
+
+void CNullDevice::Close(void)
+{
+    m_DRMLibVA.reset();
+}
+
+mfxStatus CNullDevice::GetHandle(mfxHandleType type, mfxHDL *pHdl)
+{
+    if (NULL == pHdl)
+        return MFX_ERR_NULL_PTR;
+
+    if (MFX_HANDLE_VA_DISPLAY == type) {
+        if (!m_DRMLibVA.get()) {
+            try {
+                m_DRMLibVA.reset(new DRMLibVA);
+            } catch (std::exception&) {
+                msdk_printf(MSDK_STRING("Null device: failed to open VA display\n"));
+                return MFX_ERR_DEVICE_FAILED;
+            }
+        }
+        *pHdl = m_DRMLibVA->GetVADisplay();
+        return MFX_ERR_NONE;
+    } else if (HANDLE_NULL_DEVICE == type) {
+        *pHdl = this;
+        return MFX_ERR_NONE;
+    }
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus CNullDevice::RenderFrame(mfxFrameSurface1 * pSurface, mfxFrameAllocator * /*pmfxAlloc*/)
+{
+    if (NULL == pSurface)
+        return MFX_ERR_NULL_PTR;
+
+    msdk_tick now = msdk_time_get_tick();
+
+    if (m_nFrames) {
+        msdk_tick interval = now - m_lastTick;
+        if (1 == m_nFrames || interval < m_minInterval)
+            m_minInterval = interval;
+        if (interval > m_maxInterval)
+            m_maxInterval = interval;
+    } else {
+        m_firstTick = now;
+        KPI_MARK("video_first_frame");
+    }
+    m_lastTick = now;
+    m_lastTimeStamp = pSurface->Data.TimeStamp;
+    ++m_nFrames;
+
+    return MFX_ERR_NONE;
+}
+
+void CNullDevice::PrintStats()
+{
+    double seconds = CTimer::ConvertToSeconds(m_lastTick - m_firstTick);
+
+    msdk_printf(MSDK_STRING("Null device: %u frames in %.3f s (%.2f fps), interval min %.3f ms, max %.3f ms, last timestamp %llu\n"),
+        m_nFrames,
+        seconds,
+        (m_nFrames > 1 && seconds > 0) ? (m_nFrames - 1) / seconds : 0.0,
+        CTimer::ConvertToSeconds(m_minInterval) * 1000,
+        CTimer::ConvertToSeconds(m_maxInterval) * 1000,
+        (unsigned long long)m_lastTimeStamp);
+}
+
+CHWDevice* CreateNullDevice(void)
+{
+    return new CNullDevice();
+}
@@ -31,9 +31,9 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 #include "vaapi_device.h"
 #include "vaapi_utils.h"
 #include "class_wayland.h"
+#include "null_device.h"
 
 #include "version.h"
-#include "GPIOControl.hpp"
 #pragma warning(disable : 4100)
 
 #define __SYNC_WA // avoid sync issue on Media SDK side
@@ -123,11 +123,8 @@ const mfxPluginUID & msdkGetPluginUID(mfxIMPL impl, msdkComponentType type, mfxU
 }
 
 
-CDecodingPipeline::CDecodingPipeline(earlyapp::GPIOControl* pGPIOCtrl)
+CDecodingPipeline::CDecodingPipeline()
 {
-    // GPIO control to measure KPI.
-    m_pGPIOCtrl = pGPIOCtrl;
-
     m_nFrames=0;
     m_export_mode=0;
     m_bVppFullColorRange=false;
@@ -183,9 +180,6 @@ CDecodingPipeline::CDecodingPipeline(earlyapp::GPIOControl* pGPIOCtrl)
     m_bResetFileWriter = false;
     m_bResetFileReader = false;
 
-    m_startTick = 0;
-    m_delayTicks = 0;
-
     MSDK_ZERO_MEMORY(m_VppDoNotUse);
     m_VppDoNotUse.Header.BufferId = MFX_EXTBUFF_VPP_DONOTUSE;
     m_VppDoNotUse.Header.BufferSz = sizeof(m_VppDoNotUse);
@@ -213,6 +207,9 @@ CDecodingPipeline::CDecodingPipeline(earlyapp::GPIOControl* pGPIOCtrl)
 
     m_export_mode = vaapiAllocatorParams::DONOT_EXPORT;
     m_bPerfMode = false;
+    m_bNullRender = false;
+    m_ePresentMode = PRESENT_MODE_FIFO;
+    m_nPresentQueueDepth = WL_PRESENT_DEFAULT_QUEUE_DEPTH;
 
     m_monitorType = 0;
     totalBytesProcessed = 0;
@@ -277,6 +274,17 @@ mfxStatus CDecodingPipeline::Init(sInputParams *pParams)
     if(pParams->bPerfMode)
         m_bPerfMode = true;
 
+    m_bNullRender = pParams->bNullRender;
+    if ((MODE_RENDERING == pParams->mode) && (SYSTEM_MEMORY == pParams->memType) && !m_bNullRender)
+    {
+        msdk_printf(MSDK_STRING("error: system memory can only be rendered by the null device\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    m_ePresentMode = pParams->presentMode;
+    if (pParams->nPresentQueueDepth)
+        m_nPresentQueueDepth = MSDK_MIN(pParams->nPresentQueueDepth, WL_PRESENT_MAX_FRAMES - 2);
+
     if (pParams->Width)
         m_vppOutWidth = pParams->Width;
     if (pParams->Height)
@@ -403,7 +411,7 @@ mfxStatus CDecodingPipeline::Init(sInputParams *pParams)
         m_bRenderWin = pParams->bRenderWin;
     }
 
-    m_delayTicks = pParams->nMaxFPS ? msdk_time_get_frequency() / pParams->nMaxFPS : 0;
+    m_FramePacer.Init(pParams->nMaxFPS, 1, pParams->pacingPolicy);
 
     // create decoder
     m_pmfxDEC = new MFXVideoDECODE(m_mfxSession);
@@ -913,10 +921,10 @@ mfxStatus CDecodingPipeline::InitVppParams()
     return MFX_ERR_NONE;
 }
 
-mfxStatus CDecodingPipeline::CreateHWDevice(earlyapp::GPIOControl* pGPIOCtrl)
+mfxStatus CDecodingPipeline::CreateHWDevice()
 {
     mfxStatus sts = MFX_ERR_NONE;
-    m_hwdev = CreateVAAPIDevice(pGPIOCtrl);
+    m_hwdev = m_bNullRender ? CreateNullDevice() : CreateVAAPIDevice();
 
     if (NULL == m_hwdev) {
         return MFX_ERR_MEMORY_ALLOC;
@@ -925,7 +933,7 @@ mfxStatus CDecodingPipeline::CreateHWDevice(earlyapp::GPIOControl* pGPIOCtrl)
     sts = m_hwdev->Init(&m_monitorType, (m_eWorkMode == MODE_RENDERING) ? 1 : 0, MSDKAdapter::GetNumber(m_mfxSession));
     MSDK_CHECK_STATUS(sts, "m_hwdev->Init failed");
 
-    if (m_eWorkMode == MODE_RENDERING) {
+    if ((m_eWorkMode == MODE_RENDERING) && !m_bNullRender) {
         mfxHDL hdl = NULL;
         mfxHandleType hdlw_t = (mfxHandleType)HANDLE_WAYLAND_DRIVER;
         Wayland *wld;
@@ -934,6 +942,7 @@ mfxStatus CDecodingPipeline::CreateHWDevice(earlyapp::GPIOControl* pGPIOCtrl)
         wld = (Wayland*)hdl;
         wld->SetRenderWinPos(m_nRenderWinX, m_nRenderWinY);
         wld->SetPerfMode(m_bPerfMode);
+        wld->SetPresentMode(m_ePresentMode == PRESENT_MODE_MAILBOX, m_nPresentQueueDepth);
     }
     return MFX_ERR_NONE;
 }
@@ -954,6 +963,8 @@ mfxStatus CDecodingPipeline::AllocFrames()
 
     mfxU16 nSurfNum = 0; // number of surfaces for decoder
     mfxU16 nVppSurfNum = 0; // number of surfaces for vpp
+    // surfaces queued for presentation plus the one on screen
+    mfxU16 nPresentSurfNum = (m_eWorkMode == MODE_RENDERING) ? m_nPresentQueueDepth + 1 : 0;
 
     MSDK_ZERO_MEMORY(Request);
 
@@ -1028,7 +1039,7 @@ mfxStatus CDecodingPipeline::AllocFrames()
         nSurfNum = Request.NumFrameSuggested + VppRequest[0].NumFrameSuggested - m_mfxVideoParams.AsyncDepth + 1;
 
         // The number of surfaces for vpp output
-        nVppSurfNum = VppRequest[1].NumFrameSuggested;
+        nVppSurfNum = VppRequest[1].NumFrameSuggested + nPresentSurfNum;
 
         // prepare allocation request
         Request.NumFrameSuggested = Request.NumFrameMin = nSurfNum;
@@ -1036,6 +1047,11 @@ mfxStatus CDecodingPipeline::AllocFrames()
         // surfaces are shared between vpp input and decode output
         Request.Type = MFX_MEMTYPE_EXTERNAL_FRAME | MFX_MEMTYPE_FROM_DECODE | MFX_MEMTYPE_FROM_VPPIN;
     }
+    else
+    {
+        // decoder output is presented directly
+        Request.NumFrameSuggested += nPresentSurfNum;
+    }
 
     if ((Request.NumFrameSuggested < m_mfxVideoParams.AsyncDepth) &&
         (m_impl & MFX_IMPL_HARDWARE_ANY))
@@ -1129,7 +1145,7 @@ mfxStatus CDecodingPipeline::CreateAllocator()
     m_pGeneralAllocator = new GeneralAllocator();
     if (m_memType != SYSTEM_MEMORY || !m_bDecOutSysmem)
     {
-        sts = CreateHWDevice(m_pGPIOCtrl);
+        sts = CreateHWDevice();
         MSDK_CHECK_STATUS(sts, "CreateHWDevice failed");
         /* It's possible to skip failed result here and switch to SW implementation,
            but we don't process this way */
@@ -1164,11 +1180,14 @@ mfxStatus CDecodingPipeline::CreateAllocator()
     {
         //in case of system memory allocator we also have to pass MFX_HANDLE_VA_DISPLAY to HW library
 
-        if(MFX_IMPL_HARDWARE == MFX_IMPL_BASETYPE(m_impl))
+        if((MFX_IMPL_HARDWARE == MFX_IMPL_BASETYPE(m_impl)) || (m_eWorkMode == MODE_RENDERING))
         {
+            // rendering needs a device even with the software library
             sts = CreateHWDevice();
             MSDK_CHECK_STATUS(sts, "CreateHWDevice failed");
-
+        }
+        if(MFX_IMPL_HARDWARE == MFX_IMPL_BASETYPE(m_impl))
+        {
             // provide device manager to MediaSDK
             VADisplay va_dpy = NULL;
             sts = m_hwdev->GetHandle(MFX_HANDLE_VA_DISPLAY, (mfxHDL *)&va_dpy);
@@ -1197,7 +1216,7 @@ void CDecodingPipeline::DeleteFrames()
     FreeBuffers();
 
     m_pCurrentFreeSurface = NULL;
-    MSDK_SAFE_FREE(m_pCurrentFreeOutputSurface);
+    m_pCurrentFreeOutputSurface = NULL;
 
     m_pCurrentFreeVppSurface = NULL;
 
@@ -1352,6 +1371,97 @@ mfxStatus CDecodingPipeline::ResetDecoder(sInputParams *pParams)
     return MFX_ERR_NONE;
 }
 
+static Wayland* GetWayland(CHWDevice *hwdev)
+{
+    mfxHDL hdl = NULL;
+
+    if (!hwdev)
+        return NULL;
+    if (MFX_ERR_NONE != hwdev->GetHandle((mfxHandleType)HANDLE_WAYLAND_DRIVER, &hdl))
+        return NULL;
+    return (Wayland*)hdl;
+}
+
+void CDecodingPipeline::Stop()
+{
+    Wayland *wld = GetWayland(m_hwdev);
+
+    // the surface stays alive, it is mapped again by the next frame
+    if (wld)
+        wld->HideSurface();
+}
+
+mfxStatus CDecodingPipeline::Restart()
+{
+    mfxStatus sts = MFX_ERR_NONE;
+
+    MSDK_CHECK_POINTER(m_pmfxDEC, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(m_FileReader.get(), MFX_ERR_NOT_INITIALIZED);
+
+    // rewind the input, headers are parsed again along with the first frame
+    m_FileReader->Reset();
+    m_mfxBS.DataOffset = 0;
+    m_mfxBS.DataLength = 0;
+    totalBytesProcessed = 0;
+
+    // stream parameters are unchanged, so no reallocation is needed
+    sts = m_pmfxDEC->Reset(&m_mfxVideoParams);
+    MSDK_IGNORE_MFX_STS(sts, MFX_WRN_PARTIAL_ACCELERATION);
+    MSDK_CHECK_STATUS(sts, "m_pmfxDEC->Reset failed");
+
+    if (m_pmfxVPP)
+    {
+        sts = m_pmfxVPP->Reset(&m_mfxVppVideoParams);
+        MSDK_IGNORE_MFX_STS(sts, MFX_WRN_PARTIAL_ACCELERATION);
+        MSDK_CHECK_STATUS(sts, "m_pmfxVPP->Reset failed");
+    }
+
+    // a run which stopped before the pipeline drained leaves surfaces in
+    // flight, their sync points are gone with the reset
+    if (m_pCurrentOutputSurface) {
+        ReturnSurfaceToBuffers(m_pCurrentOutputSurface);
+        m_pCurrentOutputSurface = NULL;
+    }
+    while (msdkOutputSurface* output = m_OutputSurfacesPool.GetSurface()) {
+        ReturnSurfaceToBuffers(output);
+    }
+    while (msdkOutputSurface* output = m_DeliveredSurfacesPool.GetSurface()) {
+        ReturnSurfaceToBuffers(output);
+    }
+    if (m_pCurrentFreeOutputSurface) {
+        m_pCurrentFreeOutputSurface->surface = NULL;
+        m_pCurrentFreeOutputSurface->syncp = NULL;
+        AddFreeOutputSurface(m_pCurrentFreeOutputSurface);
+        m_pCurrentFreeOutputSurface = NULL;
+    }
+    if (m_pCurrentFreeSurface) {
+        m_UsedSurfacesPool.AddSurface(m_pCurrentFreeSurface);
+        m_pCurrentFreeSurface = NULL;
+    }
+    if (m_pCurrentFreeVppSurface) {
+        m_UsedVppSurfacesPool.AddSurface(m_pCurrentFreeVppSurface);
+        m_pCurrentFreeVppSurface = NULL;
+    }
+
+    // surfaces still held by the compositor return through SyncFrameSurfaces()
+    SyncFrameSurfaces();
+    SyncVppFrameSurfaces();
+
+    m_error = MFX_ERR_NONE;
+    m_bStopDeliverLoop = false;
+    m_input_count = 0;
+    m_output_count = 0;
+    m_synced_count = 0;
+    m_timer_overall.Sync();
+    m_tick_overall = 0;
+    m_tick_fread = 0;
+    m_tick_fwrite = 0;
+    m_vLatency.clear();
+    m_FramePacer.Reset();
+
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame)
 {
     CAutoTimer timer_fwrite(m_tick_fwrite);
@@ -1370,7 +1480,13 @@ mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame)
         m_bResetFileWriter = false;
     }
 
-    if (m_bExternalAlloc) {
+    if (m_eWorkMode == MODE_RENDERING) {
+        // sleep till the frame is due instead of spinning on the tick counter
+        if (m_FramePacer.WaitForDeadline(frame->Data.TimeStamp)) {
+            res = m_hwdev->RenderFrame(frame, m_pGeneralAllocator);
+        }
+    }
+    else if (m_bExternalAlloc) {
         if (m_eWorkMode == MODE_FILE_DUMP) {
             res = m_pGeneralAllocator->Lock(m_pGeneralAllocator->pthis, frame->Data.MemId, &(frame->Data));
             if (MFX_ERR_NONE == res) {
@@ -1381,14 +1497,6 @@ mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame)
             if ((MFX_ERR_NONE == res) && (MFX_ERR_NONE != sts)) {
                 res = sts;
             }
-        } else if (m_eWorkMode == MODE_RENDERING) {
-            res = m_hwdev->RenderFrame(frame, m_pGeneralAllocator);
-
-            while( m_delayTicks && (m_startTick + m_delayTicks > msdk_time_get_tick()) )
-            {
-                MSDK_SLEEP(0);
-            };
-            m_startTick=msdk_time_get_tick();
         }
     }
     else {
@@ -1428,6 +1536,18 @@ mfxStatus CDecodingPipeline::DeliverLoop(void)
     return res;
 }
 
+void CDecodingPipeline::FinishPresentation(void)
+{
+    Wayland *wld = GetWayland(m_hwdev);
+
+    if (wld) {
+        // show everything still queued before reporting
+        wld->FlushPresentQueue();
+        wld->PrintPresentStats();
+    }
+    m_FramePacer.PrintStats();
+}
+
 unsigned int MFX_STDCALL CDecodingPipeline::DeliverThreadFunc(void* ctx)
 {
     CDecodingPipeline* pipeline = (CDecodingPipeline*)ctx;
@@ -1457,7 +1577,8 @@ void CDecodingPipeline::PrintPerFrameStat(bool force)
             (fps_fread < MY_THRESHOLD)? fps_fread: 0.0,
             (fps_fwrite < MY_THRESHOLD)? fps_fwrite: 0.0);
         fflush(NULL);
-        m_hwdev->UpdateTitle(fps);
+        if (m_hwdev)
+            m_hwdev->UpdateTitle(fps);
     }
 }
 
@@ -1830,6 +1951,7 @@ mfxStatus CDecodingPipeline::RunDecoding()
         m_pDeliverOutputSemaphore->Post();
         if (pDeliverThread)
             pDeliverThread->Wait();
+        FinishPresentation();
     }
 
     MSDK_SAFE_DELETE(m_pDeliverOutputSemaphore);
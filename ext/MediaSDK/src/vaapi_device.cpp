@@ -18,8 +18,10 @@ or https://software.intel.com/en-us/media-client-solutions-support.
 \**********************************************************************************/
 
 #include "vaapi_device.h"
+#include "mfx_buffering.h"
 #include "class_wayland.h"
 #include "wayland-drm-client-protocol.h"
+#include "KpiMarker.h"
 
 CVAAPIDeviceWayland::~CVAAPIDeviceWayland(void)
 {
@@ -67,7 +69,6 @@ mfxStatus CVAAPIDeviceWayland::RenderFrame(mfxFrameSurface1 * pSurface, mfxFrame
         mfx_res = MFX_ERR_UNKNOWN;
         return mfx_res;
     }
-    m_Wayland->Sync();
     memId = (vaapiMemId*)(pSurface->Data.MemId);
 
     if (pSurface->Info.FourCC == MFX_FOURCC_NV12)
@@ -102,12 +103,16 @@ mfxStatus CVAAPIDeviceWayland::RenderFrame(mfxFrameSurface1 * pSurface, mfxFrame
             return mfx_res;
     }
 
-    m_Wayland->RenderBuffer(m_wl_buffer, pSurface->Info.CropW, pSurface->Info.CropH);
+    // The decoder must not reuse the surface until the compositor
+    // releases the buffer wrapping it.
+    m_Wayland->RenderBuffer(m_wl_buffer
+      , pSurface->Info.CropW
+      , pSurface->Info.CropH
+      , &(((msdkFrameSurface*)pSurface)->render_lock));
 
-    // GPIO output.
-    if(!m_bGotFirstFrame && m_pGPIOCtrl != nullptr)
+    if(!m_bGotFirstFrame)
     {
-        m_pGPIOCtrl->outputPattern();
+        KPI_MARK("video_first_frame");
         m_bGotFirstFrame = true;
     }
 
@@ -116,10 +121,12 @@ mfxStatus CVAAPIDeviceWayland::RenderFrame(mfxFrameSurface1 * pSurface, mfxFrame
 
 void CVAAPIDeviceWayland::Close(void)
 {
-    m_Wayland->FreeSurface();
+    // no Wayland connection is made for performance and dump modes
+    if (m_Wayland)
+        m_Wayland->FreeSurface();
 }
 
-CHWDevice* CreateVAAPIDevice(earlyapp::GPIOControl* pGPIOCtrl)
+CHWDevice* CreateVAAPIDevice(void)
 {
-    return new CVAAPIDeviceWayland(pGPIOCtrl);
+    return new CVAAPIDeviceWayland();
 }
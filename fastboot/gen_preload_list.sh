@@ -1,32 +1,49 @@
 #!/bin/bash -e
+#
+# gen_preload_list.sh <list file> <tier>:<file>...
+#
+# Writes "<tier> <path>" lines ordered by tier. The shared libraries of each
+# file are added with the tier of the first file that needs them.
 
 PRELOAD_LIST_FILE=$DESTDIR/$1
 shift
 
-rm -f $PRELOAD_LIST_FILE
-for f in $@; do
-	echo $f >> $PRELOAD_LIST_FILE
+declare -A tier_of
+files=()
+
+add_file() {
+	if [ -z "${tier_of[$2]}" ]; then
+		tier_of[$2]=$1
+		files+=("$2")
+	fi
+}
+
+for arg in $@; do
+	add_file ${arg%%:*} ${arg#*:}
 done
 
-while true; do
-	found_new=n
-	for _f in `cat $PRELOAD_LIST_FILE`; do
-		if [ ! -e $_f ]; then
-			f=$DESTDIR/$_f
-		else
-			f=$_f
-		fi
-		if ! /usr/lib64/ld-linux-x86-64.so.2 --list $f >/dev/null 2>&1; then
-			continue
+i=0
+while [ $i -lt ${#files[@]} ]; do
+	_f=${files[$i]}
+	i=$((i + 1))
+	if [ ! -e $_f ]; then
+		f=$DESTDIR/$_f
+	else
+		f=$_f
+	fi
+	if ! /usr/lib64/ld-linux-x86-64.so.2 --list $f >/dev/null 2>&1; then
+		continue
+	fi
+	for f_lib in `/usr/lib64/ld-linux-x86-64.so.2 --list $f | grep '=>' | grep -o '/usr/lib[^ ]*'`; do
+		add_file ${tier_of[$_f]} $f_lib
+	done
+done
+
+rm -f $PRELOAD_LIST_FILE
+for tier in 0 1 2; do
+	for f in ${files[@]}; do
+		if [ "${tier_of[$f]}" == "$tier" ]; then
+			echo "$tier $f" >> $PRELOAD_LIST_FILE
 		fi
-		for f_lib in `/usr/lib64/ld-linux-x86-64.so.2 --list $f | grep '=>' | grep -o '/usr/lib[^ ]*'`; do
-			if ! grep -q "^$f_lib$" $PRELOAD_LIST_FILE; then
-				found_new=y
-				echo $f_lib >> $PRELOAD_LIST_FILE
-			fi
-		done
 	done
-	if [ "$found_new" == "n" ]; then
-		break;
-	fi
 done
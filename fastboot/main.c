@@ -39,10 +39,16 @@
 #include <sys/sysmacros.h>
 #include <pthread.h>
 
+#include "module_loader.h"
+#include "preload.h"
+#include "preload_record.h"
+
 #define DEFAULT_INIT "/sbin/init"
 
 #ifdef SPLASH_SCREEN_FB_FILE
 void *splash_screen_init(void *arg);
+void *splash_screen_handoff(void *arg);
+static pthread_t splash_handoff_tid;
 #endif
 static int splash_screen_trigger = 0;
 
@@ -60,14 +66,7 @@ void *cbc_attach_init(void *arg)
 #endif
 
 #define ARRAY_SIZE(array)       (sizeof(array) / sizeof((array)[0]))
-static pthread_t load_ipu4_modules_tid;
-static pthread_t load_ipu4_crlmodule_lite_tid;
-static pthread_t load_ipu4_isys_csslib_tid;
-static pthread_t load_ipu4_psys_csslib_tid;
-static pthread_t load_ipu4_mmu_tid;
-static pthread_t load_ipu4_psys_tid;
-static pthread_t load_ipu4_isys_tid;
-char *ipu4_modulesp[]  = { 
+static const char *ipu4_modulesp[]  = {
 	"crlmodule-lite",
 	"intel-ipu4",
 	"intel-ipu4-mmu",
@@ -77,85 +76,26 @@ char *ipu4_modulesp[]  = {
 	"intel-ipu4-isys-csslib",
 };
 
-void *load_ipu4_mmu(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[2]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[2]);
-	return NULL;
-}
-
-void *load_ipu4_psys(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[3]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[3]);
-	return NULL;
-}
-
-
-void *load_ipu4_isys(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[4]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[4]);
-	return NULL;
-}
-
-
-void *load_ipu4_crlmodule_lite(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[0]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[0]);
-	return NULL;
-}
-
-void *load_ipu4_isys_csslib(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[6]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[6]);
-	return NULL;
-}
-
-void *load_ipu4_psys_csslib(void *arg)
-{
-	int ret;
-	char mprobe[64];
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[5]);
-	ret = system(mprobe);
-	if (ret < 0)
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[5]);
-	return NULL;
-}
-
-void *load_ipu4_modules(void *arg)
+/*
+ * Loads the modules in process in dependency order, without a shell and a
+ * modprobe per module. modprobe is only the fallback when modules.dep can not
+ * be used or a module failed, it also applies the modprobe.d options.
+ */
+static void load_ipu4_modules(void)
 {
 	char mprobe[64];
+	unsigned int i;
 	int ret;
 
-	sprintf(mprobe, "modprobe %s", ipu4_modulesp[1]);
-	ret = system(mprobe);
-	if (ret < 0) 
-		fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[1]);
+	if (module_loader_load(NULL, ipu4_modulesp, ARRAY_SIZE(ipu4_modulesp)) == 0)
+		return;
 
-	return NULL;
+	for (i = 0; i < ARRAY_SIZE(ipu4_modulesp); i++) {
+		snprintf(mprobe, sizeof(mprobe), "modprobe %s", ipu4_modulesp[i]);
+		ret = system(mprobe);
+		if (ret < 0)
+			fprintf(stderr, "faile to modprobe %s", ipu4_modulesp[i]);
+	}
 }
 
 #ifdef EARLY_AUDIO_CMD
@@ -173,48 +113,37 @@ void *setup_early_audio(void *arg)
 #endif
 
 #ifdef PRELOAD_LIST_FILE
+/*
+ * With the record trigger in place this boot is recorded instead of
+ * preloaded, and later boots preload the recorded list.
+ */
+#define PRELOAD_RECORD_TRIGGER_FILE	WORKDIR "/preload_record"
+#define PRELOAD_RECORDED_LIST_FILE	WORKDIR "/preload.txt"
+
 static pthread_t preload_tid;
 static void *preload_thread(void *arg)
 {
-	int fd;
-	struct stat sb;
-	int ret;
-	FILE *fp;
-	char *line = NULL;
-	size_t len = 0;
-	ssize_t nread;
-
-	fp = fopen(PRELOAD_LIST_FILE, "r");
-	if (!fp) {
-//		fprintf(stderr, "open preload list error (%d): %m\n", errno);
-		goto exit;
-	}
+	struct preload_record_cfg record = {
+		.manifest = PRELOAD_RECORDED_LIST_FILE,
+		.list = PRELOAD_LIST_FILE,
+		.app_comm = PRELOAD_APP_COMM,
+	};
+	struct preload_cfg cfg = {
+		.list = PRELOAD_LIST_FILE,
+#ifdef PRELOAD_REPORT
+		.report_comm = PRELOAD_APP_COMM,
+#endif
+	};
 
-	while ((nread = getline(&line, &len, fp)) != -1) {
-		if (nread < 2) {
-			continue;
-		}
-		if (line[nread - 1] == '\n' || line[nread - 1] == '\r')
-			line[nread - 1] = 0;
-		fd = open(line, O_RDONLY);
-		if (fd > 0) {
-			fstat(fd, &sb);
-			ret = readahead(fd, 0, sb.st_size);
-			if (ret == 0) {
-				//fprintf(stdout, "preload %s success\n", line);
-			}else {
-				fprintf(stdout, "preload %s error (%d): %m\n", line, errno);
-			}
-			close(fd);
-		} else {
-			//fprintf(stdout, "preload open %s error (%d): %m\n", line, errno);
-		}
+	if (access(PRELOAD_RECORD_TRIGGER_FILE, F_OK) == 0) {
+		if (preload_record(&record) == 0)
+			unlink(PRELOAD_RECORD_TRIGGER_FILE);
+		return NULL;
 	}
 
-exit:
-	free(line);
-	if (fp)
-		fclose(fp);
+	if (access(PRELOAD_RECORDED_LIST_FILE, R_OK) == 0)
+		cfg.list = PRELOAD_RECORDED_LIST_FILE;
+	preload_run(&cfg);
 	return NULL;
 }
 #endif
@@ -264,31 +193,24 @@ int main(int argc, char *argv[])
 	if (pid < 0)
 		fprintf(stderr, "fork ipu4 pid error\n");
         else if (pid == 0) {
-		pthread_create(&load_ipu4_modules_tid, NULL, load_ipu4_modules, NULL);
-		pthread_create(&load_ipu4_crlmodule_lite_tid, NULL, load_ipu4_crlmodule_lite, NULL);
-		pthread_create(&load_ipu4_isys_csslib_tid, NULL, load_ipu4_isys_csslib, NULL);
-		pthread_create(&load_ipu4_psys_csslib_tid, NULL, load_ipu4_psys_csslib, NULL);
-		pthread_create(&load_ipu4_mmu_tid,  NULL, load_ipu4_mmu, NULL);
-		pthread_create(&load_ipu4_psys_tid,  NULL, load_ipu4_psys, NULL);
-		pthread_create(&load_ipu4_isys_tid,  NULL, load_ipu4_isys, NULL);
 #ifdef CBC_ATTACH
 		pthread_create(&cbc_attach_tid, NULL, cbc_attach_init, NULL);
 #endif
 
+		load_ipu4_modules();
+
 #ifdef CBC_ATTACH
 		pthread_join(cbc_attach_tid, NULL);
 #endif
-
-		pthread_join(load_ipu4_modules_tid, NULL);
-		pthread_join(load_ipu4_crlmodule_lite_tid, NULL);
-		pthread_join(load_ipu4_isys_csslib_tid, NULL);
-		pthread_join(load_ipu4_psys_csslib_tid, NULL);
-		pthread_join(load_ipu4_mmu_tid, NULL);
-		pthread_join(load_ipu4_psys_tid,  NULL);
-		pthread_join(load_ipu4_isys_tid,  NULL);
 		return 0;
 	}
 
+#ifdef SPLASH_SCREEN_FB_FILE
+	/* the splash stays up until earlyapp takes over the display */
+	if (splash_screen_trigger)
+		pthread_create(&splash_handoff_tid, NULL, splash_screen_handoff, NULL);
+#endif
+
 #ifdef PRELOAD_LIST_FILE
 	pthread_create(&preload_tid, NULL, preload_thread, NULL);
 #endif
@@ -304,5 +226,10 @@ int main(int argc, char *argv[])
 #ifdef EARLY_AUDIO_CMD
 	pthread_join(early_audio_tid, NULL);
 #endif
+
+#ifdef SPLASH_SCREEN_FB_FILE
+	if (splash_screen_trigger)
+		pthread_join(splash_handoff_tid, NULL);
+#endif
 	return 0;
 }
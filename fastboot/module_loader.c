@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#include "module_loader.h"
+
+#ifndef MODULE_INIT_COMPRESSED_FILE
+#define MODULE_INIT_COMPRESSED_FILE	4
+#endif
+
+#define MODULE_NAME_LEN	64
+
+enum module_state {
+	MODULE_WAITING,		/* dependencies still loading */
+	MODULE_QUEUED,
+	MODULE_LOADING,
+	MODULE_DONE,
+	MODULE_FAILED,
+};
+
+struct module_node {
+	char name[MODULE_NAME_LEN];
+	char path[PATH_MAX];
+	enum module_state state;
+	unsigned int pending;		/* dependencies not loaded yet */
+	int dep_failed;
+	unsigned int dependents[MODULE_LOADER_MAX];
+	unsigned int dependent_count;
+};
+
+/* One "path: dep dep ..." line of modules.dep, split in place. */
+struct dep_line {
+	char name[MODULE_NAME_LEN];
+	char *path;
+	char *deps;
+};
+
+struct module_graph {
+	const struct module_loader_cfg *cfg;
+	const struct module_loader_ops *ops;
+	char dir[256];
+
+	char *dep_buf;
+	struct dep_line *lines;
+	unsigned int line_count;
+
+	struct module_node nodes[MODULE_LOADER_MAX];
+	unsigned int count;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int queue[MODULE_LOADER_MAX];
+	unsigned int queue_head, queue_tail;
+	unsigned int remaining;		/* modules neither loaded nor failed */
+	unsigned int active;		/* modules being loaded */
+	int failed;
+};
+
+static int kernel_finit_module(int fd, const char *params, int flags)
+{
+	return syscall(SYS_finit_module, fd, params, flags);
+}
+
+/* Loaded modules and built-in ones with parameters show up in sysfs. */
+static int kernel_is_loaded(const char *name)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "/sys/module/%s", name);
+	return access(path, F_OK) == 0;
+}
+
+static const struct module_loader_ops kernel_ops = {
+	kernel_finit_module,
+	kernel_is_loaded,
+};
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0
+		+ (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+/* Module name of a path or a name, without ".ko*" and with '_' for '-'. */
+static void module_name(char *name, const char *s, size_t len)
+{
+	const char *base = strrchr(s, '/');
+	size_t i;
+
+	base = base ? base + 1 : s;
+	for (i = 0; i + 1 < len && base[i] && strncmp(base + i, ".ko", 3) != 0; i++)
+		name[i] = (base[i] == '-') ? '_' : base[i];
+	name[i] = '\0';
+}
+
+static int read_modules_dep(struct module_graph *g)
+{
+	char path[PATH_MAX];
+	struct stat st;
+	char *p, *end, *colon;
+	unsigned int n = 0;
+	ssize_t len, got = 0;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/modules.dep", g->dir);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		fprintf(stderr, "cannot open %s: %m\n", path);
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+
+	g->dep_buf = malloc(st.st_size + 1);
+	if (!g->dep_buf) {
+		close(fd);
+		return -1;
+	}
+	while (got < st.st_size && (len = read(fd, g->dep_buf + got, st.st_size - got)) > 0)
+		got += len;
+	close(fd);
+	g->dep_buf[got] = '\0';
+
+	for (p = g->dep_buf; *p; p++)
+		n += (*p == '\n');
+	g->lines = calloc(n + 1, sizeof(*g->lines));
+	if (!g->lines)
+		return -1;
+
+	for (p = g->dep_buf; *p; p = end + 1) {
+		end = strchrnul(p, '\n');
+		colon = memchr(p, ':', end - p);
+		if (colon) {
+			*colon = '\0';
+			g->lines[g->line_count].path = p;
+			g->lines[g->line_count].deps = colon + 1;
+			module_name(g->lines[g->line_count].name, p, MODULE_NAME_LEN);
+			g->line_count++;
+		}
+		if (!*end)
+			break;
+		*end = '\0';
+	}
+	return 0;
+}
+
+static struct dep_line *find_line(struct module_graph *g, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < g->line_count; i++)
+		if (strcmp(g->lines[i].name, name) == 0)
+			return &g->lines[i];
+	return NULL;
+}
+
+/*
+ * Adds the module and, depth first, what it depends on. Returns the node
+ * index, -1 when the module is loaded already and -2 on errors.
+ */
+static int add_module(struct module_graph *g, const char *name)
+{
+	struct module_node *node;
+	struct dep_line *line;
+	char dep_name[MODULE_NAME_LEN];
+	char *deps, *dep, *save = NULL;
+	unsigned int i, idx;
+	int d;
+
+	for (i = 0; i < g->count; i++)
+		if (strcmp(g->nodes[i].name, name) == 0)
+			return i;
+
+	if (g->ops->is_loaded(name))
+		return -1;
+
+	line = find_line(g, name);
+	if (!line) {
+		fprintf(stderr, "module %s not found in %s/modules.dep\n", name, g->dir);
+		return -2;
+	}
+	if (g->count == MODULE_LOADER_MAX) {
+		fprintf(stderr, "too many modules to load\n");
+		return -2;
+	}
+
+	idx = g->count++;
+	node = &g->nodes[idx];
+	strncpy(node->name, name, sizeof(node->name) - 1);
+	if (line->path[0] == '/')
+		snprintf(node->path, sizeof(node->path), "%s", line->path);
+	else
+		snprintf(node->path, sizeof(node->path), "%s/%s", g->dir, line->path);
+
+	/* The line is parsed once, tokenizing a copy keeps it intact. */
+	deps = strdup(line->deps);
+	if (!deps)
+		return -2;
+	for (dep = strtok_r(deps, " \t", &save); dep; dep = strtok_r(NULL, " \t", &save)) {
+		module_name(dep_name, dep, sizeof(dep_name));
+		d = add_module(g, dep_name);
+		if (d == -2) {
+			free(deps);
+			return -2;
+		}
+		if (d >= 0 && g->nodes[d].dependent_count < MODULE_LOADER_MAX) {
+			g->nodes[d].dependents[g->nodes[d].dependent_count++] = idx;
+			g->nodes[idx].pending++;
+		}
+	}
+	free(deps);
+	return idx;
+}
+
+static void queue_module(struct module_graph *g, unsigned int idx)
+{
+	g->nodes[idx].state = MODULE_QUEUED;
+	g->queue[g->queue_tail++ % MODULE_LOADER_MAX] = idx;
+}
+
+/* Called with the lock held, releases the modules waiting for this one. */
+static void finish_module(struct module_graph *g, unsigned int idx, int ok)
+{
+	struct module_node *node = &g->nodes[idx];
+	struct module_node *dependent;
+	unsigned int i;
+
+	node->state = ok ? MODULE_DONE : MODULE_FAILED;
+	g->remaining--;
+	if (!ok)
+		g->failed = 1;
+
+	for (i = 0; i < node->dependent_count; i++) {
+		dependent = &g->nodes[node->dependents[i]];
+		if (!ok)
+			dependent->dep_failed = 1;
+		if (--dependent->pending > 0)
+			continue;
+
+		if (dependent->dep_failed) {
+			fprintf(stderr, "module %s skipped, a dependency failed\n",
+				dependent->name);
+			finish_module(g, node->dependents[i], 0);
+		} else {
+			queue_module(g, node->dependents[i]);
+		}
+	}
+}
+
+static int load_module(struct module_graph *g, struct module_node *node)
+{
+	struct timespec start;
+	const char *ext = strstr(node->path, ".ko");
+	int flags = 0, fd, ret;
+
+	/* Compressed modules are unpacked by the kernel. */
+	if (ext && ext[3] == '.')
+		flags |= MODULE_INIT_COMPRESSED_FILE;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fd = open(node->path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "cannot open %s: %m\n", node->path);
+		return -1;
+	}
+	ret = g->ops->finit_module(fd, "", flags);
+	if (ret < 0 && errno == EEXIST)
+		ret = 0;
+	else if (ret < 0)
+		fprintf(stderr, "cannot load module %s: %m\n", node->name);
+	close(fd);
+
+	if (ret == 0)
+		printf("module %-24s | %6.02f ms\n", node->name, elapsed_ms(&start));
+	return ret;
+}
+
+static void *load_worker(void *arg)
+{
+	struct module_graph *g = arg;
+	unsigned int idx;
+	int ret;
+
+	pthread_mutex_lock(&g->lock);
+	while (g->remaining > 0) {
+		if (g->queue_head == g->queue_tail) {
+			/* Nothing queued and nothing loading is a cycle in modules.dep. */
+			if (g->active == 0) {
+				fprintf(stderr, "module dependency cycle\n");
+				g->failed = 1;
+				break;
+			}
+			pthread_cond_wait(&g->cond, &g->lock);
+			continue;
+		}
+
+		idx = g->queue[g->queue_head++ % MODULE_LOADER_MAX];
+		g->nodes[idx].state = MODULE_LOADING;
+		g->active++;
+		pthread_mutex_unlock(&g->lock);
+
+		ret = load_module(g, &g->nodes[idx]);
+
+		pthread_mutex_lock(&g->lock);
+		g->active--;
+		finish_module(g, idx, ret == 0);
+		pthread_cond_broadcast(&g->cond);
+	}
+	pthread_cond_broadcast(&g->cond);
+	pthread_mutex_unlock(&g->lock);
+	return NULL;
+}
+
+int module_loader_load(const struct module_loader_cfg *cfg,
+		const char *const *names, unsigned int count)
+{
+	static const struct module_loader_cfg default_cfg;
+	struct module_graph *g;
+	struct utsname uts;
+	struct timespec start;
+	char name[MODULE_NAME_LEN];
+	pthread_t tids[MODULE_LOADER_MAX];
+	unsigned int i, threads;
+	int ret = -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (!cfg)
+		cfg = &default_cfg;
+
+	g = calloc(1, sizeof(*g));
+	if (!g)
+		return -1;
+	g->cfg = cfg;
+	g->ops = cfg->ops ? cfg->ops : &kernel_ops;
+	pthread_mutex_init(&g->lock, NULL);
+	pthread_cond_init(&g->cond, NULL);
+
+	if (cfg->dir) {
+		snprintf(g->dir, sizeof(g->dir), "%s", cfg->dir);
+	} else {
+		if (uname(&uts) < 0)
+			goto out;
+		snprintf(g->dir, sizeof(g->dir), "/lib/modules/%s", uts.release);
+	}
+	if (read_modules_dep(g) < 0)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		module_name(name, names[i], sizeof(name));
+		if (add_module(g, name) == -2)
+			goto out;
+	}
+	printf("module graph: %u to load, %6.02f ms\n", g->count, elapsed_ms(&start));
+
+	g->remaining = g->count;
+	for (i = 0; i < g->count; i++)
+		if (g->nodes[i].pending == 0)
+			queue_module(g, i);
+
+	threads = cfg->threads ? cfg->threads : MODULE_LOADER_THREADS;
+	if (threads > g->count)
+		threads = g->count;
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tids[i], NULL, load_worker, g) != 0)
+			break;
+	}
+	/* Without any worker the modules are loaded here. */
+	if (i == 0 && g->count)
+		load_worker(g);
+	threads = i;
+	while (i-- > 0)
+		pthread_join(tids[i], NULL);
+
+	printf("modules loaded with %u threads in %6.02f ms\n", threads, elapsed_ms(&start));
+	ret = g->failed ? -1 : 0;
+out:
+	pthread_cond_destroy(&g->cond);
+	pthread_mutex_destroy(&g->lock);
+	free(g->lines);
+	free(g->dep_buf);
+	free(g);
+	return ret;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef MODULE_LOADER_H
+#define MODULE_LOADER_H
+
+/*
+ * In-process kernel module loader. The modules and everything they depend on
+ * according to modules.dep are loaded with finit_module(), independent ones
+ * in parallel, each module once all of its dependencies are in.
+ */
+
+/* Kernel side of the loader, replaceable to run against a fake module tree. */
+struct module_loader_ops {
+	/* finit_module(2), returns 0 or -1 with errno set */
+	int (*finit_module)(int fd, const char *params, int flags);
+	/* nonzero when the module, by normalized name, is loaded or built in */
+	int (*is_loaded)(const char *name);
+};
+
+struct module_loader_cfg {
+	const char *dir;			/* NULL for /lib/modules/$(uname -r) */
+	unsigned int threads;			/* 0 for MODULE_LOADER_THREADS */
+	const struct module_loader_ops *ops;	/* NULL for the running kernel */
+};
+
+#define MODULE_LOADER_THREADS	4
+#define MODULE_LOADER_MAX	64
+
+/*
+ * Loads @names and their dependencies. Module names are matched with '-' and
+ * '_' treated alike, as modprobe does. Returns 0 when every module is loaded,
+ * -1 when modules.dep can not be read or any module failed.
+ */
+int module_loader_load(const struct module_loader_cfg *cfg,
+		const char *const *names, unsigned int count);
+
+#endif /* MODULE_LOADER_H */
@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Module loader against a fake module tree: modules.dep and empty .ko files
+ * in a temporary directory, with finit_module() stubbed to record the load
+ * order and return injected errors.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "module_loader.h"
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define NAME_LEN	64
+
+/* Load time of every fake module, long enough to overlap the workers. */
+#define LOAD_MS		20
+
+struct fake_load {
+	char name[NAME_LEN];
+	int flags;
+	struct timespec start, end;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	char dir[256];
+	const char *const *fail;	/* "name:errno" to inject */
+	const char *const *loaded;	/* loaded or built in already */
+	struct fake_load loads[MODULE_LOADER_MAX];
+	unsigned int load_count;
+	unsigned int active, max_active;
+} fake = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static int failures;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+/* Normalized module name of a path, as the loader matches them. */
+static void fake_name(char *name, const char *path)
+{
+	const char *base = strrchr(path, '/');
+	size_t i;
+
+	base = base ? base + 1 : path;
+	for (i = 0; i + 1 < NAME_LEN && base[i] && strncmp(base + i, ".ko", 3) != 0; i++)
+		name[i] = (base[i] == '-') ? '_' : base[i];
+	name[i] = '\0';
+}
+
+static int fake_errno(const char *name)
+{
+	const char *const *f;
+	size_t len = strlen(name);
+
+	for (f = fake.fail; f && *f; f++)
+		if (strncmp(*f, name, len) == 0 && (*f)[len] == ':')
+			return atoi(*f + len + 1);
+	return 0;
+}
+
+static int fake_finit_module(int fd, const char *params, int flags)
+{
+	char link[64], path[PATH_MAX];
+	struct fake_load *load;
+	ssize_t len;
+	int err;
+
+	(void)params;
+	snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+	len = readlink(link, path, sizeof(path) - 1);
+	if (len < 0)
+		return -1;
+	path[len] = '\0';
+
+	pthread_mutex_lock(&fake.lock);
+	load = &fake.loads[fake.load_count++];
+	fake_name(load->name, path);
+	load->flags = flags;
+	if (++fake.active > fake.max_active)
+		fake.max_active = fake.active;
+	pthread_mutex_unlock(&fake.lock);
+
+	clock_gettime(CLOCK_MONOTONIC, &load->start);
+	usleep(LOAD_MS * 1000);
+	clock_gettime(CLOCK_MONOTONIC, &load->end);
+
+	pthread_mutex_lock(&fake.lock);
+	fake.active--;
+	pthread_mutex_unlock(&fake.lock);
+
+	err = fake_errno(load->name);
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+static int fake_is_loaded(const char *name)
+{
+	const char *const *l;
+
+	for (l = fake.loaded; l && *l; l++)
+		if (strcmp(*l, name) == 0)
+			return 1;
+	return 0;
+}
+
+static const struct module_loader_ops fake_ops = {
+	fake_finit_module,
+	fake_is_loaded,
+};
+
+/* Writes modules.dep and creates every module it names, under kernel/. */
+static void fake_tree(const char *dep)
+{
+	char path[PATH_MAX], file[256];
+	const char *p = dep;
+	FILE *f;
+	int n;
+
+	snprintf(path, sizeof(path), "%s/kernel", fake.dir);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/modules.dep", fake.dir);
+	f = fopen(path, "w");
+	if (!f || fputs(dep, f) < 0) {
+		perror(path);
+		exit(2);
+	}
+	fclose(f);
+
+	while (sscanf(p, " %255[^: \n]%n", file, &n) == 1) {
+		p += n;
+		if (*p == ':')
+			p++;
+		snprintf(path, sizeof(path), "%s/%s", fake.dir, file);
+		f = fopen(path, "w");
+		if (!f) {
+			perror(path);
+			exit(2);
+		}
+		fclose(f);
+	}
+}
+
+static int run(const char *dep, unsigned int threads,
+		const char *const *names, unsigned int count)
+{
+	struct module_loader_cfg cfg = { fake.dir, threads, &fake_ops };
+
+	fake_tree(dep);
+	memset(fake.loads, 0, sizeof(fake.loads));
+	fake.load_count = 0;
+	fake.max_active = 0;
+	return module_loader_load(&cfg, names, count);
+}
+
+static struct fake_load *find_load(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < fake.load_count; i++)
+		if (strcmp(fake.loads[i].name, name) == 0)
+			return &fake.loads[i];
+	return NULL;
+}
+
+static int before(const struct timespec *a, const struct timespec *b)
+{
+	return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec <= b->tv_nsec);
+}
+
+/* Every module starts loading after all of its dependencies are done. */
+static int loaded_after(const char *name, const char *dep)
+{
+	struct fake_load *l = find_load(name);
+	struct fake_load *d = find_load(dep);
+
+	return l && d && before(&d->end, &l->start);
+}
+
+static double span_ms(void)
+{
+	struct timespec first = fake.loads[0].start, last = fake.loads[0].end;
+	unsigned int i;
+
+	for (i = 1; i < fake.load_count; i++) {
+		if (before(&fake.loads[i].start, &first))
+			first = fake.loads[i].start;
+		if (before(&last, &fake.loads[i].end))
+			last = fake.loads[i].end;
+	}
+	return (last.tv_sec - first.tv_sec) * 1000.0
+		+ (last.tv_nsec - first.tv_nsec) / 1000000.0;
+}
+
+/*
+ * ipu depends on bus and css, both on core. modules.dep lists every
+ * dependency of a module, not only the direct ones.
+ */
+static const char ipu_dep[] =
+	"kernel/ipu.ko: kernel/bus.ko kernel/css.ko kernel/core.ko\n"
+	"kernel/bus.ko: kernel/core.ko\n"
+	"kernel/css.ko.xz: kernel/core.ko\n"
+	"kernel/core.ko:\n"
+	"kernel/snd-hda.ko:\n"
+	"kernel/i2c.ko:\n"
+	"kernel/spi.ko:\n"
+	"kernel/gpio.ko:\n";
+
+static void test_order(void)
+{
+	static const char *const names[] = { "ipu" };
+	struct fake_load *css;
+
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 4);
+	CHECK(loaded_after("bus", "core"));
+	CHECK(loaded_after("css", "core"));
+	CHECK(loaded_after("ipu", "bus"));
+	CHECK(loaded_after("ipu", "css"));
+
+	/* bus and css only wait for core, they load side by side. */
+	CHECK(fake.max_active == 2);
+
+	css = find_load("css");
+	CHECK(css && (css->flags & 4));
+	CHECK(find_load("core") && find_load("core")->flags == 0);
+}
+
+static void test_parallel(void)
+{
+	static const char *const names[] = { "i2c", "spi", "gpio", "snd-hda" };
+
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 4);
+	CHECK(fake.max_active == 4);
+	CHECK(span_ms() < 3 * LOAD_MS);
+
+	/* One thread loads them one after another. */
+	CHECK(run(ipu_dep, 1, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 4);
+	CHECK(fake.max_active == 1);
+	CHECK(span_ms() >= 4 * LOAD_MS);
+}
+
+static void test_failure(void)
+{
+	static const char *const names[] = { "ipu", "i2c" };
+	static const char *const core_fails[] = { "core:8", NULL };
+	static const char *const css_fails[] = { "css:22", NULL };
+
+	/* A failed dependency skips everything above it, not the rest. */
+	fake.fail = core_fails;
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == -1);
+	CHECK(fake.load_count == 2);
+	CHECK(find_load("core") && find_load("i2c"));
+	CHECK(!find_load("bus") && !find_load("css") && !find_load("ipu"));
+
+	/* bus still loads next to the failing css, ipu does not. */
+	fake.fail = css_fails;
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == -1);
+	CHECK(find_load("bus") && find_load("css"));
+	CHECK(!find_load("ipu"));
+	fake.fail = NULL;
+}
+
+static void test_loaded(void)
+{
+	static const char *const names[] = { "ipu" };
+	static const char *const core_exists[] = { "core:17", NULL };
+	static const char *const core_loaded[] = { "core", NULL };
+	static const char *const all_loaded[] = { "ipu", NULL };
+
+	/* EEXIST from the kernel is success, a race with udev. */
+	fake.fail = core_exists;
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 4);
+	CHECK(loaded_after("bus", "core"));
+	fake.fail = NULL;
+
+	/* Loaded modules are not loaded again and do not hold others back. */
+	fake.loaded = core_loaded;
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 3);
+	CHECK(!find_load("core"));
+	CHECK(fake.max_active == 2);
+
+	fake.loaded = all_loaded;
+	CHECK(run(ipu_dep, 4, names, ARRAY_SIZE(names)) == 0);
+	CHECK(fake.load_count == 0);
+	fake.loaded = NULL;
+}
+
+static void test_errors(void)
+{
+	static const char *const missing[] = { "ipu", "nosuch" };
+	static const char *const cycle[] = { "a" };
+
+	CHECK(run(ipu_dep, 4, missing, ARRAY_SIZE(missing)) == -1);
+	CHECK(fake.load_count == 0);
+
+	CHECK(run("kernel/a.ko: kernel/b.ko\nkernel/b.ko: kernel/a.ko\n",
+		4, cycle, ARRAY_SIZE(cycle)) == -1);
+	CHECK(fake.load_count == 0);
+}
+
+static int remove_file(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	(void)st;
+	(void)flag;
+	(void)ftw;
+	return remove(path);
+}
+
+int main(void)
+{
+	snprintf(fake.dir, sizeof(fake.dir), "%s/module_loader_test.XXXXXX",
+		getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+	if (!mkdtemp(fake.dir)) {
+		perror(fake.dir);
+		return 2;
+	}
+
+	test_order();
+	test_parallel();
+	test_failure();
+	test_loaded();
+	test_errors();
+	nftw(fake.dir, remove_file, 8, FTW_DEPTH | FTW_PHYS);
+
+	if (failures == 0)
+		printf("module loader tests passed\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,516 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/fanotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "preload.h"
+
+struct preload_extent {
+	off_t offset;
+	off_t length;
+};
+
+struct preload_file {
+	char *path;
+	enum preload_tier tier;
+	int fd;
+	struct stat st;
+	struct preload_extent *extents;	/* NULL for the whole file */
+	unsigned int extent_count;
+	/* filled in by the report thread */
+	int opened;
+	double opened_ms;		/* CLOCK_BOOTTIME */
+	unsigned int resident;		/* percent of pages in the page cache */
+};
+
+struct preload {
+	struct preload_file files[PRELOAD_MAX_FILES];
+	unsigned int count;
+	/* files of the tier being loaded are handed out to the workers */
+	pthread_mutex_t lock;
+	enum preload_tier tier;
+	unsigned int next;
+	/* report */
+	const char *comm;
+	int fan_fd;
+	unsigned int timeout_ms;
+	pthread_t report_tid;
+};
+
+static const char *tier_names[PRELOAD_TIERS] = {
+	"rvc",
+	"splash",
+	"rest",
+};
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0
+		+ (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static double boottime_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_BOOTTIME, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+int preload_parse_line(char *line, enum preload_tier *tier, char **path, char **extents)
+{
+	size_t len = strlen(line);
+	char *end;
+
+	while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+		line[--len] = 0;
+
+	*tier = PRELOAD_TIER_REST;
+	if (isdigit((unsigned char)line[0]) && line[1] == ' ') {
+		if (line[0] - '0' < PRELOAD_TIERS)
+			*tier = line[0] - '0';
+		line += 2;
+	}
+	if (line[0] == 0)
+		return -1;
+
+	*path = line;
+	end = strchr(line, ' ');
+	if (end) {
+		*end = 0;
+		*extents = end + 1;
+	} else {
+		*extents = strchr(line, 0);
+	}
+	return 0;
+}
+
+static int parse_extents(struct preload_file *f, const char *str)
+{
+	struct preload_extent *extents = NULL;
+	struct preload_extent *e;
+	unsigned int count = 0;
+	long long offset, length;
+	char *end;
+
+	while (*str) {
+		offset = strtoll(str, &end, 10);
+		if (end == str || *end != '+')
+			break;
+		str = end + 1;
+		length = strtoll(str, &end, 10);
+		if (end == str)
+			break;
+		str = end;
+		while (*str == ' ')
+			str++;
+		if (offset < 0 || length <= 0 || offset >= f->st.st_size)
+			continue;
+
+		e = realloc(extents, (count + 1) * sizeof(*extents));
+		if (!e) {
+			free(extents);
+			return -1;
+		}
+		extents = e;
+		extents[count].offset = offset;
+		extents[count].length = length;
+		count++;
+	}
+	f->extents = extents;
+	f->extent_count = count;
+	return 0;
+}
+
+static int read_list(struct preload *p, const char *list)
+{
+	struct preload_file *f;
+	enum preload_tier tier;
+	FILE *fp;
+	char *line = NULL;
+	char *path;
+	char *extents;
+	size_t len = 0;
+	int fd;
+
+	fp = fopen(list, "r");
+	if (!fp)
+		return -1;
+
+	while (getline(&line, &len, fp) != -1) {
+		if (preload_parse_line(line, &tier, &path, &extents) < 0)
+			continue;
+		if (p->count == PRELOAD_MAX_FILES) {
+			fprintf(stderr, "preload list truncated at %u files\n", p->count);
+			break;
+		}
+
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			continue;
+		f = &p->files[p->count];
+		if (fstat(fd, &f->st) < 0 || !S_ISREG(f->st.st_mode)) {
+			close(fd);
+			continue;
+		}
+		f->path = strdup(path);
+		if (!f->path || parse_extents(f, extents) < 0) {
+			free(f->path);
+			close(fd);
+			break;
+		}
+		f->tier = tier;
+		f->fd = fd;
+		p->count++;
+	}
+
+	free(line);
+	fclose(fp);
+	return 0;
+}
+
+/*
+ * The RVC and splash tiers are faulted in through a populated mapping, which
+ * only returns once the extent is in the page cache. The rest is left to the
+ * kernel readahead.
+ */
+static int preload_extent(struct preload_file *f, off_t offset, off_t length)
+{
+	static long page;
+	off_t start;
+	void *map;
+
+	/* The file may have shrunk since the extent was recorded. */
+	if (offset >= f->st.st_size)
+		return 0;
+	if (offset + length > f->st.st_size)
+		length = f->st.st_size - offset;
+	if (readahead(f->fd, offset, length) < 0)
+		return -1;
+	if (f->tier == PRELOAD_TIER_REST)
+		return 0;
+
+	if (!page)
+		page = sysconf(_SC_PAGESIZE);
+	start = offset & ~(off_t)(page - 1);
+	length += offset - start;
+	map = mmap(NULL, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, f->fd, start);
+	if (map != MAP_FAILED)
+		munmap(map, length);
+	return 0;
+}
+
+static int preload_file(struct preload_file *f)
+{
+	unsigned int i;
+
+	if (f->st.st_size == 0)
+		return 0;
+	if (!f->extents)
+		return preload_extent(f, 0, f->st.st_size);
+
+	for (i = 0; i < f->extent_count; i++) {
+		if (preload_extent(f, f->extents[i].offset, f->extents[i].length) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+static void *preload_worker(void *arg)
+{
+	struct preload *p = arg;
+	struct preload_file *f;
+
+	for (;;) {
+		pthread_mutex_lock(&p->lock);
+		while (p->next < p->count && p->files[p->next].tier != p->tier)
+			p->next++;
+		f = p->next < p->count ? &p->files[p->next++] : NULL;
+		pthread_mutex_unlock(&p->lock);
+		if (!f)
+			break;
+
+		if (preload_file(f) < 0)
+			fprintf(stderr, "preload %s error (%d): %m\n", f->path, errno);
+	}
+	return NULL;
+}
+
+static void preload_tier(struct preload *p, enum preload_tier tier, unsigned int threads)
+{
+	pthread_t tids[PRELOAD_THREADS];
+	struct timespec start;
+	unsigned int files = 0;
+	unsigned int i;
+
+	for (i = 0; i < p->count; i++)
+		if (p->files[i].tier == tier)
+			files++;
+	if (files == 0)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	p->tier = tier;
+	p->next = 0;
+
+	if (threads > files)
+		threads = files;
+	for (i = 0; i < threads; i++) {
+		if (pthread_create(&tids[i], NULL, preload_worker, p) != 0)
+			break;
+	}
+	/* Without any worker the tier is loaded here. */
+	if (i == 0)
+		preload_worker(p);
+	while (i-- > 0)
+		pthread_join(tids[i], NULL);
+
+	printf("preload %-8s %4u files | %6.02f ms\n", tier_names[tier], files,
+			elapsed_ms(&start));
+}
+
+static unsigned int resident_percent(int fd, off_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t pages = (size + page - 1) / page;
+	size_t resident = 0;
+	size_t i;
+	unsigned char *vec;
+	void *map;
+
+	if (size == 0)
+		return 100;
+
+	map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return 0;
+	vec = malloc(pages);
+	if (vec && mincore(map, size, vec) == 0) {
+		for (i = 0; i < pages; i++)
+			resident += vec[i] & 1;
+	}
+	free(vec);
+	munmap(map, size);
+	return resident * 100 / pages;
+}
+
+static int opened_by(const struct preload *p, pid_t pid, const struct preload_file *f)
+{
+	char path[32];
+	char comm[32];
+	const char *base;
+	ssize_t len;
+	int fd;
+
+	/* The program itself is opened by exec, under the name of its parent. */
+	base = strrchr(f->path, '/');
+	base = base ? base + 1 : f->path;
+	if (strcmp(base, p->comm) == 0)
+		return 1;
+
+	snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+	len = read(fd, comm, sizeof(comm) - 1);
+	close(fd);
+	if (len <= 0)
+		return 0;
+	if (comm[len - 1] == '\n')
+		len--;
+	comm[len] = 0;
+	return strncmp(comm, p->comm, sizeof(comm) - 1) == 0;
+}
+
+static void report_event(struct preload *p, const struct fanotify_event_metadata *ev,
+		unsigned int *remaining)
+{
+	struct preload_file *f;
+	struct stat st;
+	unsigned int i;
+
+	if (fstat(ev->fd, &st) < 0)
+		return;
+
+	for (i = 0; i < p->count; i++) {
+		f = &p->files[i];
+		if (f->opened || f->st.st_dev != st.st_dev || f->st.st_ino != st.st_ino)
+			continue;
+		if (!opened_by(p, ev->pid, f))
+			return;
+		f->opened_ms = boottime_ms();
+		f->resident = resident_percent(ev->fd, st.st_size);
+		f->opened = 1;
+		(*remaining)--;
+		return;
+	}
+}
+
+static void *report_thread(void *arg)
+{
+	struct preload *p = arg;
+	struct fanotify_event_metadata buf[64];
+	struct fanotify_event_metadata *ev;
+	struct timespec start;
+	struct pollfd pfd;
+	unsigned int remaining = p->count;
+	double left;
+	ssize_t len;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pfd.fd = p->fan_fd;
+	pfd.events = POLLIN;
+
+	while (remaining > 0) {
+		left = p->timeout_ms - elapsed_ms(&start);
+		if (left <= 0)
+			break;
+		if (poll(&pfd, 1, (int)left + 1) <= 0)
+			continue;
+
+		len = read(p->fan_fd, buf, sizeof(buf));
+		if (len <= 0)
+			continue;
+		for (ev = buf; FAN_EVENT_OK(ev, len); ev = FAN_EVENT_NEXT(ev, len)) {
+			if (ev->vers != FANOTIFY_METADATA_VERSION || ev->fd < 0)
+				continue;
+			if (ev->mask & FAN_OPEN)
+				report_event(p, ev, &remaining);
+			close(ev->fd);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Watches the listed files for opens. The files are already open here, and
+ * the preloader's own mappings do not count as opens.
+ */
+static int report_start(struct preload *p)
+{
+	unsigned int i;
+
+	p->fan_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC, O_RDONLY | O_LARGEFILE);
+	if (p->fan_fd < 0) {
+		fprintf(stderr, "preload report unavailable (%d): %m\n", errno);
+		return -1;
+	}
+	for (i = 0; i < p->count; i++) {
+		if (fanotify_mark(p->fan_fd, FAN_MARK_ADD, FAN_OPEN, AT_FDCWD,
+				p->files[i].path) < 0)
+			fprintf(stderr, "preload report %s error (%d): %m\n",
+					p->files[i].path, errno);
+	}
+	if (pthread_create(&p->report_tid, NULL, report_thread, p) != 0) {
+		close(p->fan_fd);
+		p->fan_fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static void report_finish(struct preload *p)
+{
+	struct preload_file *f;
+	unsigned int i;
+
+	pthread_join(p->report_tid, NULL);
+	close(p->fan_fd);
+
+	printf("preload report for %s\n", p->comm);
+	for (i = 0; i < p->count; i++) {
+		f = &p->files[i];
+		if (f->opened)
+			printf("%-6s %-48s | %8.02f ms | %3u%% resident\n",
+					tier_names[f->tier], f->path,
+					f->opened_ms, f->resident);
+		else
+			printf("%-6s %-48s | not opened\n",
+					tier_names[f->tier], f->path);
+	}
+}
+
+int preload_run(const struct preload_cfg *cfg)
+{
+	struct preload *p;
+	struct timespec start;
+	unsigned int threads;
+	unsigned int i;
+	int report;
+	int t;
+
+	p = calloc(1, sizeof(*p));
+	if (!p)
+		return -1;
+	pthread_mutex_init(&p->lock, NULL);
+	p->fan_fd = -1;
+	p->comm = cfg->report_comm;
+	p->timeout_ms = cfg->report_timeout_ms ?
+		cfg->report_timeout_ms : PRELOAD_REPORT_TIMEOUT_MS;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (read_list(p, cfg->list) < 0) {
+		pthread_mutex_destroy(&p->lock);
+		free(p);
+		return -1;
+	}
+
+	report = p->comm && p->count && report_start(p) == 0;
+
+	threads = cfg->threads ? cfg->threads : PRELOAD_THREADS;
+	if (threads > PRELOAD_THREADS)
+		threads = PRELOAD_THREADS;
+	for (t = PRELOAD_TIER_RVC; t < PRELOAD_TIERS; t++)
+		preload_tier(p, t, threads);
+	printf("preloaded %u files with %u threads in %6.02f ms\n", p->count, threads,
+			elapsed_ms(&start));
+
+	if (report)
+		report_finish(p);
+
+	for (i = 0; i < p->count; i++) {
+		close(p->files[i].fd);
+		free(p->files[i].path);
+		free(p->files[i].extents);
+	}
+	pthread_mutex_destroy(&p->lock);
+	free(p);
+	return 0;
+}
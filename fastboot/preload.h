@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PRELOAD_H
+#define PRELOAD_H
+
+/*
+ * Page cache preloader. Each line of the preload list is
+ * "<tier> <path> [<offset>+<length>...]", a line without a tier is in
+ * PRELOAD_TIER_REST and a line without extents preloads the whole file.
+ * Tiers are loaded one after the other, the files of a tier in list order by
+ * a pool of threads. The RVC and splash tiers are read in completely before
+ * the next tier starts, the rest is only handed to the kernel readahead.
+ */
+
+enum preload_tier {
+	PRELOAD_TIER_RVC,		/* earlyapp, its libraries, RVC assets */
+	PRELOAD_TIER_SPLASH,		/* splash video and sound */
+	PRELOAD_TIER_REST,
+	PRELOAD_TIERS,
+};
+
+struct preload_cfg {
+	const char *list;		/* preload list file */
+	unsigned int threads;		/* 0 for PRELOAD_THREADS */
+	/*
+	 * When set, the first open of each listed file by a process of this
+	 * name is reported together with how much of the file was in the page
+	 * cache at that point, for up to report_timeout_ms. Needs fanotify.
+	 */
+	const char *report_comm;
+	unsigned int report_timeout_ms;	/* 0 for PRELOAD_REPORT_TIMEOUT_MS */
+};
+
+#define PRELOAD_THREADS			4
+#define PRELOAD_MAX_FILES		512
+#define PRELOAD_REPORT_TIMEOUT_MS	30000
+
+/*
+ * Splits a preload list line in place into its tier, path and extents, the
+ * latter is an empty string when the line has none. Returns 0, or -1 for a
+ * line without a path.
+ */
+int preload_parse_line(char *line, enum preload_tier *tier, char **path, char **extents);
+
+/*
+ * Preloads the files of cfg->list and, with report_comm set, waits for the
+ * report to complete. Returns 0, or -1 when the list can not be read.
+ */
+int preload_run(const struct preload_cfg *cfg);
+
+#endif /* PRELOAD_H */
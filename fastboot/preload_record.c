@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/fanotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "preload.h"
+#include "preload_record.h"
+
+struct record_file {
+	char path[PATH_MAX];
+	int fd;				/* kept open until the extents are taken */
+	dev_t dev;
+	ino_t ino;
+	enum preload_tier tier;
+};
+
+struct listed_file {
+	dev_t dev;
+	ino_t ino;
+	enum preload_tier tier;
+};
+
+struct record {
+	struct record_file files[PRELOAD_MAX_FILES];
+	unsigned int count;
+	struct listed_file listed[PRELOAD_MAX_FILES];
+	unsigned int listed_count;
+	const char *app_comm;
+};
+
+/* Mounts watched for opens, a path on the root mount is marked only once. */
+static const char *record_mounts[] = {
+	"/",
+	"/usr",
+};
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0
+		+ (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void read_listed(struct record *r, const char *list)
+{
+	struct listed_file *l;
+	enum preload_tier tier;
+	struct stat st;
+	FILE *fp;
+	char *line = NULL;
+	char *path;
+	char *extents;
+	size_t len = 0;
+
+	fp = fopen(list, "r");
+	if (!fp)
+		return;
+
+	while (getline(&line, &len, fp) != -1 && r->listed_count < PRELOAD_MAX_FILES) {
+		if (preload_parse_line(line, &tier, &path, &extents) < 0)
+			continue;
+		if (stat(path, &st) < 0)
+			continue;
+		l = &r->listed[r->listed_count++];
+		l->dev = st.st_dev;
+		l->ino = st.st_ino;
+		l->tier = tier;
+	}
+
+	free(line);
+	fclose(fp);
+}
+
+static int opened_by_app(const struct record *r, pid_t pid, const char *path)
+{
+	char comm_path[32];
+	char comm[32];
+	const char *base;
+	ssize_t len;
+	int fd;
+
+	/* The program itself is opened by exec, under the name of its parent. */
+	base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	if (strcmp(base, r->app_comm) == 0)
+		return 1;
+
+	snprintf(comm_path, sizeof(comm_path), "/proc/%d/comm", pid);
+	fd = open(comm_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+	len = read(fd, comm, sizeof(comm) - 1);
+	close(fd);
+	if (len <= 0)
+		return 0;
+	if (comm[len - 1] == '\n')
+		len--;
+	comm[len] = 0;
+	return strncmp(comm, r->app_comm, sizeof(comm) - 1) == 0;
+}
+
+static enum preload_tier file_tier(const struct record *r, const struct stat *st,
+		pid_t pid, const char *path)
+{
+	unsigned int i;
+
+	for (i = 0; i < r->listed_count; i++) {
+		if (r->listed[i].dev == st->st_dev && r->listed[i].ino == st->st_ino)
+			return r->listed[i].tier;
+	}
+	if (r->app_comm && opened_by_app(r, pid, path))
+		return PRELOAD_TIER_SPLASH;
+	return PRELOAD_TIER_REST;
+}
+
+/* Returns nonzero when the event fd was kept for the file. */
+static int record_open(struct record *r, const struct fanotify_event_metadata *ev)
+{
+	struct record_file *f;
+	struct stat st;
+	char link[32];
+	ssize_t len;
+	unsigned int i;
+
+	if (r->count == PRELOAD_MAX_FILES)
+		return 0;
+	if (fstat(ev->fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+		return 0;
+	for (i = 0; i < r->count; i++) {
+		if (r->files[i].dev == st.st_dev && r->files[i].ino == st.st_ino)
+			return 0;
+	}
+
+	f = &r->files[r->count];
+	snprintf(link, sizeof(link), "/proc/self/fd/%d", ev->fd);
+	len = readlink(link, f->path, sizeof(f->path) - 1);
+	if (len <= 0 || f->path[0] != '/')
+		return 0;
+	f->path[len] = 0;
+	/* preload list lines are split at spaces */
+	if (strchr(f->path, ' '))
+		return 0;
+
+	f->fd = ev->fd;
+	f->dev = st.st_dev;
+	f->ino = st.st_ino;
+	f->tier = file_tier(r, &st, ev->pid, f->path);
+	r->count++;
+	return 1;
+}
+
+/* Writes the page cache resident extents of @f, nothing when none is. */
+static void write_extents(FILE *fp, const struct record_file *f, const struct stat *st)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	size_t pages = (st->st_size + page - 1) / page;
+	size_t i, run;
+	unsigned char *vec;
+	void *map;
+	int first = 1;
+
+	map = mmap(NULL, st->st_size, PROT_READ, MAP_SHARED, f->fd, 0);
+	if (map == MAP_FAILED)
+		return;
+	vec = malloc(pages);
+	if (!vec || mincore(map, st->st_size, vec) < 0)
+		goto out;
+
+	for (i = 0; i < pages; i++) {
+		if (!(vec[i] & 1))
+			continue;
+		for (run = i; run < pages && (vec[run] & 1); run++)
+			;
+		if (first)
+			fprintf(fp, "%d %s", f->tier, f->path);
+		first = 0;
+		fprintf(fp, " %lld+%lld", (long long)i * page, (long long)(run - i) * page);
+		i = run;
+	}
+	if (!first)
+		fputc('\n', fp);
+out:
+	free(vec);
+	munmap(map, st->st_size);
+}
+
+/*
+ * Files written to since the recording started are logs and state, not
+ * something the next boot wants to read ahead.
+ */
+static int write_manifest(struct record *r, const char *manifest, time_t started)
+{
+	char tmp[PATH_MAX];
+	struct stat st;
+	unsigned int i;
+	int tier;
+	FILE *fp;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", manifest);
+	fp = fopen(tmp, "w");
+	if (!fp) {
+		fprintf(stderr, "cannot write %s: %m\n", tmp);
+		return -1;
+	}
+	for (tier = PRELOAD_TIER_RVC; tier < PRELOAD_TIERS; tier++) {
+		for (i = 0; i < r->count; i++) {
+			if (r->files[i].tier != tier)
+				continue;
+			if (fstat(r->files[i].fd, &st) < 0 || st.st_mtime >= started)
+				continue;
+			write_extents(fp, &r->files[i], &st);
+		}
+	}
+	if (fclose(fp) != 0 || rename(tmp, manifest) < 0) {
+		fprintf(stderr, "cannot write %s: %m\n", manifest);
+		unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+int preload_record(const struct preload_record_cfg *cfg)
+{
+	struct fanotify_event_metadata buf[64];
+	struct fanotify_event_metadata *ev;
+	struct timespec start;
+	struct pollfd pfd;
+	struct record *r;
+	unsigned int duration_ms;
+	unsigned int i;
+	time_t started;
+	double left;
+	ssize_t len;
+	int ret = -1;
+	int fan_fd;
+
+	r = calloc(1, sizeof(*r));
+	if (!r)
+		return -1;
+	r->app_comm = cfg->app_comm;
+	/* read before the marks, the list is not part of the recording */
+	if (cfg->list)
+		read_listed(r, cfg->list);
+
+	fan_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC, O_RDONLY | O_LARGEFILE);
+	if (fan_fd < 0) {
+		fprintf(stderr, "preload record unavailable (%d): %m\n", errno);
+		free(r);
+		return -1;
+	}
+	for (i = 0; i < sizeof(record_mounts) / sizeof(record_mounts[0]); i++) {
+		if (fanotify_mark(fan_fd, FAN_MARK_ADD | FAN_MARK_MOUNT, FAN_OPEN,
+				AT_FDCWD, record_mounts[i]) < 0)
+			fprintf(stderr, "preload record %s error (%d): %m\n",
+					record_mounts[i], errno);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	started = time(NULL);
+	duration_ms = cfg->duration_ms ? cfg->duration_ms : PRELOAD_RECORD_MS;
+	pfd.fd = fan_fd;
+	pfd.events = POLLIN;
+
+	for (;;) {
+		left = duration_ms - elapsed_ms(&start);
+		if (left <= 0)
+			break;
+		if (poll(&pfd, 1, (int)left + 1) <= 0)
+			continue;
+
+		len = read(fan_fd, buf, sizeof(buf));
+		if (len <= 0)
+			continue;
+		for (ev = buf; FAN_EVENT_OK(ev, len); ev = FAN_EVENT_NEXT(ev, len)) {
+			if (ev->vers != FANOTIFY_METADATA_VERSION || ev->fd < 0)
+				continue;
+			if (!(ev->mask & FAN_OPEN) || !record_open(r, ev))
+				close(ev->fd);
+		}
+	}
+	close(fan_fd);
+
+	if (write_manifest(r, cfg->manifest, started) == 0) {
+		printf("preload record: %u files in %s\n", r->count, cfg->manifest);
+		ret = 0;
+	}
+
+	for (i = 0; i < r->count; i++)
+		close(r->files[i].fd);
+	free(r);
+	return ret;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef PRELOAD_RECORD_H
+#define PRELOAD_RECORD_H
+
+/*
+ * Boot time file access recorder. Every regular file opened on the root and
+ * /usr file systems is recorded in the order of its first open. When the
+ * recording ends, the pages of each file that are in the page cache give the
+ * extents that were read since boot, and the files are written out as a
+ * preload list with those extents (see preload.h).
+ */
+
+struct preload_record_cfg {
+	const char *manifest;		/* preload list to write */
+	/*
+	 * Files of this list keep their tier. Other files opened by app_comm
+	 * go to PRELOAD_TIER_SPLASH, the rest to PRELOAD_TIER_REST.
+	 */
+	const char *list;
+	const char *app_comm;
+	unsigned int duration_ms;	/* 0 for PRELOAD_RECORD_MS */
+};
+
+#define PRELOAD_RECORD_MS	30000
+
+/*
+ * Records for cfg->duration_ms and writes the manifest. Returns 0, or -1
+ * when fanotify is not available or the manifest can not be written.
+ */
+int preload_record(const struct preload_record_cfg *cfg);
+
+#endif /* PRELOAD_RECORD_H */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Converts a PNG into a splash image for earlyapp-fastboot:
+ *   earlyapp-splash-convert [--raw] <image.png> <splash.img>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <png.h>
+
+#include "splash_image.h"
+
+static int write_image(const char *path, const png_image *png, const uint32_t *pixels, int raw)
+{
+	struct splash_image_header header;
+	uint8_t *data;
+	size_t size = 0;
+	uint32_t y;
+	FILE *fp;
+	int ret = -1;
+
+	data = malloc((size_t)SPLASH_IMAGE_RLE_ROW_MAX(png->width) * png->height);
+	if (!data)
+		return -1;
+
+	for (y = 0; y < png->height; y++) {
+		if (raw) {
+			memcpy(data + size, pixels + (size_t)y * png->width, png->width * 4);
+			size += png->width * 4;
+		} else {
+			size += splash_image_encode_row(pixels + (size_t)y * png->width,
+					png->width, data + size);
+		}
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = SPLASH_IMAGE_MAGIC;
+	header.version = SPLASH_IMAGE_VERSION;
+	header.compression = raw ? SPLASH_IMAGE_RAW : SPLASH_IMAGE_RLE;
+	header.width = png->width;
+	header.height = png->height;
+	header.stride = png->width * 4;
+	header.format = SPLASH_IMAGE_XRGB8888;
+	header.data_size = size;
+
+	fp = fopen(path, "wb");
+	if (!fp) {
+		fprintf(stderr, "cannot open %s: %m\n", path);
+		goto out;
+	}
+	if (fwrite(&header, sizeof(header), 1, fp) != 1
+			|| fwrite(data, 1, size, fp) != size) {
+		fprintf(stderr, "cannot write %s: %m\n", path);
+		fclose(fp);
+		goto out;
+	}
+	if (fclose(fp) != 0) {
+		fprintf(stderr, "cannot write %s: %m\n", path);
+		goto out;
+	}
+	printf("%s: %ux%u, %zu bytes of %s data (raw %zu)\n", path, png->width,
+			png->height, size, raw ? "raw" : "RLE",
+			(size_t)png->width * png->height * 4);
+	ret = 0;
+out:
+	free(data);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	png_image png;
+	uint32_t *pixels;
+	int raw = 0;
+	int ret;
+
+	if (argc > 1 && strcmp(argv[1], "--raw") == 0) {
+		raw = 1;
+		argc--;
+		argv++;
+	}
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s [--raw] <image.png> <splash.img>\n", argv[0]);
+		return 1;
+	}
+
+	memset(&png, 0, sizeof(png));
+	png.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&png, argv[1])) {
+		fprintf(stderr, "%s: %s\n", argv[1], png.message);
+		return 1;
+	}
+	/* BGRA in memory is XRGB8888 on the little endian target */
+	png.format = PNG_FORMAT_BGRA;
+	pixels = malloc(PNG_IMAGE_SIZE(png));
+	if (!pixels) {
+		png_image_free(&png);
+		return 1;
+	}
+	if (!png_image_finish_read(&png, NULL, pixels, 0, NULL)) {
+		fprintf(stderr, "%s: %s\n", argv[1], png.message);
+		free(pixels);
+		return 1;
+	}
+
+	ret = write_image(argv[2], &png, pixels, raw);
+	free(pixels);
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include <string.h>
+
+#include "splash_image.h"
+
+#define RLE_MAX_COUNT	128
+
+static uint32_t run_length(const uint32_t *row, uint32_t width, uint32_t x)
+{
+	uint32_t n = 1;
+
+	while (x + n < width && n < RLE_MAX_COUNT && row[x + n] == row[x])
+		n++;
+	return n;
+}
+
+size_t splash_image_encode_row(const uint32_t *row, uint32_t width, uint8_t *out)
+{
+	uint8_t *p = out;
+	uint32_t x = 0;
+	uint32_t n;
+
+	while (x < width) {
+		n = run_length(row, width, x);
+		if (n > 1) {
+			*p++ = 0x80 | (n - 1);
+			memcpy(p, &row[x], 4);
+			p += 4;
+			x += n;
+			continue;
+		}
+		/* literals up to the next run */
+		n = 1;
+		while (x + n < width && n < RLE_MAX_COUNT && run_length(row, width, x + n) == 1)
+			n++;
+		*p++ = n - 1;
+		memcpy(p, &row[x], n * 4);
+		p += n * 4;
+		x += n;
+	}
+	return p - out;
+}
+
+int splash_image_open(const uint8_t *data, size_t size,
+		const struct splash_image_header **header, const uint8_t **pixels)
+{
+	const struct splash_image_header *h = (const struct splash_image_header *)data;
+
+	if (size < sizeof(*h) || h->magic != SPLASH_IMAGE_MAGIC)
+		return -1;
+	if (h->version != SPLASH_IMAGE_VERSION || h->format != SPLASH_IMAGE_XRGB8888)
+		return -1;
+	if (h->width == 0 || h->height == 0 || h->data_size > size - sizeof(*h))
+		return -1;
+	if (h->compression == SPLASH_IMAGE_RAW) {
+		if (h->stride < h->width * 4
+				|| (uint64_t)h->stride * h->height > h->data_size)
+			return -1;
+	} else if (h->compression != SPLASH_IMAGE_RLE) {
+		return -1;
+	}
+
+	*header = h;
+	*pixels = data + sizeof(*h);
+	return 0;
+}
+
+/*
+ * Decodes a row of @width pixels from @src, of which the @count pixels from
+ * @skip on are written to @dst. Returns the next row, or NULL when the data
+ * is corrupt.
+ */
+static const uint8_t *decode_rle_row(const uint8_t *src, const uint8_t *end,
+		uint32_t width, uint32_t skip, uint32_t count, uint8_t *dst)
+{
+	uint32_t *out = (uint32_t *)dst;
+	uint32_t x = 0;
+	uint32_t first, last;
+	uint32_t pixel;
+	uint32_t n, i;
+	int run;
+
+	while (x < width) {
+		if (src >= end)
+			return NULL;
+		run = *src & 0x80;
+		n = (*src++ & 0x7f) + 1;
+		if (x + n > width)
+			return NULL;
+
+		first = x > skip ? x : skip;
+		last = x + n < skip + count ? x + n : skip + count;
+		if (run) {
+			if (end - src < 4)
+				return NULL;
+			memcpy(&pixel, src, 4);
+			src += 4;
+			for (i = first; i < last; i++)
+				out[i - skip] = pixel;
+		} else {
+			if ((size_t)(end - src) < n * 4)
+				return NULL;
+			if (first < last)
+				memcpy(&out[first - skip], src + (first - x) * 4, (last - first) * 4);
+			src += n * 4;
+		}
+		x += n;
+	}
+	return src;
+}
+
+int splash_image_decode(const struct splash_image_header *header, const uint8_t *pixels,
+		uint8_t *dst, uint32_t width, uint32_t height, uint32_t stride)
+{
+	const uint8_t *src = pixels;
+	const uint8_t *end = pixels + header->data_size;
+	uint32_t x0, y0, skip_x, skip_y, count_x, count_y;
+	uint32_t y;
+	uint8_t *row;
+
+	/* the image is centered, cut on both sides when it is larger */
+	x0 = width > header->width ? (width - header->width) / 2 : 0;
+	y0 = height > header->height ? (height - header->height) / 2 : 0;
+	skip_x = header->width > width ? (header->width - width) / 2 : 0;
+	skip_y = header->height > height ? (header->height - height) / 2 : 0;
+	count_x = header->width < width ? header->width : width;
+	count_y = header->height < height ? header->height : height;
+
+	for (y = 0; y < skip_y + count_y; y++) {
+		row = y < skip_y ? NULL : dst + (size_t)(y0 + y - skip_y) * stride + x0 * 4;
+		if (header->compression == SPLASH_IMAGE_RAW) {
+			if (row)
+				memcpy(row, pixels + (size_t)y * header->stride + skip_x * 4,
+						count_x * 4);
+			continue;
+		}
+		src = decode_rle_row(src, end, header->width, skip_x,
+				row ? count_x : 0, row);
+		if (!src)
+			return -1;
+	}
+	return 0;
+}
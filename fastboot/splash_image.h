@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SPLASH_IMAGE_H
+#define SPLASH_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Splash image file: a splash_image_header followed by data_size bytes of
+ * pixel data, all little endian. Pixels are 32 bit XRGB8888. RLE data codes
+ * each row on its own, as runs of tokens:
+ *   0x80 | (n - 1), pixel	n times the pixel, n up to 128
+ *   n - 1, n pixels		n literal pixels, n up to 128
+ * so that it can be decoded a row at a time into a buffer of any stride.
+ */
+
+#define SPLASH_IMAGE_MAGIC	0x4c505345	/* "ESPL" */
+#define SPLASH_IMAGE_VERSION	1
+#define SPLASH_IMAGE_XRGB8888	0x34325258	/* DRM_FORMAT_XRGB8888 */
+
+enum splash_image_compression {
+	SPLASH_IMAGE_RAW,		/* rows of stride bytes */
+	SPLASH_IMAGE_RLE,
+};
+
+struct splash_image_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t compression;
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;		/* bytes per row of RAW data */
+	uint32_t format;
+	uint32_t data_size;
+};
+
+/* Upper bound of the RLE size of a row of @width pixels. */
+#define SPLASH_IMAGE_RLE_ROW_MAX(width)	((width) * 4 + ((width) + 127) / 128)
+
+/* Codes a row of @width pixels into @out, returns the bytes written. */
+size_t splash_image_encode_row(const uint32_t *row, uint32_t width, uint8_t *out);
+
+/*
+ * Checks the header at @data, @size bytes with the pixel data. Returns 0 and
+ * points @pixels at the data, or -1 when it is not a usable splash image.
+ */
+int splash_image_open(const uint8_t *data, size_t size,
+		const struct splash_image_header **header, const uint8_t **pixels);
+
+/*
+ * Decodes the image into a @width x @height buffer of @stride bytes per row,
+ * centered and clipped to it. Pixels outside the image are left untouched.
+ * Returns 0, or -1 when the data is corrupt.
+ */
+int splash_image_decode(const struct splash_image_header *header, const uint8_t *pixels,
+		uint8_t *dst, uint32_t width, uint32_t height, uint32_t stride);
+
+#endif /* SPLASH_IMAGE_H */
@@ -23,9 +23,12 @@
  *
  * Authors: Bin Yang <bin.yang@intel.com>
  */
+#include <poll.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -33,9 +36,13 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/sysmacros.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#include "splash_image.h"
+
 #define FB_DEPTH 24
 #define FB_BPP 32
 
@@ -54,6 +61,9 @@ struct  drm_fb_t {
 };
 
 static struct drm_fb_t drm_fb0;
+static int drm_fd = -1;
+static int handoff_fd = -1;
+static int splash_shown;
 
 static void drm_destroy_fb(struct drm_fb_t *fb)
 {
@@ -190,22 +200,127 @@ exit:
 }
 
 
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0
+		+ (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+/*
+ * Decodes a splash image file into the framebuffer, row by row at the
+ * framebuffer stride. Returns the bytes read, or -1.
+ */
+static ssize_t splash_image_show(int img_fd, struct drm_fb_t *fb)
+{
+	const struct splash_image_header *header;
+	const uint8_t *pixels;
+	struct stat sb;
+	uint8_t *data;
+	size_t done = 0;
+	ssize_t ret;
+
+	if (fstat(img_fd, &sb) < 0)
+		return -1;
+	data = malloc(sb.st_size);
+	if (!data)
+		return -1;
+	while (done < (size_t)sb.st_size) {
+		ret = read(img_fd, data + done, sb.st_size - done);
+		if (ret <= 0)
+			break;
+		done += ret;
+	}
+
+	ret = -1;
+	if (splash_image_open(data, done, &header, &pixels) < 0) {
+		fprintf(stderr, "%s is not a splash image\n", SPLASH_SCREEN_IMG_FILE);
+		goto exit;
+	}
+	if (header->width != fb->width || header->height != fb->height)
+		fprintf(stderr, "splash image %ux%u on a %ux%u fb0, centered\n",
+				header->width, header->height, fb->width, fb->height);
+	if (splash_image_decode(header, pixels, fb->map, fb->width, fb->height, fb->stride) < 0) {
+		fprintf(stderr, "%s is corrupt\n", SPLASH_SCREEN_IMG_FILE);
+		goto exit;
+	}
+	ret = done;
+exit:
+	free(data);
+	return ret;
+}
+
+/*
+ * Handoff socket, bound to SPLASH_HANDOFF_NAME in the abstract namespace so
+ * that it does not depend on any file system being mounted. earlyapp sends
+ * a datagram to it once its first frame is on screen.
+ */
+static int handoff_open(void)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path + 1, SPLASH_HANDOFF_NAME, sizeof(addr.sun_path) - 2);
+	if (bind(fd, (struct sockaddr *)&addr,
+			offsetof(struct sockaddr_un, sun_path) + 1 + strlen(SPLASH_HANDOFF_NAME)) < 0) {
+		fprintf(stderr, "bind splash handoff socket error (%d): %m\n", errno);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Splash duration from the trigger file, used when there is no handoff. */
+static int trigger_duration_ms(void)
+{
+	FILE *fp;
+	char str[6];
+	int msec = 0;
+
+	fp = fopen(SPLASH_SCREEN_TRIGGER_FILE, "r");
+	if (fp) {
+		if (fgets(str, sizeof(str), fp))
+			msec = atoi(str);
+		fclose(fp);
+	}
+	msec = (msec < 0 ? 0 : msec);
+	return msec > SPLASH_SCREEN_MAX_MS_DURATION ? SPLASH_SCREEN_MAX_MS_DURATION : msec;
+}
+
+/*
+ * Shows the splash image and returns with it still scanned out. DRM master
+ * is dropped right away so that the compositor can take over the display,
+ * the framebuffer is kept until splash_screen_handoff().
+ */
 void *splash_screen_init(void *arg)
 {
 	dev_t dev;
-	int drm_fd = -1;
 	int img_fd = -1;
-	FILE *fp;
-	char str[6];
-	int msec;
-	useconds_t usec;
 	struct stat sb;
+	struct timespec start;
+	const char *img_file = SPLASH_SCREEN_IMG_FILE;
+	int compressed = 1;
+	ssize_t img_bytes;
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 #ifdef SPLASH_SCREEN_START_CMD
 	if (system(SPLASH_SCREEN_START_CMD " > /dev/null"))
 		fprintf(stderr, "\"%s\" return error\n", SPLASH_SCREEN_START_CMD);
 #endif
-	img_fd = open(SPLASH_SCREEN_FB_FILE, O_RDONLY);
+	/* the compressed image when installed, the raw fb0 dump otherwise */
+	img_fd = open(img_file, O_RDONLY);
+	if (img_fd < 0) {
+		img_file = SPLASH_SCREEN_FB_FILE;
+		img_fd = open(img_file, O_RDONLY);
+		compressed = 0;
+	}
 	if (img_fd < 0) {
 		fprintf(stderr, "open %s error, errno = %d\n", SPLASH_SCREEN_FB_FILE, errno);
 		goto exit;
@@ -224,36 +339,79 @@ void *splash_screen_init(void *arg)
 		goto exit;
 	}
 
-	fstat(img_fd, &sb);
-	if (drm_fb0.size != sb.st_size)
-		fprintf(stderr, "fb0 size and splash img size mismatch, fb0 size: %u, img size: %lu\n", drm_fb0.size, sb.st_size);
-	if (read(img_fd, drm_fb0.map, drm_fb0.size) <= 0) {
-		fprintf(stderr, "read %s error, errno = %d\n", SPLASH_SCREEN_FB_FILE, errno);
-		goto exit;
+	if (compressed) {
+		img_bytes = splash_image_show(img_fd, &drm_fb0);
+		if (img_bytes < 0)
+			goto exit;
+	} else {
+		fstat(img_fd, &sb);
+		if (drm_fb0.size != sb.st_size)
+			fprintf(stderr, "fb0 size and splash img size mismatch, fb0 size: %u, img size: %lu\n", drm_fb0.size, sb.st_size);
+		img_bytes = read(img_fd, drm_fb0.map, drm_fb0.size);
+		if (img_bytes <= 0) {
+			fprintf(stderr, "read %s error, errno = %d\n", SPLASH_SCREEN_FB_FILE, errno);
+			goto exit;
+		}
 	}
+	printf("splash %s: %zd bytes read, %6.02f ms to scanout\n", img_file, img_bytes,
+			elapsed_ms(&start));
+
+	if (drmDropMaster(drm_fd) < 0)
+		fprintf(stderr, "drop drm master error (%d): %m\n", errno);
+	handoff_fd = handoff_open();
+	splash_shown = 1;
 
 exit:
 #ifdef SPLASH_SCREEN_END_CMD
 	if (system(SPLASH_SCREEN_END_CMD " > /dev/null"))
 		fprintf(stderr, "\"%s\" return error\n", SPLASH_SCREEN_END_CMD);
 #endif
-	fp = fopen(SPLASH_SCREEN_TRIGGER_FILE, "r");
-	if (fp > 0) {
-		if (feof(fp) == 0) {
-			fgets(str,6,fp);
-			msec = atoi(str);
-			msec = (msec < 0 ? 0: msec);
-			usec = (msec > SPLASH_SCREEN_MAX_MS_DURATION ? SPLASH_SCREEN_MAX_MS_DURATION : msec) * 1000;
-			usleep(usec);
-		}
-
-		close(fp);
-	}
 	if (img_fd > 0)
 		close(img_fd);
-	if (drm_fd > 0) {
+	if (!splash_shown && drm_fd > 0) {
 		drm_destroy_fb(&drm_fb0);
 		close(drm_fd);
+		drm_fd = -1;
 	}
 	return NULL;
 }
+
+/*
+ * Keeps the splash on screen until earlyapp reports its first frame, at most
+ * SPLASH_SCREEN_MAX_MS_DURATION, then frees the framebuffer. Without the
+ * handoff socket the splash stays for the trigger file duration.
+ */
+void *splash_screen_handoff(void *arg)
+{
+	struct pollfd pfd;
+	struct timespec start;
+	char msg[64];
+	ssize_t len;
+
+	if (!splash_shown)
+		return NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (handoff_fd < 0) {
+		usleep(trigger_duration_ms() * 1000);
+	} else {
+		pfd.fd = handoff_fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, SPLASH_SCREEN_MAX_MS_DURATION) > 0
+				&& (len = recv(handoff_fd, msg, sizeof(msg) - 1, 0)) > 0) {
+			msg[len] = 0;
+			printf("splash handed off (%s) after %6.02f ms\n", msg,
+					elapsed_ms(&start));
+		} else {
+			fprintf(stderr, "splash handoff timed out\n");
+		}
+		close(handoff_fd);
+		handoff_fd = -1;
+	}
+
+	drm_destroy_fb(&drm_fb0);
+	close(drm_fd);
+	drm_fd = -1;
+	splash_shown = 0;
+	return NULL;
+}
@@ -36,6 +36,7 @@ extern "C" {
 
 #include "pipeline-cfg.h"
 #include "icitest.h"
+#include "CaptureSession.h"
 
 #ifdef __cplusplus
 }
@@ -106,9 +107,12 @@ namespace earlyapp
         boost::thread_group* m_pThreadGrpRVC = nullptr;
         boost::thread* m_pThreadRVC = nullptr;
 
-        static void displayCamera(setup, int, void*);
+        static void displayCamera(setup, int);
 
-        void* m_pGPIOClass = NULL;
+        /*
+          Capture session the frames come from.
+         */
+        void* m_pCapture = NULL;
 
         /**
            @brief Default camera width, height.
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CaptureSession.h"
+
+namespace earlyapp
+{
+    /**
+      @brief Capture device interface behind a capture session.
+
+      A backend only drives the device. Buffer memory belongs to the
+      CaptureBufferManager and buffer lifetime to the CaptureSession.
+     */
+    class CaptureBackend
+    {
+    public:
+        /**
+           @brief Destructor.
+        */
+        virtual ~CaptureBackend(void) { }
+
+        /**
+           @brief Backend name used in logs and statistics.
+        */
+        virtual const char* name(void) const = 0;
+
+        /**
+           @brief Is there camera hardware behind the backend?
+        */
+        virtual bool hardware(void) const { return true; }
+
+        /**
+           @brief Open the capture device.
+           @param config Capture configuration.
+           @return true for success, false otherwise.
+        */
+        virtual bool open(const capture_config& config) = 0;
+
+        /**
+           @brief Set the format and request the buffers.
+           @param config Capture configuration.
+           @param format Format agreed with the driver.
+           @return true for success, false otherwise.
+        */
+        virtual bool configure(const capture_config& config, capture_format& format) = 0;
+
+        /**
+           @brief Export a driver owned buffer as dmabuf, for CAPTURE_MEMORY_EXPORTED.
+           @return dmabuf file descriptor, -1 on failure.
+        */
+        virtual int exportBuffer(unsigned int index) { (void) index; return -1; }
+
+        /**
+           @brief Give a buffer to the driver.
+           @return true for success, false otherwise.
+        */
+        virtual bool queue(const capture_buffer& buffer) = 0;
+
+        /**
+           @brief Take a captured buffer from the driver.
+           @param frame Filled with the field, timestamp and sequence.
+           @return Buffer index, -1 when no frame is ready, CAPTURE_ERROR when
+           the device failed and has to be streamed off and on again.
+        */
+        virtual int dequeue(capture_frame& frame) = 0;
+
+        /**
+           @brief Start streaming.
+        */
+        virtual bool streamOn(void) = 0;
+
+        /**
+           @brief Stop streaming, every queued buffer is returned.
+        */
+        virtual bool streamOff(void) = 0;
+
+        /**
+           @brief Close the capture device.
+        */
+        virtual void close(void) = 0;
+
+        /**
+           @brief File descriptor becoming readable when a frame is ready.
+        */
+        virtual int pollFd(void) const = 0;
+    };
+} // namespace
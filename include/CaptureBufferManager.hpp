@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <libdrm/intel_bufmgr.h>
+
+#include "CaptureBackend.hpp"
+
+namespace earlyapp
+{
+    /**
+      @brief Owns the capture buffers of both camera engines.
+
+      GEM buffers are allocated in i915 and exported as dmabuf, driver
+      buffers are imported from their dmabuf, both are mapped once for the
+      CPU and flinked for wl_drm. The DRM device stays open across restarts.
+     */
+    class CaptureBufferManager
+    {
+    public:
+        /**
+           @brief Destructor, releases the buffers and the DRM device.
+        */
+        ~CaptureBufferManager(void);
+
+        /**
+           @brief Allocate the buffers for a configured backend.
+           @param backend Backend exporting driver buffers.
+           @param config Capture configuration.
+           @param format Format agreed with the driver.
+           @return true for success, false otherwise.
+        */
+        bool allocate(CaptureBackend& backend,
+                      const capture_config& config, const capture_format& format);
+
+        /**
+           @brief Release every buffer.
+        */
+        void release(void);
+
+        /**
+           @brief Number of allocated buffers.
+        */
+        unsigned int count(void) const { return m_Buffers.size(); }
+
+        /**
+           @brief Buffer with the given index.
+        */
+        const capture_buffer& buffer(unsigned int index) const { return m_Buffers[index]; }
+
+    private:
+        /**
+           @brief Open i915 and create the GEM buffer manager once.
+        */
+        bool initGem(void);
+
+        /**
+           @brief Allocate a GEM buffer and export it.
+        */
+        bool createGem(capture_buffer& buffer, drm_intel_bo*& bo);
+
+        /**
+           @brief Import an exported driver buffer.
+        */
+        bool importPrime(capture_buffer& buffer, drm_intel_bo*& bo);
+
+        int m_DrmFd = -1;
+        drm_intel_bufmgr* m_pBufmgr = nullptr;
+        std::vector<capture_buffer> m_Buffers;
+        std::vector<drm_intel_bo*> m_Bos;
+    };
+} // namespace
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Capture session C interfaces.
+ *
+ * The ICI and CSI camera engines share one capture session: a backend
+ * driving the device (ICI stream, V4L2 video node or a fake test source)
+ * and one buffer manager owning the capture memory. The engines only see
+ * the buffers, the frames and the poll file descriptor.
+ */
+
+/* Where the capture buffer memory comes from. */
+enum capture_memory {
+    CAPTURE_MEMORY_GEM,		/* GEM buffers allocated here, imported by the driver */
+    CAPTURE_MEMORY_EXPORTED,	/* driver buffers exported as dmabuf, imported in GEM */
+    CAPTURE_MEMORY_USERPTR,		/* page aligned CPU memory */
+};
+
+enum capture_field {
+    CAPTURE_FIELD_NONE,
+    CAPTURE_FIELD_TOP,
+    CAPTURE_FIELD_BOTTOM,
+};
+
+struct capture_config {
+    char device[32];
+    unsigned int width, height;
+    unsigned int fourcc;		/* pixel format understood by the backend */
+    unsigned int bytes_per_pixel;
+    unsigned int bytes_per_line;	/* 0 lets the driver choose */
+    unsigned int buffer_count;
+    unsigned int interlaced;
+    enum capture_memory memory;
+};
+
+/* Format agreed with the driver. */
+struct capture_format {
+    unsigned int width, height;
+    unsigned int fourcc;
+    unsigned int bytes_per_pixel;
+    unsigned int bytes_per_line;
+    unsigned int size;
+};
+
+struct capture_buffer {
+    unsigned int index;
+    void *data;			/* CPU mapping */
+    size_t size;
+    int dmabuf_fd;			/* -1 for CPU memory */
+    uint32_t flink_name;		/* 0 for CPU memory */
+};
+
+/* Returned by dequeue when the device failed and the stream needs recovery. */
+#define CAPTURE_ERROR (-2)
+
+struct capture_frame {
+    int index;
+    enum capture_field field;
+    uint64_t timestamp_ns;		/* CLOCK_MONOTONIC */
+    uint32_t sequence;
+};
+
+/*
+ * Creates a session for the "v4l2", "ici", "fake" or "fake-faults" backend,
+ * NULL when unknown. "fake-faults" is the fake source failing regularly, to
+ * exercise error recovery.
+ */
+void *CaptureSession_create(const char *backend);
+void CaptureSession_release(void *session);
+
+/* Opens and configures the device, allocates and queues the buffers and streams on. */
+int CaptureSession_start(void *session, const struct capture_config *config);
+/* Streams off, frees the buffers and closes the device. */
+void CaptureSession_stop(void *session);
+/* Stops and starts again with the same configuration, after device errors. */
+int CaptureSession_restart(void *session);
+/* Streams off, gives every buffer back to the driver and streams on. */
+int CaptureSession_requeue(void *session);
+/*
+ * Streams off after a device error or while the camera is hidden, keeping
+ * the buffers and their holders. Buffers put meanwhile are kept until
+ * CaptureSession_resume or CaptureSession_requeue.
+ */
+int CaptureSession_suspend(void *session);
+/* Gives every buffer nobody holds to the driver and streams on again. */
+int CaptureSession_resume(void *session);
+
+/* File descriptor to wait on for frames. */
+int CaptureSession_fd(void *session);
+/* 0 when no camera hardware is behind the session. */
+int CaptureSession_hardware(void *session);
+const struct capture_format *CaptureSession_format(void *session);
+unsigned int CaptureSession_buffer_count(void *session);
+const struct capture_buffer *CaptureSession_buffer(void *session, unsigned int index);
+
+/*
+ * Dequeues a frame, returns the buffer index, -1 when no frame is ready or
+ * CAPTURE_ERROR. The caller holds one reference to the buffer, which goes
+ * back to the driver with the last put.
+ */
+int CaptureSession_dequeue(void *session, struct capture_frame *frame);
+void CaptureSession_get(void *session, int index);
+/* Returns -1 when the buffer could not be given back to the driver. */
+int CaptureSession_put(void *session, int index);
+
+#ifdef __cplusplus
+}
+#endif
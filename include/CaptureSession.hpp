@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "CaptureSession.h"
+#include "CaptureBackend.hpp"
+#include "CaptureBufferManager.hpp"
+
+namespace earlyapp
+{
+    /**
+      @brief One capture stream shared by the ICI and CSI camera engines.
+
+      Ties a backend to the buffer manager and keeps the buffer references:
+      a dequeued buffer is held by the capture thread and by every mailbox
+      frame using it, and goes back to the driver with the last put.
+     */
+    class CaptureSession
+    {
+    public:
+        /**
+           @brief Create the backend with the given name.
+           @param name "v4l2", "ici" or "fake".
+           @return Backend, nullptr for unknown names.
+        */
+        static std::unique_ptr<CaptureBackend> createBackend(const std::string& name);
+
+        /**
+           @brief Constructor.
+           @param backend Backend driving the device.
+        */
+        explicit CaptureSession(std::unique_ptr<CaptureBackend> backend);
+
+        /**
+           @brief Destructor, stops the stream.
+        */
+        ~CaptureSession(void);
+
+        /**
+           @brief Open, configure, allocate, queue every buffer and stream on.
+           @return true for success, false otherwise.
+        */
+        bool start(const capture_config& config);
+
+        /**
+           @brief Stream off, release the buffers and close the device.
+        */
+        void stop(void);
+
+        /**
+           @brief Stop and start again with the last configuration.
+        */
+        bool restart(void);
+
+        /**
+           @brief Stream off, give every buffer to the driver and stream on.
+        */
+        bool requeue(void);
+
+        /**
+           @brief Stream off after a device error, keeping the buffers.
+           Held buffers stay with their holders and are not queued by put()
+           until resume().
+        */
+        bool suspend(void);
+
+        /**
+           @brief Queue every buffer nobody holds and stream on again.
+           @return false when the device is still failing, the session stays suspended.
+        */
+        bool resume(void);
+
+        /**
+           @brief Dequeue a frame holding one buffer reference.
+           @return Buffer index, -1 when no frame is ready, CAPTURE_ERROR on device errors.
+        */
+        int dequeue(capture_frame& frame);
+
+        /**
+           @brief Add a buffer reference.
+        */
+        void get(int index);
+
+        /**
+           @brief Drop a buffer reference, the last one queues the buffer.
+           @return false when the buffer could not be queued.
+        */
+        bool put(int index);
+
+        /**
+           @brief Backend of the session.
+        */
+        CaptureBackend& backend(void) { return *m_pBackend; }
+
+        /**
+           @brief Buffers of the session.
+        */
+        const CaptureBufferManager& buffers(void) const { return m_Buffers; }
+
+        /**
+           @brief Format agreed with the driver.
+        */
+        const capture_format& format(void) const { return m_Format; }
+
+    private:
+        /**
+           @brief Queue every buffer with a single reference reset.
+        */
+        bool queueAll(void);
+
+        std::unique_ptr<CaptureBackend> m_pBackend;
+        CaptureBufferManager m_Buffers;
+        capture_config m_Config;
+        capture_format m_Format;
+        std::unique_ptr<std::atomic<int>[]> m_pRefs;
+        bool m_Started = false;
+        bool m_Suspended = false;
+
+        /**
+           @brief Serializes the last put of a buffer against suspend and resume.
+        */
+        std::mutex m_Lock;
+    };
+} // namespace
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace earlyapp
+{
+    /**
+      @brief Binary snapshot of a parsed configuration.
+
+      The snapshot is written by "earlyapp --compile-config <arguments>" and
+      read back by a start with the same arguments, skipping the option parsing.
+      A snapshot is stale, and ignored, when the arguments, the format version
+      or the executable changed since it was written.
+     */
+    class ConfigSnapshot
+    {
+    public:
+        /**
+          @brief Value types of the snapshot entries.
+         */
+        enum eValueType
+        {
+            VALUE_STRING = 1,
+            VALUE_INT,
+            VALUE_UINT,
+            VALUE_BOOL
+        };
+
+        /**
+          @brief A configuration value.
+         */
+        struct Value
+        {
+            std::string key;
+            eValueType type;
+            std::string str;    // VALUE_STRING
+            uint32_t num;       // VALUE_INT, VALUE_UINT and VALUE_BOOL
+        };
+
+        /**
+          @brief File identification and format version.
+         */
+        static const uint32_t MAGIC;
+        static const uint16_t VERSION;
+
+        /**
+          @brief Largest accepted snapshot file.
+         */
+        static const uint32_t MAX_SIZE;
+
+        /**
+          @brief Returns the hash of the arguments, skipping the ones equal to skip.
+         */
+        static uint64_t hashArguments(int argc, char** argv, const char* skip);
+
+        /**
+          @brief Returns the snapshot path for the argument hash.
+         */
+        static std::string pathOf(uint64_t argsHash);
+
+        /**
+          @brief Maps, validates and reads a snapshot.
+          @return false if the snapshot is missing, stale or corrupted.
+         */
+        static bool load(const std::string& path, uint64_t argsHash, std::vector<Value>& values);
+
+        /**
+          @brief Writes a snapshot, replacing the previous one atomically.
+          @return true when succeed.
+         */
+        static bool store(const std::string& path, uint64_t argsHash, const std::vector<Value>& values);
+
+    private:
+        /**
+          @brief File header. Multi byte fields are in the host byte order.
+         */
+        struct Header
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t count;     // number of entries
+            uint32_t size;      // file size with the header
+            uint32_t checksum;  // FNV-1a of the entries
+            uint64_t argsHash;
+            uint64_t exeSize;   // executable identity
+            uint64_t exeMtime;
+        };
+
+        /**
+          @brief Entry header, followed by the key and the value bytes.
+         */
+        struct Entry
+        {
+            uint8_t type;
+            uint8_t keyLength;
+            uint16_t valueLength;
+        };
+
+        /**
+          @brief Reads the size and modification time of the running executable.
+         */
+        static bool exeIdentity(uint64_t& size, uint64_t& mtime);
+
+        /**
+          @brief FNV-1a hash.
+         */
+        static uint32_t checksum(const uint8_t* data, size_t length);
+    };
+} // namespace
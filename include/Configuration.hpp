@@ -27,8 +27,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <boost/program_options.hpp>
 
+#include "ConfigSnapshot.hpp"
+
 
 namespace earlyapp
 {
@@ -59,9 +62,25 @@ namespace earlyapp
         static const unsigned int DEFAULT_DISPLAY_HEIGHT;
         static const int DEFAULT_GPIONUMBER;
         static const useconds_t DEFAULT_GPIOSUSTAIN;
+        static const char* DEFAULT_GPIOLINE;
+        static const char* DEFAULT_KPI_SINKS;
+        static const char* DEFAULT_KPI_GPIO;
+        static const char* DEFAULT_LOG_SINKS;
+        static const char* DEFAULT_LOG_FILE;
         static const bool DEFAULT_USE_GSTREAMER;
 	static const bool DEFAULT_USE_CSICAM;
         static const char* DEFAULT_GSTCAMCMD;
+        static const char* DEFAULT_CAMERA_DEINTERLACE;
+        static const char* DEFAULT_CAMERA_RENDER;
+        static const char* DEFAULT_CAMERA_CAPTURE;
+        static const bool DEFAULT_CAMERA_CONVERT_BENCHMARK;
+        static const char* DEFAULT_VIDEO_PRESENTMODE;
+        static const unsigned int DEFAULT_VIDEO_PRESENTQUEUE;
+        static const unsigned int DEFAULT_VIDEO_MAXFPS;
+        static const char* DEFAULT_VIDEO_PACING;
+        static const char* DEFAULT_VIDEO_MODE;
+        static const char* DEFAULT_VIDEO_MEMORY;
+        static const char* DEFAULT_VIDEO_DUMPPATH;
 
 
         /*
@@ -78,9 +97,26 @@ namespace earlyapp
         static const char* KEY_DISPLAYHEIGHT;
         static const char* KEY_GPIONUMBER;
         static const char* KEY_GPIOSUSTAIN;
+        static const char* KEY_GPIOLINE;
+        static const char* KEY_KPISINKS;
+        static const char* KEY_KPIGPIO;
+        static const char* KEY_LOGSINKS;
+        static const char* KEY_LOGFILE;
         static const char* KEY_USEGSTREAMER;
 	static const char* KEY_USECSICAM;
         static const char* KEY_GSTCAMCMD;
+        static const char* KEY_CAMERADEINTERLACE;
+        static const char* KEY_CAMERARENDER;
+        static const char* KEY_CAMERACAPTURE;
+        static const char* KEY_CAMERACONVERTBENCHMARK;
+        static const char* KEY_VIDEOPRESENTMODE;
+        static const char* KEY_VIDEOPRESENTQUEUE;
+        static const char* KEY_VIDEOMAXFPS;
+        static const char* KEY_VIDEOPACING;
+        static const char* KEY_VIDEOMODE;
+        static const char* KEY_VIDEOMEMORY;
+        static const char* KEY_VIDEODUMPPATH;
+        static const char* KEY_COMPILECONFIG;
 
 
         /**
@@ -95,6 +131,7 @@ namespace earlyapp
 
         /*
           @brief Creates and return a Configuration class object with given parameters.
+          Reads the configuration snapshot of the same parameters when there is one.
         */
         static std::shared_ptr<Configuration> makeConfiguration(int argc, char** argv);
 
@@ -104,6 +141,17 @@ namespace earlyapp
          */
         bool isValid(void);
 
+        /**
+           @brief Returns whether user asked to write a configuration snapshot and exit.
+         */
+        bool compileConfig(void) const;
+
+        /**
+           @brief Writes the configuration snapshot for the given parameters.
+           @return true when succeed.
+         */
+        bool writeSnapshot(int argc, char** argv);
+
         /**
           @brief Print usage.
          */
@@ -169,6 +217,31 @@ namespace earlyapp
          */
         unsigned int gpioSustain(void) const;
 
+        /**
+          @brief Returns user set output GPIO line as chip:offset, empty when not set.
+         */
+        const std::string& gpioLine(void);
+
+        /**
+           @brief Returns comma separated KPI marker sinks, "gpio", "kmsg" and "trace".
+         */
+        const std::string& kpiSinks(void);
+
+        /**
+           @brief Returns comma separated class=number GPIO lines of the KPI marker classes.
+         */
+        const std::string& kpiGpio(void);
+
+        /**
+           @brief Returns comma separated log sinks, "stdout", "kmsg" and "file".
+         */
+        const std::string& logSinks(void);
+
+        /**
+           @brief Returns the file of the file log sink.
+         */
+        const std::string& logFile(void);
+
         /**
            @brief Returns whether user asked to use GStreamer.
         */
@@ -185,6 +258,62 @@ namespace earlyapp
          */
         const std::string& gstCamCmd(void);
 
+        /**
+           @brief Returns camera deinterlacing mode, "none", "weave", "bob" or "motion".
+         */
+        const std::string& cameraDeinterlace(void);
+
+        /**
+           @brief Returns camera renderer, "gl" or "shm" (CPU conversion into wl_shm buffers).
+         */
+        const std::string& cameraRender(void);
+
+        /**
+           @brief Returns camera capture source, "ipu", "fake" (test pattern without camera hardware)
+                  or "fake-faults" (test pattern with injected capture errors).
+         */
+        const std::string& cameraCapture(void);
+
+        /**
+           @brief Returns true to benchmark the CPU camera frame conversion and exit.
+         */
+        bool cameraConvertBenchmark(void) const;
+
+        /**
+           @brief Returns video presentation mode, "fifo" or "mailbox".
+         */
+        const std::string& videoPresentMode(void);
+
+        /**
+           @brief Returns number of video frames queued ahead of the compositor.
+         */
+        unsigned int videoPresentQueue(void) const;
+
+        /**
+           @brief Returns video rendering frame rate limit, 0 for no limit.
+         */
+        unsigned int videoMaxFPS(void) const;
+
+        /**
+           @brief Returns policy for late video frames, "catch-up" or "drop".
+         */
+        const std::string& videoPacing(void);
+
+        /**
+           @brief Returns video decoding mode, "render", "null", "performance" or "dump".
+         */
+        const std::string& videoMode(void);
+
+        /**
+           @brief Returns video decoder surface memory, "video" or "system".
+         */
+        const std::string& videoMemory(void);
+
+        /**
+           @brief Returns output file path for the dump video mode.
+         */
+        const std::string& videoDumpPath(void);
+
         /**
            @brief Disable copy assigned operators.
         */
@@ -203,11 +332,21 @@ namespace earlyapp
          */
         boost::program_options::variables_map m_VM;
 
+        /**
+          @brief Option values, from the variables_map or a snapshot.
+         */
+        std::vector<ConfigSnapshot::Value> m_Values;
+
         /**
           @brief Is configuration valid.
          */
         bool m_Valid = false;
 
+        /**
+          @brief Write a snapshot and exit.
+         */
+        bool m_CompileConfig = false;
+
         /**
           @brief Initialize and return program options.
           @return True when succeed.
@@ -215,9 +354,28 @@ namespace earlyapp
         bool initProgramOptions(int argc, char** argv);
 
         /**
-          @brief Returns mapped value from the variables_map m_VM.
+          @brief Reads the snapshot of the parameters.
+          @return True when succeed.
+         */
+        bool loadSnapshot(int argc, char** argv);
+
+        /**
+          @brief Copies the option values of the variables_map m_VM.
          */
-        const std::string& stringMappedValueOf(const char* key);
+        void mapValues(void);
+
+        /**
+          @brief Returns the value of the key, nullptr for unknown keys or other types.
+         */
+        const ConfigSnapshot::Value* valueOf(const char* key, ConfigSnapshot::eValueType type) const;
+
+        /**
+          @brief Returns mapped values of the key.
+         */
+        const std::string& stringMappedValueOf(const char* key) const;
+        int intMappedValueOf(const char* key) const;
+        unsigned int uintMappedValueOf(const char* key) const;
+        bool boolMappedValueOf(const char* key) const;
 
         /**
           @brief Camera option checker.
@@ -225,6 +383,72 @@ namespace earlyapp
          */
         static void checkCameraParameter(std::string optStr);
 
+        /**
+          @brief Deinterlacing mode option checker.
+          Raises exception for not suppored deinterlacing modes.
+         */
+        static void checkDeinterlaceParameter(std::string optStr);
+
+        /**
+          @brief Camera renderer option checker.
+          Raises exception for not suppored camera renderers.
+         */
+        static void checkCameraRenderParameter(std::string optStr);
+
+        /**
+          @brief KPI sinks option checker.
+          Raises exception for not suppored KPI sinks.
+         */
+        static void checkKpiSinksParameter(std::string optStr);
+
+        /**
+          @brief KPI GPIO lines option checker.
+          Raises exception for malformed class=number entries.
+         */
+        static void checkKpiGpioParameter(std::string optStr);
+
+        /**
+          @brief GPIO line option checker.
+          Raises exception for lines not given as chip:offset.
+         */
+        static void checkGpioLineParameter(std::string optStr);
+
+        /**
+          @brief Log sinks option checker.
+          Raises exception for not suppored log sinks.
+         */
+        static void checkLogSinksParameter(std::string optStr);
+
+        /**
+          @brief Camera capture option checker.
+          Raises exception for not suppored capture sources.
+         */
+        static void checkCameraCaptureParameter(std::string optStr);
+
+        /**
+          @brief Presentation mode option checker.
+          Raises exception for not suppored presentation modes.
+         */
+        static void checkPresentModeParameter(std::string optStr);
+
+        /**
+          @brief Pacing policy option checker.
+          Raises exception for not suppored pacing policies.
+         */
+        static void checkPacingParameter(std::string optStr);
+
+        /**
+          @brief Video mode option checker.
+          Raises exception for not suppored video modes.
+         */
+        static void checkVideoModeParameter(std::string optStr);
+
+        /**
+          @brief Video memory option checker.
+          Raises exception for not suppored memory types.
+         */
+        static void checkVideoMemoryParameter(std::string optStr);
+
         /**
            @brief Default exception handler for option parsing.
          */
@@ -35,6 +35,7 @@ extern "C" {
 #endif
 
 #include "csi_common.h"
+#include "CaptureSession.h"
 
 #ifdef __cplusplus
 }
@@ -103,9 +104,12 @@ namespace earlyapp
         boost::thread_group* m_pThreadGrpCsiRVC = nullptr;
         boost::thread* m_pThreadCsiRVC = nullptr;
 
-        static void displayCamera(set_up, void*);
+        static void displayCamera(set_up);
 
-        void* m_pGPIOClass = NULL;
+        /*
+          Capture session the frames come from.
+         */
+        void* m_pCapture = NULL;
 
         /**
            @brief Default camera width, height.
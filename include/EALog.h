@@ -26,52 +26,75 @@
 
 #pragma once
 
+/*
+  Log levels, for EALOG_LEVEL. Calls below EALOG_LEVEL are compiled out.
+ */
+#define EALOG_LEVEL_DEBUG 0
+#define EALOG_LEVEL_INFO 1
+#define EALOG_LEVEL_WARNING 2
+#define EALOG_LEVEL_ERROR 3
+#define EALOG_LEVEL_NONE 4
+
+#ifndef EALOG_LEVEL
+#define EALOG_LEVEL EALOG_LEVEL_INFO
+#endif
+
 #ifdef USE_LOGOUTPUT
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
+#include "Logger.hpp"
 
-// Informative logs.
-#define LINF_(tag, str) \
-    BOOST_LOG_TRIVIAL(info) \
-    << "[" << tag << "] " \
-    << str
+// Stores the streamed arguments into the log ring of the thread,
+// they are formatted and written by the log drain thread.
+#define EALOG_(level, tag, str) \
+    do \
+    { \
+        earlyapp::LogRecord ealogRecord_(level, tag); \
+        if(ealogRecord_) \
+        { \
+            ealogRecord_ << str; \
+        } \
+    } while(0)
+
+#else
+#undef EALOG_LEVEL
+#define EALOG_LEVEL EALOG_LEVEL_NONE
+#endif // USE_LOGOUTPUT
 
 // Debug logs.
-#define LDBG_(tag, str) \
-    BOOST_LOG_TRIVIAL(debug) \
-    << "[" << tag << "] " \
-    << str
+#if EALOG_LEVEL <= EALOG_LEVEL_DEBUG
+#define LDBG_(tag, str) EALOG_(earlyapp::LOG_DEBUG, tag, str)
+#else
+#define LDBG_(tag, str)
+#endif
+
+// Informative logs.
+#if EALOG_LEVEL <= EALOG_LEVEL_INFO
+#define LINF_(tag, str) EALOG_(earlyapp::LOG_INFO, tag, str)
+#else
+#define LINF_(tag, str)
+#endif
 
 // Warning logs.
-#define LWRN_(tag, str) \
-    BOOST_LOG_TRIVIAL(warning) \
-    << "[" << tag << "] " \
-    << str
+#if EALOG_LEVEL <= EALOG_LEVEL_WARNING
+#define LWRN_(tag, str) EALOG_(earlyapp::LOG_WARNING, tag, str)
+#else
+#define LWRN_(tag, str)
+#endif
 
 // Error logs.
-#define LERR_(tag, str) \
-    BOOST_LOG_TRIVIAL(error) \
-    << "[" << tag << "] " \
-    << str
-
+#if EALOG_LEVEL <= EALOG_LEVEL_ERROR
+#define LERR_(tag, str) EALOG_(earlyapp::LOG_ERROR, tag, str)
 #else
-// No log output
-#define LINF_(tag, str)
-#define LDBG_(tag, str)
-#define LWRN_(tag, str)
 #define LERR_(tag, str)
-
-#endif // USE_LOGOUTPUT
+#endif
 
 #ifdef USE_DMESGLOG
 //Init demsg log
 int dmesgLogInit(void);
 
-//Log message to dmesg log
+//Log message to dmesg log, written by the log drain thread
 int dmesgLogPrint(const char*);
 
 //Close demsg log
 int dmesgLogClose(void);
 
 #endif
-
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+#include "CaptureBackend.hpp"
+
+namespace earlyapp
+{
+    /**
+      @brief Test source paced by a timer, no camera hardware needed.
+
+      Paints a moving pattern into queued buffers at the nominal rate,
+      alternating top and bottom fields when configured interlaced, so the
+      capture loops and renderers can run on machines without an IPU.
+
+      With a fault interval the source fails like an IPU losing its input:
+      every interval frames dequeue reports CAPTURE_ERROR until the stream
+      is switched off, and the next stream on attempts fail before one
+      succeeds, so every step of the error recovery runs. Tests inject
+      each kind of fault with injectFault().
+     */
+    class FakeCaptureBackend: public CaptureBackend
+    {
+    public:
+        /**
+           @brief Frames between injected faults of the "fake-faults" source.
+        */
+        static const unsigned int FAULT_INTERVAL = 300;
+
+        /**
+           @brief Faults of the source.
+        */
+        enum Fault
+        {
+            FAULT_NONE,
+            FAULT_DEQUEUE_ERROR,    //!< dequeue fails until stream off, stream on fails twice
+            FAULT_STALL,            //!< no frames until the next stream on
+            FAULT_DEVICE_LOST       //!< dequeue and stream on fail until the device is reopened
+        };
+
+        /**
+           @brief Constructor.
+           @param faultInterval Frames between injected faults, 0 for none.
+        */
+        explicit FakeCaptureBackend(unsigned int faultInterval = 0)
+            : m_FaultInterval(faultInterval), m_NextFault(faultInterval) { }
+
+        virtual ~FakeCaptureBackend(void) { close(); }
+
+        const char* name(void) const { return m_FaultInterval ? "fake-faults" : "fake"; }
+        bool hardware(void) const { return false; }
+        bool open(const capture_config& config);
+        bool configure(const capture_config& config, capture_format& format);
+        bool queue(const capture_buffer& buffer);
+        int dequeue(capture_frame& frame);
+        bool streamOn(void);
+        bool streamOff(void);
+        void close(void);
+        int pollFd(void) const { return m_TimerFd; }
+
+        /**
+           @brief Make the source fail from the next frame on.
+        */
+        void injectFault(Fault fault);
+
+        /**
+           @brief Stream on attempts failing after a dequeue error.
+        */
+        static const unsigned int FAULT_FAILED_RESUMES = 2;
+
+    private:
+        /**
+           @brief Fill a buffer with the pattern of the current frame.
+        */
+        void paint(const capture_buffer& buffer);
+
+        /**
+           @brief Frames (or fields) per second produced.
+        */
+        static const unsigned int FRAME_RATE = 30;
+        static const unsigned int FIELD_RATE = 50;
+
+        int m_TimerFd = -1;
+        capture_format m_Format;
+        bool m_Interlaced = false;
+        uint32_t m_Sequence = 0;
+        bool m_Bottom = false;
+        std::deque<capture_buffer> m_Queued;
+
+        unsigned int m_FaultInterval;
+        uint32_t m_NextFault;
+        Fault m_Fault = FAULT_NONE;
+        unsigned int m_FailedResumes = 0;
+
+        /**
+           @brief Buffers are queued by the renderer and dequeued by the capture thread.
+        */
+        std::mutex m_Lock;
+    };
+} // namespace
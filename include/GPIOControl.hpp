@@ -27,7 +27,10 @@
 #pragma once
 
 #include <unistd.h>
+#include <stdint.h>
+#include <atomic>
 #include <string>
+#include <thread>
 
 #include "Configuration.hpp"
 
@@ -35,6 +38,13 @@ namespace earlyapp
 {
     /**
        @brief Controls given GPIO number with user set values.
+
+       The line is requested once through the GPIO character device, pulses
+       are then lowered by a timer thread so that the caller only pays for
+       raising the line. A line is given by chip and offset, or by its global
+       GPIO number which is then looked up. Without the character device the
+       sysfs interface is used for GPIO numbers, and pulses block the caller
+       for the sustaining time.
      */
     class GPIOControl
     {
@@ -48,6 +58,20 @@ namespace earlyapp
             HIGH = 1
         };
 
+        /**
+          @brief An output edge, as recorded for KPI measurements.
+         */
+        struct Edge
+        {
+            uint64_t timeNs;    // CLOCK_BOOTTIME
+            eGPIOValue value;
+        };
+
+        /**
+          @brief Number of edges recorded, later ones are dropped.
+         */
+        static const unsigned int MAX_EDGES = 64;
+
         /**
           @brief Constructor.
           @param gpioNumber GPIO number to control.
@@ -57,6 +81,22 @@ namespace earlyapp
             int gpioNumber = Configuration::NOT_SET,
             unsigned int peakSustainTime = Configuration::DEFAULT_GPIOSUSTAIN);
 
+        /**
+          @brief Constructor for a character device line.
+          @param chip Chip name, e.g. "gpiochip0", or device path.
+          @param offset Line offset on the chip.
+          @param sustainTime GPIO peak sustaining time in ms.
+        */
+        GPIOControl(
+            const std::string& chip,
+            unsigned int offset,
+            unsigned int peakSustainTime = Configuration::DEFAULT_GPIOSUSTAIN);
+
+        /**
+          @brief Destructor, lowers a pending pulse and logs the recorded edges.
+        */
+        ~GPIOControl(void);
+
         /**
            @brief Ouput GPIO with given value.
            @param hightLow Set the GPIO with HIGH or LOW.
@@ -74,6 +114,17 @@ namespace earlyapp
          */
         void outputPattern(void);
 
+        /**
+           @brief Number of recorded edges.
+         */
+        unsigned int edgeCount(void) const;
+
+        /**
+           @brief Recorded edge.
+           @param index Edge index, below edgeCount().
+         */
+        const Edge& edge(unsigned int index) const;
+
         /**
           @brief GPIO export path.
           @return Corresponding GPIO export path.
@@ -103,11 +154,81 @@ namespace earlyapp
          */
         int m_GPIONumber = -1;
 
+        /**
+           @brief Chip and line offset, when given instead of the GPIO number.
+         */
+        std::string m_Chip;
+        unsigned int m_Offset = 0;
+
+        /**
+           @brief Line name for the logs.
+         */
+        std::string m_Name;
+
         /**
           @brief GPIO sustaining time in ms.
          */
         unsigned int m_SustainTime = 0;
 
+        /**
+          @brief Character device line handle, -1 for sysfs.
+         */
+        int m_LineFd = -1;
+
+        /**
+          @brief Timer lowering the line at the end of a pulse.
+         */
+        int m_TimerFd = -1;
+
+        /**
+          @brief Event stopping the pulse thread.
+         */
+        int m_StopFd = -1;
+
+        /**
+          @brief Thread lowering the line when the timer expires.
+         */
+        std::thread m_PulseThread;
+
+        /**
+          @brief Recorded edges.
+         */
+        Edge m_Edges[MAX_EDGES];
+        std::atomic<unsigned int> m_EdgeCount{0};
+
+        /**
+          @brief Requests the line through the GPIO character device.
+          @return true for success, false when only sysfs can be used.
+         */
+        bool openLine(void);
+
+        /**
+          @brief Finds the chip and line offset of a global GPIO number.
+          @return true when found.
+         */
+        static bool findLine(int gpioNumber, std::string& chip, unsigned int& offset);
+
+        /**
+          @brief Starts the thread ending the pulses.
+          @return true for success.
+         */
+        bool startPulseThread(void);
+
+        /**
+          @brief Pulse thread.
+         */
+        void pulseLoop(void);
+
+        /**
+          @brief Ouput GPIO through sysfs.
+         */
+        bool outputSysfs(eGPIOValue highLow);
+
+        /**
+          @brief Record an output edge.
+         */
+        void recordEdge(eGPIOValue highLow);
+
         /**
           @brief Hidden default constructor.
         */
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CaptureBackend.hpp"
+
+namespace earlyapp
+{
+    /**
+      @brief Capture from an ICI stream device, used by the ICI camera.
+     */
+    class IciCaptureBackend: public CaptureBackend
+    {
+    public:
+        virtual ~IciCaptureBackend(void) { close(); }
+
+        const char* name(void) const { return "IPU"; }
+        bool open(const capture_config& config);
+        bool configure(const capture_config& config, capture_format& format);
+        bool queue(const capture_buffer& buffer);
+        int dequeue(capture_frame& frame);
+        bool streamOn(void);
+        bool streamOff(void);
+        void close(void);
+        int pollFd(void) const { return m_Fd; }
+
+    private:
+        int m_Fd = -1;
+        int m_MemType = 0;
+        bool m_Interlaced = false;
+    };
+} // namespace
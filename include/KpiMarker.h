@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * KPI markers.
+ *
+ * Marks the named KPI point, e.g. KPI_MARK("rvc_first_frame"), with the
+ * CLOCK_BOOTTIME time of the call. Only the first mark of a name in a boot
+ * reaches the sinks; the part of the name before the first '_' is its
+ * class, which selects the GPIO line.
+ *
+ * A call site marks only on its first call in the process, so its name
+ * must not vary. Later calls, e.g. on per-frame paths, cost a relaxed load
+ * and no lock, allocation or system call.
+ */
+#define KPI_MARK(name) \
+	do { \
+		static int kpi_marked_; \
+		if (!__atomic_load_n(&kpi_marked_, __ATOMIC_RELAXED) && \
+		    !__atomic_exchange_n(&kpi_marked_, 1, __ATOMIC_RELAXED)) \
+			KpiMarker_mark(name); \
+	} while (0)
+
+void KpiMarker_mark(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Configuration.hpp"
+#include "GPIOControl.hpp"
+#include "KpiMarker.h"
+
+namespace earlyapp
+{
+    /**
+      @brief A KPI mark.
+     */
+    struct KpiEvent
+    {
+        const char* name;
+        uint64_t timeNs;    // CLOCK_BOOTTIME at the call site
+    };
+
+    /**
+      @brief Receives the KPI marks.
+     */
+    class KpiSink
+    {
+    public:
+        virtual ~KpiSink(void) = default;
+
+        /**
+          @brief Outputs a mark. Called once per name and boot, without
+                 the registry lock, so marks of several threads can overlap.
+         */
+        virtual void mark(const KpiEvent& ev) = 0;
+
+        /**
+          @brief Whether the output carries the mark time, so marks made
+                 before the sink existed can still be output.
+         */
+        virtual bool timestamped(void) const { return true; }
+    };
+
+    /**
+      @brief Pulses a GPIO line per marker class.
+     */
+    class KpiGpioSink: public KpiSink
+    {
+    public:
+        /**
+          @brief Constructor.
+          @param classLines Comma separated class=line list, e.g. "rvc=12,video=gpiochip0:13".
+          @param defaultLine Line of the other classes, empty for none.
+          @param sustainTime GPIO peak sustaining time in ms.
+
+          A line is a global GPIO number or a chip:offset character device line.
+         */
+        KpiGpioSink(const std::string& classLines, const std::string& defaultLine, unsigned int sustainTime);
+
+        void mark(const KpiEvent& ev) override;
+
+        /**
+          @brief A pulse is only meaningful at the time of the mark.
+         */
+        bool timestamped(void) const override { return false; }
+
+    private:
+        /**
+          @brief GPIO controls by line, a line is requested only once.
+         */
+        std::map<std::string, std::unique_ptr<GPIOControl>> m_Lines;
+
+        /**
+          @brief Line of each marker class.
+         */
+        std::map<std::string, std::string> m_Classes;
+
+        /**
+          @brief Line of unlisted classes.
+         */
+        std::string m_DefaultLine;
+
+        /**
+          @brief Returns the GPIO control for the line, opening it on first use.
+         */
+        GPIOControl* line(const std::string& gpioLine, unsigned int sustainTime);
+    };
+
+    /**
+      @brief Writes a line per mark to the kernel log.
+     */
+    class KpiKmsgSink: public KpiSink
+    {
+    public:
+        KpiKmsgSink(void);
+        ~KpiKmsgSink(void);
+
+        void mark(const KpiEvent& ev) override;
+
+    private:
+        int m_Fd = -1;
+    };
+
+    /**
+      @brief Writes a line per mark to the ftrace ring buffer.
+     */
+    class KpiTraceSink: public KpiSink
+    {
+    public:
+        KpiTraceSink(void);
+        ~KpiTraceSink(void);
+
+        void mark(const KpiEvent& ev) override;
+
+    private:
+        int m_Fd = -1;
+    };
+
+    /**
+      @brief KPI marker registry, dispatching the first mark of each name to the sinks.
+     */
+    class KpiMarker
+    {
+    public:
+        /**
+          @brief Returns the process wide registry.
+         */
+        static KpiMarker& getInstance(void);
+
+        /**
+          @brief Creates the sinks chosen by the configuration.
+          Marks made before are output to the timestamped sinks.
+         */
+        void setup(std::shared_ptr<Configuration> pConf);
+
+        /**
+          @brief Adds a sink, the registry takes its ownership.
+         */
+        void addSink(KpiSink* pSink);
+
+        /**
+          @brief Marks a KPI point.
+          @param name Marker name.
+          @param timeNs CLOCK_BOOTTIME of the mark.
+          @return true if this was the first mark of the name in this boot.
+         */
+        bool mark(const char* name, uint64_t timeNs);
+
+        /**
+          @brief Releases the sinks and their GPIO lines, sinks still
+                 outputting a mark are released when done.
+         */
+        void release(void);
+
+        /**
+          @brief Disable copy assigned operators.
+        */
+        KpiMarker& operator=(const KpiMarker&) = delete;
+        KpiMarker(const KpiMarker&) = delete;
+
+    private:
+        KpiMarker(void);
+
+        /**
+          @brief Claims the name for this boot.
+          @return false if the name was already marked.
+         */
+        bool claim(const char* name);
+
+        std::mutex m_Lock;
+
+        /**
+          @brief Sinks.
+         */
+        std::vector<std::shared_ptr<KpiSink>> m_Sinks;
+
+        /**
+          @brief Names marked by this process.
+         */
+        std::set<std::string> m_Marked;
+
+        /**
+          @brief Per boot marker directory could be used.
+         */
+        bool m_BootState = true;
+
+        /**
+          @brief Sinks have been set up.
+         */
+        bool m_SetUp = false;
+
+        /**
+          @brief Marks made before the sinks were set up.
+         */
+        std::vector<KpiEvent> m_Early;
+    };
+} // namespace
@@ -0,0 +1,510 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <condition_variable>
+#include <ios>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+namespace earlyapp
+{
+    /**
+      @brief Log levels.
+     */
+    enum eLogLevel
+    {
+        LOG_DEBUG = 0,
+        LOG_INFO,
+        LOG_WARNING,
+        LOG_ERROR
+    };
+
+    /**
+      @brief Ring of fixed size log records with a single producer thread.
+
+      Arguments are stored in binary, the drain thread formats them.
+     */
+    class LogRing
+    {
+    public:
+        /**
+          @brief Record size and count.
+         */
+        static const unsigned int RECORD_SIZE = 512;
+        static const unsigned int RECORDS = 128;
+
+        /**
+          @brief Record flags.
+         */
+        enum eRecordFlags
+        {
+            FLAG_KMSG = 1,          // Always written to the kernel log.
+            FLAG_TRUNCATED = 2      // Arguments did not fit.
+        };
+
+        /**
+          @brief Argument types of the record payload.
+         */
+        enum eArgType
+        {
+            ARG_STRING = 0,         // uint16_t length, characters
+            ARG_CHAR,
+            ARG_INT,                // int64_t
+            ARG_UINT,               // uint64_t
+            ARG_DOUBLE,
+            ARG_POINTER,
+            ARG_HEX,                // Following integers in hex.
+            ARG_DEC                 // Following integers in decimal.
+        };
+
+        /**
+          @brief A log record.
+         */
+        struct Record
+        {
+            uint64_t timeNs;        // CLOCK_BOOTTIME
+            const char* tag;
+            uint16_t size;          // Used payload bytes.
+            uint8_t level;
+            uint8_t flags;
+            uint8_t payload[RECORD_SIZE - 24];
+        };
+
+        /**
+          @brief Returns the next free record, nullptr when the ring is full.
+         */
+        Record* reserve(void)
+        {
+            uint32_t head = m_Head.load(std::memory_order_relaxed);
+            if(head - m_Tail.load(std::memory_order_acquire) >= RECORDS)
+            {
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &m_Records[head % RECORDS];
+        }
+
+        /**
+          @brief Hands the reserved record to the drain thread.
+         */
+        void publish(void)
+        {
+            m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+          @brief Oldest record, nullptr when empty. Drain thread only.
+         */
+        const Record* front(void) const
+        {
+            uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+            if(tail == m_Head.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return &m_Records[tail % RECORDS];
+        }
+
+        /**
+          @brief Releases the oldest record. Drain thread only.
+         */
+        void pop(void)
+        {
+            m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+          @brief Producer position, on its own cache line.
+         */
+        std::atomic<uint32_t> m_Head{0};
+        char m_HeadPad[64 - sizeof(std::atomic<uint32_t>)];
+
+        /**
+          @brief Drain position.
+         */
+        std::atomic<uint32_t> m_Tail{0};
+        char m_TailPad[64 - sizeof(std::atomic<uint32_t>)];
+
+        /**
+          @brief Records dropped for a full ring, and how many were reported.
+         */
+        std::atomic<uint32_t> m_Dropped{0};
+        uint32_t m_ReportedDrops = 0;
+
+        /**
+          @brief The thread has exited, the ring is freed once drained.
+         */
+        std::atomic<bool> m_Closed{false};
+
+        /**
+          @brief Next ring of the logger.
+         */
+        LogRing* m_pNext = nullptr;
+
+        Record m_Records[RECORDS];
+    };
+
+
+    /**
+      @brief Builds a log record in place in the ring of the calling thread.
+
+      Costs a clock read and copying the arguments; never blocks.
+      The record is dropped when the ring is full.
+     */
+    class LogRecord
+    {
+    public:
+        LogRecord(eLogLevel level, const char* tag, unsigned int flags = 0);
+
+        ~LogRecord(void)
+        {
+            if(m_pRecord != nullptr)
+            {
+                commit();
+            }
+        }
+
+        /**
+          @brief Is there a record to write to?
+         */
+        explicit operator bool(void) const
+        {
+            return m_pRecord != nullptr;
+        }
+
+        LogRecord& operator<<(const char* str)
+        {
+            putString(str ? str : "(null)", str ? strlen(str) : 6);
+            return *this;
+        }
+
+        LogRecord& operator<<(const std::string& str)
+        {
+            putString(str.data(), str.size());
+            return *this;
+        }
+
+        LogRecord& operator<<(char c)
+        {
+            put(LogRing::ARG_CHAR, &c, sizeof(c));
+            return *this;
+        }
+
+        LogRecord& operator<<(signed char c) { return *this << static_cast<char>(c); }
+        LogRecord& operator<<(unsigned char c) { return *this << static_cast<char>(c); }
+
+        LogRecord& operator<<(bool b) { return putInt(b ? 1 : 0); }
+        LogRecord& operator<<(short v) { return putInt(v); }
+        LogRecord& operator<<(int v) { return putInt(v); }
+        LogRecord& operator<<(long v) { return putInt(v); }
+        LogRecord& operator<<(long long v) { return putInt(v); }
+        LogRecord& operator<<(unsigned short v) { return putUInt(v); }
+        LogRecord& operator<<(unsigned int v) { return putUInt(v); }
+        LogRecord& operator<<(unsigned long v) { return putUInt(v); }
+        LogRecord& operator<<(unsigned long long v) { return putUInt(v); }
+
+        LogRecord& operator<<(double v)
+        {
+            put(LogRing::ARG_DOUBLE, &v, sizeof(v));
+            return *this;
+        }
+
+        LogRecord& operator<<(float v) { return *this << static_cast<double>(v); }
+
+        LogRecord& operator<<(const void* p)
+        {
+            put(LogRing::ARG_POINTER, &p, sizeof(p));
+            return *this;
+        }
+
+        /**
+          @brief std::hex and std::dec.
+         */
+        LogRecord& operator<<(std::ios_base& (*manip)(std::ios_base&))
+        {
+            if(manip == static_cast<std::ios_base& (*)(std::ios_base&)>(std::hex))
+            {
+                put(LogRing::ARG_HEX, nullptr, 0);
+            }
+            else if(manip == static_cast<std::ios_base& (*)(std::ios_base&)>(std::dec))
+            {
+                put(LogRing::ARG_DEC, nullptr, 0);
+            }
+            return *this;
+        }
+
+        /**
+          @brief Enumerations are logged as their values.
+         */
+        template<typename T>
+        typename std::enable_if<std::is_enum<T>::value, LogRecord&>::type operator<<(T v)
+        {
+            return putInt(static_cast<long long>(v));
+        }
+
+        LogRecord& operator=(const LogRecord&) = delete;
+        LogRecord(const LogRecord&) = delete;
+
+    private:
+        LogRing* m_pRing = nullptr;
+        LogRing::Record* m_pRecord = nullptr;
+
+        void put(uint8_t type, const void* data, size_t len)
+        {
+            size_t used = m_pRecord->size;
+            if(used + 1 + len > sizeof(m_pRecord->payload))
+            {
+                m_pRecord->flags |= LogRing::FLAG_TRUNCATED;
+                return;
+            }
+            m_pRecord->payload[used] = type;
+            if(len > 0)
+            {
+                memcpy(&m_pRecord->payload[used + 1], data, len);
+            }
+            m_pRecord->size = used + 1 + len;
+        }
+
+        void putString(const char* str, size_t len)
+        {
+            size_t used = m_pRecord->size;
+            size_t room = sizeof(m_pRecord->payload) - used;
+            if(room < 1 + sizeof(uint16_t) + 1)
+            {
+                m_pRecord->flags |= LogRing::FLAG_TRUNCATED;
+                return;
+            }
+            room -= 1 + sizeof(uint16_t);
+            if(len > room)
+            {
+                len = room;
+                m_pRecord->flags |= LogRing::FLAG_TRUNCATED;
+            }
+            uint16_t len16 = len;
+            m_pRecord->payload[used] = LogRing::ARG_STRING;
+            memcpy(&m_pRecord->payload[used + 1], &len16, sizeof(len16));
+            memcpy(&m_pRecord->payload[used + 1 + sizeof(len16)], str, len);
+            m_pRecord->size = used + 1 + sizeof(len16) + len;
+        }
+
+        LogRecord& putInt(long long v)
+        {
+            int64_t v64 = v;
+            put(LogRing::ARG_INT, &v64, sizeof(v64));
+            return *this;
+        }
+
+        LogRecord& putUInt(unsigned long long v)
+        {
+            uint64_t v64 = v;
+            put(LogRing::ARG_UINT, &v64, sizeof(v64));
+            return *this;
+        }
+
+        /**
+          @brief Publishes the record.
+         */
+        void commit(void);
+    };
+
+
+    /**
+      @brief Drains the log rings of all threads into the sinks from a background thread.
+     */
+    class Logger
+    {
+    public:
+        /**
+          @brief Sinks.
+         */
+        enum eSink
+        {
+            SINK_STDOUT = 1,
+            SINK_KMSG = 2,
+            SINK_FILE = 4
+        };
+
+        /**
+          @brief Drain interval in ms.
+         */
+        static const unsigned int DRAIN_INTERVAL = 10;
+
+        /**
+          @brief Returns the process wide logger.
+         */
+        static Logger& getInstance(void);
+
+        /**
+          @brief Selects the sinks.
+          @param sinks Comma separated "stdout", "kmsg" and "file".
+          @param filePath File of the file sink.
+          @return false if a sink could not be opened.
+         */
+        bool setSinks(const std::string& sinks, const std::string& filePath);
+
+        /**
+          @brief Opens the kernel log for FLAG_KMSG records.
+          @return true for success.
+         */
+        bool openKmsg(void);
+
+        /**
+          @brief Writes out the records logged so far, from the calling thread.
+         */
+        void flush(void);
+
+        /**
+          @brief Writes a record from the calling thread.
+         */
+        void writeRecord(const LogRing::Record& rec);
+
+        /**
+          @brief Returns the ring of the calling thread.
+         */
+        static LogRing* threadRing(void)
+        {
+            return t_pRing ? t_pRing : createThreadRing();
+        }
+
+        /**
+          @brief The drain thread has stopped at exit, records are written by the caller.
+         */
+        static std::atomic<bool> s_Stopped;
+
+        Logger& operator=(const Logger&) = delete;
+        Logger(const Logger&) = delete;
+
+    private:
+        Logger(void);
+
+        /**
+          @brief Ring of the thread.
+         */
+        static thread_local LogRing* t_pRing;
+
+        /**
+          @brief Creates the ring of the calling thread.
+         */
+        static LogRing* createThreadRing(void);
+
+        /**
+          @brief Adds a thread ring, starting the drain thread with the first one.
+         */
+        void addRing(LogRing* pRing);
+
+        /**
+          @brief Drain thread.
+         */
+        void drainLoop(void);
+
+        /**
+          @brief Writes out all rings. Called with m_DrainLock held.
+         */
+        void drainAll(void);
+
+        /**
+          @brief Formats and writes a record.
+         */
+        void output(const LogRing::Record& rec);
+
+        /**
+          @brief Writes the buffered stdout and file output.
+         */
+        void flushBuffer(void);
+
+        /**
+          @brief Stops the drain thread and drains, at exit.
+         */
+        static void shutdown(void);
+
+        std::mutex m_RingLock;
+        LogRing* m_pRings = nullptr;
+
+        std::mutex m_DrainLock;
+        std::condition_variable m_DrainCond;
+        bool m_DrainRequested = false;
+        std::thread m_Thread;
+        std::atomic<bool> m_Stop{false};
+
+        std::atomic<unsigned int> m_Sinks{SINK_STDOUT};
+        int m_KmsgFd = -1;
+        int m_FileFd = -1;
+
+        /**
+          @brief Buffered stdout and file output.
+         */
+        char m_Buffer[8192];
+        size_t m_Used = 0;
+    };
+
+
+    // Takes a record of the thread ring.
+    inline LogRecord::LogRecord(eLogLevel level, const char* tag, unsigned int flags)
+    {
+        m_pRing = Logger::threadRing();
+        m_pRecord = m_pRing ? m_pRing->reserve() : nullptr;
+        if(m_pRing == nullptr && Logger::s_Stopped.load(std::memory_order_acquire))
+        {
+            // Thread exiting after the logger, write it from here.
+            m_pRecord = new LogRing::Record;
+        }
+        if(m_pRecord != nullptr)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_BOOTTIME, &ts);
+            m_pRecord->timeNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+            m_pRecord->tag = tag;
+            m_pRecord->size = 0;
+            m_pRecord->level = level;
+            m_pRecord->flags = flags;
+        }
+    }
+
+    // Publish the record.
+    inline void LogRecord::commit(void)
+    {
+        if(m_pRing == nullptr)
+        {
+            Logger::getInstance().writeRecord(*m_pRecord);
+            delete m_pRecord;
+            return;
+        }
+        m_pRing->publish();
+        if(Logger::s_Stopped.load(std::memory_order_acquire))
+        {
+            Logger::getInstance().flush();
+        }
+    }
+} // namespace
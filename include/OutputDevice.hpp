@@ -29,7 +29,6 @@
 #include <string>
 
 #include "Configuration.hpp"
-#include "GPIOControl.hpp"
 
 namespace earlyapp
 {
@@ -101,11 +100,6 @@ namespace earlyapp
          */
         virtual ~OutputDevice(void);
 
-        /**
-          @brief GPIO output for KPI measurements.
-         */
-        void outputGPIOPattern(void);
-
         /**
            @brief Device name.
          */
@@ -119,11 +113,6 @@ namespace earlyapp
         OutputDevice(void) = default;
 
     protected:
-        /**
-          @brief GPIO control, nullptr if user didn't provide GPIO control option.
-        */
-        GPIOControl* m_pGPIOCtrl = nullptr;
-
         /**
            @brief Device name.
          */
@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <linux/videodev2.h>
+
+#include "CaptureBackend.hpp"
+
+namespace earlyapp
+{
+    /**
+      @brief Capture from a V4L2 video node, used by the CSI camera.
+     */
+    class V4L2CaptureBackend: public CaptureBackend
+    {
+    public:
+        virtual ~V4L2CaptureBackend(void) { close(); }
+
+        const char* name(void) const { return "IPU"; }
+        bool open(const capture_config& config);
+        bool configure(const capture_config& config, capture_format& format);
+        int exportBuffer(unsigned int index);
+        bool queue(const capture_buffer& buffer);
+        int dequeue(capture_frame& frame);
+        bool streamOn(void);
+        bool streamOff(void);
+        void close(void);
+        int pollFd(void) const { return m_Fd; }
+
+    private:
+        /**
+           @brief Is the buffer type multi-planar?
+        */
+        bool isMplane(void) const;
+
+        int m_Fd = -1;
+        enum v4l2_buf_type m_Type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        enum v4l2_memory m_Memory = V4L2_MEMORY_DMABUF;
+    };
+} // namespace
@@ -56,6 +56,7 @@ namespace earlyapp
 
         /**
            @brief Stop playback.
+           The decoder is kept so the next play() only rewinds it.
         */
         void stop(void);
 
@@ -85,6 +86,11 @@ namespace earlyapp
            Decoding input parameters.
          */
         sInputParams m_Params;
+
+        /**
+           Set once the pipeline has run, play() then restarts it.
+         */
+        bool m_bPlayed = false;
     };
 } // namespace
 
@@ -29,8 +29,8 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <poll.h>
-#include <boost/format.hpp>
 
 #include "EALog.h"
 #include "CBCEvent.hpp"
@@ -66,11 +66,7 @@ namespace earlyapp
             else
             {
                 m_bOpenSuccess = false;
-                LERR_(TAG,
-                      boost::str(
-                          boost::format("Failed to open device %s (%s)")
-                          % cbcDevice
-                          % strerror(errno)));
+                LERR_(TAG, "Failed to open device " << cbcDevice << " (" << strerror(errno) << ")");
             }
         }
     }
@@ -164,11 +160,7 @@ namespace earlyapp
             std::shared_ptr<CBCEvent> e = std::make_shared<CBCEvent>(cbcEv);
 
             LINF_(TAG, "Buffer: " << std::hex << cbcSignalBuffer[0] << cbcSignalBuffer[1] << cbcSignalBuffer[2] << cbcSignalBuffer[3] << cbcSignalBuffer[4] << cbcSignalBuffer[5]);
-            LINF_(TAG,
-                  boost::str(
-                      boost::format("Got an event %s:%d")
-                      %e->toString()
-                      %e->toEnum()));
+            LINF_(TAG, "Got an event " << e->toString() << ":" << e->toEnum());
 
             return e;
         }
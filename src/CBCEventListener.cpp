@@ -25,7 +25,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <set>
-#include <boost/format.hpp>
 #include <boost/thread.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -80,8 +79,8 @@ namespace earlyapp
         else
         {
             m_pEvDev = pEvDev;
-            LINF_(TAG, boost::str(
-                      boost::format("Device has changed from %x to %x") % pOldDev % pEvDev));
+            LINF_(TAG, "Device has changed from " << static_cast<const void*>(pOldDev)
+                  << " to " << static_cast<const void*>(pEvDev));
         }
         return pOldDev;
     }
@@ -99,8 +98,7 @@ namespace earlyapp
         // Failed to add due to duplicatation.
         if(! r.second)
         {
-            LWRN_(TAG, boost::str(
-                      boost::format("Subscriber %x has not been added.") % pSub));
+            LWRN_(TAG, "Subscriber " << static_cast<const void*>(pSub) << " has not been added.");
             return false;
         }
 
@@ -80,7 +80,17 @@ namespace earlyapp
 	m_ICIEnabled = 1;
         m_pConf = pConf;
 
-        m_ICIEnabled = ConfigureICI(false);
+        // A fake capture source needs no ICI pipeline. Error recovery is
+        // CSI only, the ICI camera takes fake-faults as a plain test pattern.
+        if(m_pConf->cameraCapture() != "ipu")
+        {
+            m_pCapture = CaptureSession_create("fake");
+        }
+        else
+        {
+            m_pCapture = CaptureSession_create("ici");
+            m_ICIEnabled = ConfigureICI(false);
+        }
         strcpy(m_iciParam.stream, "/dev/intel_stream27");
 
         // Set output width/height with user set values.
@@ -103,20 +113,18 @@ namespace earlyapp
         m_iciParam.buffer_count = 4;
         m_iciParam.port = 4;
         m_iciParam.fullscreen = 0;
-        m_iciParam.interlaced = 0;
+        if(deinterlace_mode_from_string(
+               m_pConf->cameraDeinterlace().c_str(), &m_iciParam.deinterlace) < 0)
+            m_iciParam.deinterlace = DEINTERLACE_NONE;
+        m_iciParam.interlaced = (m_iciParam.deinterlace != DEINTERLACE_NONE);
         m_iciParam.frames_count = 0;
         m_iciParam.stream_input = CVBS_INPUT;
         m_iciParam.mem_type = ICI_MEM_DMABUF;
+        m_iciParam.capture = m_pCapture;
         m_stream_id = 27;
 
         initWlConnection();
 
-        /* gpio creation */
-        if(m_pConf->gpioNumber() != m_pConf->NOT_SET)
-        {
-            m_pGPIOClass = GPIOControl_create(m_pConf->gpioNumber(), m_pConf->gpioSustain());
-        }
-
         LINF_(TAG, "Camerea intialized.");
     }
 
@@ -138,7 +146,7 @@ namespace earlyapp
 	m_pThreadGrpRVC = new(boost::thread_group);
 	m_pThreadRVC = m_pThreadGrpRVC->create_thread(
 			boost::bind(
-			&displayCamera, m_iciParam, m_stream_id, m_pGPIOClass));
+			&displayCamera, m_iciParam, m_stream_id));
     }
 
     /*
@@ -169,18 +177,20 @@ namespace earlyapp
     void CameraDevice::terminate(void)
     {
         LINF_(TAG, "CameraDevice terminate");
-        if(m_pGPIOClass)
+        if(m_pCapture)
         {
-            GPIOControl_release(m_pGPIOClass);
+            iciReleaseDisplay();
+            CaptureSession_release(m_pCapture);
+            m_pCapture = NULL;
         }
         disconnectWlConnection();
     }
 
-    void CameraDevice::displayCamera(setup m_iciParam, int stream_id, void *GPIOClass)
+    void CameraDevice::displayCamera(setup m_iciParam, int stream_id)
     {
         LINF_(TAG, "Display loop.");
 
-        iciStartDisplay(m_iciParam, stream_id, 1, GPIOClass, &m_ICIEnabled);
+        iciStartDisplay(m_iciParam, stream_id, 1, &m_ICIEnabled);
     }
 
 } // namespace
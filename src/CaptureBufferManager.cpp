@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <xf86drm.h>
+
+#include "EALog.h"
+#include "CaptureBufferManager.hpp"
+
+// Log tag.
+#define TAG "CAPTUREBUF"
+
+// GEM batch buffer size.
+#define BATCH_SIZE 0x80000
+
+
+namespace earlyapp
+{
+    // Destructor.
+    CaptureBufferManager::~CaptureBufferManager(void)
+    {
+        release();
+
+        if(m_pBufmgr != nullptr)
+            drm_intel_bufmgr_destroy(m_pBufmgr);
+        if(m_DrmFd >= 0)
+            drmClose(m_DrmFd);
+    }
+
+    // Open i915 once, buffers are reallocated on restarts.
+    bool CaptureBufferManager::initGem(void)
+    {
+        if(m_pBufmgr != nullptr)
+            return true;
+
+        m_DrmFd = drmOpen("i915", nullptr);
+        if(m_DrmFd < 0)
+        {
+            LERR_(TAG, "Cannot open i915");
+            return false;
+        }
+
+        // Opened before weston, master has to be released or weston won't initialize.
+        drmDropMaster(m_DrmFd);
+
+        m_pBufmgr = drm_intel_bufmgr_gem_init(m_DrmFd, BATCH_SIZE);
+        if(m_pBufmgr == nullptr)
+        {
+            LERR_(TAG, "Cannot create GEM buffer manager");
+            drmClose(m_DrmFd);
+            m_DrmFd = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    // Allocate a GEM buffer, export it and map it once.
+    bool CaptureBufferManager::createGem(capture_buffer& buffer, drm_intel_bo*& bo)
+    {
+        bo = drm_intel_bo_alloc_for_render(m_pBufmgr, "capture", buffer.size, 0);
+        if(bo == nullptr)
+        {
+            LERR_(TAG, "Cannot allocate GEM buffer " << buffer.index);
+            return false;
+        }
+
+        if(drm_intel_bo_gem_export_to_prime(bo, &buffer.dmabuf_fd) < 0)
+        {
+            LERR_(TAG, "Cannot export GEM buffer " << buffer.index << ": " << strerror(errno));
+            return false;
+        }
+
+        if(drm_intel_bo_map(bo, 1) != 0)
+        {
+            LERR_(TAG, "Cannot map GEM buffer " << buffer.index);
+            return false;
+        }
+        buffer.data = bo->virt;
+
+        return true;
+    }
+
+    // Import a driver buffer and map it once through the GTT.
+    bool CaptureBufferManager::importPrime(capture_buffer& buffer, drm_intel_bo*& bo)
+    {
+        bo = drm_intel_bo_gem_create_from_prime(m_pBufmgr, buffer.dmabuf_fd, (int) buffer.size);
+        if(bo == nullptr)
+        {
+            LERR_(TAG, "Cannot import buffer " << buffer.index);
+            return false;
+        }
+
+        if(drm_intel_gem_bo_map_gtt(bo) != 0)
+        {
+            LERR_(TAG, "Cannot map buffer " << buffer.index);
+            return false;
+        }
+        buffer.data = bo->virt;
+
+        return true;
+    }
+
+    // Allocate the buffers.
+    bool CaptureBufferManager::allocate(CaptureBackend& backend,
+                                        const capture_config& config, const capture_format& format)
+    {
+        release();
+
+        if(config.memory != CAPTURE_MEMORY_USERPTR && !initGem())
+            return false;
+
+        capture_buffer empty;
+        memset(&empty, 0, sizeof(empty));
+        empty.size = format.size;
+        empty.dmabuf_fd = -1;
+        m_Buffers.assign(config.buffer_count, empty);
+        m_Bos.assign(config.buffer_count, nullptr);
+
+        for(unsigned int i = 0; i < config.buffer_count; i++)
+        {
+            capture_buffer& buffer = m_Buffers[i];
+            bool ok;
+
+            buffer.index = i;
+            switch(config.memory)
+            {
+            case CAPTURE_MEMORY_USERPTR:
+                ok = (posix_memalign(&buffer.data, getpagesize(), buffer.size) == 0);
+                break;
+            case CAPTURE_MEMORY_EXPORTED:
+                buffer.dmabuf_fd = backend.exportBuffer(i);
+                ok = (buffer.dmabuf_fd >= 0 && importPrime(buffer, m_Bos[i]));
+                break;
+            default:
+                ok = createGem(buffer, m_Bos[i]);
+                break;
+            }
+
+            if(!ok)
+            {
+                LERR_(TAG, "Failed to allocate capture buffer " << i);
+                release();
+                return false;
+            }
+
+            // Only wl_drm needs the global name, renderers use the mapping or dmabuf.
+            if(m_Bos[i] != nullptr && drm_intel_bo_flink(m_Bos[i], &buffer.flink_name) != 0)
+                LWRN_(TAG, "Cannot flink capture buffer " << i);
+        }
+
+        LINF_(TAG, config.buffer_count << " capture buffers of " << format.size << " bytes");
+        return true;
+    }
+
+    // Release every buffer.
+    void CaptureBufferManager::release(void)
+    {
+        for(unsigned int i = 0; i < m_Buffers.size(); i++)
+        {
+            capture_buffer& buffer = m_Buffers[i];
+
+            if(m_Bos[i] != nullptr)
+            {
+                if(buffer.data != nullptr)
+                    drm_intel_bo_unmap(m_Bos[i]);
+                drm_intel_bo_unreference(m_Bos[i]);
+            }
+            else
+            {
+                free(buffer.data);
+            }
+
+            if(buffer.dmabuf_fd >= 0)
+                close(buffer.dmabuf_fd);
+        }
+
+        m_Buffers.clear();
+        m_Bos.clear();
+    }
+
+} // namespace
@@ -0,0 +1,315 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+  Capture error recovery checks. Each fault of the fake backend is injected
+  into a streaming session and the polling thread steps of
+  capture_recovery.h are taken as the CSI camera takes them, checking the
+  state after each one: a dequeue error recovers after the failing stream on
+  attempts, a stall recovers with the first attempt and a lost device uses
+  the attempts up and comes back after it is reopened.
+
+  Deadlines are passed in as the current time, nothing waits for the back
+  off delays.
+
+  Usage: capture_recovery_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <linux/videodev2.h>
+
+#include "frame_mailbox.h"
+#include "capture_recovery.h"
+#include "CaptureSession.hpp"
+#include "FakeCaptureBackend.hpp"
+
+using namespace earlyapp;
+
+// Longest wait for an event, the fake source runs at 30 frames per second.
+#define EVENT_TIMEOUT_MS 1000
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) \
+    { \
+        fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while(0)
+
+
+// A streaming session, its fake backend and the state of its polling thread.
+struct Stream
+{
+    FakeCaptureBackend* pFake;
+    std::unique_ptr<CaptureSession> pSession;
+    capture_events events;
+    capture_recovery rec;
+    int signalLost = 0;
+    unsigned int resets = 0;
+};
+
+static int countReset(void* data)
+{
+    static_cast<Stream*>(data)->resets++;
+    return 0;
+}
+
+// Sets up the capture events and the recovery, as a new polling thread.
+static void watch(Stream& stream)
+{
+    CHECK(capture_events_init(&stream.events, stream.pSession->backend().pollFd(), -1) == 0);
+    capture_recovery_init(&stream.rec, stream.pSession.get(), &stream.events,
+                          &stream.signalLost, frame_mailbox_now_ns());
+    stream.rec.reset = countReset;
+    stream.rec.reset_data = &stream;
+}
+
+static void start(Stream& stream)
+{
+    capture_config config;
+
+    stream.pFake = new FakeCaptureBackend();
+    stream.pSession.reset(new CaptureSession(std::unique_ptr<CaptureBackend>(stream.pFake)));
+
+    memset(&config, 0, sizeof(config));
+    strncpy(config.device, "/dev/video-fake", sizeof(config.device) - 1);
+    config.width = 64;
+    config.height = 48;
+    config.fourcc = V4L2_PIX_FMT_UYVY;
+    config.bytes_per_pixel = 2;
+    config.buffer_count = 4;
+    config.memory = CAPTURE_MEMORY_USERPTR;
+    CHECK(stream.pSession->start(config));
+
+    watch(stream);
+}
+
+/*
+  One wakeup of the polling thread without waiting past @now_ns. Returns -1
+  when the capture failed and the recovery is suspended, 1 for a frame and 0
+  otherwise.
+ */
+static int step(Stream& stream, uint64_t now_ns)
+{
+    capture_frame frame;
+    int mask, index = -1, failed, ret;
+
+    mask = capture_events_wait(&stream.events, EVENT_TIMEOUT_MS);
+    CHECK(mask >= 0);
+    if(mask < 0)
+        return 0;
+
+    failed = (mask & CAPTURE_EVENT_ERROR);
+    if(!failed && (mask & CAPTURE_EVENT_FRAME))
+    {
+        index = stream.pSession->dequeue(frame);
+        failed = (index == CAPTURE_ERROR);
+    }
+    if(!failed)
+    {
+        ret = capture_recovery_check(&stream.rec, mask & CAPTURE_EVENT_FRAME, now_ns);
+        failed = (ret < 0);
+        if(ret == 1)
+            index = -1;
+    }
+
+    if(failed)
+        return capture_recovery_suspend(&stream.rec, now_ns) < 0 ? -2 : -1;
+    if(index < 0)
+        return 0;
+
+    capture_recovery_frame(&stream.rec, now_ns);
+    stream.pSession->put(index);
+    return 1;
+}
+
+// Steps until a frame arrives, false when none comes.
+static bool waitFrame(Stream& stream)
+{
+    int i;
+
+    for(i = 0; i < 30; i++)
+    {
+        if(step(stream, frame_mailbox_now_ns()) == 1)
+            return true;
+    }
+
+    return false;
+}
+
+// Steps until the capture fails.
+static int waitFailure(Stream& stream)
+{
+    int i, ret;
+
+    for(i = 0; i < 30; i++)
+    {
+        ret = step(stream, frame_mailbox_now_ns());
+        if(ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+// Makes the attempt scheduled by the last suspend, 0 when it worked.
+static int attempt(Stream& stream)
+{
+    uint64_t deadline = stream.rec.deadline_ns;
+
+    // Not yet due, the device stays streamed off.
+    CHECK(capture_recovery_check(&stream.rec, 0, deadline - 1) == 1);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_RESET);
+
+    if(capture_recovery_check(&stream.rec, 0, deadline) < 0)
+        return capture_recovery_suspend(&stream.rec, deadline) < 0 ? -2 : -1;
+
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_WAIT_FRAME);
+    return 0;
+}
+
+static void stop(Stream& stream)
+{
+    capture_events_close(&stream.events);
+    stream.pSession.reset();
+}
+
+// A failing dequeue recovers once the stream on attempts stop failing.
+static void testDequeueError(void)
+{
+    Stream stream;
+    unsigned int i;
+
+    start(stream);
+    CHECK(waitFrame(stream));
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_STREAMING);
+
+    stream.pFake->injectFault(FakeCaptureBackend::FAULT_DEQUEUE_ERROR);
+    CHECK(waitFailure(stream) == -1);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_RESET);
+    CHECK(stream.signalLost == 1);
+    CHECK(stream.rec.attempts == 0);
+    CHECK(stream.rec.delay_ms == CAPTURE_RECOVERY_FIRST_DELAY_MS);
+
+    // The attempts back off while stream on fails.
+    for(i = 1; i <= FakeCaptureBackend::FAULT_FAILED_RESUMES; i++)
+    {
+        CHECK(attempt(stream) == -1);
+        CHECK(stream.rec.state == CAPTURE_RECOVERY_RESET);
+        CHECK(stream.rec.attempts == i);
+        CHECK(stream.rec.delay_ms == (unsigned int) CAPTURE_RECOVERY_FIRST_DELAY_MS << i);
+    }
+
+    CHECK(attempt(stream) == 0);
+    CHECK(stream.resets == FakeCaptureBackend::FAULT_FAILED_RESUMES + 1);
+    CHECK(stream.signalLost == 1);
+
+    CHECK(waitFrame(stream));
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_STREAMING);
+    CHECK(stream.signalLost == 0);
+    stop(stream);
+}
+
+// A stalled stream, and one stalling again after the attempt, recover.
+static void testStall(void)
+{
+    Stream stream;
+    uint64_t frame;
+
+    start(stream);
+    CHECK(waitFrame(stream));
+
+    stream.pFake->injectFault(FakeCaptureBackend::FAULT_STALL);
+    frame = stream.rec.frame_ns;
+    CHECK(step(stream, frame + CAPTURE_RECOVERY_STALL_MS * 1000000ull - 1) == 0);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_STREAMING);
+    CHECK(step(stream, frame + CAPTURE_RECOVERY_STALL_MS * 1000000ull) == -1);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_RESET);
+    CHECK(stream.signalLost == 1);
+
+    CHECK(attempt(stream) == 0);
+    CHECK(stream.rec.attempts == 1);
+
+    // No frame after the attempt is a failure as well.
+    stream.pFake->injectFault(FakeCaptureBackend::FAULT_STALL);
+    CHECK(step(stream, stream.rec.deadline_ns) == -1);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_RESET);
+    CHECK(stream.rec.delay_ms == CAPTURE_RECOVERY_FIRST_DELAY_MS * 2);
+
+    CHECK(attempt(stream) == 0);
+    CHECK(stream.rec.attempts == 2);
+    CHECK(waitFrame(stream));
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_STREAMING);
+    CHECK(stream.signalLost == 0);
+    stop(stream);
+}
+
+// A lost device uses the attempts up and streams again once reopened.
+static void testDeviceLost(void)
+{
+    Stream stream;
+    int ret = 0;
+    unsigned int i;
+
+    start(stream);
+    CHECK(waitFrame(stream));
+
+    stream.pFake->injectFault(FakeCaptureBackend::FAULT_DEVICE_LOST);
+    CHECK(waitFailure(stream) == -1);
+
+    for(i = 0; i < CAPTURE_RECOVERY_MAX_ATTEMPTS && ret != -2; i++)
+        ret = attempt(stream);
+    CHECK(ret == -2);
+    CHECK(stream.rec.attempts == CAPTURE_RECOVERY_MAX_ATTEMPTS);
+    CHECK(stream.rec.delay_ms == CAPTURE_RECOVERY_MAX_DELAY_MS);
+    CHECK(stream.resets == CAPTURE_RECOVERY_MAX_ATTEMPTS);
+    CHECK(stream.signalLost == 1);
+
+    // The CSI camera reopens the device and starts a new polling thread.
+    capture_events_close(&stream.events);
+    CHECK(stream.pSession->restart());
+    watch(stream);
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_WAIT_FRAME);
+
+    CHECK(waitFrame(stream));
+    CHECK(stream.rec.state == CAPTURE_RECOVERY_STREAMING);
+    CHECK(stream.signalLost == 0);
+    stop(stream);
+}
+
+int main(void)
+{
+    testDequeueError();
+    testStall();
+    testDeviceLost();
+
+    if(!failures)
+        printf("capture recovery tests passed\n");
+    return failures ? 1 : 0;
+}
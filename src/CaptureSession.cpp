@@ -0,0 +1,304 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "EALog.h"
+#include "CaptureSession.hpp"
+#include "V4L2CaptureBackend.hpp"
+#include "IciCaptureBackend.hpp"
+#include "FakeCaptureBackend.hpp"
+
+// Log tag.
+#define TAG "CAPTURE"
+
+
+namespace earlyapp
+{
+    // Backend factory.
+    std::unique_ptr<CaptureBackend> CaptureSession::createBackend(const std::string& name)
+    {
+        if(name == "v4l2")
+            return std::unique_ptr<CaptureBackend>(new V4L2CaptureBackend());
+        if(name == "ici")
+            return std::unique_ptr<CaptureBackend>(new IciCaptureBackend());
+        if(name == "fake")
+            return std::unique_ptr<CaptureBackend>(new FakeCaptureBackend());
+        if(name == "fake-faults")
+            return std::unique_ptr<CaptureBackend>(
+                new FakeCaptureBackend(FakeCaptureBackend::FAULT_INTERVAL));
+
+        LERR_(TAG, "Unknown capture backend " << name);
+        return nullptr;
+    }
+
+    // Constructor.
+    CaptureSession::CaptureSession(std::unique_ptr<CaptureBackend> backend)
+        : m_pBackend(std::move(backend))
+    {
+        memset(&m_Config, 0, sizeof(m_Config));
+        memset(&m_Format, 0, sizeof(m_Format));
+    }
+
+    // Destructor.
+    CaptureSession::~CaptureSession(void)
+    {
+        stop();
+    }
+
+    // Start streaming.
+    bool CaptureSession::start(const capture_config& config)
+    {
+        stop();
+        m_Config = config;
+
+        if(!m_pBackend->open(m_Config))
+            return false;
+
+        if(!m_pBackend->configure(m_Config, m_Format)
+           || !m_Buffers.allocate(*m_pBackend, m_Config, m_Format))
+        {
+            m_pBackend->close();
+            return false;
+        }
+
+        m_pRefs.reset(new std::atomic<int>[m_Buffers.count()]);
+        m_Started = true;
+
+        if(!queueAll() || !m_pBackend->streamOn())
+        {
+            stop();
+            return false;
+        }
+
+        LINF_(TAG, m_pBackend->name() << " streaming from " << m_Config.device);
+        return true;
+    }
+
+    // Stop streaming.
+    void CaptureSession::stop(void)
+    {
+        if(!m_Started)
+            return;
+
+        m_pBackend->streamOff();
+        m_Buffers.release();
+        m_pBackend->close();
+        m_pRefs.reset();
+        m_Started = false;
+    }
+
+    // Restart after device errors.
+    bool CaptureSession::restart(void)
+    {
+        capture_config config = m_Config;
+
+        stop();
+        return start(config);
+    }
+
+    // Give every buffer back to the driver.
+    bool CaptureSession::requeue(void)
+    {
+        if(!m_pBackend->streamOff())
+            return false;
+
+        return queueAll() && m_pBackend->streamOn();
+    }
+
+    // Stream off after a device error.
+    bool CaptureSession::suspend(void)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        m_Suspended = true;
+        return m_pBackend->streamOff();
+    }
+
+    // Stream on again with the buffers nobody holds.
+    bool CaptureSession::resume(void)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        for(unsigned int i = 0; i < m_Buffers.count(); i++)
+        {
+            if(m_pRefs[i].load() == 0 && !m_pBackend->queue(m_Buffers.buffer(i)))
+            {
+                // Take back what was queued, the next attempt queues it again.
+                m_pBackend->streamOff();
+                return false;
+            }
+        }
+
+        if(!m_pBackend->streamOn())
+        {
+            m_pBackend->streamOff();
+            return false;
+        }
+
+        m_Suspended = false;
+        return true;
+    }
+
+    // Queue every buffer.
+    bool CaptureSession::queueAll(void)
+    {
+        m_Suspended = false;
+        for(unsigned int i = 0; i < m_Buffers.count(); i++)
+        {
+            m_pRefs[i].store(0);
+            if(!m_pBackend->queue(m_Buffers.buffer(i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Dequeue a frame.
+    int CaptureSession::dequeue(capture_frame& frame)
+    {
+        int index = m_pBackend->dequeue(frame);
+
+        if(index < 0)
+            return index;
+        if(index >= (int) m_Buffers.count())
+        {
+            LERR_(TAG, "Driver returned buffer " << index << " of " << m_Buffers.count());
+            return -1;
+        }
+
+        m_pRefs[index].store(1);
+        return index;
+    }
+
+    // Add a reference.
+    void CaptureSession::get(int index)
+    {
+        m_pRefs[index].fetch_add(1);
+    }
+
+    // Drop a reference.
+    bool CaptureSession::put(int index)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        // A suspended session queues the idle buffers when it resumes.
+        if(m_pRefs[index].fetch_sub(1) != 1 || m_Suspended)
+            return true;
+
+        return m_pBackend->queue(m_Buffers.buffer(index));
+    }
+
+
+    /*
+      C interfaces.
+    */
+    extern "C" void* CaptureSession_create(const char* backend)
+    {
+        std::unique_ptr<CaptureBackend> pBackend = CaptureSession::createBackend(backend);
+
+        if(pBackend == nullptr)
+            return nullptr;
+
+        return new CaptureSession(std::move(pBackend));
+    }
+
+    extern "C" void CaptureSession_release(void* session)
+    {
+        delete static_cast<CaptureSession*>(session);
+    }
+
+    extern "C" int CaptureSession_start(void* session, const capture_config* config)
+    {
+        return static_cast<CaptureSession*>(session)->start(*config) ? 0 : -1;
+    }
+
+    extern "C" void CaptureSession_stop(void* session)
+    {
+        static_cast<CaptureSession*>(session)->stop();
+    }
+
+    extern "C" int CaptureSession_restart(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->restart() ? 0 : -1;
+    }
+
+    extern "C" int CaptureSession_requeue(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->requeue() ? 0 : -1;
+    }
+
+    extern "C" int CaptureSession_suspend(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->suspend() ? 0 : -1;
+    }
+
+    extern "C" int CaptureSession_resume(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->resume() ? 0 : -1;
+    }
+
+    extern "C" int CaptureSession_fd(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->backend().pollFd();
+    }
+
+    extern "C" int CaptureSession_hardware(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->backend().hardware();
+    }
+
+    extern "C" const capture_format* CaptureSession_format(void* session)
+    {
+        return &static_cast<CaptureSession*>(session)->format();
+    }
+
+    extern "C" unsigned int CaptureSession_buffer_count(void* session)
+    {
+        return static_cast<CaptureSession*>(session)->buffers().count();
+    }
+
+    extern "C" const capture_buffer* CaptureSession_buffer(void* session, unsigned int index)
+    {
+        return &static_cast<CaptureSession*>(session)->buffers().buffer(index);
+    }
+
+    extern "C" int CaptureSession_dequeue(void* session, capture_frame* frame)
+    {
+        return static_cast<CaptureSession*>(session)->dequeue(*frame);
+    }
+
+    extern "C" void CaptureSession_get(void* session, int index)
+    {
+        static_cast<CaptureSession*>(session)->get(index);
+    }
+
+    extern "C" int CaptureSession_put(void* session, int index)
+    {
+        return static_cast<CaptureSession*>(session)->put(index) ? 0 : -1;
+    }
+
+} // namespace
@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+  Capture session checks against the fake backend: frames are delivered in
+  order into the buffers of the session, a held buffer is not reused, fields
+  come in top/bottom pairs and stop releases the device and the buffers.
+
+  Usage: capture_session_test
+ */
+
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <linux/videodev2.h>
+
+#include "frame_mailbox.h"
+#include "CaptureSession.hpp"
+#include "FakeCaptureBackend.hpp"
+
+using namespace earlyapp;
+
+// Frames dequeued by each check.
+#define FRAMES 12
+
+// Longest wait for a frame, the fake source runs at 30 frames per second.
+#define FRAME_TIMEOUT_MS 1000
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) \
+    { \
+        fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while(0)
+
+
+// Small UYVY frames in memory of the process.
+static void makeConfig(capture_config& config, bool interlaced)
+{
+    memset(&config, 0, sizeof(config));
+    strncpy(config.device, "/dev/video-fake", sizeof(config.device) - 1);
+    config.width = 64;
+    config.height = 48;
+    config.fourcc = V4L2_PIX_FMT_UYVY;
+    config.bytes_per_pixel = 2;
+    config.buffer_count = 4;
+    config.interlaced = interlaced;
+    config.memory = CAPTURE_MEMORY_USERPTR;
+}
+
+// Waits for the next frame, the index or -1 on timeout.
+static int waitFrame(CaptureSession& session, capture_frame& frame)
+{
+    uint64_t deadline = frame_mailbox_now_ns() + FRAME_TIMEOUT_MS * 1000000ull;
+    struct pollfd pfd;
+    int index;
+
+    pfd.fd = session.backend().pollFd();
+    pfd.events = POLLIN;
+    // Frames without a queued buffer are dropped, the source keeps going.
+    while(frame_mailbox_now_ns() < deadline)
+    {
+        pfd.revents = 0;
+        if(poll(&pfd, 1, FRAME_TIMEOUT_MS) <= 0)
+            return -1;
+
+        index = session.dequeue(frame);
+        if(index != -1)
+            return index;
+    }
+
+    return -1;
+}
+
+static CaptureSession* createFake(void)
+{
+    return new CaptureSession(std::unique_ptr<CaptureBackend>(new FakeCaptureBackend()));
+}
+
+// Progressive frames come in order and every put buffer is used again.
+static void testFrames(void)
+{
+    std::unique_ptr<CaptureSession> session(createFake());
+    capture_config config;
+    capture_frame frame;
+    uint32_t last = 0;
+    unsigned int seen = 0;
+    int index, i;
+
+    makeConfig(config, false);
+    CHECK(session->start(config));
+    CHECK(session->buffers().count() == config.buffer_count);
+    CHECK(session->format().width == config.width);
+    CHECK(session->format().bytes_per_line == config.width * 2);
+    CHECK(session->backend().pollFd() >= 0);
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        index = waitFrame(*session, frame);
+        CHECK(index >= 0 && index < (int) config.buffer_count);
+        if(index < 0)
+            break;
+
+        CHECK(frame.index == index);
+        CHECK(frame.field == CAPTURE_FIELD_NONE);
+        CHECK(frame.sequence > last);
+        CHECK(frame.timestamp_ns != 0);
+        // The pattern is painted into the buffer memory.
+        CHECK(((unsigned char*) session->buffers().buffer(index).data)[0] != 0);
+        last = frame.sequence;
+        seen |= 1u << index;
+
+        CHECK(session->put(index));
+    }
+
+    // Buffers go round, each one was filled.
+    CHECK(seen == (1u << config.buffer_count) - 1);
+}
+
+// Held buffers are not handed out again, frames are dropped instead.
+static void testHeld(void)
+{
+    std::unique_ptr<CaptureSession> session(createFake());
+    capture_config config;
+    capture_frame frame;
+    int held[4];
+    unsigned int i;
+
+    makeConfig(config, false);
+    CHECK(session->start(config));
+
+    for(i = 0; i < config.buffer_count; i++)
+    {
+        held[i] = waitFrame(*session, frame);
+        CHECK(held[i] >= 0);
+        if(held[i] < 0)
+            return;
+        // A second reference, as a mailbox frame holds it.
+        session->get(held[i]);
+        CHECK(session->put(held[i]));
+    }
+
+    CHECK(waitFrame(*session, frame) == -1);
+
+    // The last put gives the buffer back.
+    CHECK(session->put(held[0]));
+    CHECK(waitFrame(*session, frame) == held[0]);
+}
+
+// Interlaced sources deliver a top and a bottom field per frame.
+static void testFields(void)
+{
+    std::unique_ptr<CaptureSession> session(createFake());
+    capture_config config;
+    capture_frame frame;
+    uint32_t topSequence = 0;
+    int index, i;
+
+    makeConfig(config, true);
+    CHECK(session->start(config));
+
+    for(i = 0; i < FRAMES; i++)
+    {
+        index = waitFrame(*session, frame);
+        CHECK(index >= 0);
+        if(index < 0)
+            break;
+
+        if(i % 2 == 0)
+        {
+            CHECK(frame.field == CAPTURE_FIELD_TOP);
+            topSequence = frame.sequence;
+        }
+        else
+        {
+            CHECK(frame.field == CAPTURE_FIELD_BOTTOM);
+            CHECK(frame.sequence == topSequence);
+        }
+        CHECK(session->put(index));
+    }
+}
+
+// Stop closes the device and releases the buffers, start works again after it.
+static void testStop(void)
+{
+    std::unique_ptr<CaptureSession> session(createFake());
+    capture_config config;
+    capture_frame frame;
+    int index;
+
+    makeConfig(config, false);
+    CHECK(session->start(config));
+    index = waitFrame(*session, frame);
+    CHECK(index >= 0);
+
+    session->stop();
+    CHECK(session->backend().pollFd() < 0);
+    CHECK(session->buffers().count() == 0);
+    // Stopping twice is harmless.
+    session->stop();
+
+    CHECK(session->start(config));
+    CHECK(session->buffers().count() == config.buffer_count);
+    CHECK(waitFrame(*session, frame) >= 0);
+
+    // Requeue and restart give every buffer back to the driver.
+    CHECK(session->requeue());
+    CHECK(waitFrame(*session, frame) >= 0);
+    CHECK(session->restart());
+    CHECK(waitFrame(*session, frame) >= 0);
+}
+
+// The C interface of the camera engines.
+static void testCInterface(void)
+{
+    capture_config config;
+    capture_frame frame;
+    struct pollfd pfd;
+    void* session;
+    int index = -1;
+
+    CHECK(CaptureSession_create("no-such-backend") == nullptr);
+
+    session = CaptureSession_create("fake");
+    CHECK(session != nullptr);
+    if(session == nullptr)
+        return;
+
+    makeConfig(config, false);
+    CHECK(CaptureSession_start(session, &config) == 0);
+    CHECK(CaptureSession_hardware(session) == 0);
+    CHECK(CaptureSession_buffer_count(session) == config.buffer_count);
+    CHECK(CaptureSession_buffer(session, 1)->index == 1);
+
+    pfd.fd = CaptureSession_fd(session);
+    pfd.events = POLLIN;
+    if(poll(&pfd, 1, FRAME_TIMEOUT_MS) > 0)
+        index = CaptureSession_dequeue(session, &frame);
+    CHECK(index >= 0);
+    if(index >= 0)
+        CHECK(CaptureSession_put(session, index) == 0);
+
+    CaptureSession_stop(session);
+    CHECK(CaptureSession_fd(session) < 0);
+    CaptureSession_release(session);
+}
+
+int main(void)
+{
+    testFrames();
+    testHeld();
+    testFields();
+    testStop();
+    testCInterface();
+
+    if(!failures)
+        printf("capture session tests passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "EALog.h"
+#include "ConfigSnapshot.hpp"
+
+// Log tag.
+#define TAG "CFG"
+
+// Snapshot directory, set by the build.
+#ifndef CONFIG_SNAPSHOT_DIR
+#define CONFIG_SNAPSHOT_DIR "/var/cache/earlyapp"
+#endif
+
+
+namespace earlyapp
+{
+    const uint32_t ConfigSnapshot::MAGIC = 0x46434145;   // "EACF"
+    const uint16_t ConfigSnapshot::VERSION = 1;
+    const uint32_t ConfigSnapshot::MAX_SIZE = 64 * 1024;
+
+    // Argument hash, FNV-1a over the NUL terminated arguments.
+    uint64_t ConfigSnapshot::hashArguments(int argc, char** argv, const char* skip)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+
+        for(int i = 1; i < argc; ++i)
+        {
+            if(skip != nullptr && strcmp(argv[i], skip) == 0)
+            {
+                continue;
+            }
+            const char* p = argv[i];
+            do
+            {
+                hash ^= static_cast<uint8_t>(*p);
+                hash *= 0x100000001b3ULL;
+            } while(*p++ != '\0');
+        }
+        return hash;
+    }
+
+    // Snapshot path.
+    std::string ConfigSnapshot::pathOf(uint64_t argsHash)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.cfg", static_cast<unsigned long long>(argsHash));
+        return std::string(CONFIG_SNAPSHOT_DIR).append(name);
+    }
+
+    // Executable identity.
+    bool ConfigSnapshot::exeIdentity(uint64_t& size, uint64_t& mtime)
+    {
+        struct stat st;
+        if(stat("/proc/self/exe", &st) != 0)
+        {
+            return false;
+        }
+        size = static_cast<uint64_t>(st.st_size);
+        mtime = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ULL + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    // FNV-1a.
+    uint32_t ConfigSnapshot::checksum(const uint8_t* data, size_t length)
+    {
+        uint32_t hash = 0x811c9dc5;
+        for(size_t i = 0; i < length; ++i)
+        {
+            hash ^= data[i];
+            hash *= 0x01000193;
+        }
+        return hash;
+    }
+
+    // Load.
+    bool ConfigSnapshot::load(const std::string& path, uint64_t argsHash, std::vector<Value>& values)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            if(errno != ENOENT)
+            {
+                LWRN_(TAG, "Failed to open configuration snapshot " << path << ": " << strerror(errno));
+            }
+            return false;
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) != 0
+           || st.st_size < static_cast<off_t>(sizeof(Header))
+           || st.st_size > static_cast<off_t>(MAX_SIZE))
+        {
+            LWRN_(TAG, "Configuration snapshot " << path << " has a bad size");
+            close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if(map == MAP_FAILED)
+        {
+            LWRN_(TAG, "Failed to map configuration snapshot " << path << ": " << strerror(errno));
+            return false;
+        }
+
+        const uint8_t* data = static_cast<const uint8_t*>(map);
+        Header header;
+        memcpy(&header, data, sizeof(header));
+
+        uint64_t exeSize = 0;
+        uint64_t exeMtime = 0;
+        const char* stale = nullptr;
+        if(header.magic != MAGIC || header.size != size)
+        {
+            stale = "not a snapshot";
+        }
+        else if(header.version != VERSION)
+        {
+            stale = "format version";
+        }
+        else if(header.argsHash != argsHash)
+        {
+            stale = "arguments";
+        }
+        else if(! exeIdentity(exeSize, exeMtime)
+                || header.exeSize != exeSize
+                || header.exeMtime != exeMtime)
+        {
+            stale = "executable";
+        }
+        else if(header.checksum != checksum(data + sizeof(Header), size - sizeof(Header)))
+        {
+            stale = "checksum";
+        }
+
+        // Entries.
+        std::vector<Value> parsed;
+        size_t offset = sizeof(Header);
+        for(uint16_t i = 0; stale == nullptr && i < header.count; ++i)
+        {
+            Entry entry;
+            if(size - offset < sizeof(entry))
+            {
+                stale = "truncated";
+                break;
+            }
+            memcpy(&entry, data + offset, sizeof(entry));
+            offset += sizeof(entry);
+            if(size - offset < static_cast<size_t>(entry.keyLength) + entry.valueLength)
+            {
+                stale = "truncated";
+                break;
+            }
+
+            Value v;
+            v.key.assign(reinterpret_cast<const char*>(data + offset), entry.keyLength);
+            offset += entry.keyLength;
+            v.type = static_cast<eValueType>(entry.type);
+            v.num = 0;
+            if(v.type == VALUE_STRING)
+            {
+                v.str.assign(reinterpret_cast<const char*>(data + offset), entry.valueLength);
+            }
+            else if(
+                (v.type == VALUE_INT || v.type == VALUE_UINT || v.type == VALUE_BOOL)
+                && entry.valueLength == sizeof(v.num))
+            {
+                memcpy(&v.num, data + offset, sizeof(v.num));
+            }
+            else
+            {
+                stale = "value type";
+                break;
+            }
+            offset += entry.valueLength;
+            parsed.push_back(std::move(v));
+        }
+        if(stale == nullptr && offset != size)
+        {
+            stale = "trailing data";
+        }
+        munmap(map, size);
+
+        if(stale != nullptr)
+        {
+            LWRN_(TAG, "Ignoring configuration snapshot " << path << ", stale " << stale);
+            return false;
+        }
+        values.swap(parsed);
+        return true;
+    }
+
+    // Store.
+    bool ConfigSnapshot::store(const std::string& path, uint64_t argsHash, const std::vector<Value>& values)
+    {
+        Header header;
+        memset(&header, 0, sizeof(header));
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.argsHash = argsHash;
+        if(! exeIdentity(header.exeSize, header.exeMtime) || values.size() > UINT16_MAX)
+        {
+            return false;
+        }
+
+        std::string buf(sizeof(Header), '\0');
+        for(const Value& v: values)
+        {
+            Entry entry;
+            entry.type = static_cast<uint8_t>(v.type);
+            entry.valueLength = (v.type == VALUE_STRING) ? v.str.size() : sizeof(v.num);
+            entry.keyLength = v.key.size();
+            if(v.key.size() > UINT8_MAX || v.str.size() > UINT16_MAX)
+            {
+                LERR_(TAG, "Configuration value " << v.key << " is too long for a snapshot");
+                return false;
+            }
+            buf.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            buf.append(v.key);
+            if(v.type == VALUE_STRING)
+            {
+                buf.append(v.str);
+            }
+            else
+            {
+                buf.append(reinterpret_cast<const char*>(&v.num), sizeof(v.num));
+            }
+        }
+        if(buf.size() > MAX_SIZE)
+        {
+            return false;
+        }
+
+        header.count = values.size();
+        header.size = buf.size();
+        header.checksum = checksum(
+            reinterpret_cast<const uint8_t*>(buf.data()) + sizeof(Header), buf.size() - sizeof(Header));
+        buf.replace(0, sizeof(header), reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Write next to the snapshot and rename over it.
+        mkdir(CONFIG_SNAPSHOT_DIR, 0755);
+        std::string tmpPath = path + ".tmp";
+        int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            LERR_(TAG, "Failed to create " << tmpPath << ": " << strerror(errno));
+            return false;
+        }
+        bool written = (write(fd, buf.data(), buf.size()) == static_cast<ssize_t>(buf.size()));
+        written = (fsync(fd) == 0) && written;
+        close(fd);
+        if(! written || rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+            LERR_(TAG, "Failed to write " << path << ": " << strerror(errno));
+            unlink(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+} // namespace
@@ -24,8 +24,12 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+#include <chrono>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
 #include "EALog.h"
@@ -39,6 +43,20 @@
 
 namespace earlyapp
 {
+    // A global GPIO number.
+    static bool isGpioNumber(const std::string& str)
+    {
+        return ! str.empty() && str.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    // A chip:offset GPIO line.
+    static bool isGpioLine(const std::string& str)
+    {
+        size_t colon = str.rfind(':');
+        return colon != std::string::npos && colon > 0 && isGpioNumber(str.substr(colon + 1));
+    }
+
+
     // Definitions.
     const int Configuration::DONT_CARE = 0;
     const int Configuration::NOT_SET = -1;
@@ -56,9 +74,25 @@ namespace earlyapp
     const unsigned int Configuration::DEFAULT_DISPLAY_HEIGHT = DONT_CARE;
     const int Configuration::DEFAULT_GPIONUMBER = NOT_SET;
     const unsigned int Configuration::DEFAULT_GPIOSUSTAIN = 1;
+    const char* Configuration::DEFAULT_GPIOLINE = "";
+    const char* Configuration::DEFAULT_KPI_SINKS = "gpio";
+    const char* Configuration::DEFAULT_KPI_GPIO = "";
+    const char* Configuration::DEFAULT_LOG_SINKS = "stdout";
+    const char* Configuration::DEFAULT_LOG_FILE = "/run/earlyapp.log";
     const bool Configuration::DEFAULT_USE_GSTREAMER = false;
     const bool Configuration::DEFAULT_USE_CSICAM = false;
     const char* Configuration::DEFAULT_GSTCAMCMD = "";
+    const char* Configuration::DEFAULT_CAMERA_DEINTERLACE = "none";
+    const char* Configuration::DEFAULT_CAMERA_RENDER = "gl";
+    const char* Configuration::DEFAULT_CAMERA_CAPTURE = "ipu";
+    const bool Configuration::DEFAULT_CAMERA_CONVERT_BENCHMARK = false;
+    const char* Configuration::DEFAULT_VIDEO_PRESENTMODE = "fifo";
+    const unsigned int Configuration::DEFAULT_VIDEO_PRESENTQUEUE = 2;
+    const unsigned int Configuration::DEFAULT_VIDEO_MAXFPS = 0;
+    const char* Configuration::DEFAULT_VIDEO_PACING = "catch-up";
+    const char* Configuration::DEFAULT_VIDEO_MODE = "render";
+    const char* Configuration::DEFAULT_VIDEO_MEMORY = "video";
+    const char* Configuration::DEFAULT_VIDEO_DUMPPATH = "/tmp/earlyapp_video.yuv";
 
 
     // Configuration keys.
@@ -73,9 +107,26 @@ namespace earlyapp
     const char* Configuration::KEY_DISPLAYHEIGHT = "height";
     const char* Configuration::KEY_GPIONUMBER = "gpio-number";
     const char* Configuration::KEY_GPIOSUSTAIN = "gpio-sustain";
+    const char* Configuration::KEY_GPIOLINE = "gpio-line";
+    const char* Configuration::KEY_KPISINKS = "kpi-sinks";
+    const char* Configuration::KEY_KPIGPIO = "kpi-gpio";
+    const char* Configuration::KEY_LOGSINKS = "log-sinks";
+    const char* Configuration::KEY_LOGFILE = "log-file";
     const char* Configuration::KEY_USEGSTREAMER = "use-gstreamer";
     const char* Configuration::KEY_USECSICAM = "use-csicam";
     const char* Configuration::KEY_GSTCAMCMD = "gstcamcmd";
+    const char* Configuration::KEY_CAMERADEINTERLACE = "camera-deinterlace";
+    const char* Configuration::KEY_CAMERARENDER = "camera-render";
+    const char* Configuration::KEY_CAMERACAPTURE = "camera-capture";
+    const char* Configuration::KEY_CAMERACONVERTBENCHMARK = "camera-convert-benchmark";
+    const char* Configuration::KEY_VIDEOPRESENTMODE = "video-present-mode";
+    const char* Configuration::KEY_VIDEOPRESENTQUEUE = "video-present-queue";
+    const char* Configuration::KEY_VIDEOMAXFPS = "video-max-fps";
+    const char* Configuration::KEY_VIDEOPACING = "video-pacing";
+    const char* Configuration::KEY_VIDEOMODE = "video-mode";
+    const char* Configuration::KEY_VIDEOMEMORY = "video-memory";
+    const char* Configuration::KEY_VIDEODUMPPATH = "video-dump-path";
+    const char* Configuration::KEY_COMPILECONFIG = "compile-config";
 
 
 
@@ -86,14 +137,113 @@ namespace earlyapp
 
         if(conf != nullptr && conf.get() != nullptr)
         {
-            // Initialize program options.
-            conf->initProgramOptions(argc, argv);
+#if EALOG_LEVEL <= EALOG_LEVEL_INFO
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#endif
+
+            // A snapshot of the same parameters skips the option parsing.
+            bool fromSnapshot = conf->loadSnapshot(argc, argv);
+            if(fromSnapshot)
+            {
+                conf->m_Valid = true;
+            }
+            else
+            {
+                // Initialize program options.
+                conf->initProgramOptions(argc, argv);
+            }
+
+#if EALOG_LEVEL <= EALOG_LEVEL_INFO
+            // Measured before the first log line, which starts the logger.
+            long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            LINF_(TAG, "Configuration " << (fromSnapshot ? "read from snapshot" : "parsed")
+                  << " in " << elapsed << " us");
+#endif
 
             return conf;
         }
         return nullptr;
     }
 
+    // Read snapshot.
+    bool Configuration::loadSnapshot(int argc, char** argv)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            // Always parse when writing the snapshot.
+            if(strcmp(argv[i], "--compile-config") == 0)
+            {
+                return false;
+            }
+        }
+
+        uint64_t argsHash = ConfigSnapshot::hashArguments(argc, argv, nullptr);
+        return ConfigSnapshot::load(ConfigSnapshot::pathOf(argsHash), argsHash, m_Values);
+    }
+
+    // Write snapshot.
+    bool Configuration::writeSnapshot(int argc, char** argv)
+    {
+        // The snapshot is read by the same parameters without --compile-config.
+        uint64_t argsHash = ConfigSnapshot::hashArguments(argc, argv, "--compile-config");
+        std::string path = ConfigSnapshot::pathOf(argsHash);
+
+        if(! ConfigSnapshot::store(path, argsHash, m_Values))
+        {
+            std::cerr << "ERROR: Failed to write configuration snapshot " << path << std::endl;
+            return false;
+        }
+        std::cout << "Configuration snapshot written to " << path << std::endl;
+        return true;
+    }
+
+    // Copy option values.
+    void Configuration::mapValues(void)
+    {
+        m_Values.clear();
+        for(const auto& option: m_VM)
+        {
+            ConfigSnapshot::Value v;
+            const boost::any& value = option.second.value();
+
+            v.key = option.first;
+            v.num = 0;
+            if(value.type() == typeid(std::string))
+            {
+                v.type = ConfigSnapshot::VALUE_STRING;
+                v.str = boost::any_cast<std::string>(value);
+            }
+            else if(value.type() == typeid(int))
+            {
+                v.type = ConfigSnapshot::VALUE_INT;
+                v.num = static_cast<uint32_t>(boost::any_cast<int>(value));
+            }
+            else if(value.type() == typeid(unsigned int))
+            {
+                v.type = ConfigSnapshot::VALUE_UINT;
+                v.num = boost::any_cast<unsigned int>(value);
+            }
+            else if(value.type() == typeid(bool))
+            {
+                v.type = ConfigSnapshot::VALUE_BOOL;
+                v.num = boost::any_cast<bool>(value) ? 1 : 0;
+            }
+            else
+            {
+                // Flags without a value, help, version and compile-config.
+                continue;
+            }
+            m_Values.push_back(std::move(v));
+        }
+    }
+
+    // Write a snapshot and exit.
+    bool Configuration::compileConfig(void) const
+    {
+        return m_CompileConfig;
+    }
+
     // Is valid.
     bool Configuration::isValid(void)
     {
@@ -161,62 +311,122 @@ namespace earlyapp
         return stringMappedValueOf(Configuration::KEY_TESTCBCDEVICE);
     }
 
-    const std::string& Configuration::stringMappedValueOf(const char* key)
+    // Value of the key.
+    const ConfigSnapshot::Value* Configuration::valueOf(const char* key, ConfigSnapshot::eValueType type) const
     {
-        static const std::string nullStr = std::string("");
-        const std::string* valueStr;
-
-        try
+        for(const ConfigSnapshot::Value& v: m_Values)
         {
-            valueStr = &(m_VM[key].as<std::string>());
-        }
-        catch(const boost::bad_any_cast&)
-        {
-            LERR_(TAG, "Map error for key " << key);
-            valueStr = &nullStr;
+            if(v.key.compare(key) == 0)
+            {
+                if(v.type == type)
+                {
+                    return &v;
+                }
+                break;
+            }
         }
-        return *valueStr;
+        LERR_(TAG, "Map error for key " << key);
+        return nullptr;
+    }
+
+    const std::string& Configuration::stringMappedValueOf(const char* key) const
+    {
+        static const std::string nullStr = std::string("");
+        const ConfigSnapshot::Value* v = valueOf(key, ConfigSnapshot::VALUE_STRING);
+
+        return (v != nullptr) ? v->str : nullStr;
+    }
+
+    int Configuration::intMappedValueOf(const char* key) const
+    {
+        const ConfigSnapshot::Value* v = valueOf(key, ConfigSnapshot::VALUE_INT);
+
+        return (v != nullptr) ? static_cast<int>(v->num) : 0;
+    }
+
+    unsigned int Configuration::uintMappedValueOf(const char* key) const
+    {
+        const ConfigSnapshot::Value* v = valueOf(key, ConfigSnapshot::VALUE_UINT);
+
+        return (v != nullptr) ? v->num : 0;
+    }
+
+    bool Configuration::boolMappedValueOf(const char* key) const
+    {
+        const ConfigSnapshot::Value* v = valueOf(key, ConfigSnapshot::VALUE_BOOL);
+
+        return (v != nullptr) && v->num != 0;
     }
 
     // Display width
     unsigned int Configuration::displayWidth(void) const
     {
-        unsigned int w = m_VM[Configuration::KEY_DISPLAYWIDTH].as<unsigned int>();
+        unsigned int w = uintMappedValueOf(Configuration::KEY_DISPLAYWIDTH);
         return w;
     }
 
     // Display height
     unsigned int Configuration::displayHeight(void) const
     {
-        unsigned h = m_VM[Configuration::KEY_DISPLAYHEIGHT].as<unsigned int>();
+        unsigned h = uintMappedValueOf(Configuration::KEY_DISPLAYHEIGHT);
         return h;
     }
 
     // GPIO output number
     int Configuration::gpioNumber(void) const
     {
-        int gpio = m_VM[Configuration::KEY_GPIONUMBER].as<int>();
+        int gpio = intMappedValueOf(Configuration::KEY_GPIONUMBER);
         return gpio;
     }
 
     // GPIO peak sustaining time in ms.
     unsigned int Configuration::gpioSustain(void) const
     {
-        unsigned int peakSustain = m_VM[Configuration::KEY_GPIOSUSTAIN].as<unsigned int>();
+        unsigned int peakSustain = uintMappedValueOf(Configuration::KEY_GPIOSUSTAIN);
         return peakSustain;
     }
 
+    // GPIO chip:offset line.
+    const std::string& Configuration::gpioLine(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_GPIOLINE);
+    }
+
+    // KPI marker sinks.
+    const std::string& Configuration::kpiSinks(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_KPISINKS);
+    }
+
+    // GPIO lines of the KPI marker classes.
+    const std::string& Configuration::kpiGpio(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_KPIGPIO);
+    }
+
+    // Log sinks.
+    const std::string& Configuration::logSinks(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_LOGSINKS);
+    }
+
+    // File of the file log sink.
+    const std::string& Configuration::logFile(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_LOGFILE);
+    }
+
     // Use GStreamer
     bool Configuration::useGStreamer(void) const
     {
-        bool useGStreamer = m_VM[Configuration::KEY_USEGSTREAMER].as<bool>();
+        bool useGStreamer = boolMappedValueOf(Configuration::KEY_USEGSTREAMER);
         return useGStreamer;
     }
 
     // Use CsiCam
     bool Configuration::useCsicam(void) const
     {
-        bool useCsicam = m_VM[Configuration::KEY_USECSICAM].as<bool>();
+        bool useCsicam = boolMappedValueOf(Configuration::KEY_USECSICAM);
         return useCsicam;
     }
 
@@ -226,6 +436,75 @@ namespace earlyapp
         return stringMappedValueOf(Configuration::KEY_GSTCAMCMD);
     }
 
+    // Camera deinterlacing mode.
+    const std::string& Configuration::cameraDeinterlace(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_CAMERADEINTERLACE);
+    }
+
+    // Camera renderer.
+    const std::string& Configuration::cameraRender(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_CAMERARENDER);
+    }
+
+    // Camera capture source.
+    const std::string& Configuration::cameraCapture(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_CAMERACAPTURE);
+    }
+
+    // Benchmark the CPU camera frame conversion.
+    bool Configuration::cameraConvertBenchmark(void) const
+    {
+        bool benchmark = boolMappedValueOf(Configuration::KEY_CAMERACONVERTBENCHMARK);
+        return benchmark;
+    }
+
+    // Video presentation mode.
+    const std::string& Configuration::videoPresentMode(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_VIDEOPRESENTMODE);
+    }
+
+    // Video frames queued ahead of the compositor.
+    unsigned int Configuration::videoPresentQueue(void) const
+    {
+        unsigned int depth = uintMappedValueOf(Configuration::KEY_VIDEOPRESENTQUEUE);
+        return depth;
+    }
+
+    // Video rendering frame rate limit.
+    unsigned int Configuration::videoMaxFPS(void) const
+    {
+        unsigned int fps = uintMappedValueOf(Configuration::KEY_VIDEOMAXFPS);
+        return fps;
+    }
+
+    // Policy for late video frames.
+    const std::string& Configuration::videoPacing(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_VIDEOPACING);
+    }
+
+    // Video decoding mode.
+    const std::string& Configuration::videoMode(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_VIDEOMODE);
+    }
+
+    // Video decoder surface memory.
+    const std::string& Configuration::videoMemory(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_VIDEOMEMORY);
+    }
+
+    // Output file for the dump video mode.
+    const std::string& Configuration::videoDumpPath(void)
+    {
+        return stringMappedValueOf(Configuration::KEY_VIDEODUMPPATH);
+    }
+
     // Destructor.
     Configuration::~Configuration(void)
     {
@@ -250,6 +529,9 @@ namespace earlyapp
                 // Version.
                 ("version,v", "Print version number.")
 
+                // Configuration snapshot.
+                (Configuration::KEY_COMPILECONFIG, "Write a configuration snapshot of the other options and exit. Later starts with the same options read the snapshot instead of parsing them.")
+
                 // Camera input source.
                 // NOTE: Camera source option is supported with GStreamer.
                 ("camera-input,c",
@@ -305,6 +587,31 @@ namespace earlyapp
                  boost::program_options::value<unsigned int>()->default_value(Configuration::DEFAULT_GPIOSUSTAIN),
                  "GPIO sustaining time in ms for KPI measurements.")
 
+                // GPIO chip line.
+                (Configuration::KEY_GPIOLINE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_GPIOLINE)->notifier(&checkGpioLineParameter),
+                 "GPIO character device line for KPI measurements as chip:offset, e.g. gpiochip0:12. Used instead of gpio-number.")
+
+                // KPI marker sinks.
+                (Configuration::KEY_KPISINKS,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_KPI_SINKS)->notifier(&checkKpiSinksParameter),
+                 "Comma separated KPI marker outputs: gpio, kmsg (kernel log) and trace (ftrace marker).")
+
+                // KPI marker GPIO lines.
+                (Configuration::KEY_KPIGPIO,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_KPI_GPIO)->notifier(&checkKpiGpioParameter),
+                 "Comma separated class=number GPIO lines of KPI marker classes, e.g. rvc=12,video=13. Other classes use gpio-number.")
+
+                // Log sinks.
+                (Configuration::KEY_LOGSINKS,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_LOG_SINKS)->notifier(&checkLogSinksParameter),
+                 "Comma separated log outputs: stdout, kmsg (kernel log) and file.")
+
+                // Log file.
+                (Configuration::KEY_LOGFILE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_LOG_FILE),
+                 "Log file of the file log output.")
+
                 // Use GStreamer
                 (Configuration::KEY_USEGSTREAMER,
                  boost::program_options::bool_switch()->default_value(Configuration::DEFAULT_USE_GSTREAMER),
@@ -318,7 +625,62 @@ namespace earlyapp
 		// Custom GStreamer camera command.
                 (Configuration::KEY_GSTCAMCMD,
                  boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_GSTCAMCMD),
-                 "Custom GStreamer camera command. Only supported with use-gstreamer option.");
+                 "Custom GStreamer camera command. Only supported with use-gstreamer option.")
+
+                // Camera deinterlacing mode.
+                (Configuration::KEY_CAMERADEINTERLACE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_CAMERA_DEINTERLACE)->notifier(&checkDeinterlaceParameter),
+                 "Camera deinterlacing mode: none (progressive capture), weave, bob or motion.")
+
+                // Camera renderer.
+                (Configuration::KEY_CAMERARENDER,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_CAMERA_RENDER)->notifier(&checkCameraRenderParameter),
+                 "Camera renderer: gl, or shm to convert frames with the CPU. gl falls back to shm without EGL.")
+
+                // Camera capture source.
+                (Configuration::KEY_CAMERACAPTURE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_CAMERA_CAPTURE)->notifier(&checkCameraCaptureParameter),
+                 "Camera capture source: ipu, fake for a test pattern without camera hardware, or fake-faults for a test pattern with periodic capture errors.")
+
+                // Camera conversion benchmark.
+                (Configuration::KEY_CAMERACONVERTBENCHMARK,
+                 boost::program_options::bool_switch()->default_value(Configuration::DEFAULT_CAMERA_CONVERT_BENCHMARK),
+                 "Benchmark the CPU camera frame conversion and exit.")
+
+                // Video presentation mode.
+                (Configuration::KEY_VIDEOPRESENTMODE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_VIDEO_PRESENTMODE)->notifier(&checkPresentModeParameter),
+                 "Video presentation mode: fifo or mailbox.")
+
+                // Video presentation queue depth.
+                (Configuration::KEY_VIDEOPRESENTQUEUE,
+                 boost::program_options::value<unsigned int>()->default_value(Configuration::DEFAULT_VIDEO_PRESENTQUEUE),
+                 "Number of video frames queued ahead of the compositor.")
+
+                // Video frame rate limit.
+                (Configuration::KEY_VIDEOMAXFPS,
+                 boost::program_options::value<unsigned int>()->default_value(Configuration::DEFAULT_VIDEO_MAXFPS),
+                 "Video rendering frame rate limit. 0 for no limit.")
+
+                // Video pacing policy.
+                (Configuration::KEY_VIDEOPACING,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_VIDEO_PACING)->notifier(&checkPacingParameter),
+                 "Policy for video frames late for the frame rate limit: catch-up or drop.")
+
+                // Video decoding mode.
+                (Configuration::KEY_VIDEOMODE,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_VIDEO_MODE)->notifier(&checkVideoModeParameter),
+                 "Video decoding mode: render, null (headless renderer), performance (decode only) or dump.")
+
+                // Video surface memory.
+                (Configuration::KEY_VIDEOMEMORY,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_VIDEO_MEMORY)->notifier(&checkVideoMemoryParameter),
+                 "Video decoder surface memory: video or system.")
+
+                // Video dump file.
+                (Configuration::KEY_VIDEODUMPPATH,
+                 boost::program_options::value<std::string>()->default_value(Configuration::DEFAULT_VIDEO_DUMPPATH),
+                 "Decoded frames output file for the dump video mode.");
 
 
             boost::program_options::store(
@@ -339,6 +701,8 @@ namespace earlyapp
             else
             {
                 // Configuration is ready.
+                mapValues();
+                m_CompileConfig = (m_VM.count(Configuration::KEY_COMPILECONFIG) > 0);
                 m_Valid = true;
             }
         }
@@ -373,6 +737,186 @@ namespace earlyapp
         }
     }
 
+    // Deinterlacing mode option checker.
+    void Configuration::checkDeinterlaceParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("none") != 0
+            && optStr.compare("weave") != 0
+            && optStr.compare("bob") != 0
+            && optStr.compare("motion") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined camera deinterlacing mode: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // Camera renderer option checker.
+    void Configuration::checkCameraRenderParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("gl") != 0
+            && optStr.compare("shm") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined camera renderer: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // GPIO line option checker.
+    void Configuration::checkGpioLineParameter(std::string optStr)
+    {
+        if(! optStr.empty() && ! isGpioLine(optStr))
+        {
+            boost::program_options::error e(
+                std::string("Malformed GPIO line, expected chip:offset: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // KPI sinks option checker.
+    void Configuration::checkKpiSinksParameter(std::string optStr)
+    {
+        std::vector<std::string> sinks;
+        boost::split(sinks, optStr, boost::is_any_of(","), boost::token_compress_on);
+        for(const std::string& sink: sinks)
+        {
+            if(
+                sink.compare("gpio") != 0
+                && sink.compare("kmsg") != 0
+                && sink.compare("trace") != 0)
+            {
+                boost::program_options::error e(
+                    std::string("Undefined KPI sink: ")
+                    .append(sink));
+                throw e;
+            }
+        }
+    }
+
+    // KPI GPIO lines option checker.
+    void Configuration::checkKpiGpioParameter(std::string optStr)
+    {
+        if(optStr.empty())
+        {
+            return;
+        }
+
+        std::vector<std::string> entries;
+        boost::split(entries, optStr, boost::is_any_of(","), boost::token_compress_on);
+        for(const std::string& entry: entries)
+        {
+            size_t eq = entry.find('=');
+            if(
+                eq == std::string::npos || eq == 0
+                || ! (isGpioNumber(entry.substr(eq + 1)) || isGpioLine(entry.substr(eq + 1))))
+            {
+                boost::program_options::error e(
+                    std::string("Malformed KPI GPIO line: ")
+                    .append(entry));
+                throw e;
+            }
+        }
+    }
+
+    // Log sinks option checker.
+    void Configuration::checkLogSinksParameter(std::string optStr)
+    {
+        std::vector<std::string> sinks;
+        boost::split(sinks, optStr, boost::is_any_of(","), boost::token_compress_on);
+        for(const std::string& sink: sinks)
+        {
+            if(
+                sink.compare("stdout") != 0
+                && sink.compare("kmsg") != 0
+                && sink.compare("file") != 0)
+            {
+                boost::program_options::error e(
+                    std::string("Undefined log sink: ")
+                    .append(sink));
+                throw e;
+            }
+        }
+    }
+
+    // Camera capture option checker.
+    void Configuration::checkCameraCaptureParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("ipu") != 0
+            && optStr.compare("fake") != 0
+            && optStr.compare("fake-faults") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined camera capture source: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // Presentation mode option checker.
+    void Configuration::checkPresentModeParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("fifo") != 0
+            && optStr.compare("mailbox") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined video presentation mode: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // Pacing policy option checker.
+    void Configuration::checkPacingParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("catch-up") != 0
+            && optStr.compare("drop") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined video pacing policy: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // Video mode option checker.
+    void Configuration::checkVideoModeParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("render") != 0
+            && optStr.compare("null") != 0
+            && optStr.compare("performance") != 0
+            && optStr.compare("dump") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined video mode: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
+    // Video memory option checker.
+    void Configuration::checkVideoMemoryParameter(std::string optStr)
+    {
+        if(
+            optStr.compare("video") != 0
+            && optStr.compare("system") != 0)
+        {
+            boost::program_options::error e(
+                std::string("Undefined video memory: ")
+                .append(optStr));
+            throw e;
+        }
+    }
+
     // Program option parsing exception handler.
     void Configuration::handleProgramOptionException(const std::exception& e)
     {
@@ -94,12 +94,13 @@ namespace earlyapp
             m_csiParam.ow = DEFAULT_CAMERA_WIDTH;
         if((int) m_csiParam.oh == Configuration::DONT_CARE)
             m_csiParam.oh = DEFAULT_CAMERA_HEIGHT;
-
-	/* gpio creation */
-        if(m_pConf->gpioNumber() != m_pConf->NOT_SET)
-        {
-            m_pGPIOClass = GPIOControl_create(m_pConf->gpioNumber(), m_pConf->gpioSustain());
-        }
+        if(deinterlace_mode_from_string(
+               m_pConf->cameraDeinterlace().c_str(), &m_csiParam.deinterlace) < 0)
+            m_csiParam.deinterlace = DEINTERLACE_NONE;
+        m_csiParam.render_type = (m_pConf->cameraRender() == "shm") ? RENDER_TYPE_SHM : RENDER_TYPE_GL;
+        m_pCapture = CaptureSession_create(
+            (m_pConf->cameraCapture() == "ipu") ? "v4l2" : m_pConf->cameraCapture().c_str());
+        m_csiParam.capture = m_pCapture;
 
         LINF_(TAG, "CSI Camerea intialized.");
     }
@@ -119,7 +120,7 @@ namespace earlyapp
 	m_pThreadGrpCsiRVC = new(boost::thread_group);
 	m_pThreadCsiRVC = m_pThreadGrpCsiRVC->create_thread(
 			boost::bind(
-			&displayCamera, m_csiParam, m_pGPIOClass));
+			&displayCamera, m_csiParam));
     }
 
     /*
@@ -150,14 +151,15 @@ namespace earlyapp
     void CsiCameraDevice::terminate(void)
     {
         LINF_(TAG, "CameraDevice terminate");
-        if(m_pGPIOClass)
+        if(m_pCapture)
         {
-            GPIOControl_release(m_pGPIOClass);
+            CsiReleaseDisplay();
+            CaptureSession_release(m_pCapture);
+            m_pCapture = NULL;
         }
-
     }
 
-    void CsiCameraDevice::displayCamera(set_up m_csiParam, void *GPIOClass)
+    void CsiCameraDevice::displayCamera(set_up m_csiParam)
     {
         LINF_(TAG, "Display loop.");
 
@@ -165,7 +167,7 @@ namespace earlyapp
 	dmesgLogPrint("EA: Csi displayCamera\n");
 #endif
 
-        CsiStartDisplay(m_csiParam, GPIOClass, 1);
+        CsiStartDisplay(m_csiParam, 1);
     }
 
 } // namespace
@@ -24,20 +24,14 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <iostream>
-#include <string.h>
-#include <fcntl.h>
-#include <unistd.h>
 #include "EALog.h"
+#include "Logger.hpp"
 
 
 #ifdef USE_DMESGLOG
-int dmesg_fd = 0;
-
 int dmesgLogInit(void)
 {
-    dmesg_fd = open("/dev/kmsg", O_RDWR);
-    if (dmesg_fd < 0)
+    if (!earlyapp::Logger::getInstance().openKmsg())
     {
         return(-1);
     }
@@ -45,34 +39,30 @@ int dmesgLogInit(void)
 }
 
 /*
- Enabel logging to dmesg
+ Enabel logging to dmesg, the kernel log write is done by the log drain thread
+ with the call time in the text.
  Example: 
  dmesgLogPrint(("testing-gst-init"); 
  */
 int dmesgLogPrint(const char* stringPtr)
 {
-    int ret = -1;
+    earlyapp::LogRecord record(earlyapp::LOG_INFO, "EA", earlyapp::LogRing::FLAG_KMSG);
 
-    if (dmesg_fd > 0)
+    if (!record)
     {
-        ret=write(dmesg_fd, stringPtr, strlen(stringPtr)+1);	    
+        return(-1);
     }
+    record << stringPtr;
 
-    return(ret);
+    return 0;
 }
 
 
 
 int dmesgLogClose(void)
 {
-    int ret = -1;
-
-    if (dmesg_fd > 0)
-    {
-        ret=close(dmesg_fd);
-    }
+    earlyapp::Logger::getInstance().flush();
 
-    return(ret);
+    return 0;
 }
 #endif
-
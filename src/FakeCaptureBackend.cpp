@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "EALog.h"
+#include "frame_mailbox.h"
+#include "FakeCaptureBackend.hpp"
+
+// Log tag.
+#define TAG "FAKECAM"
+
+
+namespace earlyapp
+{
+    // The timer stands in for the video node.
+    bool FakeCaptureBackend::open(const capture_config& config)
+    {
+        m_TimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if(m_TimerFd < 0)
+        {
+            LERR_(TAG, "Cannot create frame timer: " << strerror(errno));
+            return false;
+        }
+
+        LINF_(TAG, "Fake capture instead of " << config.device);
+        return true;
+    }
+
+    // Any format is accepted, the stride is packed unless given.
+    bool FakeCaptureBackend::configure(const capture_config& config, capture_format& format)
+    {
+        format.width = config.width;
+        format.height = config.height;
+        format.fourcc = config.fourcc;
+        format.bytes_per_pixel = config.bytes_per_pixel ? config.bytes_per_pixel : 2;
+        format.bytes_per_line = config.bytes_per_line ?
+            config.bytes_per_line : config.width * format.bytes_per_pixel;
+        format.size = format.bytes_per_line * config.height;
+
+        m_Format = format;
+        m_Interlaced = config.interlaced;
+        return true;
+    }
+
+    // Queue a buffer.
+    bool FakeCaptureBackend::queue(const capture_buffer& buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        m_Queued.push_back(buffer);
+        return true;
+    }
+
+    // One frame per timer expiration, dropped when no buffer is queued.
+    int FakeCaptureBackend::dequeue(capture_frame& frame)
+    {
+        uint64_t expirations;
+        capture_buffer buffer;
+
+        if(read(m_TimerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            return -1;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+
+            // Alternate fields of one frame share the sequence number.
+            for(uint64_t i = 0; i < expirations; i++)
+            {
+                if(m_Interlaced)
+                    m_Bottom = !m_Bottom;
+                if(!m_Bottom)
+                    m_Sequence++;
+            }
+
+            // A failed source reports errors until it is streamed off.
+            if(m_FaultInterval && m_Fault == FAULT_NONE && m_Sequence >= m_NextFault)
+            {
+                LWRN_(TAG, "Injecting a capture fault at frame " << m_Sequence);
+                m_Fault = FAULT_DEQUEUE_ERROR;
+                m_FailedResumes = 0;
+                m_NextFault = m_Sequence + m_FaultInterval;
+            }
+            if(m_Fault == FAULT_DEQUEUE_ERROR || m_Fault == FAULT_DEVICE_LOST)
+                return CAPTURE_ERROR;
+
+            if(m_Queued.empty())
+                return -1;
+            buffer = m_Queued.front();
+            m_Queued.pop_front();
+        }
+
+        paint(buffer);
+        frame.index = buffer.index;
+        if(!m_Interlaced)
+            frame.field = CAPTURE_FIELD_NONE;
+        else
+            frame.field = m_Bottom ? CAPTURE_FIELD_BOTTOM : CAPTURE_FIELD_TOP;
+        frame.timestamp_ns = frame_mailbox_now_ns();
+        frame.sequence = m_Sequence;
+
+        return buffer.index;
+    }
+
+    // Diagonal bars moving with the sequence number.
+    void FakeCaptureBackend::paint(const capture_buffer& buffer)
+    {
+        unsigned char* row = static_cast<unsigned char*>(buffer.data);
+        unsigned int bpp = m_Format.bytes_per_pixel;
+        unsigned int x, y;
+
+        if(row == nullptr)
+            return;
+
+        for(y = 0; y < m_Format.height; y++, row += m_Format.bytes_per_line)
+        {
+            for(x = 0; x < m_Format.width; x++)
+            {
+                unsigned char value = ((x + y + m_Sequence * 4) & 0x40) ? 0xd0 : 0x30;
+                memset(row + x * bpp, value, bpp);
+            }
+        }
+    }
+
+    // Start the frame timer.
+    bool FakeCaptureBackend::streamOn(void)
+    {
+        struct itimerspec its;
+        unsigned int rate = m_Interlaced ? FIELD_RATE : FRAME_RATE;
+
+        if(m_Fault == FAULT_DEVICE_LOST
+           || (m_Fault == FAULT_DEQUEUE_ERROR && m_FailedResumes++ < FAULT_FAILED_RESUMES))
+        {
+            LWRN_(TAG, "Injected fault: stream on failed");
+            return false;
+        }
+        m_Fault = FAULT_NONE;
+
+        memset(&its, 0, sizeof(its));
+        its.it_interval.tv_nsec = 1000000000L / rate;
+        its.it_value = its.it_interval;
+        if(timerfd_settime(m_TimerFd, 0, &its, nullptr) < 0)
+        {
+            LERR_(TAG, "Cannot arm frame timer: " << strerror(errno));
+            return false;
+        }
+
+        // The first field is a top field.
+        m_Bottom = m_Interlaced;
+        return true;
+    }
+
+    // Stop the frame timer, queued buffers are returned.
+    bool FakeCaptureBackend::streamOff(void)
+    {
+        struct itimerspec its;
+
+        memset(&its, 0, sizeof(its));
+        timerfd_settime(m_TimerFd, 0, &its, nullptr);
+
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Queued.clear();
+        return true;
+    }
+
+    // A stall stops the frame timer until the next stream on.
+    void FakeCaptureBackend::injectFault(Fault fault)
+    {
+        struct itimerspec its;
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        LWRN_(TAG, "Injecting capture fault " << fault << " at frame " << m_Sequence);
+        m_Fault = fault;
+        m_FailedResumes = 0;
+        if(fault == FAULT_STALL)
+        {
+            memset(&its, 0, sizeof(its));
+            timerfd_settime(m_TimerFd, 0, &its, nullptr);
+        }
+    }
+
+    // Close the timer.
+    void FakeCaptureBackend::close(void)
+    {
+        if(m_TimerFd >= 0)
+        {
+            ::close(m_TimerFd);
+            m_TimerFd = -1;
+            m_Fault = FAULT_NONE;
+        }
+    }
+
+} // namespace
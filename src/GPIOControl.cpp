@@ -25,11 +25,21 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <sstream>
+#include <fstream>
+#include <vector>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <linux/gpio.h>
+#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <string.h>
 #include "EALog.h"
@@ -41,6 +51,15 @@
 // GPIO directory path.
 #define GPIO_DIRPATH "/sys/class/gpio"
 
+// GPIO character devices.
+#define GPIO_DEVDIR "/dev"
+
+// GPIO chip devices, with or without the sysfs interface.
+#define GPIO_BUSDIR "/sys/bus/gpio/devices"
+
+// GPIO ranges of the chips in debugfs.
+#define GPIO_DEBUGFS "/sys/kernel/debug/gpio"
+
 
 namespace earlyapp
 {
@@ -52,6 +71,7 @@ namespace earlyapp
         {
             m_Valid = true;
             m_GPIONumber = gpioNumber;
+            m_Name = std::to_string(gpioNumber);
             LINF_(TAG, "GPIO output to " << gpioNumber);
         }
         else
@@ -63,10 +83,334 @@ namespace earlyapp
         // Peak time. x 1000 to make it ms.
         m_SustainTime = peakSustainTime * 1000;
         LINF_(TAG, "Peak sustaining time(us): " << m_SustainTime);
+
+        if(m_Valid && openLine() && !startPulseThread())
+        {
+            close(m_LineFd);
+            m_LineFd = -1;
+        }
+        if(m_Valid && m_LineFd < 0)
+        {
+            LINF_(TAG, "GPIO " << m_GPIONumber << " through sysfs.");
+        }
+    }
+
+    // Constructor for a character device line.
+    GPIOControl::GPIOControl(const std::string& chip, unsigned int offset, unsigned int peakSustainTime)
+        : m_Chip(chip), m_Offset(offset)
+    {
+        m_Name = chip + ":" + std::to_string(offset);
+        m_SustainTime = peakSustainTime * 1000;
+        LINF_(TAG, "GPIO output to " << m_Name << ", peak sustaining time(us): " << m_SustainTime);
+
+        // No sysfs fallback without a GPIO number.
+        m_Valid = openLine();
+        if(m_Valid && !startPulseThread())
+        {
+            close(m_LineFd);
+            m_LineFd = -1;
+            m_Valid = false;
+        }
+        if(!m_Valid)
+        {
+            LERR_(TAG, "Not controlling GPIO " << m_Name);
+        }
+    }
+
+    // Destructor.
+    GPIOControl::~GPIOControl(void)
+    {
+        if(m_PulseThread.joinable())
+        {
+            uint64_t stop = 1;
+            if(write(m_StopFd, &stop, sizeof(stop)) == sizeof(stop))
+            {
+                m_PulseThread.join();
+            }
+            else
+            {
+                m_PulseThread.detach();
+            }
+        }
+        if(m_TimerFd >= 0)
+        {
+            // A pulse still running is ended now.
+            struct itimerspec its;
+            if(timerfd_gettime(m_TimerFd, &its) == 0
+               && (its.it_value.tv_sec != 0 || its.it_value.tv_nsec != 0))
+            {
+                output(LOW);
+            }
+            close(m_TimerFd);
+        }
+        if(m_StopFd >= 0)
+        {
+            close(m_StopFd);
+        }
+        if(m_LineFd >= 0)
+        {
+            close(m_LineFd);
+        }
+
+        for(unsigned int i = 0; i < edgeCount(); ++i)
+        {
+            LINF_(TAG, "GPIO " << m_Name << " edge " << m_Edges[i].value
+                  << " at " << m_Edges[i].timeNs / 1000000.0 << " ms");
+        }
+    }
+
+    // Legacy sysfs chips directly in dir, gpiochip<base> with base and ngpio.
+    static std::vector<std::pair<int, unsigned int>> legacyChips(const std::string& dir)
+    {
+        std::vector<std::pair<int, unsigned int>> chips;
+        DIR* d = opendir(dir.c_str());
+        if(d == nullptr)
+        {
+            return chips;
+        }
+        struct dirent* ent;
+        while((ent = readdir(d)) != nullptr)
+        {
+            if(strncmp(ent->d_name, "gpiochip", 8) != 0)
+            {
+                continue;
+            }
+            std::ifstream baseFile(dir + "/" + ent->d_name + "/base");
+            std::ifstream ngpioFile(dir + "/" + ent->d_name + "/ngpio");
+            int base = -1;
+            unsigned int n = 0;
+            if((baseFile >> base) && (ngpioFile >> n) && base >= 0)
+            {
+                chips.push_back(std::make_pair(base, n));
+            }
+        }
+        closedir(d);
+        return chips;
+    }
+
+    // Character device chips directly in dir, the ones with a device number.
+    static unsigned int deviceChips(const std::string& dir)
+    {
+        unsigned int count = 0;
+        DIR* d = opendir(dir.c_str());
+        if(d == nullptr)
+        {
+            return 0;
+        }
+        struct dirent* ent;
+        while((ent = readdir(d)) != nullptr)
+        {
+            if(strncmp(ent->d_name, "gpiochip", 8) == 0
+               && access((dir + "/" + ent->d_name + "/dev").c_str(), F_OK) == 0)
+            {
+                ++count;
+            }
+        }
+        closedir(d);
+        return count;
+    }
+
+    // Chip and offset of a global GPIO number.
+    bool GPIOControl::findLine(int gpioNumber, std::string& chip, unsigned int& offset)
+    {
+        // The legacy sysfs chip is a child of the chip device, or of its parent
+        // device. A parent with several chips can not be told apart.
+        DIR* dir = opendir(GPIO_BUSDIR);
+        if(dir != nullptr)
+        {
+            struct dirent* ent;
+            while(chip.empty() && (ent = readdir(dir)) != nullptr)
+            {
+                if(strncmp(ent->d_name, "gpiochip", 8) != 0)
+                {
+                    continue;
+                }
+                std::string dev = std::string(GPIO_BUSDIR "/") + ent->d_name;
+                std::vector<std::pair<int, unsigned int>> legacy = legacyChips(dev);
+                if(legacy.empty() && deviceChips(dev + "/..") == 1)
+                {
+                    legacy = legacyChips(dev + "/..");
+                }
+                if(legacy.size() == 1
+                   && gpioNumber >= legacy[0].first
+                   && gpioNumber < legacy[0].first + static_cast<int>(legacy[0].second))
+                {
+                    chip = ent->d_name;
+                    offset = gpioNumber - legacy[0].first;
+                }
+            }
+            closedir(dir);
+        }
+        if(!chip.empty())
+        {
+            return true;
+        }
+
+        // Kernels without the sysfs interface: "gpiochipN: GPIOs <first>-<last>, ..."
+        std::ifstream debugFile(GPIO_DEBUGFS);
+        std::string line;
+        while(std::getline(debugFile, line))
+        {
+            char name[32];
+            int first = 0;
+            int last = -1;
+            if(sscanf(line.c_str(), "%31[^:]: GPIOs %d-%d", name, &first, &last) == 3
+               && gpioNumber >= first && gpioNumber <= last)
+            {
+                chip = name;
+                offset = gpioNumber - first;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Request the line through its chip character device.
+    bool GPIOControl::openLine(void)
+    {
+        std::string chip = m_Chip;
+        unsigned int offset = m_Offset;
+        if(chip.empty() && !findLine(m_GPIONumber, chip, offset))
+        {
+            return false;
+        }
+
+        std::string dev = (chip.find('/') == std::string::npos) ? std::string(GPIO_DEVDIR "/") + chip : chip;
+        int chipFd = open(dev.c_str(), O_RDONLY | O_CLOEXEC);
+        if(chipFd < 0)
+        {
+            LERR_(TAG, "Failed to open " << dev << ": " << strerror(errno));
+            return false;
+        }
+        struct gpiohandle_request req;
+        memset(&req, 0, sizeof(req));
+        req.lineoffsets[0] = offset;
+        req.lines = 1;
+        req.flags = GPIOHANDLE_REQUEST_OUTPUT;
+        req.default_values[0] = LOW;
+        strncpy(req.consumer_label, "earlyapp-kpi", sizeof(req.consumer_label) - 1);
+        if(ioctl(chipFd, GPIO_GET_LINEHANDLE_IOCTL, &req) == 0)
+        {
+            m_LineFd = req.fd;
+            LINF_(TAG, "GPIO " << m_Name << " on " << dev << " line " << offset);
+        }
+        else
+        {
+            LERR_(TAG, "Failed to request " << dev << " line " << offset << ": " << strerror(errno));
+        }
+        close(chipFd);
+        return m_LineFd >= 0;
+    }
+
+    // Start the thread ending pulses.
+    bool GPIOControl::startPulseThread(void)
+    {
+        m_TimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        m_StopFd = eventfd(0, EFD_CLOEXEC);
+        if(m_TimerFd < 0 || m_StopFd < 0)
+        {
+            LERR_(TAG, "Failed to create the pulse timer: " << strerror(errno));
+            return false;
+        }
+        try
+        {
+            m_PulseThread = std::thread(&GPIOControl::pulseLoop, this);
+        }
+        catch(const std::system_error& e)
+        {
+            LERR_(TAG, "Failed to start the pulse thread: " << e.what());
+            return false;
+        }
+        return true;
+    }
+
+    // Lower the line whenever the pulse timer expires.
+    void GPIOControl::pulseLoop(void)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = m_TimerFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_StopFd;
+        fds[1].events = POLLIN;
+
+        for(;;)
+        {
+            if(poll(fds, 2, -1) < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+            if(fds[1].revents)
+            {
+                break;
+            }
+            uint64_t expirations;
+            if(fds[0].revents && read(m_TimerFd, &expirations, sizeof(expirations)) > 0)
+            {
+                output(LOW);
+            }
+        }
+    }
+
+    // Record an edge.
+    void GPIOControl::recordEdge(eGPIOValue highLow)
+    {
+        unsigned int index = m_EdgeCount.fetch_add(1);
+        if(index >= MAX_EDGES)
+        {
+            return;
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        m_Edges[index].timeNs = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        m_Edges[index].value = highLow;
+    }
+
+    // Number of recorded edges.
+    unsigned int GPIOControl::edgeCount(void) const
+    {
+        unsigned int count = m_EdgeCount.load();
+        return count < MAX_EDGES ? count : MAX_EDGES;
+    }
+
+    // Recorded edge.
+    const GPIOControl::Edge& GPIOControl::edge(unsigned int index) const
+    {
+        return m_Edges[index];
     }
 
     // Output GPIO.
     bool GPIOControl::output(eGPIOValue highLow)
+    {
+        if(!m_Valid)
+        {
+            return false;
+        }
+        if(m_LineFd >= 0)
+        {
+            struct gpiohandle_data data;
+            memset(&data, 0, sizeof(data));
+            data.values[0] = highLow;
+            if(ioctl(m_LineFd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) < 0)
+            {
+                return false;
+            }
+            recordEdge(highLow);
+            return true;
+        }
+        if(!outputSysfs(highLow))
+        {
+            return false;
+        }
+        recordEdge(highLow);
+        return true;
+    }
+
+    // Output GPIO through sysfs.
+    bool GPIOControl::outputSysfs(eGPIOValue highLow)
     {
         std::string strGPIO = std::to_string(m_GPIONumber);
         const char* cstrGPIO = strGPIO.c_str();
@@ -80,7 +424,7 @@ namespace earlyapp
             int exportFd = open(exportPath()->c_str(), O_WRONLY);
             if(exportFd < 0)
             {
-                LERR_(TAG, "Failed to open export path:" << exportPath());
+                LERR_(TAG, "Failed to open export path:" << *exportPath());
                 return false;
             }
             write(exportFd, cstrGPIO, gpioStrLen);
@@ -90,7 +434,7 @@ namespace earlyapp
             int dirFd = open(directionPath()->c_str(), O_WRONLY);
             if (dirFd < 0)
             {
-                LERR_(TAG, "Failed to open direction:" << directionPath());
+                LERR_(TAG, "Failed to open direction:" << *directionPath());
                 return false;
             }
             write(dirFd, "out", (size_t)3);
@@ -100,7 +444,7 @@ namespace earlyapp
             valueFd = open(valuePath()->c_str(), O_WRONLY);
             if(valueFd < 0)
             {
-                LERR_(TAG, "Failed to open GPIO value: " << valuePath());
+                LERR_(TAG, "Failed to open GPIO value: " << *valuePath());
                 return false;
             }
         }
@@ -122,6 +466,22 @@ namespace earlyapp
     // GPIO Output Pattern.
     void GPIOControl::outputPattern(void)
     {
+        if(m_PulseThread.joinable())
+        {
+            // The pulse thread lowers the line, a zero time would disarm the timer.
+            struct itimerspec its;
+            memset(&its, 0, sizeof(its));
+            its.it_value.tv_sec = m_SustainTime / 1000000;
+            its.it_value.tv_nsec = (m_SustainTime % 1000000) * 1000;
+            if(m_SustainTime == 0)
+            {
+                its.it_value.tv_nsec = 1;
+            }
+            output(HIGH);
+            timerfd_settime(m_TimerFd, 0, &its, nullptr);
+            return;
+        }
+
         output(HIGH);
         sustain();
         output(LOW);
@@ -0,0 +1,321 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+  RVC toggle soak test. Toggles the gear at 5 Hz for a number of cycles,
+  100 ms in reverse and 100 ms out, with the camera renderer of the ICI and
+  CSI engines showing the fake capture source. Every cycle streams on, shows
+  frames and hides the surface as an RVC session does, and checks that the
+  surface, the EGL context and the textures set up by the first one are
+  reused and that the open fds and the resident memory do not grow.
+
+  Usage: gear_toggle_test [cycles]
+         Exits with 77 without a Wayland compositor or EGL.
+ */
+
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <linux/videodev2.h>
+#include <memory>
+
+#include "camera_renderer.h"
+#include "capture_loop.h"
+
+#define EXIT_SKIP 77
+
+// 5 Hz, half of the period in reverse.
+#define REVERSE_MS 100
+#define FORWARD_MS 100
+#define DEFAULT_CYCLES 50
+
+// Cycles before the counts are taken, the first ones fill caches of the driver stack.
+#define WARMUP_CYCLES 3
+
+// Resident memory growth allowed over the cycles, in kB.
+#define RSS_SLACK_KB 1024
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) \
+    { \
+        fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while(0)
+
+
+// State of the polling thread of an RVC session.
+struct Capture
+{
+    camera_renderer* pRenderer;
+    int wakeupFd;
+    volatile int running;
+};
+
+// Hands every frame to the renderer, as the polling threads of the engines do.
+static void* pollingThread(void* data)
+{
+    Capture* pCapture = static_cast<Capture*>(data);
+    camera_renderer* r = pCapture->pRenderer;
+    capture_events events;
+    capture_frame frame;
+    int mask, index;
+
+    if(capture_events_init(&events, CaptureSession_fd(r->capture), pCapture->wakeupFd) < 0)
+        return nullptr;
+
+    while(pCapture->running)
+    {
+        mask = capture_events_wait(&events, 500);
+        if(mask < 0)
+            break;
+        if(!(mask & CAPTURE_EVENT_FRAME))
+            continue;
+
+        index = CaptureSession_dequeue(r->capture, &frame);
+        if(index >= 0)
+            camera_renderer_capture(r, index, &frame);
+    }
+
+    camera_renderer_drop_fields(r);
+    capture_events_close(&events);
+    return nullptr;
+}
+
+// Dispatches the display for @ms milliseconds, the frame callbacks redraw.
+static void dispatchFor(wl_display* display, unsigned int ms)
+{
+    uint64_t end = frame_mailbox_now_ns() + ms * 1000000ull;
+    struct pollfd pfd;
+    uint64_t now;
+
+    pfd.fd = wl_display_get_fd(display);
+    pfd.events = POLLIN;
+    while((now = frame_mailbox_now_ns()) < end)
+    {
+        while(wl_display_prepare_read(display) != 0)
+            wl_display_dispatch_pending(display);
+        wl_display_flush(display);
+
+        pfd.revents = 0;
+        if(poll(&pfd, 1, (int) ((end - now) / 1000000ull) + 1) > 0)
+            wl_display_read_events(display);
+        else
+            wl_display_cancel_read(display);
+        wl_display_dispatch_pending(display);
+    }
+}
+
+static unsigned int countFds(void)
+{
+    DIR* dir = opendir("/proc/self/fd");
+    unsigned int count = 0;
+
+    if(dir == nullptr)
+        return 0;
+    while(readdir(dir) != nullptr)
+        count++;
+    closedir(dir);
+    return count;
+}
+
+static long residentKb(void)
+{
+    FILE* file = fopen("/proc/self/status", "r");
+    char line[128];
+    long kb = -1;
+
+    if(file == nullptr)
+        return -1;
+    while(fgets(line, sizeof(line), file) != nullptr)
+    {
+        if(sscanf(line, "VmRSS: %ld kB", &kb) == 1)
+            break;
+    }
+    fclose(file);
+    return kb;
+}
+
+// What the first session sets up and every later one has to reuse.
+struct Persistent
+{
+    EGLContext context;
+    EGLSurface eglSurface;
+    wl_surface* surface;
+    GLuint program;
+    GLuint textures[2];
+    GLuint bufferTextures[8];
+
+    explicit Persistent(const camera_renderer& r)
+        : context(r.egl.ctx), eglSurface(r.egl_surface), surface(r.surface),
+          program(r.gl.program)
+    {
+        memcpy(textures, r.gl.texture, sizeof(textures));
+        for(unsigned int i = 0; i < 8; i++)
+            bufferTextures[i] = (i < r.buffer_count) ? r.buffers[i].gl.texture : 0;
+    }
+
+    bool operator==(const Persistent& other) const
+    {
+        return context == other.context && eglSurface == other.eglSurface
+            && surface == other.surface && program == other.program
+            && memcmp(textures, other.textures, sizeof(textures)) == 0
+            && memcmp(bufferTextures, other.bufferTextures, sizeof(bufferTextures)) == 0;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    unsigned int cycles = (argc > 1) ? atoi(argv[1]) : DEFAULT_CYCLES;
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    char socketPath[256];
+    struct stat st;
+    camera_renderer renderer;
+    camera_renderer_config config;
+    capture_config capture;
+    Capture pollState;
+    std::unique_ptr<Persistent> pFirst;
+    pthread_t thread;
+    wl_display* display;
+    void* session;
+    unsigned int fds = 0, i, framelessCycles = 0;
+    long rss = 0;
+
+    // The renderer waits for the compositor, which never comes here.
+    snprintf(socketPath, sizeof(socketPath), "%s/wayland-0", runtimeDir ? runtimeDir : "");
+    if(runtimeDir == nullptr || stat(socketPath, &st) != 0
+       || (display = wl_display_connect(nullptr)) == nullptr)
+    {
+        printf("no Wayland compositor, skipped\n");
+        return EXIT_SKIP;
+    }
+
+    session = CaptureSession_create("fake");
+    memset(&capture, 0, sizeof(capture));
+    strncpy(capture.device, "/dev/video-fake", sizeof(capture.device) - 1);
+    capture.width = 720;
+    capture.height = 480;
+    capture.fourcc = V4L2_PIX_FMT_UYVY;
+    capture.bytes_per_pixel = 2;
+    capture.buffer_count = 4;
+    capture.memory = CAPTURE_MEMORY_USERPTR;
+    if(session == nullptr || CaptureSession_start(session, &capture) < 0)
+    {
+        fprintf(stderr, "Cannot start the fake capture\n");
+        return 1;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.title = "gear_toggle_test";
+    config.name = "test camera";
+    config.width = capture.width;
+    config.height = capture.height;
+    config.render_type = RENDER_TYPE_GL;
+    config.format = CAMERA_FORMAT_UYVY;
+    config.iw = capture.width;
+    config.ih = capture.height;
+    config.stride_width = capture.width;
+    config.deinterlace = DEINTERLACE_NONE;
+    if(camera_renderer_init(&renderer, session, &config) < 0)
+    {
+        fprintf(stderr, "Cannot set up the renderer\n");
+        return 1;
+    }
+
+    pollState.pRenderer = &renderer;
+    pollState.wakeupFd = capture_wakeup_fd();
+    renderer.wakeup_fd = pollState.wakeupFd;
+
+    for(i = 0; i < cycles; i++)
+    {
+        // Reverse.
+        if(i > 0)
+            CHECK(CaptureSession_requeue(session) == 0);
+        pollState.running = 1;
+        CHECK(pthread_create(&thread, nullptr, pollingThread, &pollState) == 0);
+
+        if(i == 0)
+        {
+            camera_renderer_connect(&renderer, display);
+            if(!camera_renderer_gl(&renderer))
+            {
+                printf("no EGL, skipped\n");
+                return EXIT_SKIP;
+            }
+        }
+        else
+        {
+            camera_renderer_show(&renderer);
+        }
+        dispatchFor(display, REVERSE_MS);
+        if(renderer.frame_count == 0)
+            framelessCycles++;
+
+        // Forward.
+        pollState.running = 0;
+        capture_wakeup(pollState.wakeupFd);
+        pthread_join(thread, nullptr);
+        camera_renderer_hide(&renderer);
+        usleep(FORWARD_MS * 1000);
+
+        if(i == 0)
+            pFirst.reset(new Persistent(renderer));
+        else
+            CHECK(Persistent(renderer) == *pFirst);
+
+        if(i + 1 == WARMUP_CYCLES)
+        {
+            fds = countFds();
+            rss = residentKb();
+        }
+    }
+
+    if(cycles > WARMUP_CYCLES)
+    {
+        printf("%u cycles: %u fds, %ld kB resident after warmup, %u fds, %ld kB at the end\n",
+               cycles, fds, rss, countFds(), residentKb());
+        CHECK(countFds() <= fds);
+        CHECK(residentKb() <= rss + RSS_SLACK_KB);
+    }
+    // The first cycle may end before the compositor configured the surface.
+    CHECK(framelessCycles <= 1);
+
+    camera_renderer_fini(&renderer);
+    wl_display_disconnect(display);
+    close(pollState.wakeupFd);
+    CaptureSession_release(session);
+
+    if(!failures)
+        printf("gear toggle tests passed\n");
+    return failures ? 1 : 0;
+}
@@ -32,6 +32,7 @@
 #include "OutputDevice.hpp"
 #include "GstCameraDevice.hpp"
 #include "Configuration.hpp"
+#include "KpiMarker.h"
 
 // A log tag for Camera device
 #define TAG "CAMERA"
@@ -248,7 +249,7 @@ namespace earlyapp
         LINF_(TAG, "GstCameraDevice play");
         // Initialization again makes icamsrc camera last longer.
         //init(m_pConf);
-        OutputDevice::outputGPIOPattern();
+        KPI_MARK("rvc_play");
         startPlay();
     }
 
@@ -26,12 +26,12 @@
 
 #include <string>
 #include <gst/gst.h>
-#include <boost/format.hpp>
 
 #include "EALog.h"
 #include "OutputDevice.hpp"
 #include "GstVideoDevice.hpp"
 #include "Configuration.hpp"
+#include "KpiMarker.h"
 
 // A log tag for video device.
 #define TAG "VIDEO"
@@ -182,7 +182,7 @@ namespace earlyapp
     void GstVideoDevice::play(void)
     {
         LINF_(TAG, "GstVideoDevice play");
-        OutputDevice::outputGPIOPattern();
+        KPI_MARK("video_play");
         startPlay();
     }
 
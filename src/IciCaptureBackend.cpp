@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <linux/types.h>
+
+#include "EALog.h"
+#include "ici.h"
+#include "frame_mailbox.h"
+#include "capture_loop.h"
+#include "IciCaptureBackend.hpp"
+
+// Log tag.
+#define TAG "ICI"
+
+
+namespace earlyapp
+{
+    // ioctl restarted on signals.
+    static int xioctl(int fd, unsigned long request, void* arg)
+    {
+        int ret;
+
+        do
+        {
+            ret = ioctl(fd, request, arg);
+        } while(ret == -1 && errno == EINTR);
+
+        return ret;
+    }
+
+    // Open the stream device.
+    bool IciCaptureBackend::open(const capture_config& config)
+    {
+        struct stat st;
+
+        if(stat(config.device, &st) < 0 || !S_ISCHR(st.st_mode))
+        {
+            LERR_(TAG, config.device << " is no device");
+            return false;
+        }
+
+        m_Fd = ::open(config.device, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if(m_Fd < 0)
+        {
+            LERR_(TAG, "Cannot open " << config.device << ": " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Set the stream format, ICI has no buffer request.
+    bool IciCaptureBackend::configure(const capture_config& config, capture_format& format)
+    {
+        struct ici_stream_format fmt;
+
+        memset(&fmt, 0, sizeof(fmt));
+        fmt.ffmt.width = config.width;
+        fmt.ffmt.height = config.height;
+        fmt.ffmt.pixelformat = config.fourcc;
+        fmt.ffmt.field = config.interlaced ? ICI_FIELD_ALTERNATE : ICI_FIELD_NONE;
+        fmt.pfmt.num_planes = 1;
+        fmt.pfmt.plane_fmt[0].bytesperline = config.bytes_per_line;
+
+        if(xioctl(m_Fd, ICI_IOC_SET_FORMAT, &fmt) < 0)
+        {
+            LERR_(TAG, "Unable to set stream format: " << strerror(errno));
+            return false;
+        }
+
+        format.width = fmt.ffmt.width;
+        format.height = fmt.ffmt.height;
+        format.fourcc = fmt.ffmt.pixelformat;
+        format.bytes_per_pixel = fmt.pfmt.plane_fmt[0].bpp >> 3;
+        format.bytes_per_line = fmt.pfmt.plane_fmt[0].bytesperline;
+        format.size = fmt.pfmt.plane_fmt[0].sizeimage;
+        if(format.bytes_per_pixel == 0)
+            format.bytes_per_pixel = config.bytes_per_pixel;
+        LINF_(TAG, "Stream format " << format.width << "x" << format.height
+              << ", stride " << format.bytes_per_line << ", buffer size " << format.size);
+
+        if(config.memory == CAPTURE_MEMORY_EXPORTED)
+        {
+            LERR_(TAG, "ICI streams can not export buffers");
+            return false;
+        }
+        m_MemType = (config.memory == CAPTURE_MEMORY_USERPTR) ? ICI_MEM_USERPTR : ICI_MEM_DMABUF;
+        m_Interlaced = config.interlaced;
+
+        return true;
+    }
+
+    // Queue a buffer.
+    bool IciCaptureBackend::queue(const capture_buffer& buffer)
+    {
+        struct ici_frame_info info;
+
+        memset(&info, 0, sizeof(info));
+        info.mem_type = m_MemType;
+        info.num_planes = 1;
+        if(m_MemType == ICI_MEM_USERPTR)
+            info.frame_planes[0].mem.userptr = (unsigned long) buffer.data;
+        else
+            info.frame_planes[0].mem.dmafd = buffer.dmabuf_fd;
+        info.frame_planes[0].length = buffer.size;
+        info.frame_buf_id = buffer.index;
+
+        if(xioctl(m_Fd, ICI_IOC_GET_BUF, &info) < 0)
+        {
+            LERR_(TAG, "ICI_IOC_GET_BUF failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Dequeue a captured buffer.
+    int IciCaptureBackend::dequeue(capture_frame& frame)
+    {
+        struct ici_frame_info info;
+
+        memset(&info, 0, sizeof(info));
+        info.mem_type = m_MemType;
+        if(xioctl(m_Fd, ICI_IOC_PUT_BUF, &info) < 0)
+        {
+            LERR_(TAG, "ICI_IOC_PUT_BUF failed: " << strerror(errno));
+            return -1;
+        }
+
+        if(!m_Interlaced)
+            frame.field = CAPTURE_FIELD_NONE;
+        else if(info.field == ICI_FIELD_BOTTOM)
+            frame.field = CAPTURE_FIELD_BOTTOM;
+        else
+            frame.field = CAPTURE_FIELD_TOP;
+
+        // ICI stamps frames with the monotonic clock, 0 when it did not.
+        if(info.frame_timestamp.tv_sec || info.frame_timestamp.tv_usec)
+            frame.timestamp_ns = capture_timeval_ns(&info.frame_timestamp);
+        else
+            frame.timestamp_ns = frame_mailbox_now_ns();
+        frame.sequence = info.frame_sequence_id;
+        frame.index = info.frame_buf_id;
+
+        return info.frame_buf_id;
+    }
+
+    // Stream on.
+    bool IciCaptureBackend::streamOn(void)
+    {
+        if(ioctl(m_Fd, ICI_IOC_STREAM_ON) < 0)
+        {
+            LERR_(TAG, "ICI_IOC_STREAM_ON failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Stream off.
+    bool IciCaptureBackend::streamOff(void)
+    {
+        if(ioctl(m_Fd, ICI_IOC_STREAM_OFF) < 0)
+        {
+            LERR_(TAG, "ICI_IOC_STREAM_OFF failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Close the stream device.
+    void IciCaptureBackend::close(void)
+    {
+        if(m_Fd >= 0)
+        {
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+    }
+
+} // namespace
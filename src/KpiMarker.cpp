@@ -0,0 +1,348 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/algorithm/string.hpp>
+#include "EALog.h"
+#include "KpiMarker.hpp"
+
+// Log tag.
+#define TAG "KPI"
+
+// Kernel log level of the marks, KERN_NOTICE.
+#define KPI_KMSG_LEVEL 5
+
+
+namespace earlyapp
+{
+    // Formats a mark as "<name> <seconds>.<microseconds>", as dmesg prints times.
+    static int formatMark(char* buf, size_t size, const KpiEvent& ev)
+    {
+        return snprintf(buf, size, "%s %llu.%06llu",
+                        ev.name,
+                        static_cast<unsigned long long>(ev.timeNs / 1000000000ULL),
+                        static_cast<unsigned long long>((ev.timeNs % 1000000000ULL) / 1000ULL));
+    }
+
+    // Marker class, the name up to the first '_'.
+    static std::string markerClass(const char* name)
+    {
+        const char* end = strchr(name, '_');
+        return end ? std::string(name, end - name) : std::string(name);
+    }
+
+
+    // GPIO sink.
+    KpiGpioSink::KpiGpioSink(const std::string& classLines, const std::string& defaultLine, unsigned int sustainTime)
+        : m_DefaultLine(defaultLine)
+    {
+        std::vector<std::string> entries;
+        boost::split(entries, classLines, boost::is_any_of(","), boost::token_compress_on);
+        for(const std::string& entry: entries)
+        {
+            size_t eq = entry.find('=');
+            if(eq == std::string::npos)
+            {
+                continue;
+            }
+            std::string gpioLine = entry.substr(eq + 1);
+            m_Classes[entry.substr(0, eq)] = gpioLine;
+            line(gpioLine, sustainTime);
+        }
+        if(! m_DefaultLine.empty())
+        {
+            line(m_DefaultLine, sustainTime);
+        }
+    }
+
+    // Returns the GPIO control for the line, chip:offset or a GPIO number.
+    GPIOControl* KpiGpioSink::line(const std::string& gpioLine, unsigned int sustainTime)
+    {
+        std::unique_ptr<GPIOControl>& pLine = m_Lines[gpioLine];
+        if(pLine == nullptr)
+        {
+            size_t colon = gpioLine.rfind(':');
+            if(colon != std::string::npos)
+            {
+                pLine.reset(new GPIOControl(
+                    gpioLine.substr(0, colon), atoi(gpioLine.c_str() + colon + 1), sustainTime));
+            }
+            else
+            {
+                pLine.reset(new GPIOControl(atoi(gpioLine.c_str()), sustainTime));
+            }
+        }
+        return pLine.get();
+    }
+
+    // Pulse the line of the marker class.
+    void KpiGpioSink::mark(const KpiEvent& ev)
+    {
+        std::map<std::string, std::string>::const_iterator it = m_Classes.find(markerClass(ev.name));
+        const std::string& gpioLine = (it != m_Classes.end()) ? it->second : m_DefaultLine;
+
+        std::map<std::string, std::unique_ptr<GPIOControl>>::iterator pLine = m_Lines.find(gpioLine);
+        if(pLine != m_Lines.end())
+        {
+            pLine->second->outputPattern();
+        }
+    }
+
+
+    // Kernel log sink.
+    KpiKmsgSink::KpiKmsgSink(void)
+    {
+        m_Fd = open("/dev/kmsg", O_WRONLY | O_CLOEXEC);
+        if(m_Fd < 0)
+        {
+            LERR_(TAG, "Failed to open /dev/kmsg: " << strerror(errno));
+        }
+    }
+
+    KpiKmsgSink::~KpiKmsgSink(void)
+    {
+        if(m_Fd >= 0)
+        {
+            close(m_Fd);
+        }
+    }
+
+    // One kernel log record per mark.
+    void KpiKmsgSink::mark(const KpiEvent& ev)
+    {
+        if(m_Fd < 0)
+        {
+            return;
+        }
+
+        char buf[128];
+        int len = snprintf(buf, sizeof(buf), "<%d>earlyapp KPI ", KPI_KMSG_LEVEL);
+        len += formatMark(buf + len, sizeof(buf) - len, ev);
+        if(len < static_cast<int>(sizeof(buf)) - 1)
+        {
+            buf[len++] = '\n';
+            if(write(m_Fd, buf, len) < 0)
+            {
+                LERR_(TAG, "Failed to write the mark to /dev/kmsg: " << strerror(errno));
+            }
+        }
+    }
+
+
+    // ftrace sink.
+    KpiTraceSink::KpiTraceSink(void)
+    {
+        m_Fd = open("/sys/kernel/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+        if(m_Fd < 0)
+        {
+            m_Fd = open("/sys/kernel/debug/tracing/trace_marker", O_WRONLY | O_CLOEXEC);
+        }
+        if(m_Fd < 0)
+        {
+            LERR_(TAG, "Failed to open the ftrace marker: " << strerror(errno));
+        }
+    }
+
+    KpiTraceSink::~KpiTraceSink(void)
+    {
+        if(m_Fd >= 0)
+        {
+            close(m_Fd);
+        }
+    }
+
+    // One trace_marker write per mark.
+    void KpiTraceSink::mark(const KpiEvent& ev)
+    {
+        if(m_Fd < 0)
+        {
+            return;
+        }
+
+        char buf[128];
+        int len = snprintf(buf, sizeof(buf), "earlyapp KPI ");
+        len += formatMark(buf + len, sizeof(buf) - len, ev);
+        if(len < static_cast<int>(sizeof(buf)))
+        {
+            if(write(m_Fd, buf, len) < 0)
+            {
+                LERR_(TAG, "Failed to write the mark to the ftrace marker: " << strerror(errno));
+            }
+        }
+    }
+
+
+    // Process wide registry.
+    KpiMarker& KpiMarker::getInstance(void)
+    {
+        static KpiMarker s_Marker;
+        return s_Marker;
+    }
+
+    // Registry.
+    KpiMarker::KpiMarker(void)
+    {
+        // Marker files of the boot live on the /run tmpfs.
+        if(mkdir(KPI_STATE_DIR, 0755) < 0 && errno != EEXIST)
+        {
+            LERR_(TAG, "KPI markers are per process, failed to create " KPI_STATE_DIR ": " << strerror(errno));
+            m_BootState = false;
+        }
+    }
+
+    // Create the configured sinks.
+    void KpiMarker::setup(std::shared_ptr<Configuration> pConf)
+    {
+        std::vector<std::string> sinks;
+        boost::split(sinks, pConf->kpiSinks(), boost::is_any_of(","), boost::token_compress_on);
+        for(const std::string& sink: sinks)
+        {
+            if(sink == "gpio")
+            {
+                // The chip line, or else the GPIO number, serves the unlisted classes.
+                std::string defaultLine = pConf->gpioLine();
+                if(defaultLine.empty() && pConf->gpioNumber() > 0)
+                {
+                    defaultLine = std::to_string(pConf->gpioNumber());
+                }
+                if(! defaultLine.empty() || ! pConf->kpiGpio().empty())
+                {
+                    addSink(new KpiGpioSink(pConf->kpiGpio(), defaultLine, pConf->gpioSustain()));
+                }
+            }
+            else if(sink == "kmsg")
+            {
+                addSink(new KpiKmsgSink());
+            }
+            else if(sink == "trace")
+            {
+                addSink(new KpiTraceSink());
+            }
+        }
+
+        // Marks made before, e.g. at the start of main().
+        std::lock_guard<std::mutex> lock(m_Lock);
+        for(const KpiEvent& ev: m_Early)
+        {
+            for(std::shared_ptr<KpiSink>& pSink: m_Sinks)
+            {
+                if(pSink->timestamped())
+                {
+                    pSink->mark(ev);
+                }
+            }
+        }
+        m_Early.clear();
+        m_SetUp = true;
+    }
+
+    // Add a sink.
+    void KpiMarker::addSink(KpiSink* pSink)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Sinks.emplace_back(pSink);
+    }
+
+    // Claim the name for this boot.
+    bool KpiMarker::claim(const char* name)
+    {
+        if(! m_Marked.insert(name).second)
+        {
+            return false;
+        }
+        if(! m_BootState)
+        {
+            return true;
+        }
+
+        // An earlier earlyapp process of this boot may have marked it.
+        std::string path = std::string(KPI_STATE_DIR "/") + name;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            return errno != EEXIST;
+        }
+        close(fd);
+        return true;
+    }
+
+    // Mark a KPI point.
+    bool KpiMarker::mark(const char* name, uint64_t timeNs)
+    {
+        KpiEvent ev;
+        std::vector<std::shared_ptr<KpiSink>> sinks;
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            if(! claim(name))
+            {
+                return false;
+            }
+
+            // The name is kept by m_Marked for the early marks.
+            ev.name = m_Marked.find(name)->c_str();
+            ev.timeNs = timeNs;
+            if(! m_SetUp)
+            {
+                m_Early.push_back(ev);
+            }
+            sinks = m_Sinks;
+        }
+
+        // A sysfs GPIO pulse blocks for the sustaining time, only this caller waits.
+        for(std::shared_ptr<KpiSink>& pSink: sinks)
+        {
+            pSink->mark(ev);
+        }
+        LINF_(TAG, name << " at " << timeNs / 1000 << " us");
+        return true;
+    }
+
+    // Release the sinks.
+    void KpiMarker::release(void)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Sinks.clear();
+    }
+
+
+    // C interface, the time is taken before anything else.
+    extern "C" void KpiMarker_mark(const char* name)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        uint64_t timeNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+
+        KpiMarker::getInstance().mark(name, timeNs);
+    }
+} // namespace
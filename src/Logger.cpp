@@ -0,0 +1,471 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include "Logger.hpp"
+
+
+namespace earlyapp
+{
+    // Level names, and their kernel log priorities.
+    static const char* const s_LevelNames[] = { "debug", "info", "warning", "error" };
+    static const int s_KmsgLevels[] = { 7, 6, 4, 3 };
+
+    const unsigned int LogRing::RECORD_SIZE;
+    const unsigned int LogRing::RECORDS;
+    const unsigned int Logger::DRAIN_INTERVAL;
+    std::atomic<bool> Logger::s_Stopped(false);
+    thread_local LogRing* Logger::t_pRing = nullptr;
+
+    // Writes all of the buffer.
+    static void writeAll(int fd, const char* buf, size_t len)
+    {
+        while(len > 0)
+        {
+            ssize_t n = write(fd, buf, len);
+            if(n < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            buf += n;
+            len -= n;
+        }
+    }
+
+    // Appends to a fixed size line, keeping it terminated.
+    static void append(char* line, size_t size, size_t& used, const char* str, size_t len)
+    {
+        if(used + 1 >= size)
+        {
+            return;
+        }
+        if(len > size - 1 - used)
+        {
+            len = size - 1 - used;
+        }
+        memcpy(line + used, str, len);
+        used += len;
+        line[used] = '\0';
+    }
+
+    // Formats the arguments of a record.
+    static size_t formatMessage(const LogRing::Record& rec, char* line, size_t size)
+    {
+        size_t used = 0;
+        size_t pos = 0;
+        bool hex = false;
+        char num[32];
+
+        line[0] = '\0';
+        while(pos < rec.size)
+        {
+            uint8_t type = rec.payload[pos++];
+            int len = 0;
+            switch(type)
+            {
+            case LogRing::ARG_STRING:
+            {
+                uint16_t strLen;
+                memcpy(&strLen, &rec.payload[pos], sizeof(strLen));
+                pos += sizeof(strLen);
+                append(line, size, used, reinterpret_cast<const char*>(&rec.payload[pos]), strLen);
+                pos += strLen;
+                break;
+            }
+            case LogRing::ARG_CHAR:
+                append(line, size, used, reinterpret_cast<const char*>(&rec.payload[pos]), 1);
+                pos += 1;
+                break;
+            case LogRing::ARG_INT:
+            {
+                int64_t v;
+                memcpy(&v, &rec.payload[pos], sizeof(v));
+                pos += sizeof(v);
+                len = hex ? snprintf(num, sizeof(num), "%llx", static_cast<unsigned long long>(v))
+                    : snprintf(num, sizeof(num), "%lld", static_cast<long long>(v));
+                break;
+            }
+            case LogRing::ARG_UINT:
+            {
+                uint64_t v;
+                memcpy(&v, &rec.payload[pos], sizeof(v));
+                pos += sizeof(v);
+                len = snprintf(num, sizeof(num), hex ? "%llx" : "%llu", static_cast<unsigned long long>(v));
+                break;
+            }
+            case LogRing::ARG_DOUBLE:
+            {
+                double v;
+                memcpy(&v, &rec.payload[pos], sizeof(v));
+                pos += sizeof(v);
+                len = snprintf(num, sizeof(num), "%g", v);
+                break;
+            }
+            case LogRing::ARG_POINTER:
+            {
+                const void* p;
+                memcpy(&p, &rec.payload[pos], sizeof(p));
+                pos += sizeof(p);
+                len = snprintf(num, sizeof(num), "%p", p);
+                break;
+            }
+            case LogRing::ARG_HEX:
+                hex = true;
+                break;
+            case LogRing::ARG_DEC:
+                hex = false;
+                break;
+            default:
+                // Corrupt record.
+                pos = rec.size;
+                break;
+            }
+            if(len > 0)
+            {
+                append(line, size, used, num, len);
+            }
+        }
+        if(rec.flags & LogRing::FLAG_TRUNCATED)
+        {
+            append(line, size, used, "...", 3);
+        }
+
+        // dmesg strings come with their line feeds.
+        while(used > 0 && line[used - 1] == '\n')
+        {
+            line[--used] = '\0';
+        }
+        return used;
+    }
+
+
+    // Process wide logger, never destroyed so that static destructors can log.
+    Logger& Logger::getInstance(void)
+    {
+        static Logger* s_pLogger = new Logger();
+        return *s_pLogger;
+    }
+
+    // Constructor.
+    Logger::Logger(void)
+    {
+        atexit(&Logger::shutdown);
+    }
+
+    // Create the ring of the calling thread.
+    LogRing* Logger::createThreadRing(void)
+    {
+        // Closes the ring when the thread exits, the drain thread frees it.
+        struct RingCloser
+        {
+            bool exited = false;
+
+            ~RingCloser(void)
+            {
+                exited = true;
+                if(t_pRing != nullptr)
+                {
+                    t_pRing->m_Closed.store(true, std::memory_order_release);
+                    t_pRing = nullptr;
+                }
+            }
+        };
+        static thread_local RingCloser s_Closer;
+
+        if(s_Closer.exited)
+        {
+            return nullptr;
+        }
+
+        // Zeroed so that logging does not fault the pages in later.
+        t_pRing = new LogRing();
+        getInstance().addRing(t_pRing);
+        return t_pRing;
+    }
+
+    // Add a thread ring.
+    void Logger::addRing(LogRing* pRing)
+    {
+        std::lock_guard<std::mutex> lock(m_RingLock);
+        pRing->m_pNext = m_pRings;
+        m_pRings = pRing;
+
+        if(! m_Thread.joinable() && ! s_Stopped.load())
+        {
+            m_Thread = std::thread(&Logger::drainLoop, this);
+        }
+    }
+
+    // Select the sinks.
+    bool Logger::setSinks(const std::string& sinks, const std::string& filePath)
+    {
+        std::vector<std::string> names;
+        boost::split(names, sinks, boost::is_any_of(","), boost::token_compress_on);
+
+        unsigned int mask = 0;
+        for(const std::string& name: names)
+        {
+            if(name == "stdout")
+            {
+                mask |= SINK_STDOUT;
+            }
+            else if(name == "kmsg")
+            {
+                mask |= SINK_KMSG;
+            }
+            else if(name == "file")
+            {
+                mask |= SINK_FILE;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_DrainLock);
+        bool ok = true;
+        if((mask & SINK_KMSG) && m_KmsgFd < 0)
+        {
+            m_KmsgFd = open("/dev/kmsg", O_WRONLY | O_CLOEXEC);
+            ok = ok && m_KmsgFd >= 0;
+        }
+        if((mask & SINK_FILE) && m_FileFd < 0)
+        {
+            m_FileFd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            ok = ok && m_FileFd >= 0;
+        }
+        m_Sinks.store(mask, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // Open the kernel log.
+    bool Logger::openKmsg(void)
+    {
+        std::lock_guard<std::mutex> lock(m_DrainLock);
+        if(m_KmsgFd < 0)
+        {
+            m_KmsgFd = open("/dev/kmsg", O_WRONLY | O_CLOEXEC);
+        }
+        return m_KmsgFd >= 0;
+    }
+
+    // Drain from the calling thread.
+    void Logger::flush(void)
+    {
+        std::lock_guard<std::mutex> lock(m_DrainLock);
+        drainAll();
+    }
+
+    // Write a record from the calling thread.
+    void Logger::writeRecord(const LogRing::Record& rec)
+    {
+        std::lock_guard<std::mutex> lock(m_DrainLock);
+        output(rec);
+        flushBuffer();
+    }
+
+    // Drain thread.
+    void Logger::drainLoop(void)
+    {
+        std::unique_lock<std::mutex> lock(m_DrainLock);
+        while(! m_Stop.load())
+        {
+            m_DrainCond.wait_for(lock, std::chrono::milliseconds(DRAIN_INTERVAL),
+                                 [this] { return m_DrainRequested || m_Stop.load(); });
+            m_DrainRequested = false;
+            drainAll();
+        }
+    }
+
+    // Write out all rings.
+    void Logger::drainAll(void)
+    {
+        // Rings are only added at the head, and only removed here.
+        LogRing* pHead;
+        {
+            std::lock_guard<std::mutex> lock(m_RingLock);
+            pHead = m_pRings;
+        }
+
+        bool closedRings = false;
+        for(LogRing* pRing = pHead; pRing != nullptr; pRing = pRing->m_pNext)
+        {
+            bool closed = pRing->m_Closed.load(std::memory_order_acquire);
+            const LogRing::Record* pRec;
+            while((pRec = pRing->front()) != nullptr)
+            {
+                output(*pRec);
+                pRing->pop();
+            }
+
+            uint32_t dropped = pRing->m_Dropped.load(std::memory_order_relaxed);
+            if(dropped != pRing->m_ReportedDrops)
+            {
+                char line[64];
+                int len = snprintf(line, sizeof(line), "[LOG] %u records dropped\n",
+                                   dropped - pRing->m_ReportedDrops);
+                pRing->m_ReportedDrops = dropped;
+                if(m_Used + len > sizeof(m_Buffer))
+                {
+                    flushBuffer();
+                }
+                memcpy(m_Buffer + m_Used, line, len);
+                m_Used += len;
+            }
+            closedRings = closedRings || closed;
+        }
+        flushBuffer();
+
+        if(closedRings)
+        {
+            std::lock_guard<std::mutex> lock(m_RingLock);
+            LogRing** ppRing = &m_pRings;
+            while(*ppRing != nullptr)
+            {
+                LogRing* pRing = *ppRing;
+                if(pRing->m_Closed.load(std::memory_order_acquire) && pRing->front() == nullptr)
+                {
+                    *ppRing = pRing->m_pNext;
+                    delete pRing;
+                }
+                else
+                {
+                    ppRing = &pRing->m_pNext;
+                }
+            }
+        }
+    }
+
+    // Format and write a record.
+    void Logger::output(const LogRing::Record& rec)
+    {
+        char msg[1024];
+        size_t msgLen = formatMessage(rec, msg, sizeof(msg));
+        unsigned long long sec = rec.timeNs / 1000000000ULL;
+        unsigned long long usec = (rec.timeNs % 1000000000ULL) / 1000ULL;
+        unsigned int level = rec.level <= LOG_ERROR ? rec.level : LOG_ERROR;
+        unsigned int sinks = m_Sinks.load(std::memory_order_relaxed);
+        char line[1200];
+        int len;
+
+        // The kernel stamps the write, the call time is in the text.
+        if((rec.flags & LogRing::FLAG_KMSG) || (sinks & SINK_KMSG))
+        {
+            if(m_KmsgFd < 0)
+            {
+                m_KmsgFd = open("/dev/kmsg", O_WRONLY | O_CLOEXEC);
+            }
+            if(m_KmsgFd >= 0)
+            {
+                if(rec.flags & LogRing::FLAG_KMSG)
+                {
+                    len = snprintf(line, sizeof(line), "<%d>%.*s (at %llu.%06llu)\n",
+                                   s_KmsgLevels[level], static_cast<int>(msgLen), msg, sec, usec);
+                }
+                else
+                {
+                    len = snprintf(line, sizeof(line), "<%d>earlyapp: [%s] %.*s (at %llu.%06llu)\n",
+                                   s_KmsgLevels[level], rec.tag, static_cast<int>(msgLen), msg, sec, usec);
+                }
+                // One write per kernel log record, a short write would split it.
+                writeAll(m_KmsgFd, line, std::min(static_cast<size_t>(len), sizeof(line) - 1));
+            }
+            if(rec.flags & LogRing::FLAG_KMSG)
+            {
+                return;
+            }
+        }
+
+        if(sinks & (SINK_STDOUT | SINK_FILE))
+        {
+            len = snprintf(line, sizeof(line), "[%5llu.%06llu] [%s] [%s] %.*s\n",
+                           sec, usec, s_LevelNames[level], rec.tag,
+                           static_cast<int>(msgLen), msg);
+            size_t lineLen = std::min(static_cast<size_t>(len), sizeof(line) - 1);
+            if(m_Used + lineLen > sizeof(m_Buffer))
+            {
+                flushBuffer();
+            }
+            memcpy(m_Buffer + m_Used, line, lineLen);
+            m_Used += lineLen;
+        }
+    }
+
+    // Write the buffered output.
+    void Logger::flushBuffer(void)
+    {
+        if(m_Used == 0)
+        {
+            return;
+        }
+
+        unsigned int sinks = m_Sinks.load(std::memory_order_relaxed);
+        if(sinks & SINK_STDOUT)
+        {
+            writeAll(STDOUT_FILENO, m_Buffer, m_Used);
+        }
+        if((sinks & SINK_FILE) && m_FileFd >= 0)
+        {
+            writeAll(m_FileFd, m_Buffer, m_Used);
+        }
+        m_Used = 0;
+    }
+
+    // Stop the drain thread at exit, later records are written by their callers.
+    void Logger::shutdown(void)
+    {
+        Logger& logger = getInstance();
+
+        s_Stopped.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(logger.m_DrainLock);
+            logger.m_Stop.store(true);
+            logger.m_DrainRequested = true;
+        }
+        logger.m_DrainCond.notify_one();
+
+        std::thread drainThread;
+        {
+            std::lock_guard<std::mutex> lock(logger.m_RingLock);
+            drainThread.swap(logger.m_Thread);
+        }
+        if(drainThread.joinable())
+        {
+            drainThread.join();
+        }
+        logger.flush();
+    }
+} // namespace
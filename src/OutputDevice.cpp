@@ -25,7 +25,6 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <string>
-#include <boost/format.hpp>
 #include "EALog.h"
 #include "OutputDevice.hpp"
 
@@ -66,14 +65,7 @@ namespace earlyapp
     // Initialize.
     void OutputDevice::init(std::shared_ptr<Configuration> pConf)
     {
-        int gpioNumber = pConf->gpioNumber();
-        unsigned int sustainTime = pConf->gpioSustain();
-        if(gpioNumber > 0)
-        {
-            LINF_(TAG, boost::str(
-                      boost::format("Setting GPIO %d with default sleep time") % gpioNumber));
-            m_pGPIOCtrl = new GPIOControl(gpioNumber, sustainTime);
-        }
+        LINF_(TAG, "init()");
     }
 
     // Preapare for play.
@@ -109,22 +101,6 @@ namespace earlyapp
     // Destructor.
     OutputDevice::~OutputDevice(void)
     {
-        if(m_pGPIOCtrl != nullptr)
-        {
-            delete m_pGPIOCtrl;
-            m_pGPIOCtrl = nullptr;
-        }
-    }
-
-    // GPIO output KPI measurements.
-    void OutputDevice::outputGPIOPattern(void)
-    {
-        if(m_pGPIOCtrl == nullptr)
-        {
-            // No GPIO control.
-            return;
-        }
-        m_pGPIOCtrl->outputPattern();
     }
 
     // Device name.
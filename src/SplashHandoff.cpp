@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <atomic>
+#include <cstddef>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "EALog.h"
+#include "SplashHandoff.h"
+
+// Log tag.
+#define TAG "SPLASH"
+
+
+namespace earlyapp
+{
+    // Set once the first frame was reported.
+    static std::atomic<bool> s_Presented(false);
+
+    // Report the first presented frame to earlyapp-fastboot.
+    extern "C" void SplashHandoff_presented(const char* source)
+    {
+        if(s_Presented.exchange(true))
+        {
+            return;
+        }
+
+        int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if(fd < 0)
+        {
+            LERR_(TAG, "Failed to create the handoff socket: " << strerror(errno));
+            return;
+        }
+
+        // Abstract namespace address.
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path + 1, SPLASH_HANDOFF_NAME, sizeof(addr.sun_path) - 2);
+        socklen_t addrLen = offsetof(struct sockaddr_un, sun_path) + 1 + strlen(SPLASH_HANDOFF_NAME);
+
+        // Nobody listens when the splash screen is not up, that is fine.
+        if(sendto(fd, source, strlen(source), MSG_DONTWAIT,
+                  reinterpret_cast<struct sockaddr*>(&addr), addrLen) < 0)
+        {
+            LINF_(TAG, "No splash screen to hand off: " << strerror(errno));
+        }
+        else
+        {
+            LINF_(TAG, "Splash screen handed off by " << source);
+        }
+        close(fd);
+    }
+} // namespace
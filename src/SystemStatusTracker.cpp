@@ -24,7 +24,7 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <boost/format.hpp>
+#include <vector>
 
 #include "EALog.h"
 #include "SystemStatusTracker.hpp"
@@ -146,10 +146,8 @@ namespace earlyapp
         eSystemState prvState = m_SysState;
         eSystemState nextState = m_SysState;
 
-        LINF_(TAG, boost::str(
-                  boost::format("Current state: %s(%d), signal: %s(%d)")
-                  % stateToString() % m_SysState
-                  % CBCEvent::toString(e) % e));
+        LINF_(TAG, "Current state: " << stateToString() << "(" << m_SysState
+              << "), signal: " << CBCEvent::toString(e) << "(" << e << ")");
 
         switch(m_SysState)
         {
@@ -240,10 +238,8 @@ namespace earlyapp
             m_SysState = nextState;
             m_StateMtx.unlock();
 
-            LINF_(TAG, boost::str(
-                      boost::format("State changed from %s(%d) -> %s(%d)")
-                      % stateToString(prvState) % prvState
-                      % stateToString(nextState) % nextState));
+            LINF_(TAG, "State changed from " << stateToString(prvState) << "(" << prvState
+                  << ") -> " << stateToString(nextState) << "(" << nextState << ")");
 
             // Application exit control.
             if(nextState == eSTATE_EXIT)
@@ -256,10 +252,7 @@ namespace earlyapp
         }
         else
         {
-            LWRN_(TAG,
-                  boost::str(
-                      boost::format("State won't be changed from %s(%d).")
-                      % stateToString(prvState) % prvState));
+            LWRN_(TAG, "State won't be changed from " << stateToString(prvState) << "(" << prvState << ").");
 
             return false;
         }
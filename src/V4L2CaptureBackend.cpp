@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "EALog.h"
+#include "frame_mailbox.h"
+#include "capture_loop.h"
+#include "V4L2CaptureBackend.hpp"
+
+// Log tag.
+#define TAG "V4L2"
+
+
+namespace earlyapp
+{
+    // ioctl restarted on signals.
+    static int xioctl(int fd, unsigned long request, void* arg)
+    {
+        int ret;
+
+        do
+        {
+            ret = ioctl(fd, request, arg);
+        } while(ret == -1 && errno == EINTR);
+
+        return ret;
+    }
+
+    // Multi-planar buffer type?
+    bool V4L2CaptureBackend::isMplane(void) const
+    {
+        return m_Type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+    }
+
+    // Open the video node.
+    bool V4L2CaptureBackend::open(const capture_config& config)
+    {
+        struct v4l2_capability cap;
+        unsigned int caps;
+
+        m_Fd = ::open(config.device, O_RDONLY | O_CLOEXEC);
+        if(m_Fd < 0)
+        {
+            LERR_(TAG, "Failed to open " << config.device << ": " << strerror(errno));
+            return false;
+        }
+
+        memset(&cap, 0, sizeof(cap));
+        if(xioctl(m_Fd, VIDIOC_QUERYCAP, &cap) < 0)
+        {
+            LERR_(TAG, "VIDIOC_QUERYCAP failed: " << strerror(errno));
+            close();
+            return false;
+        }
+
+        caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+        LINF_(TAG, "Device " << (const char*) cap.card << " on " << (const char*) cap.bus_info);
+
+        // Single plane capture is preferred when the node supports both.
+        if(caps & V4L2_CAP_VIDEO_CAPTURE)
+        {
+            m_Type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        }
+        else if(caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE)
+        {
+            m_Type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        }
+        else
+        {
+            LERR_(TAG, config.device << " is not a capture device");
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Set the format and request the buffers.
+    bool V4L2CaptureBackend::configure(const capture_config& config, capture_format& format)
+    {
+        struct v4l2_format fmt;
+        struct v4l2_requestbuffers rqbufs;
+        enum v4l2_field field = config.interlaced ? V4L2_FIELD_ALTERNATE : V4L2_FIELD_NONE;
+
+        memset(&fmt, 0, sizeof(fmt));
+        fmt.type = m_Type;
+        if(isMplane())
+        {
+            fmt.fmt.pix_mp.width = config.width;
+            fmt.fmt.pix_mp.height = config.height;
+            fmt.fmt.pix_mp.pixelformat = config.fourcc;
+            fmt.fmt.pix_mp.field = field;
+            fmt.fmt.pix_mp.num_planes = 1;
+            fmt.fmt.pix_mp.plane_fmt[0].bytesperline = config.bytes_per_line;
+        }
+        else
+        {
+            fmt.fmt.pix.width = config.width;
+            fmt.fmt.pix.height = config.height;
+            fmt.fmt.pix.pixelformat = config.fourcc;
+            fmt.fmt.pix.field = field;
+            fmt.fmt.pix.bytesperline = config.bytes_per_line;
+            fmt.fmt.pix.priv = V4L2_PIX_FMT_PRIV_MAGIC;
+        }
+
+        if(xioctl(m_Fd, VIDIOC_S_FMT, &fmt) < 0)
+        {
+            LERR_(TAG, "VIDIOC_S_FMT failed: " << strerror(errno));
+            return false;
+        }
+
+        if(xioctl(m_Fd, VIDIOC_G_FMT, &fmt) < 0)
+        {
+            LERR_(TAG, "VIDIOC_G_FMT failed: " << strerror(errno));
+            return false;
+        }
+
+        format.bytes_per_pixel = config.bytes_per_pixel;
+        if(isMplane())
+        {
+            format.width = fmt.fmt.pix_mp.width;
+            format.height = fmt.fmt.pix_mp.height;
+            format.fourcc = fmt.fmt.pix_mp.pixelformat;
+            format.bytes_per_line = fmt.fmt.pix_mp.plane_fmt[0].bytesperline;
+            format.size = format.bytes_per_line ? fmt.fmt.pix_mp.plane_fmt[0].sizeimage : 0;
+        }
+        else
+        {
+            format.width = fmt.fmt.pix.width;
+            format.height = fmt.fmt.pix.height;
+            format.fourcc = fmt.fmt.pix.pixelformat;
+            format.bytes_per_line = fmt.fmt.pix.bytesperline;
+            format.size = format.bytes_per_line ? fmt.fmt.pix.sizeimage : 0;
+        }
+
+        // Some IPU drivers do not report the stride, it is then packed.
+        if(format.bytes_per_line == 0)
+            format.bytes_per_line = config.width * config.bytes_per_pixel;
+        if(format.size == 0)
+            format.size = format.bytes_per_line * config.height;
+
+        LINF_(TAG, "Format " << format.width << "x" << format.height
+              << ", stride " << format.bytes_per_line << ", buffer size " << format.size);
+
+        switch(config.memory)
+        {
+        case CAPTURE_MEMORY_EXPORTED:
+            m_Memory = V4L2_MEMORY_MMAP;
+            break;
+        case CAPTURE_MEMORY_USERPTR:
+            m_Memory = V4L2_MEMORY_USERPTR;
+            break;
+        default:
+            m_Memory = V4L2_MEMORY_DMABUF;
+            break;
+        }
+
+        memset(&rqbufs, 0, sizeof(rqbufs));
+        rqbufs.count = config.buffer_count;
+        rqbufs.type = m_Type;
+        rqbufs.memory = m_Memory;
+        if(xioctl(m_Fd, VIDIOC_REQBUFS, &rqbufs) < 0)
+        {
+            LERR_(TAG, "VIDIOC_REQBUFS failed: " << strerror(errno));
+            return false;
+        }
+        if(rqbufs.count < config.buffer_count)
+        {
+            LERR_(TAG, "Video node allocated only " << rqbufs.count
+                  << " of " << config.buffer_count << " buffers");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Export an MMAP buffer as dmabuf.
+    int V4L2CaptureBackend::exportBuffer(unsigned int index)
+    {
+        struct v4l2_exportbuffer expbuf;
+
+        memset(&expbuf, 0, sizeof(expbuf));
+        expbuf.type = m_Type;
+        expbuf.index = index;
+        expbuf.flags = O_CLOEXEC;
+        if(xioctl(m_Fd, VIDIOC_EXPBUF, &expbuf) < 0)
+        {
+            LERR_(TAG, "VIDIOC_EXPBUF failed: " << strerror(errno));
+            return -1;
+        }
+
+        return expbuf.fd;
+    }
+
+    // Queue a buffer.
+    bool V4L2CaptureBackend::queue(const capture_buffer& buffer)
+    {
+        struct v4l2_buffer buf;
+        struct v4l2_plane plane;
+
+        memset(&buf, 0, sizeof(buf));
+        memset(&plane, 0, sizeof(plane));
+        buf.type = m_Type;
+        buf.memory = m_Memory;
+        buf.index = buffer.index;
+
+        if(isMplane())
+        {
+            buf.m.planes = &plane;
+            buf.length = 1;
+            if(m_Memory == V4L2_MEMORY_DMABUF)
+                plane.m.fd = buffer.dmabuf_fd;
+            else if(m_Memory == V4L2_MEMORY_USERPTR)
+                plane.m.userptr = (unsigned long) buffer.data;
+            plane.length = buffer.size;
+        }
+        else
+        {
+            if(m_Memory == V4L2_MEMORY_DMABUF)
+                buf.m.fd = buffer.dmabuf_fd;
+            else if(m_Memory == V4L2_MEMORY_USERPTR)
+                buf.m.userptr = (unsigned long) buffer.data;
+            buf.length = buffer.size;
+        }
+
+        if(xioctl(m_Fd, VIDIOC_QBUF, &buf) < 0)
+        {
+            LERR_(TAG, "VIDIOC_QBUF failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Dequeue a captured buffer.
+    int V4L2CaptureBackend::dequeue(capture_frame& frame)
+    {
+        struct v4l2_buffer buf;
+        struct v4l2_plane planes[VIDEO_MAX_PLANES];
+
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type = m_Type;
+        buf.memory = m_Memory;
+        if(isMplane())
+        {
+            buf.m.planes = planes;
+            buf.length = VIDEO_MAX_PLANES;
+        }
+
+        if(xioctl(m_Fd, VIDIOC_DQBUF, &buf) < 0)
+        {
+            if(errno == EAGAIN)
+                return -1;
+
+            LERR_(TAG, "VIDIOC_DQBUF failed: " << strerror(errno));
+            return CAPTURE_ERROR;
+        }
+
+        if(buf.field == V4L2_FIELD_TOP)
+            frame.field = CAPTURE_FIELD_TOP;
+        else if(buf.field == V4L2_FIELD_BOTTOM)
+            frame.field = CAPTURE_FIELD_BOTTOM;
+        else
+            frame.field = CAPTURE_FIELD_NONE;
+
+        // Prefer the driver timestamp when it is in the CLOCK_MONOTONIC domain.
+        if((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+           && (buf.timestamp.tv_sec || buf.timestamp.tv_usec))
+            frame.timestamp_ns = capture_timeval_ns(&buf.timestamp);
+        else
+            frame.timestamp_ns = frame_mailbox_now_ns();
+        frame.sequence = buf.sequence;
+        frame.index = buf.index;
+
+        return buf.index;
+    }
+
+    // Stream on.
+    bool V4L2CaptureBackend::streamOn(void)
+    {
+        int type = m_Type;
+
+        if(xioctl(m_Fd, VIDIOC_STREAMON, &type) < 0)
+        {
+            LERR_(TAG, "VIDIOC_STREAMON failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Stream off.
+    bool V4L2CaptureBackend::streamOff(void)
+    {
+        int type = m_Type;
+
+        if(xioctl(m_Fd, VIDIOC_STREAMOFF, &type) < 0)
+        {
+            LERR_(TAG, "VIDIOC_STREAMOFF failed: " << strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    // Close the video node.
+    void V4L2CaptureBackend::close(void)
+    {
+        if(m_Fd >= 0)
+        {
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+    }
+
+} // namespace
@@ -25,7 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <string>
-#include <boost/format.hpp>
+#include <chrono>
 
 #include "EALog.h"
 #include "OutputDevice.hpp"
@@ -75,7 +75,7 @@ namespace earlyapp
     {
         OutputDevice::init(pConf);
 
-        m_pDecPipeline = new CDecodingPipeline(m_pGPIOCtrl);
+        m_pDecPipeline = new CDecodingPipeline();
         if(m_pDecPipeline == nullptr)
         {
             LERR_(TAG, "Failed to create decoder instance.");
@@ -86,9 +86,27 @@ namespace earlyapp
         m_Params.bUseFullColorRange = false;
         m_Params.videoType = MFX_CODEC_AVC;
 
+        // Decoding mode, the headless ones need neither Wayland nor a display.
+        const std::string& mode = pConf->videoMode();
         m_Params.mode = MODE_RENDERING;
-        m_Params.memType = D3D9_MEMORY;
-        m_Params.mode = MODE_RENDERING;
+        m_Params.bNullRender = false;
+        if(mode.compare("null") == 0)
+        {
+            m_Params.bNullRender = true;
+        }
+        else if(mode.compare("performance") == 0)
+        {
+            m_Params.mode = MODE_PERFORMANCE;
+        }
+        else if(mode.compare("dump") == 0)
+        {
+            m_Params.mode = MODE_FILE_DUMP;
+            strncpy(m_Params.strDstFile, pConf->videoDumpPath().c_str(), MSDK_MAX_FILENAME_LEN - 1);
+        }
+
+        // Surface memory, D3D9_MEMORY stands for VA surfaces.
+        m_Params.memType = (pConf->videoMemory().compare("system") == 0) ?
+            SYSTEM_MEMORY : D3D9_MEMORY;
 
         // File path.
         strcpy(m_Params.strSrcFile, pConf->videoSplashPath().c_str());
@@ -101,11 +119,24 @@ namespace earlyapp
         // Default ASync depth.
         m_Params.nAsyncDepth = 4;
 
+        // Presentation scheduling.
+        m_Params.presentMode = (pConf->videoPresentMode().compare("mailbox") == 0) ?
+            PRESENT_MODE_MAILBOX : PRESENT_MODE_FIFO;
+        m_Params.nPresentQueueDepth = pConf->videoPresentQueue();
+
+        // Frame rate limit.
+        m_Params.nMaxFPS = pConf->videoMaxFPS();
+        m_Params.pacingPolicy = (pConf->videoPacing().compare("drop") == 0) ?
+            PACING_DROP_LATE : PACING_CATCH_UP;
+
         // Initialize decoding pipeline.
+        auto start = std::chrono::steady_clock::now();
         m_pDecPipeline->Init(&m_Params);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        m_bPlayed = false;
 
-        
-        LINF_(TAG, "VideoDevice initialized.");
+        LINF_(TAG, "VideoDevice initialized in " << elapsed.count() / 1000.0 << " ms.");
     }
 
     /*
@@ -115,6 +146,29 @@ namespace earlyapp
     {
         LINF_(TAG, "VideoDevice play");
 
+        if(m_pDecPipeline == nullptr)
+        {
+            LERR_(TAG, "Decoder is not initialized.");
+            return;
+        }
+
+        // Replay reuses the session, surfaces and Wayland surface.
+        if(m_bPlayed)
+        {
+            auto start = std::chrono::steady_clock::now();
+            mfxStatus sts = m_pDecPipeline->Restart();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+
+            if(sts != MFX_ERR_NONE)
+            {
+                LERR_(TAG, "Failed to restart decoder (" << sts << ").");
+                return;
+            }
+            LINF_(TAG, "VideoDevice restarted in " << elapsed.count() / 1000.0 << " ms.");
+        }
+        m_bPlayed = true;
+
         // Start decoding and display.
         m_pDecPipeline->RunDecoding();
     }
@@ -126,11 +180,10 @@ namespace earlyapp
     {
         LINF_(TAG, "VideoDevice stop");
 
-        // Stop play
+        // Stop play, the pipeline is kept for a fast replay.
         if(m_pDecPipeline)
         {
-            delete m_pDecPipeline;
-            m_pDecPipeline = nullptr;
+            m_pDecPipeline->Stop();
         }
     }
 
@@ -141,7 +194,11 @@ namespace earlyapp
     {
         LINF_(TAG, "VideoDevice terminate");
 
-        // TODO: release resources.
+        if(m_pDecPipeline)
+        {
+            delete m_pDecPipeline;
+            m_pDecPipeline = nullptr;
+        }
 
     }
 } // namespace
@@ -29,7 +29,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
-#include <boost/format.hpp>
+#include <unistd.h>
 
 #include "EALog.h"
 #include "VirtualCBCEventDevice.hpp"
@@ -57,11 +57,7 @@ namespace earlyapp
             else
             {
                 m_bOpenSuccess = false;
-                LERR_(TAG,
-                      boost::str(
-                          boost::format("Failed to open device %s (%s)")
-                          % cbcDevice
-                          % strerror(errno)));
+                LERR_(TAG, "Failed to open device " << cbcDevice << " (" << strerror(errno) << ")");
             }
         }
     }
@@ -102,11 +98,7 @@ namespace earlyapp
         CBCEvent::eCBCEvent cbcEv = (CBCEvent::eCBCEvent) atoi((const char*) cbcSignalBuffer);
         std::shared_ptr<CBCEvent> e = std::make_shared<CBCEvent>(cbcEv);
 
-        LINF_(TAG,
-              boost::str(
-                  boost::format("Got an event %s:%d")
-                  %e->toString()
-                  %e->toEnum()));
+        LINF_(TAG, "Got an event " << e->toString() << ":" << e->toEnum());
 
         // Erase previous data in the file.
         close(m_fdCBCDev);
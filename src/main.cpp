@@ -30,7 +30,6 @@
 #include <boost/thread.hpp>
 #include <boost/bind.hpp>
 #include <boost/program_options.hpp>
-#include <boost/format.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <fcntl.h>
 
@@ -42,10 +41,12 @@
 #include "SystemStatusTracker.hpp"
 #include "DeviceController.hpp"
 #include "Configuration.hpp"
-#include "GPIOControl.hpp"
+#include "KpiMarker.hpp"
+#include "Logger.hpp"
 
 #include "GStreamerApp.hpp"
 #include "simple-egl.h"
+#include "sw_convert.h"
 
 // A log tag for main.
 #define TAG "MAIN"
@@ -73,6 +74,9 @@ void handleProgramLaunchingError(const std::exception& e)
 
 int main(int argc, char* argv[])
 {
+    // Program loading is done, see the startup benchmark.
+    KPI_MARK("startup_main");
+
     int fd;
     int ret;
     char buf[8];
@@ -93,11 +97,43 @@ int main(int argc, char* argv[])
      */
     std::shared_ptr<earlyapp::Configuration> pConf =
         earlyapp::Configuration::makeConfiguration(argc, argv);
+    KPI_MARK("startup_config");
     if(! pConf->isValid())
     {
         return -1;
     }
 
+    /*
+      Configuration snapshot for the next starts.
+     */
+    if(pConf->compileConfig())
+    {
+        return pConf->writeSnapshot(argc, argv) ? 0 : -1;
+    }
+
+    /*
+      CPU camera frame conversion benchmark.
+     */
+    if(pConf->cameraConvertBenchmark())
+    {
+        return sw_convert_benchmark();
+    }
+
+
+    /*
+      Log outputs.
+     */
+    if(! earlyapp::Logger::getInstance().setSinks(pConf->logSinks(), pConf->logFile()))
+    {
+        std::cerr << "WARNING: Failed to open log output " << pConf->logSinks() << std::endl;
+    }
+
+
+    /*
+      KPI marker outputs.
+     */
+    earlyapp::KpiMarker::getInstance().setup(pConf);
+
 
     /*
       GStreamer.
@@ -162,18 +198,10 @@ int main(int argc, char* argv[])
         LERR_(TAG, "Failed to initialize devices.");
         return -1;
     }
-
-    void* gp_pGPIOClass = NULL;
-    gp_pGPIOClass = earlyapp::GPIOControl_create(pConf->gpioNumber(), pConf->gpioSustain());
+    KPI_MARK("startup_devices");
 
     if (( pEv != nullptr ) && (pEv->toEnum() == earlyapp::CBCEvent::eGEARSTATUS_EGL)) {
-	void* gles_pGPIOClass = NULL;
-	if(pConf->gpioNumber() != pConf->NOT_SET)
-        {
-            gles_pGPIOClass = earlyapp::GPIOControl_create(pConf->gpioNumber(), pConf->gpioSustain());
-        }
-
-        simple_egl_main(gles_pGPIOClass);
+        simple_egl_main();
     }
 
     /*
@@ -316,6 +344,7 @@ int main(int argc, char* argv[])
     // Release resources.
     delete evDev;
     delete pThreadGrp;
+    earlyapp::KpiMarker::getInstance().release();
     LINF_(TAG, "Finishing...");
 
 #ifdef USE_DMESGLOG
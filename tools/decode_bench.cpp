@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+
+/*
+  Decoding pipeline into CNullDevice, without Wayland or a display.
+
+  Cold runs do Init(), RunDecoding() and Close() of a new CDecodingPipeline,
+  warm runs Stop() and Restart() one pipeline between RunDecoding() calls.
+  Prints per run the initialization or restart time, the decoding rate, the
+  time spent reading the input and delivering frames, the surface
+  allocations and the frame intervals seen by the null device.
+
+  Then checks that Restart() on a pipeline stopped before it drained gives
+  back the surfaces left in flight, and that the next run decodes as many
+  frames again.
+
+  Usage: decode_bench <file.h264> [runs] [video|system]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipeline_decode.h"
+#include "null_device.h"
+
+
+// Exposes the counters the pipeline keeps for itself.
+class CDecodeBench: public CDecodingPipeline
+{
+public:
+    void PrintStats(const char* setup, mfxF64 setupSeconds)
+    {
+        mfxHDL hdl = NULL;
+        mfxF64 seconds = CTimer::ConvertToSeconds(m_tick_overall);
+
+        printf("%s %.3f ms, %u frames in %.3f s, %.2f fps, fread %.3f ms, fwrite %.3f ms\n",
+            setup,
+            setupSeconds * 1000,
+            m_output_count,
+            seconds,
+            (seconds > 0) ? m_output_count / seconds : 0.0,
+            CTimer::ConvertToSeconds(m_tick_fread) * 1000,
+            CTimer::ConvertToSeconds(m_tick_fwrite) * 1000);
+        if(m_pGeneralAllocator)
+        {
+            printf("  %u allocations, %u video and %u system frames\n",
+                m_pGeneralAllocator->GetAllocRequests(),
+                m_pGeneralAllocator->GetAllocFrames(true),
+                m_pGeneralAllocator->GetAllocFrames(false));
+        }
+        if(m_hwdev && (MFX_ERR_NONE == m_hwdev->GetHandle((mfxHandleType)HANDLE_NULL_DEVICE, &hdl)))
+        {
+            printf("  ");
+            fflush(stdout);
+            ((CNullDevice*)hdl)->PrintStats();
+        }
+    }
+
+    mfxU32 GetOutputCount() { return m_output_count; }
+
+    // Leaves the surfaces of a decoding iteration cut short in flight,
+    // as a stop between taking them and submitting the frame does.
+    bool TakeCurrentSurfaces()
+    {
+        SyncFrameSurfaces();
+        if(!m_pCurrentFreeSurface)
+        {
+            m_pCurrentFreeSurface = m_FreeSurfacesPool.GetSurface();
+        }
+        if(!m_pCurrentFreeOutputSurface)
+        {
+            m_pCurrentFreeOutputSurface = GetFreeOutputSurface();
+        }
+        return m_pCurrentFreeSurface && m_pCurrentFreeOutputSurface;
+    }
+
+    // Nothing may be left in flight after Restart().
+    bool IsIdle()
+    {
+        bool idle = true;
+
+        if(m_pCurrentFreeSurface || m_pCurrentFreeOutputSurface ||
+            m_pCurrentFreeVppSurface || m_pCurrentOutputSurface)
+        {
+            printf("current surfaces left: free %p, output %p, vpp %p, synced %p\n",
+                (void*)m_pCurrentFreeSurface, (void*)m_pCurrentFreeOutputSurface,
+                (void*)m_pCurrentFreeVppSurface, (void*)m_pCurrentOutputSurface);
+            idle = false;
+        }
+        if(m_OutputSurfacesPool.GetSurfaceCount() || m_DeliveredSurfacesPool.GetSurfaceCount())
+        {
+            printf("output surfaces left: %u decoded, %u delivered\n",
+                m_OutputSurfacesPool.GetSurfaceCount(),
+                m_DeliveredSurfacesPool.GetSurfaceCount());
+            idle = false;
+        }
+        for(mfxU32 i = 0; i < m_SurfacesNumber; i++)
+        {
+            if(m_pSurfaces[i].render_lock)
+            {
+                printf("surface %u still render locked\n", i);
+                idle = false;
+            }
+        }
+        return idle;
+    }
+};
+
+static bool coldRun(sInputParams& params, int run)
+{
+    CDecodeBench pipeline;
+    CTimer timer;
+
+    timer.Start();
+    mfxStatus sts = pipeline.Init(&params);
+    mfxF64 seconds = timer.GetTime();
+    if(sts != MFX_ERR_NONE)
+    {
+        fprintf(stderr, "Init failed: %d\n", sts);
+        return false;
+    }
+
+    sts = pipeline.RunDecoding();
+    if(sts != MFX_ERR_NONE)
+    {
+        fprintf(stderr, "RunDecoding failed: %d\n", sts);
+        return false;
+    }
+
+    printf("cold %d: ", run);
+    pipeline.PrintStats("init", seconds);
+    return true;
+}
+
+static bool warmRuns(sInputParams& params, int runs)
+{
+    CDecodeBench pipeline;
+
+    if((pipeline.Init(&params) != MFX_ERR_NONE) ||
+        (pipeline.RunDecoding() != MFX_ERR_NONE))
+    {
+        fprintf(stderr, "First run failed\n");
+        return false;
+    }
+
+    for(int i = 0; i < runs; i++)
+    {
+        CTimer timer;
+
+        timer.Start();
+        pipeline.Stop();
+        mfxStatus sts = pipeline.Restart();
+        mfxF64 seconds = timer.GetTime();
+        if(sts != MFX_ERR_NONE)
+        {
+            fprintf(stderr, "Restart failed: %d\n", sts);
+            return false;
+        }
+
+        sts = pipeline.RunDecoding();
+        if(sts != MFX_ERR_NONE)
+        {
+            fprintf(stderr, "RunDecoding failed: %d\n", sts);
+            return false;
+        }
+
+        printf("warm %d: ", i);
+        pipeline.PrintStats("restart", seconds);
+    }
+    return true;
+}
+
+// Restart() of a pipeline stopped after a few frames, with decoded frames
+// not delivered yet and the surfaces of the next iteration taken.
+static bool restartBeforeDrain(sInputParams params)
+{
+    CDecodeBench pipeline;
+
+    params.nFrames = 8;
+    if((pipeline.Init(&params) != MFX_ERR_NONE) ||
+        (pipeline.RunDecoding() != MFX_ERR_NONE))
+    {
+        fprintf(stderr, "Partial run failed\n");
+        return false;
+    }
+    if(!pipeline.TakeCurrentSurfaces())
+    {
+        fprintf(stderr, "No free surfaces left after the partial run\n");
+        return false;
+    }
+
+    pipeline.Stop();
+    if(pipeline.Restart() != MFX_ERR_NONE)
+    {
+        fprintf(stderr, "Restart failed\n");
+        return false;
+    }
+    if(!pipeline.IsIdle())
+    {
+        return false;
+    }
+
+    if(pipeline.RunDecoding() != MFX_ERR_NONE)
+    {
+        fprintf(stderr, "RunDecoding after Restart failed\n");
+        return false;
+    }
+    if(pipeline.GetOutputCount() != params.nFrames)
+    {
+        printf("%u frames after Restart, expected %u\n",
+            pipeline.GetOutputCount(), params.nFrames);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file.h264> [runs] [video|system]\n", argv[0]);
+        return 1;
+    }
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+    bool systemMemory = (argc > 3) && (strcmp(argv[3], "system") == 0);
+
+    // Same parameters as VideoDevice, with the null renderer.
+    sInputParams params;
+    params.bUseHWLib = true;
+    params.videoType = MFX_CODEC_AVC;
+    params.mode = MODE_RENDERING;
+    params.bNullRender = true;
+    params.memType = systemMemory ? SYSTEM_MEMORY : D3D9_MEMORY;
+    params.nAsyncDepth = 4;
+    params.presentMode = PRESENT_MODE_FIFO;
+    params.pacingPolicy = PACING_CATCH_UP;
+    strncpy(params.strSrcFile, argv[1], MSDK_MAX_FILENAME_LEN - 1);
+
+    for(int i = 0; i < runs; i++)
+    {
+        if(!coldRun(params, i))
+        {
+            return 1;
+        }
+    }
+    if(!warmRuns(params, runs))
+    {
+        return 1;
+    }
+
+    bool drained = restartBeforeDrain(params);
+    printf("restart before drain: %s\n", drained ? "ok" : "FAILED");
+
+    return drained ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+  Frame pacing of the decoder, CFramePacer against the MSDK_SLEEP(0) loop it
+  replaced, at the same frame rate with the same simulated render time.
+
+  Prints the CPU time the render thread spends waiting, and the jitter of the
+  frame release times: against the frame period between two frames, and the
+  drift from the ideal timeline at the end.
+
+  Usage: frame_pacer_bench [fps] [frames] [render_us]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "frame_pacer.h"
+#include "vm/time_defs.h"
+
+
+struct sResult
+{
+    mfxU64 waitCpu;     // thread CPU time spent waiting, ns
+    mfxU64 jitterSum;   // |release interval - period|, ns
+    mfxU64 jitterMax;
+    mfxI64 drift;       // last release - ideal release time, ns
+};
+
+static mfxU64 getTime(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (mfxU64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Stands in for RenderFrame(), busy for the given time.
+static void render(mfxU64 ns)
+{
+    mfxU64 end = getTime(CLOCK_MONOTONIC) + ns;
+    while(getTime(CLOCK_MONOTONIC) < end)
+        ;
+}
+
+static void addRelease(sResult& r, mfxU64* releases, mfxU32 n, mfxU64 period)
+{
+    if(n == 0)
+    {
+        return;
+    }
+    mfxU64 interval = releases[n] - releases[n - 1];
+    mfxU64 jitter = (interval > period) ? interval - period : period - interval;
+    r.jitterSum += jitter;
+    if(jitter > r.jitterMax)
+    {
+        r.jitterMax = jitter;
+    }
+}
+
+// CFramePacer as the decoder calls it, before every rendered frame.
+static sResult runPacer(mfxU32 fps, mfxU32 frames, mfxU64 renderNs, mfxU64* releases)
+{
+    sResult r = sResult();
+    mfxU64 period = 1000000000ULL / fps;
+    CFramePacer pacer;
+    pacer.Init(fps, 1, PACING_CATCH_UP);
+
+    for(mfxU32 n = 0; n <= frames; ++n)
+    {
+        mfxU64 cpu = getTime(CLOCK_THREAD_CPUTIME_ID);
+        pacer.WaitForDeadline((mfxU64)-1);
+        releases[n] = getTime(CLOCK_MONOTONIC);
+        r.waitCpu += getTime(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+        addRelease(r, releases, n, period);
+        render(renderNs);
+    }
+    r.drift = (mfxI64)(releases[frames] - releases[0]) - (mfxI64)(frames * period);
+    return r;
+}
+
+// The loop of CDecodingPipeline::DeliverOutput before the pacer.
+static sResult runSpin(mfxU32 fps, mfxU32 frames, mfxU64 renderNs, mfxU64* releases)
+{
+    sResult r = sResult();
+    mfxU64 period = 1000000000ULL / fps;
+    msdk_tick delayTicks = msdk_time_get_frequency() / fps;
+    msdk_tick startTick = 0;
+
+    for(mfxU32 n = 0; n <= frames; ++n)
+    {
+        render(renderNs);
+
+        mfxU64 cpu = getTime(CLOCK_THREAD_CPUTIME_ID);
+        while( delayTicks && (startTick + delayTicks > msdk_time_get_tick()) )
+        {
+            MSDK_SLEEP(0);
+        };
+        startTick=msdk_time_get_tick();
+        releases[n] = getTime(CLOCK_MONOTONIC);
+        r.waitCpu += getTime(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+        addRelease(r, releases, n, period);
+    }
+    r.drift = (mfxI64)(releases[frames] - releases[0]) - (mfxI64)(frames * period);
+    return r;
+}
+
+static void report(const char* name, const sResult& r, mfxU32 frames)
+{
+    printf("%-14s wait CPU %8.3f ms (%6.1f us/frame)  jitter avg %7.3f ms, max %7.3f ms  drift %+8.3f ms\n",
+           name, r.waitCpu / 1e6, r.waitCpu / 1e3 / frames,
+           r.jitterSum / 1e6 / frames, r.jitterMax / 1e6, r.drift / 1e6);
+}
+
+
+int main(int argc, char** argv)
+{
+    mfxU32 fps = (argc > 1) ? strtoul(argv[1], NULL, 0) : 30;
+    mfxU32 frames = (argc > 2) ? strtoul(argv[2], NULL, 0) : 150;
+    mfxU64 renderNs = ((argc > 3) ? strtoull(argv[3], NULL, 0) : 5000) * 1000;
+
+    if(fps == 0 || frames == 0 || renderNs >= 1000000000ULL / fps)
+    {
+        fprintf(stderr, "usage: %s [fps] [frames] [render_us], render time below the frame period\n", argv[0]);
+        return 1;
+    }
+
+    mfxU64* releases = new mfxU64[frames + 1];
+    printf("%u fps, %u frames, %.3f ms render\n", fps, frames, renderNs / 1e6);
+    report("CFramePacer", runPacer(fps, frames, renderNs, releases), frames);
+    report("MSDK_SLEEP(0)", runSpin(fps, frames, renderNs, releases), frames);
+    delete[] releases;
+    return 0;
+}
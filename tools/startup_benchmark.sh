@@ -0,0 +1,88 @@
+#!/bin/bash
+#
+# Copyright (C) 2018 Intel Corporation
+#
+# SPDX-License-Identifier: MIT
+#
+# Startup time of earlyapp: execve to main(), to the configuration and to the
+# first device initialization.
+#
+# Usage: startup_benchmark.sh <earlyapp> <KPI state dir> [runs] [-- earlyapp options]
+#
+# The execve time is the sched_process_exec trace event, main(), the configuration
+# and the device initialization are the startup_main, startup_config and
+# startup_devices KPI markers written to the ftrace marker. Needs root for
+# tracefs and the KPI state directory.
+
+EXE=$1
+KPI_STATE_DIR=$2
+RUNS=${3:-10}
+shift 3 2>/dev/null || shift $#
+[ "$1" == "--" ] && shift
+
+if [ ! -x "$EXE" ] || [ -z "$KPI_STATE_DIR" ]
+then
+	echo "Usage: $0 <earlyapp> <KPI state dir> [runs] [-- earlyapp options]"
+	exit 1
+fi
+
+TRACING=/sys/kernel/tracing
+[ -e $TRACING/trace_marker ] || TRACING=/sys/kernel/debug/tracing
+if [ ! -w $TRACING/trace_marker ]
+then
+	echo "No writable tracefs, run as root"
+	exit 1
+fi
+
+# Trace times in CLOCK_BOOTTIME, as the KPI markers.
+OLD_CLOCK=$(sed 's/.*\[\(.*\)\].*/\1/' $TRACING/trace_clock)
+echo boot > $TRACING/trace_clock
+echo 1 > $TRACING/events/sched/sched_process_exec/enable
+echo 1 > $TRACING/tracing_on
+
+function restore_tracing()
+{
+	echo 0 > $TRACING/events/sched/sched_process_exec/enable
+	echo $OLD_CLOCK > $TRACING/trace_clock
+}
+trap restore_tracing EXIT
+
+RESULTS=$(mktemp)
+
+echo "run  exec->main(ms)  main->config(ms)  main->devices(ms)  exec->devices(ms)"
+for i in `seq 1 $RUNS`
+do
+	# The markers are output once per boot.
+	rm -f $KPI_STATE_DIR/startup_main $KPI_STATE_DIR/startup_config $KPI_STATE_DIR/startup_devices
+	echo > $TRACING/trace
+
+	"$EXE" --kpi-sinks trace "$@" > /dev/null 2>&1 &
+	PID=$!
+
+	# Wait up to 10 s for the devices.
+	for t in `seq 1 1000`
+	do
+		grep -q "earlyapp KPI startup_devices" $TRACING/trace && break
+		kill -0 $PID 2>/dev/null || break
+		sleep 0.01
+	done
+	kill $PID 2>/dev/null
+	wait $PID 2>/dev/null
+
+	awk -v pid=$PID -v run=$i '
+		/sched_process_exec:/ && $0 ~ ("pid=" pid " ") {
+			for(f = 1; f <= NF; f++) if($(f + 1) == "sched_process_exec:") { sub(":", "", $f); exec = $f }
+		}
+		/earlyapp KPI startup_main / { main = $NF }
+		/earlyapp KPI startup_config / { config = $NF }
+		/earlyapp KPI startup_devices / { devices = $NF }
+		END {
+			if(exec == "" || main == "" || config == "" || devices == "") { printf("%3d  incomplete trace\n", run); exit }
+			printf("%3d  %14.3f  %16.3f  %17.3f  %17.3f\n", run,
+			       (main - exec) * 1000, (config - main) * 1000, (devices - main) * 1000, (devices - exec) * 1000)
+		}' $TRACING/trace | tee -a $RESULTS
+done
+
+awk '$2 != "incomplete" { n++; a += $2; b += $3; c += $4; d += $5 }
+	END { if(n) printf("avg  %14.3f  %16.3f  %17.3f  %17.3f\n", a / n, b / n, c / n, d / n) }' $RESULTS
+rm -f $RESULTS
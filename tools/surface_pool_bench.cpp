@@ -0,0 +1,422 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+// OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+// OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// SPDX-License-Identifier: MIT
+//
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+  Producer/consumer harness of the CBuffering surface pools, without a GPU.
+
+  Checks that the free surface bitmap hands out each surface once, runs dry
+  and refills across bitmap words, and that the output ring keeps FIFO order
+  through wrap-around of its indices. Then times a frame handoff between a
+  decoding and a delivering thread against the mutex guarded lists the pools
+  replaced.
+
+  Usage: surface_pool_bench [frames]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "mfx_buffering.h"
+
+
+// Frame surfaces of a decoder with VPP, over one bitmap word.
+#define POOL_SURFACES 70
+
+// Surfaces in flight in the handoff benchmark, as the decoder uses.
+#define HANDOFF_SURFACES 16
+
+static int s_Failures = 0;
+
+#define CHECK(cond) \
+    do { if(!(cond)) { fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); ++s_Failures; } } while(0)
+
+
+// Pools set up the way CBuffering does.
+class FreePool: public msdkFreeSurfacesPool
+{
+public:
+    void Init(msdkFrameSurface* surfaces, mfxU32 count)
+    {
+        m_pSurfaces = surfaces;
+        m_Free.Alloc(count);
+        for(mfxU32 i = 0; i < count; ++i)
+        {
+            AddSurface(&surfaces[i]);
+        }
+    }
+};
+
+class UsedPool: public msdkUsedSurfacesPool
+{
+public:
+    void Init(msdkFrameSurface* surfaces, mfxU32 count)
+    {
+        m_pSurfaces = surfaces;
+        m_Used.Alloc(count);
+    }
+
+    bool IsUsed(mfxU32 index)
+    {
+        return (m_Used.GetWord(index / MSDK_BITMAP_WORD_BITS) >> (index % MSDK_BITMAP_WORD_BITS)) & 1;
+    }
+};
+
+class OutputRing: public msdkOutputSurfacesPool
+{
+public:
+    void Init(mfxU32 count, mfxU32 firstIndex = 0)
+    {
+        Alloc(count);
+        m_Head = m_Tail = firstIndex;
+    }
+
+    mfxU32 Size(void)
+    {
+        return m_Mask + 1;
+    }
+};
+
+
+static unsigned long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned long long threadCpuNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+// Free surfaces run dry, come back lowest index first, across bitmap words.
+static void checkExhaustion(void)
+{
+    static msdkFrameSurface surfaces[POOL_SURFACES];
+    FreePool pool;
+    pool.Init(surfaces, POOL_SURFACES);
+
+    bool taken[POOL_SURFACES] = { false };
+    for(mfxU32 i = 0; i < POOL_SURFACES; ++i)
+    {
+        msdkFrameSurface* s = pool.GetSurface();
+        CHECK(s == &surfaces[i]);
+        if(s != NULL)
+        {
+            CHECK(!taken[s - surfaces]);
+            taken[s - surfaces] = true;
+        }
+    }
+    CHECK(pool.GetSurface() == NULL);
+    CHECK(pool.GetSurface() == NULL);
+
+    // One back in each word, the lower one is handed out first.
+    pool.AddSurface(&surfaces[66]);
+    pool.AddSurface(&surfaces[3]);
+    CHECK(pool.GetSurface() == &surfaces[3]);
+    CHECK(pool.GetSurface() == &surfaces[66]);
+    CHECK(pool.GetSurface() == NULL);
+
+    // Used surfaces are set and cleared by index.
+    UsedPool used;
+    used.Init(surfaces, POOL_SURFACES);
+    used.AddSurface(&surfaces[0]);
+    used.AddSurface(&surfaces[69]);
+    CHECK(used.IsUsed(0) && used.IsUsed(69) && !used.IsUsed(1));
+    used.DetachSurface(&surfaces[69]);
+    CHECK(!used.IsUsed(69) && used.IsUsed(0));
+}
+
+// FIFO order, full and empty detection, through index wrap-around.
+static void checkRingWrap(void)
+{
+    static msdkOutputSurface outputs[8];
+
+    // Starting below UINT32_MAX makes head and tail wrap as well.
+    OutputRing ring;
+    ring.Init(3, 0xfffffff0u);
+    CHECK(ring.Size() == 4);
+
+    mfxU32 added = 0;
+    mfxU32 got = 0;
+    for(int round = 0; round < 40; ++round)
+    {
+        // Fill up, one more must be refused.
+        mfxU32 fill = (round % ring.Size()) + 1;
+        for(mfxU32 i = 0; i < fill; ++i)
+        {
+            CHECK(ring.AddSurface(&outputs[added % 8]));
+            ++added;
+        }
+        if(fill == ring.Size())
+        {
+            CHECK(!ring.AddSurface(&outputs[0]));
+        }
+        CHECK(ring.GetSurfaceCount() == fill);
+
+        for(mfxU32 i = 0; i < fill; ++i)
+        {
+            CHECK(ring.GetSurface() == &outputs[got % 8]);
+            ++got;
+        }
+        CHECK(ring.GetSurface() == NULL);
+        CHECK(ring.GetSurfaceCount() == 0);
+    }
+    CHECK(added == got);
+}
+
+
+// The pools before: a LIFO free list and a FIFO output list under one mutex.
+struct LockedPools
+{
+    std::mutex lock;
+    msdkFrameSurface* freeList[HANDOFF_SURFACES];
+    int freeCount = 0;
+    msdkOutputSurface* fifo[HANDOFF_SURFACES];
+    unsigned int head = 0;
+    unsigned int tail = 0;
+
+    msdkFrameSurface* getFree(void)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return freeCount ? freeList[--freeCount] : NULL;
+    }
+    void addFree(msdkFrameSurface* s)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        freeList[freeCount++] = s;
+    }
+    bool addOutput(msdkOutputSurface* o)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        if(tail - head == HANDOFF_SURFACES)
+        {
+            return false;
+        }
+        fifo[tail++ % HANDOFF_SURFACES] = o;
+        return true;
+    }
+    msdkOutputSurface* getOutput(void)
+    {
+        std::lock_guard<std::mutex> l(lock);
+        return (head == tail) ? NULL : fifo[head++ % HANDOFF_SURFACES];
+    }
+};
+
+// Takes a surface for the decoder, a second owner is a pool bug.
+static void own(msdkFrameSurface* s)
+{
+    if(__atomic_exchange_n(&s->render_lock, 1, __ATOMIC_ACQ_REL) != 0)
+    {
+        fprintf(stderr, "FAILED: surface handed out twice\n");
+        ++s_Failures;
+    }
+}
+
+static void release(msdkFrameSurface* s)
+{
+    __atomic_store_n(&s->render_lock, 0, __ATOMIC_RELEASE);
+}
+
+static void report(const char* name, unsigned int frames, unsigned long long ns,
+                   unsigned long long producerCpu, unsigned long long consumerCpu)
+{
+    printf("%-8s %9.1f ns/frame  decode thread %7.1f ns/frame CPU  deliver thread %7.1f ns/frame CPU\n",
+           name, (double)ns / frames, (double)producerCpu / frames, (double)consumerCpu / frames);
+}
+
+// Decoding thread: free surface -> used -> output ring. Delivering thread:
+// output ring -> detach from used -> free surface, as CBuffering does.
+static void benchLockFree(unsigned int frames)
+{
+    static msdkFrameSurface surfaces[HANDOFF_SURFACES];
+    static msdkOutputSurface outputs[HANDOFF_SURFACES];
+    FreePool freePool;
+    UsedPool usedPool;
+    OutputRing ring;
+    msdkSurfaceBitmap freeOutputs;
+
+    freePool.Init(surfaces, HANDOFF_SURFACES);
+    usedPool.Init(surfaces, HANDOFF_SURFACES);
+    ring.Init(HANDOFF_SURFACES);
+    freeOutputs.Alloc(HANDOFF_SURFACES);
+    for(mfxU32 i = 0; i < HANDOFF_SURFACES; ++i)
+    {
+        freeOutputs.Set(i);
+    }
+
+    unsigned long long producerCpu = 0;
+    unsigned long long consumerCpu = 0;
+    unsigned long long start = nowNs();
+    std::thread producer([&]() {
+        for(unsigned int n = 0; n < frames; ++n)
+        {
+            msdkFrameSurface* s;
+            while((s = freePool.GetSurface()) == NULL)
+            {
+                std::this_thread::yield();
+            }
+            own(s);
+            usedPool.AddSurface(s);
+
+            mfxI32 o;
+            while((o = freeOutputs.TakeFirst()) < 0)
+            {
+                std::this_thread::yield();
+            }
+            outputs[o].surface = s;
+            while(!ring.AddSurface(&outputs[o]))
+            {
+                std::this_thread::yield();
+            }
+        }
+        producerCpu = threadCpuNs();
+    });
+    std::thread consumer([&]() {
+        for(unsigned int n = 0; n < frames; ++n)
+        {
+            msdkOutputSurface* o;
+            while((o = ring.GetSurface()) == NULL)
+            {
+                std::this_thread::yield();
+            }
+            msdkFrameSurface* s = o->surface;
+            usedPool.DetachSurface(s);
+            release(s);
+            freePool.AddSurface(s);
+            freeOutputs.Set((mfxU32)(o - outputs));
+        }
+        consumerCpu = threadCpuNs();
+    });
+    producer.join();
+    consumer.join();
+    report("lockfree", frames, nowNs() - start, producerCpu, consumerCpu);
+
+    // Everything came back.
+    mfxU32 count = 0;
+    while(freePool.GetSurface() != NULL)
+    {
+        ++count;
+    }
+    CHECK(count == HANDOFF_SURFACES);
+}
+
+static void benchLocked(unsigned int frames)
+{
+    static msdkFrameSurface surfaces[HANDOFF_SURFACES];
+    static msdkOutputSurface outputs[HANDOFF_SURFACES];
+    LockedPools pools;
+    msdkOutputSurface* freeOutputs[HANDOFF_SURFACES];
+    int freeOutputCount = HANDOFF_SURFACES;
+    std::mutex outputLock;
+
+    for(int i = 0; i < HANDOFF_SURFACES; ++i)
+    {
+        pools.addFree(&surfaces[i]);
+        freeOutputs[i] = &outputs[i];
+    }
+
+    unsigned long long producerCpu = 0;
+    unsigned long long consumerCpu = 0;
+    unsigned long long start = nowNs();
+    std::thread producer([&]() {
+        for(unsigned int n = 0; n < frames; ++n)
+        {
+            msdkFrameSurface* s;
+            while((s = pools.getFree()) == NULL)
+            {
+                std::this_thread::yield();
+            }
+            own(s);
+
+            msdkOutputSurface* o = NULL;
+            while(o == NULL)
+            {
+                {
+                    std::lock_guard<std::mutex> l(outputLock);
+                    o = freeOutputCount ? freeOutputs[--freeOutputCount] : NULL;
+                }
+                if(o == NULL)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            o->surface = s;
+            while(!pools.addOutput(o))
+            {
+                std::this_thread::yield();
+            }
+        }
+        producerCpu = threadCpuNs();
+    });
+    std::thread consumer([&]() {
+        for(unsigned int n = 0; n < frames; ++n)
+        {
+            msdkOutputSurface* o;
+            while((o = pools.getOutput()) == NULL)
+            {
+                std::this_thread::yield();
+            }
+            release(o->surface);
+            pools.addFree(o->surface);
+            std::lock_guard<std::mutex> l(outputLock);
+            freeOutputs[freeOutputCount++] = o;
+        }
+        consumerCpu = threadCpuNs();
+    });
+    producer.join();
+    consumer.join();
+    report("mutex", frames, nowNs() - start, producerCpu, consumerCpu);
+}
+
+
+int main(int argc, char** argv)
+{
+    unsigned int frames = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+
+    checkExhaustion();
+    checkRingWrap();
+    if(s_Failures)
+    {
+        return 1;
+    }
+    printf("pool checks passed\n");
+
+    printf("%u frames, %u surfaces, %u CPUs\n", frames, HANDOFF_SURFACES, std::thread::hardware_concurrency());
+    for(int run = 0; run < 3; ++run)
+    {
+        benchLockFree(frames);
+        benchLocked(frames);
+    }
+    return s_Failures ? 1 : 0;
+}